@@ -3,7 +3,7 @@
 // Use, modification and distribution is subject to the MIT License,
 // see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
 //
-// Basic FBX export
+// Basic FBX export (ASCII or binary) and binary FBX import
 
 #include "stdafx.h"
 #include "FgStdStream.hpp"
@@ -14,6 +14,8 @@
 #include "Fg3dNormals.hpp"
 #include "FgCommand.hpp"
 #include "FgTestUtils.hpp"
+#include "FgParallel.hpp"
+#include "FgImageIo.hpp"
 
 using namespace std;
 
@@ -64,15 +66,414 @@ string
 nmVideo(size_t mm,size_t tt)
 {return "\"Video::Video"+toString(mm)+"_"+toString(tt)+"\""; }
 
+namespace {
+
+// Binary FBX is a tree of node records, each with a list of typed properties:
+struct  FbxProp
+{
+    char            type = 0;       // Scalars: CYILFD, string & raw: SR, arrays: bilfd
+    int64           ival = 0;       // Integer and boolean scalars
+    double          dval = 0;       // Floating point scalars
+    String          data;           // String and raw data, or array data once inflated
+    uint32          arrLen = 0;     // Number of array elements
+    String          zdata;          // zlib stream for compressed arrays, empty otherwise
+
+    bool
+    isArray() const
+    {return ((type == 'b') || (type == 'i') || (type == 'l') || (type == 'f') || (type == 'd')); }
+
+    size_t
+    elemSize() const
+    {
+        if (type == 'b')
+            return 1;
+        if ((type == 'i') || (type == 'f'))
+            return 4;
+        return 8;
+    }
+
+    // Converts any numeric array type:
+    template<class T>
+    Svec<T>
+    asArray() const
+    {
+        FGASSERT(isArray() && (data.size() == arrLen*elemSize()));
+        Svec<T>         ret(arrLen);
+        char const *    ptr = data.data();
+        for (size_t ii=0; ii<arrLen; ++ii, ptr+=elemSize()) {
+            if (type == 'b')
+                ret[ii] = T(*ptr);
+            else if (type == 'i')
+                ret[ii] = T(readPod<int32>(ptr));
+            else if (type == 'l')
+                ret[ii] = T(readPod<int64>(ptr));
+            else if (type == 'f')
+                ret[ii] = T(readPod<float>(ptr));
+            else
+                ret[ii] = T(readPod<double>(ptr));
+        }
+        return ret;
+    }
+
+    template<class T>
+    static
+    T
+    readPod(char const * ptr)
+    {
+        T       ret;
+        memcpy(&ret,ptr,sizeof(T));
+        return ret;
+    }
+};
+
+typedef Svec<FbxProp>   FbxProps;
+
+FbxProp
+fbxInt(char type,int64 val)
+{
+    FbxProp     ret;
+    ret.type = type;
+    ret.ival = val;
+    return ret;
+}
+
+FbxProp
+fbxDbl(double val)
+{
+    FbxProp     ret;
+    ret.type = 'D';
+    ret.dval = val;
+    return ret;
+}
+
+FbxProp
+fbxStr(String const & str,char type='S')
+{
+    FbxProp     ret;
+    ret.type = type;
+    ret.data = str;
+    return ret;
+}
+
+inline char fbxArrType(int32) {return 'i'; }
+inline char fbxArrType(int64) {return 'l'; }
+inline char fbxArrType(float) {return 'f'; }
+inline char fbxArrType(double) {return 'd'; }
+
+template<class T>
+FbxProp
+fbxArr(Svec<T> const & arr)
+{
+    FbxProp     ret;
+    ret.type = fbxArrType(T());
+    ret.arrLen = uint32(arr.size());
+    if (!arr.empty())
+        ret.data.assign(reinterpret_cast<char const *>(&arr[0]),arr.size()*sizeof(T));
+    return ret;
+}
+
+// Object names are stored as "<name>\0\1<class>" in binary FBX (displayed as "<class>::<name>" in ASCII):
+String
+fbxName(String const & name,String const & cls)
+{return name + String("\0\1",2) + cls; }
+
+struct  FbxNode
+{
+    String              name;
+    FbxProps            props;
+    Svec<FbxNode>       children;
+
+    FbxNode() {}
+    explicit FbxNode(String const & n) : name(n) {}
+    FbxNode(String const & n,FbxProps const & p) : name(n), props(p) {}
+
+    void
+    add(FbxNode const & child)
+    {children.push_back(child); }
+
+    // Returns nullptr if not found:
+    FbxNode const *
+    child(String const & nm) const
+    {
+        for (FbxNode const & c : children)
+            if (c.name == nm)
+                return &c;
+        return nullptr;
+    }
+
+    // Returns the empty string if there is no such string property:
+    String
+    str(size_t idx) const
+    {
+        if ((idx < props.size()) && (props[idx].type == 'S'))
+            return props[idx].data;
+        return String();
+    }
+
+    // String value of a child node, empty if not present:
+    String
+    childStr(String const & nm) const
+    {
+        FbxNode const *     c = child(nm);
+        return (c == nullptr) ? String() : c->str(0);
+    }
+
+    // Array value of a child node, empty if not present:
+    template<class T>
+    Svec<T>
+    childArray(String const & nm) const
+    {
+        FbxNode const *     c = child(nm);
+        if ((c == nullptr) || c->props.empty() || !c->props[0].isArray())
+            return Svec<T>();
+        return c->props[0].template asArray<T>();
+    }
+
+    // Object ID (first property of all nodes in 'Objects'):
+    int64
+    id() const
+    {return props.empty() ? 0 : props[0].ival; }
+
+    String
+    objName() const
+    {
+        String          nm = str(1);
+        size_t          pos = nm.find(String("\0\1",2));
+        return (pos == String::npos) ? nm : nm.substr(0,pos);
+    }
+};
+
+// Property node within a 'Properties70' list:
+FbxNode
+fbxP(String const & name,String const & type,String const & label,String const & flags,FbxProps const & vals)
+{
+    FbxNode     ret("P",{fbxStr(name),fbxStr(type),fbxStr(label),fbxStr(flags)});
+    cat_(ret.props,vals);
+    return ret;
+}
+
 void
-saveFbx(
-    const Ustring &            filename,
+fbxArrayProps(FbxNode & node,Svec<FbxProp*> & ret)
+{
+    for (FbxProp & prop : node.props)
+        if (prop.isArray())
+            ret.push_back(&prop);
+    for (FbxNode & child : node.children)
+        fbxArrayProps(child,ret);
+}
+
+struct  FbxReader
+{
+    String const &      data;
+    size_t              pos;
+    bool                wide = false;   // 64-bit record header fields (version 7500 and later)
+
+    FbxReader(String const & d,size_t p) : data(d), pos(p) {}
+
+    void
+    need(size_t num) const
+    {
+        if (num > data.size()-pos)
+            fgThrow("FBX file truncated at offset",pos);
+    }
+
+    template<class T>
+    T
+    read()
+    {
+        need(sizeof(T));
+        T           ret = FbxProp::readPod<T>(&data[pos]);
+        pos += sizeof(T);
+        return ret;
+    }
+
+    uint64
+    readLen()
+    {return wide ? read<uint64>() : uint64(read<uint32>()); }
+
+    String
+    readStr(size_t len)
+    {
+        need(len);
+        String      ret = data.substr(pos,len);
+        pos += len;
+        return ret;
+    }
+
+    FbxProp
+    readProp()
+    {
+        FbxProp     ret;
+        ret.type = read<char>();
+        if (ret.type == 'C')
+            ret.ival = read<uchar>();
+        else if (ret.type == 'Y')
+            ret.ival = read<int16>();
+        else if (ret.type == 'I')
+            ret.ival = read<int32>();
+        else if (ret.type == 'L')
+            ret.ival = read<int64>();
+        else if (ret.type == 'F')
+            ret.dval = read<float>();
+        else if (ret.type == 'D')
+            ret.dval = read<double>();
+        else if ((ret.type == 'S') || (ret.type == 'R'))
+            ret.data = readStr(read<uint32>());
+        else if (ret.isArray()) {
+            ret.arrLen = read<uint32>();
+            uint32          encoding = read<uint32>(),
+                            len = read<uint32>();
+            if (encoding == 0) {
+                if (len != ret.arrLen*ret.elemSize())
+                    fgThrow("FBX array size mismatch at offset",pos);
+                ret.data = readStr(len);
+            }
+            else if (encoding == 1)
+                ret.zdata = readStr(len);
+            else
+                fgThrow("Unknown FBX array encoding",encoding);
+        }
+        else
+            fgThrow("Unknown FBX property type",int(ret.type));
+        return ret;
+    }
+
+    // Returns false for the null record which terminates a list of nodes:
+    bool
+    readNode(FbxNode & node)
+    {
+        uint64          end = readLen(),
+                        numProps = readLen();
+        readLen();                                  // Property list length in bytes
+        uchar           nameLen = read<uchar>();
+        if (end == 0)
+            return false;
+        if ((end <= pos) || (end > data.size()))
+            fgThrow("Invalid FBX node record end offset",end);
+        node.name = readStr(nameLen);
+        for (uint64 ii=0; ii<numProps; ++ii)
+            node.props.push_back(readProp());
+        while (pos < end) {
+            FbxNode         child;
+            if (!readNode(child))
+                break;
+            node.children.push_back(move(child));
+        }
+        pos = size_t(end);
+        return true;
+    }
+};
+
+char const  fbxMagic[] = "Kaydara FBX Binary  ";   // Followed by 0x00, 0x1A, 0x00 then the version
+// Fixed IDs which most readers require to match:
+char const  fbxFileId[] = "\x28\xb3\x2a\xeb\xb6\x24\xcc\xc2\xbf\xc8\xb0\x2a\xa9\x2b\xfc\xf1";
+char const  fbxFooterId[] = "\xfa\xbc\xab\x09\xd0\xc8\xd4\x66\xb1\x76\xfb\x83\x1c\xf7\x26\x7e";
+char const  fbxFooterMagic[] = "\xf8\x5a\x8c\x6a\xde\xf5\xd9\x7e\xec\xe9\x0c\xe3\x75\x8f\x29\x0b";
+char const  fbxCreationTime[] = "1970-01-01 10:00:00:000";
+
+// Returns the top-level nodes as the children of the returned node:
+FbxNode
+fbxParseBinary(String const & data)
+{
+    if ((data.size() < 27) || (data.compare(0,20,fbxMagic) != 0))
+        fgThrow("Not a binary FBX file (ASCII FBX can not be loaded)");
+    FbxReader           rdr(data,23);
+    uint32              version = rdr.read<uint32>();
+    rdr.wide = (version >= 7500);
+    FbxNode             root;
+    while (rdr.pos < data.size()) {
+        FbxNode             node;
+        if (!rdr.readNode(node))
+            break;
+        root.children.push_back(move(node));
+    }
+    // Inflation dominates load time for large files so do the arrays in parallel:
+    Svec<FbxProp*>      arrays,
+                        packed;
+    fbxArrayProps(root,arrays);
+    for (FbxProp * prop : arrays)
+        if (!prop->zdata.empty())
+            packed.push_back(prop);
+    parallelFor(packed.size(),[&packed](size_t ii)
+    {
+        FbxProp &           prop = *packed[ii];
+        prop.data = zlibInflate(prop.zdata.data(),prop.zdata.size(),prop.arrLen*prop.elemSize());
+        prop.zdata = String();
+    });
+    return root;
+}
+
+template<class T>
+void
+fbxAppend(String & out,T val)
+{out.append(reinterpret_cast<char const *>(&val),sizeof(T)); }
+
+void
+fbxWriteProp(FbxProp const & prop,String & out)
+{
+    out += prop.type;
+    if (prop.type == 'C')
+        fbxAppend(out,uchar(prop.ival));
+    else if (prop.type == 'Y')
+        fbxAppend(out,int16(prop.ival));
+    else if (prop.type == 'I')
+        fbxAppend(out,int32(prop.ival));
+    else if (prop.type == 'L')
+        fbxAppend(out,int64(prop.ival));
+    else if (prop.type == 'F')
+        fbxAppend(out,float(prop.dval));
+    else if (prop.type == 'D')
+        fbxAppend(out,prop.dval);
+    else if ((prop.type == 'S') || (prop.type == 'R')) {
+        fbxAppend(out,uint32(prop.data.size()));
+        out += prop.data;
+    }
+    else {
+        FGASSERT(prop.isArray());
+        bool                packed = !prop.zdata.empty();
+        String const &      arr = packed ? prop.zdata : prop.data;
+        fbxAppend(out,prop.arrLen);
+        fbxAppend(out,uint32(packed ? 1 : 0));
+        fbxAppend(out,uint32(arr.size()));
+        out += arr;
+    }
+}
+
+// Writes 32-bit record headers (version 7400 and earlier):
+void
+fbxWriteNode(FbxNode const & node,String & out)
+{
+    size_t          start = out.size();
+    fbxAppend(out,uint32(0));                       // End offset, filled in below
+    fbxAppend(out,uint32(node.props.size()));
+    fbxAppend(out,uint32(0));                       // Property list length, filled in below
+    FGASSERT(node.name.size() < 256);
+    fbxAppend(out,uchar(node.name.size()));
+    out += node.name;
+    size_t          propStart = out.size();
+    for (FbxProp const & prop : node.props)
+        fbxWriteProp(prop,out);
+    uint32          propLen = uint32(out.size()-propStart);
+    memcpy(&out[start+8],&propLen,4);
+    for (FbxNode const & child : node.children)
+        fbxWriteNode(child,out);
+    if (!node.children.empty() || node.props.empty())
+        out.append(13,'\0');                        // Null record ends the child list
+    if (out.size() > 0xFFFFFFFFULL)
+        fgThrow("FBX file too large for 32-bit offsets");
+    uint32          end = uint32(out.size());
+    memcpy(&out[start],&end,4);
+}
+
+}
+
+static
+void
+saveFbxAscii(
+    const Path &            path,
     const vector<Mesh> &    meshes,
-    string                      imgFormat)
+    const string &          imgFormat)
 {
-    FGASSERT(!meshes.empty());
-    Path      path(filename);
-    path.ext = "fbx";
     Ofstream  ofs(path.str());
     ofs.precision(7);
     ofs <<
@@ -215,7 +616,7 @@ saveFbx(
         start = true;
         for (size_t ss=0; ss<mesh.surfaces.size(); ++ss) {
             const Surf & surf = mesh.surfaces[ss];
-            size_t              num = surf.tris.uvInds.size() + surf.quads.uvInds.size();
+            size_t              num = surf.numFacets();
             for (size_t ii=0; ii<num; ++ii) {
                 if (start)
                     start = false;
@@ -360,6 +761,473 @@ saveFbx(
     ofs << "}\n";
 }
 
+static
+void
+saveFbxBinary(
+    const Path &            path,
+    const vector<Mesh> &    meshes,
+    const string &          imgFormat)
+{
+    FbxNode             root;
+    FbxNode             header("FBXHeaderExtension");
+    header.add(FbxNode("FBXHeaderVersion",{fbxInt('I',1003)}));
+    header.add(FbxNode("FBXVersion",{fbxInt('I',7400)}));
+    header.add(FbxNode("Creator",{fbxStr("FaceGen")}));
+    root.add(header);
+    root.add(FbxNode("FileId",{fbxStr(String(fbxFileId,16),'R')}));
+    root.add(FbxNode("CreationTime",{fbxStr(fbxCreationTime)}));
+    root.add(FbxNode("Creator",{fbxStr("FaceGen")}));
+    FbxNode             defs("Definitions");
+    defs.add(FbxNode("Version",{fbxInt('I',100)}));
+    for (char const * type : {"Model","Geometry","Material","Texture","Video","Deformer"})
+        defs.add(FbxNode("ObjectType",{fbxStr(type)}));
+    root.add(defs);
+    FbxNode             objs("Objects"),
+                        conns("Connections");
+    FbxProps            zero3 {fbxDbl(0),fbxDbl(0),fbxDbl(0)},
+                        one3 {fbxDbl(1),fbxDbl(1),fbxDbl(1)};
+    auto                conn = [&conns](String const & type,size_t child,size_t parent)
+    {conns.add(FbxNode("C",{fbxStr(type),fbxInt('L',child),fbxInt('L',parent)})); };
+    for (size_t mm=0; mm<meshes.size(); ++mm)
+        conn("OO",idModel(mm),0);
+    for (size_t mm=0; mm<meshes.size(); ++mm) {
+        const Mesh &        mesh = meshes[mm];
+        FbxNode             model("Model",{fbxInt('L',idModel(mm)),fbxStr(fbxName(mesh.name.m_str,"Model")),fbxStr("Mesh")});
+        model.add(FbxNode("Version",{fbxInt('I',232)}));
+        FbxNode             modelProps("Properties70");
+        modelProps.add(fbxP("ScalingMax","Vector3D","Vector","",zero3));
+        modelProps.add(fbxP("DefaultAttributeIndex","int","Integer","",{fbxInt('I',0)}));
+        modelProps.add(fbxP("Lcl Translation","Lcl Translation","","A",zero3));
+        model.add(modelProps);
+        model.add(FbxNode("Shading",{fbxInt('C',1)}));
+        model.add(FbxNode("Culling",{fbxStr("CullingOff")}));
+        objs.add(model);
+        FbxNode             geo("Geometry",{fbxInt('L',idGeometry(mm)),fbxStr(fbxName(mesh.name.m_str,"Geometry")),fbxStr("Mesh")});
+        Doubles             verts,
+                            norms,
+                            uvs;
+        verts.reserve(mesh.verts.size()*3);
+        for (Vec3F v : mesh.verts)
+            for (uint dd=0; dd<3; ++dd)
+                verts.push_back(v[dd]);
+        geo.add(FbxNode("Vertices",{fbxArr(verts)}));
+        Svec<int32>         polyInds,
+                            uvInds,
+                            matInds;
+        for (size_t ss=0; ss<mesh.surfaces.size(); ++ss) {
+            const Surf &        surf = mesh.surfaces[ss];
+            for (Vec3UI i : surf.tris.vertInds)
+                cat_(polyInds,Svec<int32>{int32(i[0]),int32(i[1]),int32(~i[2])});
+            for (Vec4UI i : surf.quads.vertInds)
+                cat_(polyInds,Svec<int32>{int32(i[0]),int32(i[1]),int32(i[2]),int32(~i[3])});
+            for (Vec3UI i : surf.tris.uvInds)
+                cat_(uvInds,Svec<int32>{int32(i[0]),int32(i[1]),int32(i[2])});
+            for (Vec4UI i : surf.quads.uvInds)
+                cat_(uvInds,Svec<int32>{int32(i[0]),int32(i[1]),int32(i[2]),int32(i[3])});
+            matInds.resize(matInds.size()+surf.numFacets(),int32(ss));
+        }
+        geo.add(FbxNode("PolygonVertexIndex",{fbxArr(polyInds)}));
+        geo.add(FbxNode("GeometryVersion",{fbxInt('I',124)}));
+        Normals             normals = cNormals(mesh);
+        norms.reserve(mesh.verts.size()*3);
+        for (Vec3F n : normals.vert)
+            for (uint dd=0; dd<3; ++dd)
+                norms.push_back(n[dd]);
+        for (Vec2F uv : mesh.uvs)
+            cat_(uvs,Doubles{uv[0],uv[1]});
+        FbxNode             normLayer("LayerElementNormal",{fbxInt('I',0)}),
+                            uvLayer("LayerElementUV",{fbxInt('I',0)}),
+                            matLayer("LayerElementMaterial",{fbxInt('I',0)}),
+                            layer("Layer",{fbxInt('I',0)});
+        normLayer.add(FbxNode("Version",{fbxInt('I',102)}));
+        normLayer.add(FbxNode("Name",{fbxStr("")}));
+        normLayer.add(FbxNode("MappingInformationType",{fbxStr("ByVertice")}));
+        normLayer.add(FbxNode("ReferenceInformationType",{fbxStr("Direct")}));
+        normLayer.add(FbxNode("Normals",{fbxArr(norms)}));
+        geo.add(normLayer);
+        uvLayer.add(FbxNode("Version",{fbxInt('I',101)}));
+        uvLayer.add(FbxNode("Name",{fbxStr("UVs"+toString(mm))}));
+        uvLayer.add(FbxNode("MappingInformationType",{fbxStr("ByPolygonVertex")}));
+        uvLayer.add(FbxNode("ReferenceInformationType",{fbxStr("IndexToDirect")}));
+        uvLayer.add(FbxNode("UV",{fbxArr(uvs)}));
+        uvLayer.add(FbxNode("UVIndex",{fbxArr(uvInds)}));
+        geo.add(uvLayer);
+        matLayer.add(FbxNode("Version",{fbxInt('I',101)}));
+        matLayer.add(FbxNode("Name",{fbxStr("")}));
+        matLayer.add(FbxNode("MappingInformationType",{fbxStr("ByPolygon")}));
+        matLayer.add(FbxNode("ReferenceInformationType",{fbxStr("IndexToDirect")}));
+        matLayer.add(FbxNode("Materials",{fbxArr(matInds)}));
+        geo.add(matLayer);
+        layer.add(FbxNode("Version",{fbxInt('I',100)}));
+        for (char const * type : {"LayerElementNormal","LayerElementUV","LayerElementMaterial"}) {
+            FbxNode             elem("LayerElement");
+            elem.add(FbxNode("Type",{fbxStr(type)}));
+            elem.add(FbxNode("TypedIndex",{fbxInt('I',0)}));
+            layer.add(elem);
+        }
+        geo.add(layer);
+        objs.add(geo);
+        for (size_t ee=0; ee<mesh.numMorphs(); ++ee) {
+            IndexedMorph        morph = mesh.getMorphAsIndexedDelta(ee);
+            String              name = morph.name.m_str;
+            Svec<int32>         inds(morph.baseInds.begin(),morph.baseInds.end());
+            Doubles             dels;
+            dels.reserve(morph.verts.size()*3);
+            for (Vec3F v : morph.verts)
+                for (uint dd=0; dd<3; ++dd)
+                    dels.push_back(v[dd]);
+            FbxNode             shape("Geometry",{fbxInt('L',idGeoExp(mm,ee)),fbxStr(fbxName(name,"Geometry")),fbxStr("Shape")}),
+                                deformer("Deformer",{fbxInt('L',idDeformer(mm,ee)),fbxStr(fbxName(name,"Deformer")),fbxStr("BlendShape")}),
+                                channel("Deformer",{fbxInt('L',idSubdeformer(mm,ee)),fbxStr(fbxName(name,"SubDeformer")),fbxStr("BlendShapeChannel")});
+            shape.add(FbxNode("Version",{fbxInt('I',100)}));
+            shape.add(FbxNode("Indexes",{fbxArr(inds)}));
+            shape.add(FbxNode("Vertices",{fbxArr(dels)}));
+            deformer.add(FbxNode("Version",{fbxInt('I',100)}));
+            channel.add(FbxNode("Version",{fbxInt('I',100)}));
+            channel.add(FbxNode("DeformPercent",{fbxDbl(0)}));
+            channel.add(FbxNode("FullWeights",{fbxArr(Doubles{10})}));
+            objs.add(shape);
+            objs.add(deformer);
+            objs.add(channel);
+            conn("OO",idGeoExp(mm,ee),idSubdeformer(mm,ee));
+            conn("OO",idSubdeformer(mm,ee),idDeformer(mm,ee));
+            conn("OO",idDeformer(mm,ee),idGeometry(mm));
+        }
+    }
+    for (size_t mm=0; mm<meshes.size(); ++mm) {
+        const Mesh &        mesh = meshes[mm];
+        conn("OO",idGeometry(mm),idModel(mm));
+        for (size_t tt=0; tt<mesh.surfaces.size(); ++tt) {
+            String              suffix = toString(mm) + "_" + toString(tt),
+                                texName = fbxName("Texture"+suffix,"Texture"),
+                                videoName = fbxName("Video"+suffix,"Video");
+            FbxNode             material("Material",{fbxInt('L',idMaterial(mm,tt)),fbxStr(fbxName("Material"+suffix,"Material")),fbxStr("")});
+            material.add(FbxNode("Version",{fbxInt('I',102)}));
+            material.add(FbxNode("ShadingModel",{fbxStr("phong")}));
+            material.add(FbxNode("MultiLayer",{fbxInt('I',0)}));
+            FbxNode             matProps("Properties70");
+            matProps.add(fbxP("AmbientColor","Color","","A",zero3));
+            matProps.add(fbxP("DiffuseColor","Color","","A",one3));
+            matProps.add(fbxP("Emissive","Vector3D","Vector","",zero3));
+            matProps.add(fbxP("Ambient","Vector3D","Vector","",zero3));
+            matProps.add(fbxP("Diffuse","Vector3D","Vector","",one3));
+            matProps.add(fbxP("Opacity","double","Number","",{fbxDbl(1)}));
+            material.add(matProps);
+            objs.add(material);
+            Ustring             texBaseExt = path.base + suffix + "." + imgFormat;
+            if (mesh.surfaces[tt].material.albedoMap)
+                imgSaveAnyFormat(path.dir() + texBaseExt,*mesh.surfaces[tt].material.albedoMap);
+            FbxNode             texture("Texture",{fbxInt('L',idTexture(mm,tt)),fbxStr(texName),fbxStr("TextureVideoClip")});
+            texture.add(FbxNode("Type",{fbxStr("TextureVideoClip")}));
+            texture.add(FbxNode("Version",{fbxInt('I',202)}));
+            texture.add(FbxNode("TextureName",{fbxStr(texName)}));
+            FbxNode             texProps("Properties70");
+            texProps.add(fbxP("CurrentTextureBlendMode","enum","","",{fbxInt('I',0)}));
+            texProps.add(fbxP("UVSet","KString","","",{fbxStr("UVs"+toString(mm))}));
+            texProps.add(fbxP("UseMaterial","bool","","",{fbxInt('I',1)}));
+            texture.add(texProps);
+            texture.add(FbxNode("Media",{fbxStr(videoName)}));
+            texture.add(FbxNode("FileName",{fbxStr(texBaseExt.m_str)}));
+            texture.add(FbxNode("RelativeFilename",{fbxStr(texBaseExt.m_str)}));
+            texture.add(FbxNode("ModelUVTranslation",{fbxDbl(0),fbxDbl(0)}));
+            texture.add(FbxNode("ModelUVScaling",{fbxDbl(1),fbxDbl(1)}));
+            texture.add(FbxNode("Texture_Alpha_Source",{fbxStr("None")}));
+            texture.add(FbxNode("Cropping",{fbxInt('I',0),fbxInt('I',0),fbxInt('I',0),fbxInt('I',0)}));
+            objs.add(texture);
+            FbxNode             video("Video",{fbxInt('L',idVideo(mm,tt)),fbxStr(videoName),fbxStr("Clip")});
+            video.add(FbxNode("Type",{fbxStr("Clip")}));
+            FbxNode             videoProps("Properties70");
+            videoProps.add(fbxP("Path","KString","XRefUrl","",{fbxStr(texBaseExt.m_str)}));
+            video.add(videoProps);
+            video.add(FbxNode("UseMipMap",{fbxInt('I',0)}));
+            video.add(FbxNode("Filename",{fbxStr(texBaseExt.m_str)}));
+            video.add(FbxNode("RelativeFilename",{fbxStr(texBaseExt.m_str)}));
+            objs.add(video);
+            conn("OO",idMaterial(mm,tt),idModel(mm));
+            conns.add(FbxNode("C",{fbxStr("OP"),fbxInt('L',idTexture(mm,tt)),fbxInt('L',idMaterial(mm,tt)),fbxStr("DiffuseColor")}));
+            conn("OO",idVideo(mm,tt),idTexture(mm,tt));
+            if (mesh.surfaces[tt].material.albedoMap && fgUsesAlpha(*mesh.surfaces[tt].material.albedoMap))
+                conns.add(FbxNode("C",{fbxStr("OP"),fbxInt('L',idTexture(mm,tt)),fbxInt('L',idMaterial(mm,tt)),fbxStr("TransparentColor")}));
+        }
+    }
+    root.add(objs);
+    root.add(conns);
+    // Compress the larger arrays in parallel; small ones aren't worth the overhead:
+    Svec<FbxProp*>      arrays,
+                        packed;
+    fbxArrayProps(root,arrays);
+    for (FbxProp * prop : arrays)
+        if (prop->data.size() >= 128)
+            packed.push_back(prop);
+    parallelFor(packed.size(),[&packed](size_t ii)
+    {
+        FbxProp &           prop = *packed[ii];
+        prop.zdata = zlibDeflate(prop.data.data(),prop.data.size());
+    });
+    String              out(fbxMagic,20);
+    out.append("\0\x1a\0",3);
+    fbxAppend(out,uint32(7400));
+    for (FbxNode const & node : root.children)
+        fbxWriteNode(node,out);
+    out.append(13,'\0');                            // Null record ends the top-level list
+    out.append(fbxFooterId,16);
+    out.append(16 - out.size() % 16,'\0');          // Align to 16 bytes, with at least 1 byte of padding
+    fbxAppend(out,uint32(7400));
+    out.append(120,'\0');
+    out.append(fbxFooterMagic,16);
+    fgDump(out,path.str(),false);
+}
+
+void
+saveFbx(
+    const Ustring &         filename,
+    const vector<Mesh> &    meshes,
+    string                  imgFormat,
+    bool                    binary)
+{
+    FGASSERT(!meshes.empty());
+    Path      path(filename);
+    path.ext = "fbx";
+    if (binary)
+        saveFbxBinary(path,meshes,imgFormat);
+    else
+        saveFbxAscii(path,meshes,imgFormat);
+}
+
+namespace {
+
+struct  FbxScene
+{
+    map<int64,FbxNode const *>      objects;
+    // Child object IDs and the connected property name (if any) by parent ID, in connection order:
+    map<int64,Svec<pair<int64,String> > >   children;
+
+    explicit
+    FbxScene(FbxNode const & root)
+    {
+        FbxNode const *     objs = root.child("Objects");
+        FbxNode const *     conns = root.child("Connections");
+        if ((objs == nullptr) || (conns == nullptr))
+            fgThrow("FBX file has no objects");
+        for (FbxNode const & obj : objs->children)
+            objects[obj.id()] = &obj;
+        for (FbxNode const & c : conns->children) {
+            if ((c.name != "C") || (c.props.size() < 3))
+                continue;
+            String          type = c.str(0);
+            if ((type == "OO") || (type == "OP"))
+                children[c.props[2].ival].push_back(make_pair(c.props[1].ival,c.str(3)));
+        }
+    }
+
+    // Connected child objects with the given node name and (if not empty) class:
+    Svec<FbxNode const *>
+    childObjs(int64 parent,String const & nodeName,String const & cls=String()) const
+    {
+        Svec<FbxNode const *>   ret;
+        auto                    it = children.find(parent);
+        if (it == children.end())
+            return ret;
+        for (pair<int64,String> const & c : it->second) {
+            auto                    obj = objects.find(c.first);
+            if ((obj != objects.end()) && (obj->second->name == nodeName)) {
+                if (cls.empty() || (obj->second->str(2) == cls))
+                    ret.push_back(obj->second);
+            }
+        }
+        return ret;
+    }
+};
+
+Mesh
+fbxMesh(FbxScene const & scene,FbxNode const & model,FbxNode const & geo,Ustring const & dir)
+{
+    Mesh                ret;
+    ret.name = model.objName();
+    Doubles             verts = geo.childArray<double>("Vertices");
+    Ints                polyInds = geo.childArray<int>("PolygonVertexIndex");
+    if (verts.size() % 3 != 0)
+        fgThrow("FBX geometry vertices array size not a multiple of 3",ret.name);
+    ret.verts.resize(verts.size()/3);
+    for (size_t vv=0; vv<ret.verts.size(); ++vv)
+        ret.verts[vv] = Vec3F(verts[vv*3],verts[vv*3+1],verts[vv*3+2]);
+    // UVs:
+    Ints                uvInds;
+    bool                uvByPolyVert = false,
+                        uvIndexed = false;
+    FbxNode const *     uvLayer = geo.child("LayerElementUV");
+    if (uvLayer != nullptr) {
+        Doubles             uvs = uvLayer->childArray<double>("UV");
+        ret.uvs.resize(uvs.size()/2);
+        for (size_t uu=0; uu<ret.uvs.size(); ++uu)
+            ret.uvs[uu] = Vec2F(uvs[uu*2],uvs[uu*2+1]);
+        uvByPolyVert = (uvLayer->childStr("MappingInformationType") == "ByPolygonVertex");
+        uvIndexed = (uvLayer->childStr("ReferenceInformationType") != "Direct");
+        uvInds = uvLayer->childArray<int>("UVIndex");
+    }
+    bool                hasUvs = !ret.uvs.empty();
+    // Returns the UV index for the given polygon-vertex and vertex indices:
+    auto                uvIdx = [&](size_t pv,size_t vert)
+    {
+        size_t              idx = uvByPolyVert ? pv : vert;
+        if (uvIndexed)
+            idx = ((idx < uvInds.size()) && (uvInds[idx] >= 0)) ? size_t(uvInds[idx]) : 0;
+        if (idx >= ret.uvs.size())
+            fgThrow("FBX UV index out of bounds",ret.name);
+        return uint(idx);
+    };
+    // Materials (ie. surfaces):
+    Svec<FbxNode const *>   materials = scene.childObjs(model.id(),"Material");
+    Ints                matInds;
+    bool                matAllSame = true;
+    FbxNode const *     matLayer = geo.child("LayerElementMaterial");
+    if (matLayer != nullptr) {
+        matInds = matLayer->childArray<int>("Materials");
+        matAllSame = (matLayer->childStr("MappingInformationType") == "AllSame");
+    }
+    ret.surfaces.resize(std::max(materials.size(),size_t(1)));
+    size_t              start = 0,
+                        poly = 0;
+    for (size_t pv=0; pv<polyInds.size(); ++pv) {
+        if (polyInds[pv] >= 0)
+            continue;
+        size_t              num = pv + 1 - start;   // Last index is stored bitwise negated
+        Uints               vis(num),
+                            uvis(num);
+        for (size_t ii=0; ii<num; ++ii) {
+            int                 idx = polyInds[start+ii];
+            vis[ii] = uint((idx < 0) ? ~idx : idx);
+            if (vis[ii] >= ret.verts.size())
+                fgThrow("FBX vertex index out of bounds",ret.name);
+            if (hasUvs)
+                uvis[ii] = uvIdx(start+ii,vis[ii]);
+        }
+        size_t              ss = 0;
+        if (!matInds.empty()) {
+            int                 mi = matAllSame ? matInds[0] : matInds[std::min(poly,matInds.size()-1)];
+            ss = size_t(std::max(mi,0));
+        }
+        if (ss >= ret.surfaces.size())
+            ret.surfaces.resize(ss+1);
+        Surf &              surf = ret.surfaces[ss];
+        if (num == 4) {
+            surf.quads.vertInds.push_back(Vec4UI(vis[0],vis[1],vis[2],vis[3]));
+            if (hasUvs)
+                surf.quads.uvInds.push_back(Vec4UI(uvis[0],uvis[1],uvis[2],uvis[3]));
+        }
+        else {
+            // Triangle fan for other polygons; degenerate polygons (num < 3) are skipped:
+            for (size_t ii=2; ii<num; ++ii) {
+                surf.tris.vertInds.push_back(Vec3UI(vis[0],vis[ii-1],vis[ii]));
+                if (hasUvs)
+                    surf.tris.uvInds.push_back(Vec3UI(uvis[0],uvis[ii-1],uvis[ii]));
+            }
+        }
+        start = pv + 1;
+        ++poly;
+    }
+    for (size_t ss=0; ss<materials.size(); ++ss) {
+        Surf &                  surf = ret.surfaces[ss];
+        FbxNode const &         mat = *materials[ss];
+        surf.name = mat.objName();
+        int64                   texId = 0;
+        auto                    it = scene.children.find(mat.id());
+        if (it != scene.children.end()) {
+            for (pair<int64,String> const & c : it->second) {
+                auto                    obj = scene.objects.find(c.first);
+                if ((obj != scene.objects.end()) && (obj->second->name == "Texture") && (c.second == "DiffuseColor")) {
+                    texId = c.first;
+                    break;
+                }
+            }
+        }
+        if (texId != 0) {
+            FbxNode const &         tex = *scene.objects.find(texId)->second;
+            Ustrings                cands;
+            if (!tex.childStr("RelativeFilename").empty())
+                cands.push_back(dir + tex.childStr("RelativeFilename"));
+            if (!tex.childStr("FileName").empty())
+                cands.push_back(tex.childStr("FileName"));
+            for (Ustring const & fname : cands) {
+                if (fileReadable(fname)) {
+                    surf.setAlbedoMap(imgLoadAnyFormat(fname));
+                    break;
+                }
+            }
+        }
+    }
+    // Blend shapes are connected as Shape -> BlendShapeChannel -> BlendShape -> Geometry:
+    for (FbxNode const * blend : scene.childObjs(geo.id(),"Deformer","BlendShape")) {
+        for (FbxNode const * channel : scene.childObjs(blend->id(),"Deformer","BlendShapeChannel")) {
+            Svec<FbxNode const *>   shapes = scene.childObjs(channel->id(),"Geometry","Shape");
+            if (shapes.empty())
+                continue;
+            FbxNode const &         shape = *shapes.back();     // In-between shapes are ignored
+            Ints                    inds = shape.childArray<int>("Indexes");
+            Doubles                 dels = shape.childArray<double>("Vertices");
+            Ustring                 name = channel->objName();
+            if (name.empty())
+                name = shape.objName();
+            if (dels.size() != inds.size()*3)
+                fgThrow("FBX shape indices and vertices size mismatch",name);
+            // Kept as target morphs (even if empty) so that they unify by name when meshes are merged:
+            IndexedMorph            morph;
+            morph.name = name;
+            for (size_t ii=0; ii<inds.size(); ++ii) {
+                uint                    idx = uint(inds[ii]);
+                if (idx >= ret.verts.size())
+                    fgThrow("FBX shape index out of bounds",name);
+                morph.baseInds.push_back(idx);
+                morph.verts.push_back(ret.verts[idx] + Vec3F(dels[ii*3],dels[ii*3+1],dels[ii*3+2]));
+            }
+            ret.targetMorphs.push_back(morph);
+        }
+    }
+    return ret;
+}
+
+}
+
+Mesh
+loadFbx(Ustring const & fname)
+{
+    FbxNode             root;
+    try {
+        root = fbxParseBinary(fgSlurp(fname));
+    }
+    catch (FgException & e) {
+        e.pushMsg("Unable to load FBX file",fname.m_str);
+        throw;
+    }
+    FbxScene            scene(root);
+    Ustring             dir = Path(fname).dir();
+    Meshes              meshes;
+    for (FbxNode const & obj : root.child("Objects")->children) {
+        if ((obj.name != "Model") || (obj.str(2) != "Mesh"))
+            continue;
+        Svec<FbxNode const *>   geos = scene.childObjs(obj.id(),"Geometry","Mesh");
+        if (!geos.empty())
+            meshes.push_back(fbxMesh(scene,obj,*geos[0],dir));
+    }
+    if (meshes.empty())
+        fgThrow("No meshes found in FBX file",fname);
+    Mesh                ret = fgMergeMeshes(meshes);
+    // Target morphs covering all vertices are more efficiently represented as delta morphs:
+    IndexedMorphs       targs;
+    for (IndexedMorph const & tm : ret.targetMorphs) {
+        if (tm.baseInds.size() == ret.verts.size()) {
+            Vec3Fs              targ = ret.verts;
+            for (size_t ii=0; ii<tm.baseInds.size(); ++ii)
+                targ[tm.baseInds[ii]] = tm.verts[ii];
+            ret.deltaMorphs.push_back(Morph(tm.name,targ-ret.verts));
+        }
+        else
+            targs.push_back(tm);
+    }
+    ret.targetMorphs = targs;
+    return ret;
+}
+
 void
 fgSaveFbxTest(const CLArgs & args)
 {
@@ -376,6 +1244,69 @@ fgSaveFbxTest(const CLArgs & args)
     regressFileRel("meshExportFbx1_0.png","base/test/");
 }
 
+void
+fgLoadFbxTest(const CLArgs & args)
+{
+    FGTESTDIR
+    Ustring             dd = dataDir();
+    string              rd = "base/";
+    Mesh                mouth = loadTri(dd+rd+"Mouth.tri");
+    mouth.surfaces[0].setAlbedoMap(imgLoadAnyFormat(dd+rd+"MouthSmall.png"));
+    Mesh                glasses = loadTri(dd+rd+"Glasses.tri");
+    glasses.surfaces[0].setAlbedoMap(imgLoadAnyFormat(dd+rd+"Glasses.tga"));
+    Meshes              meshes = fgSvec(mouth,glasses);
+    saveFbx("binary",meshes,"png",true);
+    saveFbx("ascii",meshes,"png",false);
+    Mesh                orig = fgMergeMeshes(meshes),
+                        mesh = loadFbx("binary.fbx");
+    FGASSERT(mesh.verts == orig.verts);
+    FGASSERT(mesh.uvs == orig.uvs);
+    FGASSERT(mesh.surfaces.size() == orig.surfaces.size());
+    for (size_t ss=0; ss<mesh.surfaces.size(); ++ss) {
+        Surf const &        s0 = orig.surfaces[ss],
+                            s1 = mesh.surfaces[ss];
+        FGASSERT(s1.tris.vertInds == s0.tris.vertInds);
+        FGASSERT(s1.tris.uvInds == s0.tris.uvInds);
+        FGASSERT(s1.quads.vertInds == s0.quads.vertInds);
+        FGASSERT(s1.quads.uvInds == s0.quads.uvInds);
+        FGASSERT(s1.material.albedoMap);
+        FGASSERT(s1.material.albedoMap->dims() == s0.material.albedoMap->dims());
+    }
+    FGASSERT(mesh.numMorphs() == orig.numMorphs());
+    // Deltas below this are dropped on export:
+    float               tol = fgMaxElem(cDims(orig.verts)) * 0.0002f;
+    // Morph names are not necessarily unique so look for any match:
+    for (size_t ii=0; ii<orig.numMorphs(); ++ii) {
+        Vec3Fs              v0 = orig.morphSingle(ii);
+        bool                found = false;
+        for (size_t jj=0; (jj<mesh.numMorphs()) && !found; ++jj) {
+            if (mesh.morphName(jj) != orig.morphName(ii))
+                continue;
+            Vec3Fs              v1 = mesh.morphSingle(jj);
+            found = true;
+            for (size_t vv=0; vv<v0.size(); ++vv)
+                if (fgMaxElem(mapAbs(v1[vv]-v0[vv])) >= tol)
+                    found = false;
+        }
+        FGASSERT(found);
+    }
+    // Per-face materials must survive without UVs:
+    Mesh                noUvs = orig;
+    noUvs.uvs.clear();
+    for (Surf & surf : noUvs.surfaces) {
+        surf.tris.uvInds.clear();
+        surf.quads.uvInds.clear();
+    }
+    saveFbx("noUvs",fgSvec(noUvs),"png",true);
+    mesh = loadFbx("noUvs.fbx");
+    FGASSERT(mesh.uvs.empty());
+    FGASSERT(mesh.surfaces.size() == noUvs.surfaces.size());
+    for (size_t ss=0; ss<mesh.surfaces.size(); ++ss) {
+        FGASSERT(mesh.surfaces[ss].tris.vertInds == noUvs.surfaces[ss].tris.vertInds);
+        FGASSERT(mesh.surfaces[ss].quads.vertInds == noUvs.surfaces[ss].quads.vertInds);
+    }
+}
+
 }
 
 // */
@@ -11,11 +11,35 @@
 #include "FgException.hpp"
 #include "FgSyntax.hpp"
 #include "FgCommand.hpp"
+#include "FgLoadCache.hpp"
+#include "FgParallel.hpp"
+#include "FgTestUtils.hpp"
 
 using namespace std;
 
 namespace Fg {
 
+static
+Mesh
+meshLoadFile(Ustring const & fname)
+{
+    Ustring    ext = fgPathToExt(fname).toLower();
+    if(ext == "tri")
+        return loadTri(fname);
+    else if ((ext == "obj") || (ext == "wobj"))
+        return loadWobj(fname);
+    else if (ext == "fgmesh")
+        return loadFgmesh(fname);
+    else if (ext == "ply")
+        return loadPly(fname);
+    else if (ext == "stl")
+        return loadStl(fname);
+    else if (ext == "fbx")
+        return loadFbx(fname);
+    fgThrow("Not a readable 3D mesh format",fname);
+    return Mesh();
+}
+
 bool
 meshLoadAnyFormat(
     const Ustring &    fname,
@@ -31,18 +55,16 @@ meshLoadAnyFormat(
             path.ext = "obj";
         else if (pathExists(fname + ".fgmesh"))
             path.ext = "fgmesh";
+        else if (pathExists(fname + ".ply"))
+            path.ext = "ply";
+        else if (pathExists(fname + ".stl"))
+            path.ext = "stl";
+        else if (pathExists(fname + ".fbx"))
+            path.ext = "fbx";
         else
             return false;
     }
-    Ustring    ext = path.ext.toLower();
-    if(ext == "tri")
-        mesh = loadTri(path.str());
-    else if ((ext == "obj") || (ext == "wobj"))
-        mesh = loadWobj(path.str());
-    else if (ext == "fgmesh")
-        mesh = loadFgmesh(path.str());
-    else
-        fgThrow("Not a readable 3D mesh format",fname);
+    mesh = meshLoadCached(path.str(),"meshLoadAnyFormat1",meshLoadFile);
     return true;
 }
 
@@ -57,11 +79,142 @@ meshLoadAnyFormat(const Ustring & fname)
 
 vector<string>
 meshLoadFormats()
-{return fgSvec<string>("fgmesh","obj","wobj","tri"); }
+{return fgSvec<string>("fgmesh","obj","wobj","tri","ply","stl","fbx"); }
 
 string
 meshLoadFormatsCLDescription()
-{return string("(fgmesh | [w]obj | tri)"); }
+{return string("(fgmesh | [w]obj | tri | ply | stl | fbx)"); }
+
+size_t
+meshMemoryEstimate(Mesh const & mesh)
+{
+    size_t              ret = sizeof(Mesh) + mesh.verts.size()*sizeof(Vec3F) + mesh.uvs.size()*sizeof(Vec2F);
+    set<ImgC4UC const *> imgs;                  // Surfaces may share images
+    for (Surf const & surf : mesh.surfaces) {
+        ret += sizeof(Surf)
+            + (surf.tris.vertInds.size() + surf.tris.uvInds.size()) * sizeof(Vec3UI)
+            + (surf.quads.vertInds.size() + surf.quads.uvInds.size()) * sizeof(Vec4UI)
+            + surf.surfPoints.size() * sizeof(SurfPoint);
+        imgs.insert(surf.material.albedoMap.get());
+        imgs.insert(surf.material.specularMap.get());
+    }
+    for (ImgC4UC const * img : imgs)
+        if (img != nullptr)
+            ret += img->numPixels() * sizeof(RgbaUC);
+    for (Morph const & morph : mesh.deltaMorphs)
+        ret += morph.verts.size() * sizeof(Vec3F);
+    for (IndexedMorph const & morph : mesh.targetMorphs)
+        ret += morph.baseInds.size() * sizeof(uint) + morph.verts.size() * sizeof(Vec3F);
+    return ret;
+}
+
+MeshPrefetcher::MeshPrefetcher(Ustrings const & fnames,size_t memoryBudget,uint numThreads) :
+    m_fnames(fnames), m_budget(memoryBudget)
+{
+    if (numThreads == 0)
+        numThreads = threadsNum();
+    numThreads = uint(std::min(size_t(numThreads),m_fnames.size()));
+    for (uint tt=0; tt<numThreads; ++tt)
+        m_threads.push_back(thread(&MeshPrefetcher::worker,this));
+}
+
+MeshPrefetcher::~MeshPrefetcher()
+{
+    {
+        lock_guard<mutex>   lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (thread & t : m_threads)
+        t.join();
+}
+
+Mesh
+MeshPrefetcher::next()
+{
+    FGASSERT(more());
+    Loaded              loaded;
+    {
+        unique_lock<mutex>  lock(m_mutex);
+        m_cv.wait(lock,[this]{return (m_loaded.find(m_numConsumed) != m_loaded.end()); });
+        auto                it = m_loaded.find(m_numConsumed);
+        loaded = std::move(it->second);
+        m_loaded.erase(it);
+        m_bytesLoaded -= loaded.bytes;
+        ++m_numConsumed;
+    }
+    m_cv.notify_all();                          // Workers may be waiting on the budget
+    if (loaded.error)
+        rethrow_exception(loaded.error);
+    return std::move(loaded.mesh);
+}
+
+void
+MeshPrefetcher::worker()
+{
+    for (;;) {
+        size_t              idx;
+        {
+            unique_lock<mutex>  lock(m_mutex);
+            // Files are started in order so the one the consumer needs next is never held back:
+            m_cv.wait(lock,[this]
+            {
+                return (m_stop || (m_numStarted >= m_fnames.size()) ||
+                    (m_bytesLoaded < m_budget) || (m_numStarted == m_numConsumed));
+            });
+            if (m_stop || (m_numStarted >= m_fnames.size()))
+                return;
+            idx = m_numStarted++;
+        }
+        Loaded              loaded;
+        try {
+            loaded.mesh = meshLoadAnyFormat(m_fnames[idx]);
+            loaded.bytes = meshMemoryEstimate(loaded.mesh);
+        }
+        catch (...) {
+            loaded.error = current_exception();
+        }
+        {
+            lock_guard<mutex>   lock(m_mutex);
+            m_bytesLoaded += loaded.bytes;
+            m_loaded[idx] = std::move(loaded);
+        }
+        m_cv.notify_all();
+    }
+}
+
+void
+fgMeshPrefetchTest(CLArgs const & args)
+{
+    FGTESTDIR
+    Ustring             dd = dataDir() + "base/";
+    Ustrings            fnames;
+    for (size_t ii=0; ii<8; ++ii) {
+        Ustring             fname = "mesh" + toString(ii) + ".tri";
+        fileCopy(dd + ((ii%2 == 0) ? "Mouth.tri" : "Glasses.tri"),fname);
+        fnames.push_back(fname);
+    }
+    fnames.insert(fnames.begin()+3,"missing.tri");
+    // A budget of 1 byte allows at most one mesh ahead per thread:
+    MeshPrefetcher      prefetch(fnames,1,3);
+    for (Ustring const & fname : fnames) {
+        FGASSERT(prefetch.peekName() == fname);
+        if (fname == "missing.tri") {
+            bool                thrown = false;
+            try {prefetch.next(); }
+            catch (FgException const &) {thrown = true; }
+            FGASSERT(thrown);
+        }
+        else {
+            Mesh                mesh = prefetch.next();
+            FGASSERT(mesh.verts == loadTri(fname).verts);
+        }
+    }
+    FGASSERT(!prefetch.more());
+    // Destruction with unconsumed meshes must not block:
+    MeshPrefetcher      abandoned(fnames,1,2);
+    abandoned.next();
+}
 
 void
 meshSaveAnyFormat(
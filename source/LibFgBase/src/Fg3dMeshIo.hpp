@@ -29,6 +29,64 @@ meshLoadFormats();
 String
 meshLoadFormatsCLDescription();
 
+// Loads meshes (and their referenced textures) ahead of the consumer on background threads so that
+// file I/O and decoding overlap with the consumer's computation. Meshes are returned in the given
+// order. Loading pauses while the estimated memory of the loaded but not yet consumed meshes exceeds
+// 'memoryBudget', except that the mesh the consumer is waiting for is always loaded:
+struct  MeshPrefetcher
+{
+    explicit
+    MeshPrefetcher(
+        Ustrings const &    fnames,
+        size_t              memoryBudget = size_t(1) << 30,     // bytes
+        uint                numThreads = 0);                    // 0: 'threadsNum()' up to the number of files
+
+    // Waits for any loads in progress then discards unconsumed meshes:
+    ~MeshPrefetcher();
+
+    bool
+    more() const
+    {return (m_numConsumed < m_fnames.size()); }
+
+    // Filename of the mesh returned by the next call to 'next()':
+    Ustring const &
+    peekName() const
+    {return m_fnames[m_numConsumed]; }
+
+    // Blocks until the next mesh is loaded. Load errors are rethrown here, after which
+    // the following files can still be retrieved:
+    Mesh
+    next();
+
+private:
+    struct  Loaded
+    {
+        Mesh                mesh;
+        std::exception_ptr  error;
+        size_t              bytes = 0;
+    };
+    Ustrings                        m_fnames;
+    size_t                          m_budget;
+    std::mutex                      m_mutex;
+    std::condition_variable         m_cv;
+    size_t                          m_numStarted = 0;
+    size_t                          m_numConsumed = 0;
+    size_t                          m_bytesLoaded = 0;
+    bool                            m_stop = false;
+    std::map<size_t,Loaded>         m_loaded;
+    Svec<std::thread>               m_threads;
+
+    MeshPrefetcher(MeshPrefetcher const &) = delete;
+    MeshPrefetcher & operator=(MeshPrefetcher const &) = delete;
+
+    void
+    worker();
+};
+
+// Approximate heap memory used by a mesh, including its texture images:
+size_t
+meshMemoryEstimate(Mesh const & mesh);
+
 // Note that meshes and/or surfaces may be merged and other data may be lost
 // depending on the format (see comments below per-format).
 void
@@ -98,14 +156,23 @@ saveVrml(Ustring const & filename,Meshes const & meshes,String imgFormat = "png"
 
 // Meshes with shared morphs must be merged as different surfaces into a single Mesh for the
 // morphs to be unified in FBX (as imported into Unity). Unity will ignore albedo map file 
-// references so they must be manually added:
+// references so they must be manually added. Binary output is several times smaller than ASCII:
 void
-saveFbx(Ustring const & filename,Meshes const & meshes,String imgFormat = "png");
+saveFbx(Ustring const & filename,Meshes const & meshes,String imgFormat = "png",bool binary = false);
+
+// Binary FBX (all versions; ASCII FBX is not supported). Meshes are merged and model transforms
+// are ignored. Blend shapes covering all vertices become delta morphs, otherwise target morphs:
+Mesh
+loadFbx(Ustring const & fname);
 
 // All meshes merged, ignores UVs, textures, morphs, etc:
 void
 saveStl(Ustring const & fname,Meshes const & meshes);
 
+// Binary or ASCII STL. Vertices are welded by exact position:
+Mesh
+loadStl(Ustring const & fname);
+
 // Morph targets are also saved:
 void
 saveLwo(Ustring const & fname,Meshes const & meshes,String imgFormat = "png");
@@ -130,7 +197,12 @@ save3ds(Ustring const & fname,Meshes meshes,String imgFormat = "png");
 // Vertices & surfaces must be merged to a single list but tex images are specified per facet.
 // Currently saves all facets as tris but can easily be changed to preverve quads:
 void
-savePly(Ustring const & fname,Meshes const & meshes,String imgFormat = "png");
+savePly(Ustring const & fname,Meshes const & meshes,String imgFormat = "png",bool binary = false);
+
+// ASCII or binary little-endian PLY. Vertex UVs (u,v / s,t) or per-face 'texcoord' lists are loaded
+// and 'texnumber' separates surfaces. Normals, colours and other properties are ignored:
+Mesh
+loadPly(Ustring const & fname);
 
 // Collada. Does not yet support morphs.
 void
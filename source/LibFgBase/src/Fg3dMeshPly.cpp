@@ -11,6 +11,8 @@
 #include "Fg3dNormals.hpp"
 #include "FgStdStream.hpp"
 #include "FgFileSystem.hpp"
+#include "FgLoadCache.hpp"
+#include "FgParse.hpp"
 #include "FgCommand.hpp"
 #include "FgTestUtils.hpp"
 
@@ -18,21 +20,480 @@ using namespace std;
 
 namespace Fg {
 
+namespace {
+
+enum struct PlyType { int8, uint8, int16, uint16, int32, uint32, float32, float64 };
+
+struct  PlyProp
+{
+    String          name;
+    PlyType         type;
+    bool            isList = false;
+    PlyType         countType;      // Only valid for lists
+};
+
+struct  PlyElem
+{
+    String          name;
+    size_t          count = 0;
+    Svec<PlyProp>   props;
+
+    // Byte size of each record or zero if there are list properties:
+    size_t
+    stride() const;
+
+    // Returns 'none' if not found:
+    static size_t const none = std::numeric_limits<size_t>::max();
+
+    size_t
+    findProp(String const & propName) const
+    {
+        for (size_t ii=0; ii<props.size(); ++ii)
+            if (props[ii].name == propName)
+                return ii;
+        return none;
+    }
+};
+
+PlyType
+toPlyType(String const & str)
+{
+    if ((str == "char") || (str == "int8"))
+        return PlyType::int8;
+    if ((str == "uchar") || (str == "uint8"))
+        return PlyType::uint8;
+    if ((str == "short") || (str == "int16"))
+        return PlyType::int16;
+    if ((str == "ushort") || (str == "uint16"))
+        return PlyType::uint16;
+    if ((str == "int") || (str == "int32"))
+        return PlyType::int32;
+    if ((str == "uint") || (str == "uint32"))
+        return PlyType::uint32;
+    if ((str == "float") || (str == "float32"))
+        return PlyType::float32;
+    if ((str == "double") || (str == "float64"))
+        return PlyType::float64;
+    fgThrow("PLY unknown property type",str);
+    FG_UNREACHABLE_RETURN(PlyType::uint8);
+}
+
+size_t
+plyTypeSize(PlyType type)
+{
+    static size_t   sizes[] = {1,1,2,2,4,4,4,8};
+    return sizes[size_t(type)];
+}
+
+size_t
+PlyElem::stride() const
+{
+    size_t      ret = 0;
+    for (PlyProp const & prop : props) {
+        if (prop.isList)
+            return 0;
+        ret += plyTypeSize(prop.type);
+    }
+    return ret;
+}
+
+// Reads values from the body of a PLY file, which has been loaded in a single bulk read.
+// Only little-endian binary is supported for the binary format since that's what all
+// common tools write:
+struct  PlyReader
+{
+    char const *    ptr;
+    char const *    end;
+    bool            binary;
+
+    PlyReader(String const & data,size_t start,bool bin) :
+        ptr(data.data()+start), end(data.data()+data.size()), binary(bin)
+    {}
+
+    template<class T>
+    T
+    readBin()
+    {
+        if (ptr+sizeof(T) > end)
+            fgThrow("PLY file truncated");
+        T           ret;
+        memcpy(&ret,ptr,sizeof(T));
+        ptr += sizeof(T);
+        return ret;
+    }
+
+    double
+    readAscii()
+    {
+        while ((ptr < end) && isspace(uchar(*ptr)))
+            ++ptr;
+        if (ptr == end)
+            fgThrow("PLY file truncated");
+        char *      next;
+        double      ret = strtod(ptr,&next);
+        if (next == ptr)
+            fgThrow("PLY invalid numeric value");
+        ptr = next;
+        return ret;
+    }
+
+    double
+    read(PlyType type)
+    {
+        if (!binary)
+            return readAscii();
+        switch (type) {
+            case PlyType::int8:     return readBin<int8>();
+            case PlyType::uint8:    return readBin<uint8>();
+            case PlyType::int16:    return readBin<int16>();
+            case PlyType::uint16:   return readBin<uint16>();
+            case PlyType::int32:    return readBin<int32>();
+            case PlyType::uint32:   return readBin<uint32>();
+            case PlyType::float32:  return readBin<float>();
+            case PlyType::float64:  return readBin<double>();
+        }
+        FG_UNREACHABLE_RETURN(0.0);
+    }
+
+    // Index values are read directly to avoid the double conversion in the common binary case:
+    uint
+    readIdx(PlyType type)
+    {
+        if (binary) {
+            if ((type == PlyType::int32) || (type == PlyType::uint32))
+                return readBin<uint32>();
+        }
+        return uint(read(type));
+    }
+
+    void
+    skip(PlyProp const & prop)
+    {
+        size_t      num = 1;
+        if (prop.isList)
+            num = size_t(read(prop.countType));
+        if (binary) {
+            size_t      sz = num * plyTypeSize(prop.type);
+            if (ptr+sz > end)
+                fgThrow("PLY file truncated");
+            ptr += sz;
+        }
+        else
+            for (size_t ii=0; ii<num; ++ii)
+                readAscii();
+    }
+};
+
+}
+
+Mesh
+loadPly(Ustring const & fname)
+{
+    Ifstream            ifs(fname);
+    String              line;
+    getline(ifs,line);
+    if (!fgBeginsWith(line,"ply"))
+        fgThrow("Not a PLY file",fname);
+    bool                binary = false;
+    Svec<PlyElem>       elems;
+    Ustrings            texFiles;
+    for (;;) {
+        if (!getline(ifs,line))
+            fgThrow("PLY header not terminated",fname);
+        if (!line.empty() && (line.back() == '\r'))
+            line.pop_back();
+        Strings         words = splitChar(line);
+        if (words.empty())
+            continue;
+        String const &  key = words[0];
+        if (key == "end_header")
+            break;
+        if (key == "format") {
+            if (words.size() < 2)
+                fgThrow("PLY invalid format line",fname);
+            if (words[1] == "binary_little_endian")
+                binary = true;
+            else if (words[1] != "ascii")
+                fgThrow("PLY format not supported",words[1]);
+        }
+        else if (key == "comment") {
+            // Non-standard but widely used for texture references:
+            if ((words.size() == 3) && (words[1] == "TextureFile"))
+                texFiles.push_back(words[2]);
+        }
+        else if (key == "element") {
+            if (words.size() != 3)
+                fgThrow("PLY invalid element line",line);
+            PlyElem         elem;
+            elem.name = words[1];
+            elem.count = fgFromString<size_t>(words[2]);
+            elems.push_back(elem);
+        }
+        else if (key == "property") {
+            if (elems.empty())
+                fgThrow("PLY property without element",fname);
+            PlyProp         prop;
+            if ((words.size() == 5) && (words[1] == "list")) {
+                prop.isList = true;
+                prop.countType = toPlyType(words[2]);
+                prop.type = toPlyType(words[3]);
+                prop.name = words[4];
+            }
+            else if (words.size() == 3) {
+                prop.type = toPlyType(words[1]);
+                prop.name = words[2];
+            }
+            else
+                fgThrow("PLY invalid property line",line);
+            elems.back().props.push_back(prop);
+        }
+    }
+    // Bulk read the body in one go:
+    size_t              start = size_t(ifs.tellg());
+    ifs.seekg(0,ios::end);
+    size_t              fileSize = size_t(ifs.tellg());
+    String              data(fileSize-start,'\0');
+    ifs.seekg(start);
+    if (!data.empty())
+        ifs.read(&data[0],data.size());
+    PlyReader           rdr(data,0,binary);
+    Mesh                ret;
+    // Surfaces are split by 'texnumber' if present:
+    map<size_t,Surf>    surfs;
+    for (PlyElem const & elem : elems) {
+        if (elem.name == "vertex") {
+            size_t          ix = elem.findProp("x"),
+                            iy = elem.findProp("y"),
+                            iz = elem.findProp("z"),
+                            iu = elem.findProp("u"),
+                            iv = elem.findProp("v");
+            if (iu == PlyElem::none) {
+                iu = elem.findProp("s");
+                iv = elem.findProp("t");
+            }
+            if (iu == PlyElem::none) {
+                iu = elem.findProp("texture_u");
+                iv = elem.findProp("texture_v");
+            }
+            if ((ix == PlyElem::none) || (iy == PlyElem::none) || (iz == PlyElem::none))
+                fgThrow("PLY vertex element missing position",fname);
+            bool            hasUvs = (iu != PlyElem::none) && (iv != PlyElem::none);
+            ret.verts.resize(elem.count);
+            if (hasUvs)
+                ret.uvs.resize(elem.count);
+            size_t          stride = elem.stride(),
+                            offset = 0;
+            for (size_t pp=0; pp<ix; ++pp)
+                offset += plyTypeSize(elem.props[pp].type);
+            bool            packedFloats =
+                binary && (stride > 0) && (iy == ix+1) && (iz == ix+2) &&
+                (elem.props[ix].type == PlyType::float32) &&
+                (elem.props[iy].type == PlyType::float32) &&
+                (elem.props[iz].type == PlyType::float32);
+            if (packedFloats && !hasUvs) {
+                // Fast path for fixed-size records with contiguous float positions:
+                if (rdr.ptr + stride*elem.count > rdr.end)
+                    fgThrow("PLY file truncated",fname);
+                for (size_t vv=0; vv<elem.count; ++vv)
+                    memcpy(&ret.verts[vv][0],rdr.ptr+vv*stride+offset,12);
+                rdr.ptr += stride*elem.count;
+                continue;
+            }
+            for (size_t vv=0; vv<elem.count; ++vv) {
+                for (size_t pp=0; pp<elem.props.size(); ++pp) {
+                    PlyProp const &     prop = elem.props[pp];
+                    if (prop.isList)
+                        rdr.skip(prop);
+                    else if (pp == ix)
+                        ret.verts[vv][0] = float(rdr.read(prop.type));
+                    else if (pp == iy)
+                        ret.verts[vv][1] = float(rdr.read(prop.type));
+                    else if (pp == iz)
+                        ret.verts[vv][2] = float(rdr.read(prop.type));
+                    else if (hasUvs && (pp == iu))
+                        ret.uvs[vv][0] = float(rdr.read(prop.type));
+                    else if (hasUvs && (pp == iv))
+                        ret.uvs[vv][1] = float(rdr.read(prop.type));
+                    else
+                        rdr.skip(prop);     // Normals, colours etc. are not represented in Mesh
+                }
+            }
+        }
+        else if (elem.name == "face") {
+            size_t          ii = elem.findProp("vertex_indices"),
+                            it = elem.findProp("texcoord"),
+                            in = elem.findProp("texnumber");
+            if (ii == PlyElem::none)
+                ii = elem.findProp("vertex_index");
+            if (ii == PlyElem::none)
+                fgThrow("PLY face element missing vertex indices",fname);
+            // Per-vertex UVs share the vertex indices:
+            bool            vertUvs = !ret.uvs.empty() && (it == PlyElem::none);
+            uint            uvBase = uint(ret.uvs.size());
+            if (it != PlyElem::none)
+                ret.uvs.reserve(ret.uvs.size() + elem.count*3);
+            Svec<uint>      inds;
+            Vec2Fs          uvs;
+            size_t          texNum;
+            for (size_t ff=0; ff<elem.count; ++ff) {
+                inds.clear();
+                uvs.clear();
+                texNum = 0;
+                for (size_t pp=0; pp<elem.props.size(); ++pp) {
+                    PlyProp const &     prop = elem.props[pp];
+                    if (prop.isList && (pp == ii)) {
+                        size_t      num = size_t(rdr.read(prop.countType));
+                        for (size_t jj=0; jj<num; ++jj)
+                            inds.push_back(rdr.readIdx(prop.type));
+                    }
+                    else if (prop.isList && (pp == it)) {
+                        size_t      num = size_t(rdr.read(prop.countType)) / 2;
+                        for (size_t jj=0; jj<num; ++jj) {
+                            float       u = float(rdr.read(prop.type));
+                            uvs.push_back(Vec2F(u,float(rdr.read(prop.type))));
+                        }
+                    }
+                    else if (!prop.isList && (pp == in))
+                        texNum = size_t(rdr.read(prop.type));
+                    else
+                        rdr.skip(prop);
+                }
+                if (inds.size() < 3)
+                    continue;
+                for (uint idx : inds)
+                    if (idx >= ret.verts.size())
+                        fgThrow("PLY vertex index out of bounds",toString(idx));
+                Surf &          surf = surfs[texNum];
+                bool            faceUvs = (uvs.size() == inds.size());
+                Svec<uint>      uvInds;
+                if (faceUvs) {
+                    for (size_t jj=0; jj<uvs.size(); ++jj)
+                        uvInds.push_back(uvBase++);
+                    cat_(ret.uvs,uvs);
+                }
+                else if (vertUvs)
+                    uvInds = inds;
+                if (inds.size() == 4) {
+                    surf.quads.vertInds.push_back(Vec4UI(inds[0],inds[1],inds[2],inds[3]));
+                    if (!uvInds.empty())
+                        surf.quads.uvInds.push_back(Vec4UI(uvInds[0],uvInds[1],uvInds[2],uvInds[3]));
+                }
+                else {      // Tris and N-gons as fans:
+                    for (size_t jj=1; jj+1<inds.size(); ++jj) {
+                        surf.tris.vertInds.push_back(Vec3UI(inds[0],inds[jj],inds[jj+1]));
+                        if (!uvInds.empty())
+                            surf.tris.uvInds.push_back(Vec3UI(uvInds[0],uvInds[jj],uvInds[jj+1]));
+                    }
+                }
+            }
+        }
+        else {
+            for (size_t ee=0; ee<elem.count; ++ee)
+                for (PlyProp const & prop : elem.props)
+                    rdr.skip(prop);
+        }
+    }
+    Path                path(fname);
+    for (auto const & it : surfs) {
+        Surf            surf = it.second;
+        if (it.first < texFiles.size()) {
+            Ustring         texFile = path.dir() + texFiles[it.first];
+            loadCacheDepends(texFile);          // Even if missing, so that adding it invalidates the cache
+            if (pathExists(texFile))
+                surf.setAlbedoMap(imgLoadAnyFormat(texFile));
+        }
+        ret.surfaces.push_back(surf);
+    }
+    return ret;
+}
+
+static
+void
+savePlyAscii(Ofstream & ofs,Mesh const & mesh,Normals const & norms)
+{
+    for (size_t vv=0; vv<mesh.verts.size(); ++vv) {
+        Vec3F    pos = mesh.verts[vv],
+                    nrm = norms.vert[vv];
+        ofs << pos[0] << " " << pos[1] << " " << pos[2] << " " << nrm[0] << " " << nrm[1] << " " << nrm[2] << "\n";
+    }
+    size_t      imgCnt = 0;
+    for (size_t ss=0; ss<mesh.surfaces.size(); ++ss) {
+        const Surf &     surf = mesh.surfaces[ss];
+        FacetInds<3>          tris = surf.getTriEquivs();
+        for (size_t ii=0; ii<tris.size(); ++ii) {
+            Vec3UI           vinds = tris.vertInds[ii];
+            ofs << "3 " << vinds[0] << " " << vinds[1] << " " << vinds[2] << " 6 ";
+            if (surf.tris.uvInds.empty())
+                ofs << "0 0 0 0 0 0 ";
+            else {
+                Vec3UI   uvInds = tris.uvInds[ii];
+                for (uint vv=0; vv<3; ++vv) {
+                    Vec2F    uv = mesh.uvs[uvInds[vv]];
+                    ofs << uv[0] << " " << uv[1] << " ";
+                }
+            }
+            ofs << imgCnt << "\n";
+        }
+        if (mesh.surfaces[ss].material.albedoMap)
+            ++imgCnt;
+    }
+}
+
+// Each block is assembled in memory and written with a single call:
+static
+void
+savePlyBinary(Ofstream & ofs,Mesh const & mesh,Normals const & norms)
+{
+    Floats              vertBlock(mesh.verts.size()*6);
+    for (size_t vv=0; vv<mesh.verts.size(); ++vv) {
+        float *         ptr = &vertBlock[vv*6];
+        memcpy(ptr,&mesh.verts[vv][0],12);
+        memcpy(ptr+3,&norms.vert[vv][0],12);
+    }
+    if (!vertBlock.empty())
+        ofs.write(reinterpret_cast<char const *>(vertBlock.data()),vertBlock.size()*4);
+    // Face record: uchar 3, 3 x int32, uchar 6, 6 x float32, int32:
+    size_t const        faceSize = 1 + 12 + 1 + 24 + 4;
+    size_t              imgCnt = 0;
+    for (size_t ss=0; ss<mesh.surfaces.size(); ++ss) {
+        const Surf &        surf = mesh.surfaces[ss];
+        FacetInds<3>        tris = surf.getTriEquivs();
+        String              faceBlock(tris.size()*faceSize,'\0');
+        int32               texNum = int32(imgCnt);
+        for (size_t ii=0; ii<tris.size(); ++ii) {
+            char *          ptr = &faceBlock[ii*faceSize];
+            ptr[0] = 3;
+            memcpy(ptr+1,&tris.vertInds[ii][0],12);
+            ptr[13] = 6;
+            if (tris.hasUvs()) {
+                Vec3UI          uvInds = tris.uvInds[ii];
+                for (uint vv=0; vv<3; ++vv)
+                    memcpy(ptr+14+vv*8,&mesh.uvs[uvInds[vv]][0],8);
+            }
+            memcpy(ptr+38,&texNum,4);
+        }
+        if (!faceBlock.empty())
+            ofs.write(faceBlock.data(),faceBlock.size());
+        if (surf.material.albedoMap)
+            ++imgCnt;
+    }
+}
+
 void
 savePly(
     const Ustring &        fname,
     const vector<Mesh> & meshes,
-    string                  imgFormat)
+    string                  imgFormat,
+    bool                    binary)
 {
     Mesh    mesh = fgMergeMeshes(meshes);
     Path      path(fname);
     path.ext = "ply";
     Ofstream  ofs(path.str());
     ofs <<
-        "ply\n"
-        "format ascii 1.0\n"
+        "ply\n" <<
+        (binary ? "format binary_little_endian 1.0\n" : "format ascii 1.0\n") <<
         "comment created by FaceGen\n";
-    size_t      imgCnt = 0;
     for (size_t ii=0; ii<mesh.surfaces.size(); ++ii) {
         if (mesh.surfaces[ii].material.albedoMap) {
             Ustring    texFile = path.base + toString(ii) + "." + imgFormat;
@@ -53,32 +514,10 @@ savePly(
         "property int texnumber\n"
         "end_header\n";
     Normals         norms = cNormals(mesh);
-    for (size_t vv=0; vv<mesh.verts.size(); ++vv) {
-        Vec3F    pos = mesh.verts[vv],
-                    nrm = norms.vert[vv];
-        ofs << pos[0] << " " << pos[1] << " " << pos[2] << " " << nrm[0] << " " << nrm[1] << " " << nrm[2] << "\n";
-    }
-    imgCnt = 0;
-    for (size_t ss=0; ss<mesh.surfaces.size(); ++ss) {
-        const Surf &     surf = mesh.surfaces[ss];
-        FacetInds<3>          tris = surf.getTriEquivs();
-        for (size_t ii=0; ii<tris.size(); ++ii) {
-            Vec3UI           vinds = tris.vertInds[ii];
-            ofs << "3 " << vinds[0] << " " << vinds[1] << " " << vinds[2] << " 6 ";
-            if (surf.tris.uvInds.empty())
-                ofs << "0 0 0 0 0 0 ";
-            else {
-                Vec3UI   uvInds = tris.uvInds[ii];
-                for (uint vv=0; vv<3; ++vv) {
-                    Vec2F    uv = mesh.uvs[uvInds[vv]];
-                    ofs << uv[0] << " " << uv[1] << " ";
-                }
-            }
-            ofs << imgCnt << "\n";
-        }
-        if (mesh.surfaces[ss].material.albedoMap)
-            ++imgCnt;
-    }
+    if (binary)
+        savePlyBinary(ofs,mesh,norms);
+    else
+        savePlyAscii(ofs,mesh,norms);
 }
 
 void
@@ -97,6 +536,31 @@ fgSavePlyTest(const CLArgs & args)
     regressFileRel("meshExportPly1.png","base/test/");
 }
 
+void
+fgLoadPlyTest(const CLArgs & args)
+{
+    FGTESTDIR
+    Ustring             dd = dataDir();
+    Mesh                mouth = loadTri(dd+"base/Mouth.tri"),
+                        glasses = loadTri(dd+"base/Glasses.tri");
+    mouth.surfaces[0].setAlbedoMap(imgLoadAnyFormat(dd+"base/MouthSmall.png"));
+    glasses.surfaces[0].setAlbedoMap(imgLoadAnyFormat(dd+"base/Glasses.tga"));
+    Mesh                merged = fgMergeMeshes(mouth,glasses);
+    Tris                tris = merged.getTriEquivs();
+    savePly("binary",fgSvec(mouth,glasses),"png",true);
+    Mesh                bin = loadPly("binary.ply");
+    FGASSERT(bin.verts == merged.verts);
+    FGASSERT(bin.getTriEquivs().vertInds == tris.vertInds);
+    FGASSERT(bin.surfaces.size() == 2);
+    FGASSERT(bin.numValidAlbedoMaps() == 2);
+    FGASSERT(bin.uvs.size() == 3*tris.size());
+    savePly("ascii",fgSvec(mouth,glasses));
+    Mesh                asc = loadPly("ascii.ply");
+    FGASSERT(asc.verts.size() == merged.verts.size());
+    FGASSERT(asc.getTriEquivs().vertInds == tris.vertInds);
+    FGASSERT(asc.uvs.size() == bin.uvs.size());
+}
+
 }
 
 // */
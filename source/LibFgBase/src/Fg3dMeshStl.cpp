@@ -9,6 +9,9 @@
 #include "FgFileSystem.hpp"
 #include "FgException.hpp"
 #include "Fg3dNormals.hpp"
+#include "FgStdStream.hpp"
+#include "FgCommand.hpp"
+#include "FgTestUtils.hpp"
 
 using namespace std;
 
@@ -71,4 +74,120 @@ saveStl(const Ustring & fname,const vector<Mesh> & meshes)
         saveStl(ff,meshes[ii]);
 }
 
+namespace {
+
+// Welds STL vertices by exact bit pattern, which is what STL writers produce for shared vertices:
+struct  WeldKey
+{
+    uint32      bits[3];
+
+    bool
+    operator==(WeldKey const & rhs) const
+    {return ((bits[0] == rhs.bits[0]) && (bits[1] == rhs.bits[1]) && (bits[2] == rhs.bits[2])); }
+};
+
+struct  WeldHash
+{
+    size_t
+    operator()(WeldKey const & key) const
+    {
+        uint64      h = key.bits[0];
+        h = h * 0x9E3779B97F4A7C15ULL ^ key.bits[1];
+        h = h * 0x9E3779B97F4A7C15ULL ^ key.bits[2];
+        return size_t(h ^ (h >> 29));
+    }
+};
+
+struct  Welder
+{
+    Vec3Fs &                                    verts;
+    std::unordered_map<WeldKey,uint,WeldHash>   map;
+
+    Welder(Vec3Fs & v,size_t numTris) : verts(v)
+    {
+        // Closed manifold meshes have roughly half as many verts as tris:
+        map.reserve(numTris/2+1);
+        verts.reserve(numTris/2+1);
+    }
+
+    uint
+    operator()(Vec3F pos)
+    {
+        WeldKey     key;
+        memcpy(key.bits,&pos[0],12);
+        auto        it = map.find(key);
+        if (it != map.end())
+            return it->second;
+        uint        idx = uint(verts.size());
+        map[key] = idx;
+        verts.push_back(pos);
+        return idx;
+    }
+};
+
+}
+
+Mesh
+loadStl(Ustring const & fname)
+{
+    Mesh            ret;
+    Vec3UIs         tris;
+    String          data = fgSlurp(fname);
+    uint32          numTris = 0;
+    if (data.size() >= 84)
+        memcpy(&numTris,&data[80],4);
+    if ((data.size() >= 84) && (data.size() == 84 + size_t(numTris)*50)) {
+        Welder          weld(ret.verts,numTris);
+        tris.resize(numTris);
+        char const *    ptr = data.data() + 84;
+        for (size_t tt=0; tt<numTris; ++tt,ptr+=50) {
+            Vec3F           vs[3];
+            memcpy(&vs[0][0],ptr+12,12);        // Skip normal
+            memcpy(&vs[1][0],ptr+24,12);
+            memcpy(&vs[2][0],ptr+36,12);
+            for (uint ii=0; ii<3; ++ii)
+                tris[tt][ii] = weld(vs[ii]);
+        }
+    }
+    else if (fgBeginsWith(data,"solid")) {         // ASCII
+        istringstream   iss(data);
+        Welder          weld(ret.verts,data.size()/256);
+        String          word;
+        Svec<uint>      facet;
+        while (iss >> word) {
+            if (word == "vertex") {
+                Vec3F       pos;
+                iss >> pos[0] >> pos[1] >> pos[2];
+                facet.push_back(weld(pos));
+            }
+            else if (word == "endfacet") {
+                // Any polygons are converted to tri fans:
+                for (size_t ii=1; ii+1<facet.size(); ++ii)
+                    tris.push_back(Vec3UI(facet[0],facet[ii],facet[ii+1]));
+                facet.clear();
+            }
+        }
+    }
+    else
+        fgThrow("Invalid STL file",fname);
+    ret.surfaces.push_back(Surf(tris));
+    return ret;
+}
+
+void
+fgLoadStlTest(const CLArgs & args)
+{
+    FGTESTDIR
+    Mesh                mouth = loadTri(dataDir()+"base/Mouth.tri");
+    saveStl("mouth.stl",fgSvec(mouth));
+    Mesh                stl = loadStl("mouth.stl");
+    Tris                orig = mouth.getTriEquivs(),
+                        tris = stl.getTriEquivs();
+    FGASSERT(tris.size() == orig.size());
+    FGASSERT(stl.verts.size() <= mouth.verts.size());
+    for (size_t tt=0; tt<tris.size(); ++tt)
+        for (uint ii=0; ii<3; ++ii)
+            FGASSERT(stl.verts[tris.vertInds[tt][ii]] == mouth.verts[orig.vertInds[tt][ii]]);
+}
+
 }
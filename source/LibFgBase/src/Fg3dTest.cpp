@@ -161,6 +161,10 @@ void fgSaveDaeTest(CLArgs const &);
 void fgSaveObjTest(CLArgs const &);
 void fgSavePlyTest(CLArgs const &);
 void fgSaveXsiTest(CLArgs const &);
+void fgLoadPlyTest(CLArgs const &);
+void fgLoadStlTest(CLArgs const &);
+void fgLoadFbxTest(CLArgs const &);
+void fgMeshPrefetchTest(CLArgs const &);
 
 void
 fg3dTest(const CLArgs & args)
@@ -169,6 +173,10 @@ fg3dTest(const CLArgs & args)
     cmds.push_back(Cmd(fgSave3dsTest,"3ds",".3DS file format export"));
     cmds.push_back(Cmd(fgSaveLwoTest,"lwo","Lightwve object file format export"));
     cmds.push_back(Cmd(fgSaveMaTest,"ma","Maya ASCII file format export"));
+    cmds.push_back(Cmd(fgLoadPlyTest,"plyLoad",".PLY file format ASCII and binary round trip"));
+    cmds.push_back(Cmd(fgLoadStlTest,"stlLoad",".STL file format round trip"));
+    cmds.push_back(Cmd(fgLoadFbxTest,"fbxLoad","Binary .FBX file format round trip"));
+    cmds.push_back(Cmd(fgMeshPrefetchTest,"prefetch","Background mesh loading in order under a memory budget"));
     // Precision differences in float->string causes endless problems not just in different compilers
     // and configs, but even base lib vs main lib with same WTF:
     if (fgOverwriteBaselines()) {
@@ -0,0 +1,432 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Batch transforms of 3D points. Each SIMD lane holds one point, so packed (x,y,z) input is
+// de-interleaved into registers of x, y and z values, transformed, and re-interleaved.
+//
+
+#include "stdafx.h"
+
+#include "FgAffineC.hpp"
+#include "FgParallel.hpp"
+#include "FgSimd.hpp"
+
+using namespace std;
+
+namespace Fg {
+
+namespace {
+
+static_assert(sizeof(Vec3F) == 3*sizeof(float),"Vec3F must be packed");
+
+// Row-major 4x4 homogeneous transform. The bottom row is ignored unless projective:
+struct  Xf
+{
+    float           m[4][4];
+    bool            proj;
+};
+
+Xf
+toXf(Affine3F const & a)
+{
+    Xf              ret;
+    for (uint rr=0; rr<3; ++rr) {
+        for (uint cc=0; cc<3; ++cc)
+            ret.m[rr][cc] = a.linear.rc(rr,cc);
+        ret.m[rr][3] = a.translation[rr];
+    }
+    ret.m[3][0] = ret.m[3][1] = ret.m[3][2] = 0.0f;
+    ret.m[3][3] = 1.0f;
+    ret.proj = false;
+    return ret;
+}
+
+Xf
+toXf(Mat44F const & h)
+{
+    Xf              ret;
+    for (uint rr=0; rr<4; ++rr)
+        for (uint cc=0; cc<4; ++cc)
+            ret.m[rr][cc] = h.rc(rr,cc);
+    ret.proj = true;
+    return ret;
+}
+
+inline void
+xfScalar(Xf const & xf,float x,float y,float z,float & ox,float & oy,float & oz)
+{
+    float const (&m)[4][4] = xf.m;
+    float           rx = m[0][0]*x + m[0][1]*y + m[0][2]*z + m[0][3],
+                    ry = m[1][0]*x + m[1][1]*y + m[1][2]*z + m[1][3],
+                    rz = m[2][0]*x + m[2][1]*y + m[2][2]*z + m[2][3];
+    if (xf.proj) {
+        float           w = 1.0f / (m[3][0]*x + m[3][1]*y + m[3][2]*z + m[3][3]);
+        rx *= w;
+        ry *= w;
+        rz *= w;
+    }
+    ox = rx;
+    oy = ry;
+    oz = rz;
+}
+
+#ifdef FG_SSE2
+
+// 4 packed points in 'a','b','c' <-> x, y and z of each:
+
+#define FG_SEL(i0,i1,j0,j1) _MM_SHUFFLE(j1,j0,i1,i0)
+
+inline void
+deinterleave(__m128 a,__m128 b,__m128 c,__m128 & x,__m128 & y,__m128 & z)
+{
+    __m128          u = _mm_shuffle_ps(b,c,FG_SEL(2,3,1,2)),    // b2 b3 c1 c2
+                    v = _mm_shuffle_ps(a,b,FG_SEL(1,2,0,1)),    // a1 a2 b0 b1
+                    w = _mm_shuffle_ps(b,c,FG_SEL(0,1,0,3));    // b0 b1 c0 c3
+    x = _mm_shuffle_ps(a,u,FG_SEL(0,3,0,2));
+    y = _mm_shuffle_ps(v,u,FG_SEL(0,2,1,3));
+    z = _mm_shuffle_ps(v,w,FG_SEL(1,3,2,3));
+}
+
+inline void
+interleave(__m128 x,__m128 y,__m128 z,__m128 & a,__m128 & b,__m128 & c)
+{
+    __m128          xy01 = _mm_shuffle_ps(x,y,FG_SEL(0,1,0,1)),
+                    zx01 = _mm_shuffle_ps(z,x,FG_SEL(0,1,0,1)),
+                    yz12 = _mm_shuffle_ps(y,z,FG_SEL(1,2,1,2)),
+                    xy23 = _mm_shuffle_ps(x,y,FG_SEL(2,3,2,3)),
+                    zx23 = _mm_shuffle_ps(z,x,FG_SEL(2,3,2,3)),
+                    yz23 = _mm_shuffle_ps(y,z,FG_SEL(2,3,2,3));
+    a = _mm_shuffle_ps(xy01,zx01,FG_SEL(0,2,0,3));
+    b = _mm_shuffle_ps(yz12,xy23,FG_SEL(0,2,0,2));
+    c = _mm_shuffle_ps(zx23,yz23,FG_SEL(0,3,1,3));
+}
+
+inline __m128
+dot128(float const * r,__m128 x,__m128 y,__m128 z)
+{
+    return _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(r[0]),x),_mm_mul_ps(_mm_set1_ps(r[1]),y)),
+        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(r[2]),z),_mm_set1_ps(r[3])));
+}
+
+inline void
+xf128(Xf const & xf,__m128 & x,__m128 & y,__m128 & z)
+{
+    __m128          rx = dot128(xf.m[0],x,y,z),
+                    ry = dot128(xf.m[1],x,y,z),
+                    rz = dot128(xf.m[2],x,y,z);
+    if (xf.proj) {
+        __m128          w = _mm_div_ps(_mm_set1_ps(1.0f),dot128(xf.m[3],x,y,z));
+        rx = _mm_mul_ps(rx,w);
+        ry = _mm_mul_ps(ry,w);
+        rz = _mm_mul_ps(rz,w);
+    }
+    x = rx;
+    y = ry;
+    z = rz;
+}
+
+size_t
+xfPacked128(Xf const & xf,float const * in,float * out,size_t num)
+{
+    size_t          ii = 0;
+    for (; ii+4<=num; ii+=4) {
+        __m128          x,y,z;
+        deinterleave(_mm_loadu_ps(in+ii*3),_mm_loadu_ps(in+ii*3+4),_mm_loadu_ps(in+ii*3+8),x,y,z);
+        xf128(xf,x,y,z);
+        __m128          a,b,c;
+        interleave(x,y,z,a,b,c);
+        _mm_storeu_ps(out+ii*3,a);
+        _mm_storeu_ps(out+ii*3+4,b);
+        _mm_storeu_ps(out+ii*3+8,c);
+    }
+    return ii;
+}
+
+size_t
+xfSoa128(Xf const & xf,float const * const in[3],float * const out[3],size_t num)
+{
+    size_t          ii = 0;
+    for (; ii+4<=num; ii+=4) {
+        __m128          x = _mm_loadu_ps(in[0]+ii),
+                        y = _mm_loadu_ps(in[1]+ii),
+                        z = _mm_loadu_ps(in[2]+ii);
+        xf128(xf,x,y,z);
+        _mm_storeu_ps(out[0]+ii,x);
+        _mm_storeu_ps(out[1]+ii,y);
+        _mm_storeu_ps(out[2]+ii,z);
+    }
+    return ii;
+}
+
+#endif
+
+#ifdef FG_AVX2
+
+// As above with points 0-3 in the low lanes and 4-7 in the high lanes, since the shuffles are per lane:
+
+FG_TARGET_AVX2_FMA
+inline __m256
+load2(float const * lo,float const * hi)
+{return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lo)),_mm_loadu_ps(hi),1); }
+
+FG_TARGET_AVX2_FMA
+inline void
+store2(float * lo,float * hi,__m256 v)
+{
+    _mm_storeu_ps(lo,_mm256_castps256_ps128(v));
+    _mm_storeu_ps(hi,_mm256_extractf128_ps(v,1));
+}
+
+FG_TARGET_AVX2_FMA
+inline void
+deinterleave(__m256 a,__m256 b,__m256 c,__m256 & x,__m256 & y,__m256 & z)
+{
+    __m256          u = _mm256_shuffle_ps(b,c,FG_SEL(2,3,1,2)),
+                    v = _mm256_shuffle_ps(a,b,FG_SEL(1,2,0,1)),
+                    w = _mm256_shuffle_ps(b,c,FG_SEL(0,1,0,3));
+    x = _mm256_shuffle_ps(a,u,FG_SEL(0,3,0,2));
+    y = _mm256_shuffle_ps(v,u,FG_SEL(0,2,1,3));
+    z = _mm256_shuffle_ps(v,w,FG_SEL(1,3,2,3));
+}
+
+FG_TARGET_AVX2_FMA
+inline void
+interleave(__m256 x,__m256 y,__m256 z,__m256 & a,__m256 & b,__m256 & c)
+{
+    __m256          xy01 = _mm256_shuffle_ps(x,y,FG_SEL(0,1,0,1)),
+                    zx01 = _mm256_shuffle_ps(z,x,FG_SEL(0,1,0,1)),
+                    yz12 = _mm256_shuffle_ps(y,z,FG_SEL(1,2,1,2)),
+                    xy23 = _mm256_shuffle_ps(x,y,FG_SEL(2,3,2,3)),
+                    zx23 = _mm256_shuffle_ps(z,x,FG_SEL(2,3,2,3)),
+                    yz23 = _mm256_shuffle_ps(y,z,FG_SEL(2,3,2,3));
+    a = _mm256_shuffle_ps(xy01,zx01,FG_SEL(0,2,0,3));
+    b = _mm256_shuffle_ps(yz12,xy23,FG_SEL(0,2,0,2));
+    c = _mm256_shuffle_ps(zx23,yz23,FG_SEL(0,3,1,3));
+}
+
+FG_TARGET_AVX2_FMA
+inline __m256
+dot256(float const * r,__m256 x,__m256 y,__m256 z)
+{
+    return _mm256_fmadd_ps(_mm256_set1_ps(r[0]),x,
+        _mm256_fmadd_ps(_mm256_set1_ps(r[1]),y,
+        _mm256_fmadd_ps(_mm256_set1_ps(r[2]),z,_mm256_set1_ps(r[3]))));
+}
+
+FG_TARGET_AVX2_FMA
+inline void
+xf256(Xf const & xf,__m256 & x,__m256 & y,__m256 & z)
+{
+    __m256          rx = dot256(xf.m[0],x,y,z),
+                    ry = dot256(xf.m[1],x,y,z),
+                    rz = dot256(xf.m[2],x,y,z);
+    if (xf.proj) {
+        __m256          w = _mm256_div_ps(_mm256_set1_ps(1.0f),dot256(xf.m[3],x,y,z));
+        rx = _mm256_mul_ps(rx,w);
+        ry = _mm256_mul_ps(ry,w);
+        rz = _mm256_mul_ps(rz,w);
+    }
+    x = rx;
+    y = ry;
+    z = rz;
+}
+
+FG_TARGET_AVX2_FMA
+size_t
+xfPackedAvx2(Xf const & xf,float const * in,float * out,size_t num)
+{
+    size_t          ii = 0;
+    for (; ii+8<=num; ii+=8) {
+        float const *   p = in + ii*3;
+        __m256          x,y,z;
+        deinterleave(load2(p,p+12),load2(p+4,p+16),load2(p+8,p+20),x,y,z);
+        xf256(xf,x,y,z);
+        __m256          a,b,c;
+        interleave(x,y,z,a,b,c);
+        float *         q = out + ii*3;
+        store2(q,q+12,a);
+        store2(q+4,q+16,b);
+        store2(q+8,q+20,c);
+    }
+    return ii;
+}
+
+FG_TARGET_AVX2_FMA
+size_t
+xfSoaAvx2(Xf const & xf,float const * const in[3],float * const out[3],size_t num)
+{
+    size_t          ii = 0;
+    for (; ii+8<=num; ii+=8) {
+        __m256          x = _mm256_loadu_ps(in[0]+ii),
+                        y = _mm256_loadu_ps(in[1]+ii),
+                        z = _mm256_loadu_ps(in[2]+ii);
+        xf256(xf,x,y,z);
+        _mm256_storeu_ps(out[0]+ii,x);
+        _mm256_storeu_ps(out[1]+ii,y);
+        _mm256_storeu_ps(out[2]+ii,z);
+    }
+    return ii;
+}
+
+#endif
+
+#ifdef FG_SSE2
+#undef FG_SEL
+#endif
+
+#ifdef FG_NEON
+
+inline float32x4_t
+dot128(float const * r,float32x4_t x,float32x4_t y,float32x4_t z)
+{return vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(r[3]),x,r[0]),y,r[1]),z,r[2]); }
+
+inline void
+xf128(Xf const & xf,float32x4_t & x,float32x4_t & y,float32x4_t & z)
+{
+    float32x4_t     rx = dot128(xf.m[0],x,y,z),
+                    ry = dot128(xf.m[1],x,y,z),
+                    rz = dot128(xf.m[2],x,y,z);
+    if (xf.proj) {
+        // Reciprocal estimate plus two Newton-Raphson steps is accurate to float precision:
+        float32x4_t     d = dot128(xf.m[3],x,y,z),
+                        w = vrecpeq_f32(d);
+        w = vmulq_f32(vrecpsq_f32(d,w),w);
+        w = vmulq_f32(vrecpsq_f32(d,w),w);
+        rx = vmulq_f32(rx,w);
+        ry = vmulq_f32(ry,w);
+        rz = vmulq_f32(rz,w);
+    }
+    x = rx;
+    y = ry;
+    z = rz;
+}
+
+size_t
+xfPacked128(Xf const & xf,float const * in,float * out,size_t num)
+{
+    size_t          ii = 0;
+    for (; ii+4<=num; ii+=4) {
+        float32x4x3_t   p = vld3q_f32(in+ii*3);         // De-interleaves
+        xf128(xf,p.val[0],p.val[1],p.val[2]);
+        vst3q_f32(out+ii*3,p);
+    }
+    return ii;
+}
+
+size_t
+xfSoa128(Xf const & xf,float const * const in[3],float * const out[3],size_t num)
+{
+    size_t          ii = 0;
+    for (; ii+4<=num; ii+=4) {
+        float32x4_t     x = vld1q_f32(in[0]+ii),
+                        y = vld1q_f32(in[1]+ii),
+                        z = vld1q_f32(in[2]+ii);
+        xf128(xf,x,y,z);
+        vst1q_f32(out[0]+ii,x);
+        vst1q_f32(out[1]+ii,y);
+        vst1q_f32(out[2]+ii,z);
+    }
+    return ii;
+}
+
+#endif
+
+void
+xfPacked(Xf const & xf,float const * in,float * out,size_t num,Simd simd)
+{
+    size_t          ii = 0;
+#ifdef FG_AVX2
+    if (simd == Simd::avx2)
+        ii = xfPackedAvx2(xf,in,out,num);
+#endif
+#if defined(FG_SSE2) || defined(FG_NEON)
+    if (simd >= Simd::vec128)
+        ii += xfPacked128(xf,in+ii*3,out+ii*3,num-ii);
+#endif
+    (void)simd;
+    for (; ii<num; ++ii)
+        xfScalar(xf,in[ii*3],in[ii*3+1],in[ii*3+2],out[ii*3],out[ii*3+1],out[ii*3+2]);
+}
+
+void
+xfSoa(Xf const & xf,float const * const in[3],float * const out[3],size_t num,Simd simd)
+{
+    size_t          ii = 0;
+#ifdef FG_AVX2
+    if (simd == Simd::avx2)
+        ii = xfSoaAvx2(xf,in,out,num);
+#endif
+#if defined(FG_SSE2) || defined(FG_NEON)
+    if (simd >= Simd::vec128) {
+        float const *   in2[3] = {in[0]+ii,in[1]+ii,in[2]+ii};
+        float *         out2[3] = {out[0]+ii,out[1]+ii,out[2]+ii};
+        ii += xfSoa128(xf,in2,out2,num-ii);
+    }
+#endif
+    (void)simd;
+    for (; ii<num; ++ii)
+        xfScalar(xf,in[0][ii],in[1][ii],in[2][ii],out[0][ii],out[1][ii],out[2][ii]);
+}
+
+// Thread start-up is only worthwhile for large arrays:
+size_t constexpr    s_minBlock = 1 << 15;
+
+void
+xfPackedPar(Xf const & xf,Vec3F const * in,Vec3F * out,size_t num)
+{
+    Simd            simd = simdLevel();
+    float const *   pi = &in[0][0];
+    float *         po = &out[0][0];
+    if (num < 2*s_minBlock)
+        xfPacked(xf,pi,po,num,simd);
+    else
+        parallelForBlocks(num,s_minBlock,[&](size_t lo,size_t hi)
+        {xfPacked(xf,pi+lo*3,po+lo*3,hi-lo,simd); });
+}
+
+}
+
+void
+affineXf_(Affine3F const & xf,Vec3F const * in,Vec3F * out,size_t num)
+{
+    if (num > 0)
+        xfPackedPar(toXf(xf),in,out,num);
+}
+
+void
+affineXfSoa_(Affine3F const & xf,float const * const in[3],float * const out[3],size_t num)
+{
+    Xf              x = toXf(xf);
+    Simd            simd = simdLevel();
+    if (num < 2*s_minBlock)
+        xfSoa(x,in,out,num,simd);
+    else
+        parallelForBlocks(num,s_minBlock,[&](size_t lo,size_t hi)
+        {
+            float const *   in2[3] = {in[0]+lo,in[1]+lo,in[2]+lo};
+            float *         out2[3] = {out[0]+lo,out[1]+lo,out[2]+lo};
+            xfSoa(x,in2,out2,hi-lo,simd);
+        });
+}
+
+void
+projectXf_(Mat44F const & xf,Vec3F const * in,Vec3F * out,size_t num)
+{
+    if (num > 0)
+        xfPackedPar(toXf(xf),in,out,num);
+}
+
+Vec3Fs
+projectXf(Mat44F const & xf,Vec3Fs const & pts)
+{
+    Vec3Fs          ret(pts.size());
+    projectXf_(xf,pts.data(),ret.data(),pts.size());
+    return ret;
+}
+
+}
+
+// */
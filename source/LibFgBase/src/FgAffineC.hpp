@@ -153,6 +153,51 @@ operator<<(std::ostream & os,const Affine<T,dim> & v)
             << fgnl << " Translation: " << v.translation;
 }
 
+// Batch transforms of points using SIMD (see FgSimd.hpp), across threads for large arrays.
+// 'in' and 'out' can be the same array:
+void
+affineXf_(Affine3F const & xf,Vec3F const * in,Vec3F * out,size_t num);
+
+// As above for structure-of-arrays point streams, with arrays of X, Y and Z values:
+void
+affineXfSoa_(Affine3F const & xf,float const * const in[3],float * const out[3],size_t num);
+
+// Projective transform of points with homogeneous divide:
+void
+projectXf_(Mat44F const & xf,Vec3F const * in,Vec3F * out,size_t num);
+
+Vec3Fs
+projectXf(Mat44F const & xf,Vec3Fs const & pts);
+
+// Overloads of the generic 'mapXft' and 'mapXf_' (FgStdVector.hpp) which use the above:
+
+inline Vec3Fs
+mapXft(Vec3Fs const & in,Affine3F const & xf)
+{
+    Vec3Fs          ret(in.size());
+    affineXf_(xf,in.data(),ret.data(),in.size());
+    return ret;
+}
+
+inline Vec3Fs
+mapXft(Vec3Fs const & in,Mat33F const & xf)
+{return mapXft(in,Affine3F(xf)); }
+
+inline void
+mapXf_(Vec3Fs const & in,Affine3F const & xf,Vec3Fs & out)
+{
+    out.resize(in.size());
+    affineXf_(xf,in.data(),out.data(),in.size());
+}
+
+inline void
+mapXf_(Vec3Fs & data,Affine3F const & xf)
+{affineXf_(xf,data.data(),data.data(),data.size()); }
+
+inline void
+mapXf_(Vec3Fs & data,Mat33F const & xf)
+{mapXf_(data,Affine3F(xf)); }
+
 }
 
 #endif
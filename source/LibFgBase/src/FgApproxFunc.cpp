@@ -7,6 +7,7 @@
 #include "stdafx.h"
 
 #include "FgApproxFunc.hpp"
+#include "FgSimd.hpp"
 #include "FgRandom.hpp"
 #include "FgMath.hpp"
 #include "FgMain.hpp"
@@ -15,6 +16,585 @@ using namespace std;
 
 namespace Fg {
 
+namespace {
+
+template<class T>
+void
+lutScalar(Svec<T> const & lut,T base,T scale,T const * in,T * out,size_t num)
+{
+    FGASSERT(lut.size() > 1);
+    T               hi = T(lut.size()-1);
+    int             idxMax = int(lut.size()) - 2;
+    for (size_t ii=0; ii<num; ++ii) {
+        T               v = std::min(std::max(scale * (in[ii] - base),T(0)),hi);
+        int             idx = std::min(int(v),idxMax);
+        T               w = v - T(idx),
+                        lo = lut[idx];
+        out[ii] = lo + w * (lut[idx+1] - lo);
+    }
+}
+
+#ifdef FG_AVX2
+
+FG_TARGET_AVX2_FMA
+size_t
+lutAvx2(Floats const & lut,float base,float scale,float const * in,float * out,size_t num)
+{
+    __m256          b = _mm256_set1_ps(base),
+                    s = _mm256_set1_ps(scale),
+                    hi = _mm256_set1_ps(float(lut.size()-1));
+    __m256i         idxMax = _mm256_set1_epi32(int(lut.size())-2);
+    float const *   lut0 = lut.data();
+    size_t          ii = 0;
+    for (; ii+8<=num; ii+=8) {
+        __m256          v = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(in+ii),b),s);
+        v = _mm256_min_ps(_mm256_max_ps(v,_mm256_setzero_ps()),hi);
+        __m256i         idx = _mm256_min_epi32(_mm256_cvttps_epi32(v),idxMax);
+        __m256          w = _mm256_sub_ps(v,_mm256_cvtepi32_ps(idx)),
+                        lo = _mm256_i32gather_ps(lut0,idx,4),
+                        up = _mm256_i32gather_ps(lut0+1,idx,4);
+        _mm256_storeu_ps(out+ii,_mm256_fmadd_ps(w,_mm256_sub_ps(up,lo),lo));
+    }
+    return ii;
+}
+
+#endif
+
+enum struct Op {exp, log, pow, rsqrt, sin, cos};
+
+// Polynomial coefficients and range reduction constants are those of the Cephes single precision
+// library (expf, logf, sinf, cosf). Range reduction constants are split into an exactly representable
+// high part and a low part so that the reduced argument retains full precision:
+
+float constexpr     s_expHi = 88.72283f,        // Largest argument with a finite result
+                    s_expLo = -103.9f,          // Result rounds to zero below this
+                    s_log2e = 1.44269504088896341f,
+                    s_ln2Hi = 0.693359375f,
+                    s_ln2Lo = -2.12194440e-4f,
+                    s_sqrtHalf = 0.707106781186547524f,
+                    s_4OnPi = 1.27323954473516f,
+                    s_piOn4a = 0.78515625f,
+                    s_piOn4b = 2.4187564849853515625e-4f,
+                    s_piOn4c = 3.77489497744594108e-8f;
+
+// Scalar versions of the vector operations, so that the kernels below give the same results at every
+// SIMD level and for the remainder of arrays not a multiple of the vector width. Using libm here
+// instead would give the compiler's choice of implementation (eg. libmvec when auto-vectorized),
+// whose error can exceed the bounds documented for these functions. Comparisons return all-ones
+// bit masks as for the vector versions:
+
+struct  V1
+{
+    typedef float       F;
+    typedef int32       I;
+    static size_t constexpr width = 1;
+
+    static F asF(I v) {F r; memcpy(&r,&v,4); return r; }
+    static I asI(F v) {I r; memcpy(&r,&v,4); return r; }
+    static F mask(bool b) {return asF(b ? -1 : 0); }
+
+    static F load(float const * p) {return *p; }
+    static void store(float * p,F v) {*p = v; }
+    static F set(float v) {return v; }
+    static I seti(int v) {return v; }
+    static F add(F a,F b) {return a + b; }
+    static F sub(F a,F b) {return a - b; }
+    static F mul(F a,F b) {return a * b; }
+    static F madd(F a,F b,F c) {return a*b + c; }
+    static F min(F a,F b) {return (b < a) ? b : a; }
+    static F max(F a,F b) {return (b > a) ? b : a; }
+    static I round(F v) {return I(std::floor(v + 0.5f)); }
+    static I trunc(F v) {return I(v); }
+    static F toF(I v) {return F(v); }
+    static I addi(I a,I b) {return a + b; }
+    static I subi(I a,I b) {return a - b; }
+    static I andi(I a,I b) {return a & b; }
+    static I ori(I a,I b) {return a | b; }
+    template<int n> static I shl(I v) {return I(uint32(v) << n); }
+    template<int n> static I shr(I v) {return I(uint32(v) >> n); }
+    template<int n> static I sra(I v) {return (v < 0) ? ~(~v >> n) : (v >> n); }
+    static F lt(F a,F b) {return mask(a < b); }
+    static F gt(F a,F b) {return mask(a > b); }
+    static F eq(F a,F b) {return mask(a == b); }
+    static F eqi(I a,I b) {return mask(a == b); }
+    static F sel(F m,F a,F b) {return asF((asI(m) & asI(a)) | (~asI(m) & asI(b))); }
+    static F andF(F a,F b) {return asF(asI(a) & asI(b)); }
+    static F xorF(F a,F b) {return asF(asI(a) ^ asI(b)); }
+    static F keep(F v)
+    {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        __asm__("" : "+x"(v));
+#elif defined(__GNUC__) && defined(__aarch64__)
+        __asm__("" : "+w"(v));
+#elif defined(__GNUC__)
+        __asm__("" : "+m"(v));
+#endif
+        return v;
+    }
+    static F rsqrt(F x) {return 1.0f / std::sqrt(x); }
+};
+
+// 128-bit vector operations for the templated kernels below. The NEON and SSE2 versions must match:
+
+#ifdef FG_SSE2
+
+struct  V4
+{
+    typedef __m128      F;
+    typedef __m128i     I;
+    static size_t constexpr width = 4;
+
+    static F load(float const * p) {return _mm_loadu_ps(p); }
+    static void store(float * p,F v) {_mm_storeu_ps(p,v); }
+    static F set(float v) {return _mm_set1_ps(v); }
+    static I seti(int v) {return _mm_set1_epi32(v); }
+    static F add(F a,F b) {return _mm_add_ps(a,b); }
+    static F sub(F a,F b) {return _mm_sub_ps(a,b); }
+    static F mul(F a,F b) {return _mm_mul_ps(a,b); }
+    static F madd(F a,F b,F c) {return _mm_add_ps(_mm_mul_ps(a,b),c); }    // a*b + c
+    static F min(F a,F b) {return _mm_min_ps(a,b); }
+    static F max(F a,F b) {return _mm_max_ps(a,b); }
+    static I round(F v) {return _mm_cvtps_epi32(v); }       // Default rounding mode is nearest
+    static I trunc(F v) {return _mm_cvttps_epi32(v); }
+    static F toF(I v) {return _mm_cvtepi32_ps(v); }
+    static I addi(I a,I b) {return _mm_add_epi32(a,b); }
+    static I subi(I a,I b) {return _mm_sub_epi32(a,b); }
+    static I andi(I a,I b) {return _mm_and_si128(a,b); }
+    static I ori(I a,I b) {return _mm_or_si128(a,b); }
+    template<int n> static I shl(I v) {return _mm_slli_epi32(v,n); }
+    template<int n> static I shr(I v) {return _mm_srli_epi32(v,n); }
+    template<int n> static I sra(I v) {return _mm_srai_epi32(v,n); }
+    static F asF(I v) {return _mm_castsi128_ps(v); }
+    static I asI(F v) {return _mm_castps_si128(v); }
+    // Comparisons return lane masks:
+    static F lt(F a,F b) {return _mm_cmplt_ps(a,b); }
+    static F gt(F a,F b) {return _mm_cmpgt_ps(a,b); }
+    static F eq(F a,F b) {return _mm_cmpeq_ps(a,b); }
+    static F eqi(I a,I b) {return _mm_castsi128_ps(_mm_cmpeq_epi32(a,b)); }
+    static F sel(F m,F a,F b) {return _mm_or_ps(_mm_and_ps(m,a),_mm_andnot_ps(m,b)); }
+    static F andF(F a,F b) {return _mm_and_ps(a,b); }
+    static F xorF(F a,F b) {return _mm_xor_ps(a,b); }
+    // gcc implements these intrinsics as generic vector arithmetic, so -ffast-math may re-associate
+    // the split range reductions and lose their precision. This hides the value from the optimizer:
+    static F keep(F v)
+    {
+#ifdef __GNUC__
+        __asm__("" : "+x"(v));
+#endif
+        return v;
+    }
+    // The estimate has 12 bits of precision, one Newton-Raphson step brings it to 23:
+    static F rsqrt(F x)
+    {
+        F               y = _mm_rsqrt_ps(x);
+        return mul(y,sub(set(1.5f),mul(mul(set(0.5f),x),mul(y,y))));
+    }
+};
+
+#endif
+
+#ifdef FG_NEON
+
+struct  V4
+{
+    typedef float32x4_t F;
+    typedef int32x4_t   I;
+    static size_t constexpr width = 4;
+
+    static F load(float const * p) {return vld1q_f32(p); }
+    static void store(float * p,F v) {vst1q_f32(p,v); }
+    static F set(float v) {return vdupq_n_f32(v); }
+    static I seti(int v) {return vdupq_n_s32(v); }
+    static F add(F a,F b) {return vaddq_f32(a,b); }
+    static F sub(F a,F b) {return vsubq_f32(a,b); }
+    static F mul(F a,F b) {return vmulq_f32(a,b); }
+    static F madd(F a,F b,F c) {return vmlaq_f32(c,a,b); }
+    static F min(F a,F b) {return vminq_f32(a,b); }
+    static F max(F a,F b) {return vmaxq_f32(a,b); }
+    static I round(F v)                                     // Half away from zero
+    {
+        uint32x4_t      sgn = vandq_u32(vreinterpretq_u32_f32(v),vdupq_n_u32(0x80000000U));
+        F               half = vreinterpretq_f32_u32(vorrq_u32(sgn,vreinterpretq_u32_f32(set(0.5f))));
+        return vcvtq_s32_f32(vaddq_f32(v,half));
+    }
+    static I trunc(F v) {return vcvtq_s32_f32(v); }
+    static F toF(I v) {return vcvtq_f32_s32(v); }
+    static I addi(I a,I b) {return vaddq_s32(a,b); }
+    static I subi(I a,I b) {return vsubq_s32(a,b); }
+    static I andi(I a,I b) {return vandq_s32(a,b); }
+    static I ori(I a,I b) {return vorrq_s32(a,b); }
+    template<int n> static I shl(I v) {return vshlq_n_s32(v,n); }
+    template<int n> static I shr(I v) {return vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(v),n)); }
+    template<int n> static I sra(I v) {return vshrq_n_s32(v,n); }
+    static F asF(I v) {return vreinterpretq_f32_s32(v); }
+    static I asI(F v) {return vreinterpretq_s32_f32(v); }
+    static F lt(F a,F b) {return vreinterpretq_f32_u32(vcltq_f32(a,b)); }
+    static F gt(F a,F b) {return vreinterpretq_f32_u32(vcgtq_f32(a,b)); }
+    static F eq(F a,F b) {return vreinterpretq_f32_u32(vceqq_f32(a,b)); }
+    static F eqi(I a,I b) {return vreinterpretq_f32_u32(vceqq_s32(a,b)); }
+    static F sel(F m,F a,F b) {return vbslq_f32(vreinterpretq_u32_f32(m),a,b); }
+    static F andF(F a,F b) {return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a),vreinterpretq_u32_f32(b))); }
+    static F xorF(F a,F b) {return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a),vreinterpretq_u32_f32(b))); }
+    static F keep(F v)
+    {
+#ifdef __GNUC__
+        __asm__("" : "+w"(v));
+#endif
+        return v;
+    }
+    // The estimate has 8 bits of precision, two Newton-Raphson steps bring it to 23:
+    static F rsqrt(F x)
+    {
+        F               y = vrsqrteq_f32(x);
+        y = vmulq_f32(y,vrsqrtsq_f32(vmulq_f32(x,y),y));
+        return vmulq_f32(y,vrsqrtsq_f32(vmulq_f32(x,y),y));
+    }
+};
+
+#endif
+
+template<class V>
+typename V::F
+expV(typename V::F x)
+{
+    typedef typename V::F   F;
+    typedef typename V::I   I;
+    F               xc = V::min(V::max(x,V::set(s_expLo)),V::set(s_expHi));
+    I               n = V::round(V::mul(xc,V::set(s_log2e)));
+    F               fn = V::toF(n),
+                    r = V::keep(V::madd(fn,V::set(-s_ln2Hi),xc));
+    r = V::keep(V::madd(fn,V::set(-s_ln2Lo),r));
+    F               r2 = V::mul(r,r),
+                    p = V::set(1.9875691500e-4f);
+    p = V::madd(p,r,V::set(1.3981999507e-3f));
+    p = V::madd(p,r,V::set(8.3334519073e-3f));
+    p = V::madd(p,r,V::set(4.1665795894e-2f));
+    p = V::madd(p,r,V::set(1.6666665459e-1f));
+    p = V::madd(p,r,V::set(5.0000001201e-1f));
+    p = V::madd(p,r2,V::add(r,V::set(1.0f)));
+    // Scale by 2^n in two steps since 'n' spans the subnormal to overflow range [-150,128]:
+    I               n1 = V::template sra<1>(n),
+                    n2 = V::subi(n,n1),
+                    bias = V::seti(127);
+    p = V::mul(p,V::asF(V::template shl<23>(V::addi(n1,bias))));
+    p = V::mul(p,V::asF(V::template shl<23>(V::addi(n2,bias))));
+    return V::sel(V::gt(x,V::set(s_expHi)),V::set(numeric_limits<float>::infinity()),p);
+}
+
+template<class V>
+typename V::F
+logV(typename V::F x)
+{
+    typedef typename V::F   F;
+    typedef typename V::I   I;
+    // Split into exponent and mantissa in [0.5,1), then shift the mantissa range to [sqrt(0.5),sqrt(2)):
+    I               bits = V::asI(V::max(x,V::set(numeric_limits<float>::min()))),
+                    e = V::subi(V::template shr<23>(bits),V::seti(126));
+    F               m = V::asF(V::ori(V::andi(bits,V::seti(0x007FFFFF)),V::seti(0x3F000000))),
+                    small = V::lt(m,V::set(s_sqrtHalf));
+    e = V::subi(e,V::andi(V::asI(small),V::seti(1)));
+    m = V::add(V::sub(m,V::set(1.0f)),V::andF(small,m));
+    F               fe = V::toF(e),
+                    z = V::mul(m,m),
+                    p = V::set(7.0376836292e-2f);
+    p = V::madd(p,m,V::set(-1.1514610310e-1f));
+    p = V::madd(p,m,V::set(1.1676998740e-1f));
+    p = V::madd(p,m,V::set(-1.2420140846e-1f));
+    p = V::madd(p,m,V::set(1.4249322787e-1f));
+    p = V::madd(p,m,V::set(-1.6668057665e-1f));
+    p = V::madd(p,m,V::set(2.0000714765e-1f));
+    p = V::madd(p,m,V::set(-2.4999993993e-1f));
+    p = V::madd(p,m,V::set(3.3333331174e-1f));
+    F               y = V::mul(V::mul(p,m),z);
+    y = V::madd(fe,V::set(s_ln2Lo),y);
+    y = V::madd(z,V::set(-0.5f),y);
+    F               ret = V::madd(fe,V::set(s_ln2Hi),V::add(m,y)),
+                    zero = V::set(0.0f);
+    ret = V::sel(V::eq(x,zero),V::set(-numeric_limits<float>::infinity()),ret);
+    return V::sel(V::lt(x,zero),V::set(numeric_limits<float>::quiet_NaN()),ret);
+}
+
+template<class V>
+void
+sinCosV(typename V::F x,typename V::F & sinX,typename V::F & cosX)
+{
+    typedef typename V::F   F;
+    typedef typename V::I   I;
+    // Reduce to [-pi/4,pi/4] with the octant in 'j' (made even) selecting polynomial and sign:
+    F               sign = V::andF(x,V::set(-0.0f)),
+                    ax = V::xorF(x,sign);
+    I               j = V::trunc(V::mul(ax,V::set(s_4OnPi)));
+    j = V::andi(V::addi(j,V::seti(1)),V::seti(~1));
+    F               y = V::toF(j),
+                    r = V::keep(V::madd(y,V::set(-s_piOn4a),ax));
+    r = V::keep(V::madd(y,V::set(-s_piOn4b),r));
+    r = V::madd(y,V::set(-s_piOn4c),r);
+    F               z = V::mul(r,r),
+                    pc = V::set(2.443315711809948e-5f),
+                    ps = V::set(-1.9515295891e-4f);
+    pc = V::madd(pc,z,V::set(-1.388731625493765e-3f));
+    pc = V::madd(pc,z,V::set(4.166664568298827e-2f));
+    pc = V::mul(V::mul(pc,z),z);
+    pc = V::add(V::madd(z,V::set(-0.5f),pc),V::set(1.0f));
+    ps = V::madd(ps,z,V::set(8.3321608736e-3f));
+    ps = V::madd(ps,z,V::set(-1.6666654611e-1f));
+    ps = V::madd(V::mul(ps,z),r,r);
+    F               noSwap = V::eqi(V::andi(j,V::seti(2)),V::seti(0)),
+                    sinSign = V::xorF(sign,V::asF(V::template shl<29>(V::andi(j,V::seti(4))))),
+                    cosSign = V::asF(V::template shl<29>(V::andi(V::addi(j,V::seti(2)),V::seti(4))));
+    sinX = V::xorF(V::sel(noSwap,ps,pc),sinSign);
+    cosX = V::xorF(V::sel(noSwap,pc,ps),cosSign);
+}
+
+template<class V>
+typename V::F
+apply(Op op,float param,typename V::F x)
+{
+    typename V::F   r = x,
+                    tmp;
+    switch (op) {
+        case Op::exp:   r = expV<V>(x); break;
+        case Op::log:   r = logV<V>(x); break;
+        case Op::pow:   r = expV<V>(V::mul(V::set(param),logV<V>(x))); break;
+        case Op::rsqrt: r = V::rsqrt(x); break;
+        case Op::sin:   sinCosV<V>(x,r,tmp); break;
+        case Op::cos:   sinCosV<V>(x,tmp,r); break;
+    }
+    return r;
+}
+
+#if defined(FG_SSE2) || defined(FG_NEON)
+
+template<class V>
+size_t
+map128(Op op,float param,float const * in,float * out,size_t num)
+{
+    size_t          ii = 0;
+    for (; ii+V::width<=num; ii+=V::width)
+        V::store(out+ii,apply<V>(op,param,V::load(in+ii)));
+    return ii;
+}
+
+#endif
+
+#ifdef FG_AVX2
+
+// The same kernels as above for AVX2 with FMA. These cannot share the templates since every
+// function using 256-bit intrinsics must carry the target attribute:
+
+struct  V8
+{
+    typedef __m256      F;
+    typedef __m256i     I;
+
+    FG_TARGET_AVX2_FMA static F set(float v) {return _mm256_set1_ps(v); }
+    FG_TARGET_AVX2_FMA static I seti(int v) {return _mm256_set1_epi32(v); }
+    FG_TARGET_AVX2_FMA static F add(F a,F b) {return _mm256_add_ps(a,b); }
+    FG_TARGET_AVX2_FMA static F sub(F a,F b) {return _mm256_sub_ps(a,b); }
+    FG_TARGET_AVX2_FMA static F mul(F a,F b) {return _mm256_mul_ps(a,b); }
+    FG_TARGET_AVX2_FMA static F madd(F a,F b,F c) {return _mm256_fmadd_ps(a,b,c); }
+    FG_TARGET_AVX2_FMA static F min(F a,F b) {return _mm256_min_ps(a,b); }
+    FG_TARGET_AVX2_FMA static F max(F a,F b) {return _mm256_max_ps(a,b); }
+    FG_TARGET_AVX2_FMA static I round(F v) {return _mm256_cvtps_epi32(v); }
+    FG_TARGET_AVX2_FMA static I trunc(F v) {return _mm256_cvttps_epi32(v); }
+    FG_TARGET_AVX2_FMA static F toF(I v) {return _mm256_cvtepi32_ps(v); }
+    FG_TARGET_AVX2_FMA static I addi(I a,I b) {return _mm256_add_epi32(a,b); }
+    FG_TARGET_AVX2_FMA static I subi(I a,I b) {return _mm256_sub_epi32(a,b); }
+    FG_TARGET_AVX2_FMA static I andi(I a,I b) {return _mm256_and_si256(a,b); }
+    FG_TARGET_AVX2_FMA static I ori(I a,I b) {return _mm256_or_si256(a,b); }
+    FG_TARGET_AVX2_FMA static F asF(I v) {return _mm256_castsi256_ps(v); }
+    FG_TARGET_AVX2_FMA static I asI(F v) {return _mm256_castps_si256(v); }
+    FG_TARGET_AVX2_FMA static F lt(F a,F b) {return _mm256_cmp_ps(a,b,_CMP_LT_OQ); }
+    FG_TARGET_AVX2_FMA static F gt(F a,F b) {return _mm256_cmp_ps(a,b,_CMP_GT_OQ); }
+    FG_TARGET_AVX2_FMA static F eq(F a,F b) {return _mm256_cmp_ps(a,b,_CMP_EQ_OQ); }
+    FG_TARGET_AVX2_FMA static F eqi(I a,I b) {return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a,b)); }
+    FG_TARGET_AVX2_FMA static F sel(F m,F a,F b) {return _mm256_blendv_ps(b,a,m); }
+    FG_TARGET_AVX2_FMA static F andF(F a,F b) {return _mm256_and_ps(a,b); }
+    FG_TARGET_AVX2_FMA static F xorF(F a,F b) {return _mm256_xor_ps(a,b); }
+};
+
+FG_TARGET_AVX2_FMA
+inline __m256
+exp8(__m256 x)
+{
+    typedef V8      V;
+    __m256          xc = V::min(V::max(x,V::set(s_expLo)),V::set(s_expHi));
+    __m256i         n = V::round(V::mul(xc,V::set(s_log2e)));
+    __m256          fn = V::toF(n),
+                    r = V::madd(fn,V::set(-s_ln2Hi),xc);
+    r = V::madd(fn,V::set(-s_ln2Lo),r);
+    __m256          r2 = V::mul(r,r),
+                    p = V::set(1.9875691500e-4f);
+    p = V::madd(p,r,V::set(1.3981999507e-3f));
+    p = V::madd(p,r,V::set(8.3334519073e-3f));
+    p = V::madd(p,r,V::set(4.1665795894e-2f));
+    p = V::madd(p,r,V::set(1.6666665459e-1f));
+    p = V::madd(p,r,V::set(5.0000001201e-1f));
+    p = V::madd(p,r2,V::add(r,V::set(1.0f)));
+    __m256i         n1 = _mm256_srai_epi32(n,1),
+                    n2 = V::subi(n,n1),
+                    bias = V::seti(127);
+    p = V::mul(p,V::asF(_mm256_slli_epi32(V::addi(n1,bias),23)));
+    p = V::mul(p,V::asF(_mm256_slli_epi32(V::addi(n2,bias),23)));
+    return V::sel(V::gt(x,V::set(s_expHi)),V::set(numeric_limits<float>::infinity()),p);
+}
+
+FG_TARGET_AVX2_FMA
+inline __m256
+log8(__m256 x)
+{
+    typedef V8      V;
+    __m256i         bits = V::asI(V::max(x,V::set(numeric_limits<float>::min()))),
+                    e = V::subi(_mm256_srli_epi32(bits,23),V::seti(126));
+    __m256          m = V::asF(V::ori(V::andi(bits,V::seti(0x007FFFFF)),V::seti(0x3F000000))),
+                    small = V::lt(m,V::set(s_sqrtHalf));
+    e = V::subi(e,V::andi(V::asI(small),V::seti(1)));
+    m = V::add(V::sub(m,V::set(1.0f)),V::andF(small,m));
+    __m256          fe = V::toF(e),
+                    z = V::mul(m,m),
+                    p = V::set(7.0376836292e-2f);
+    p = V::madd(p,m,V::set(-1.1514610310e-1f));
+    p = V::madd(p,m,V::set(1.1676998740e-1f));
+    p = V::madd(p,m,V::set(-1.2420140846e-1f));
+    p = V::madd(p,m,V::set(1.4249322787e-1f));
+    p = V::madd(p,m,V::set(-1.6668057665e-1f));
+    p = V::madd(p,m,V::set(2.0000714765e-1f));
+    p = V::madd(p,m,V::set(-2.4999993993e-1f));
+    p = V::madd(p,m,V::set(3.3333331174e-1f));
+    __m256          y = V::mul(V::mul(p,m),z);
+    y = V::madd(fe,V::set(s_ln2Lo),y);
+    y = V::madd(z,V::set(-0.5f),y);
+    __m256          ret = V::madd(fe,V::set(s_ln2Hi),V::add(m,y)),
+                    zero = V::set(0.0f);
+    ret = V::sel(V::eq(x,zero),V::set(-numeric_limits<float>::infinity()),ret);
+    return V::sel(V::lt(x,zero),V::set(numeric_limits<float>::quiet_NaN()),ret);
+}
+
+FG_TARGET_AVX2_FMA
+inline void
+sinCos8(__m256 x,__m256 & sinX,__m256 & cosX)
+{
+    typedef V8      V;
+    __m256          sign = V::andF(x,V::set(-0.0f)),
+                    ax = V::xorF(x,sign);
+    __m256i         j = V::trunc(V::mul(ax,V::set(s_4OnPi)));
+    j = V::andi(V::addi(j,V::seti(1)),V::seti(~1));
+    __m256          y = V::toF(j),
+                    r = V::madd(y,V::set(-s_piOn4a),ax);
+    r = V::madd(y,V::set(-s_piOn4b),r);
+    r = V::madd(y,V::set(-s_piOn4c),r);
+    __m256          z = V::mul(r,r),
+                    pc = V::set(2.443315711809948e-5f),
+                    ps = V::set(-1.9515295891e-4f);
+    pc = V::madd(pc,z,V::set(-1.388731625493765e-3f));
+    pc = V::madd(pc,z,V::set(4.166664568298827e-2f));
+    pc = V::mul(V::mul(pc,z),z);
+    pc = V::add(V::madd(z,V::set(-0.5f),pc),V::set(1.0f));
+    ps = V::madd(ps,z,V::set(8.3321608736e-3f));
+    ps = V::madd(ps,z,V::set(-1.6666654611e-1f));
+    ps = V::madd(V::mul(ps,z),r,r);
+    __m256          noSwap = V::eqi(V::andi(j,V::seti(2)),V::seti(0)),
+                    sinSign = V::xorF(sign,V::asF(_mm256_slli_epi32(V::andi(j,V::seti(4)),29))),
+                    cosSign = V::asF(_mm256_slli_epi32(V::andi(V::addi(j,V::seti(2)),V::seti(4)),29));
+    sinX = V::xorF(V::sel(noSwap,ps,pc),sinSign);
+    cosX = V::xorF(V::sel(noSwap,pc,ps),cosSign);
+}
+
+FG_TARGET_AVX2_FMA
+inline __m256
+rsqrt8(__m256 x)
+{
+    __m256          y = _mm256_rsqrt_ps(x),
+                    hx = _mm256_mul_ps(_mm256_set1_ps(0.5f),x);
+    return _mm256_mul_ps(y,_mm256_fnmadd_ps(hx,_mm256_mul_ps(y,y),_mm256_set1_ps(1.5f)));
+}
+
+FG_TARGET_AVX2_FMA
+size_t
+mapAvx2(Op op,float param,float const * in,float * out,size_t num)
+{
+    size_t          ii = 0;
+    for (; ii+8<=num; ii+=8) {
+        __m256          x = _mm256_loadu_ps(in+ii),
+                        r = x,
+                        tmp;
+        switch (op) {
+            case Op::exp:   r = exp8(x); break;
+            case Op::log:   r = log8(x); break;
+            case Op::pow:   r = exp8(_mm256_mul_ps(_mm256_set1_ps(param),log8(x))); break;
+            case Op::rsqrt: r = rsqrt8(x); break;
+            case Op::sin:   sinCos8(x,r,tmp); break;
+            case Op::cos:   sinCos8(x,tmp,r); break;
+        }
+        _mm256_storeu_ps(out+ii,r);
+    }
+    return ii;
+}
+
+#endif
+
+void
+mapApprox(Op op,float param,float const * in,float * out,size_t num)
+{
+    Simd            simd = simdLevel();
+    size_t          ii = 0;
+#ifdef FG_AVX2
+    if (simd == Simd::avx2)
+        ii = mapAvx2(op,param,in,out,num);
+#endif
+#if defined(FG_SSE2) || defined(FG_NEON)
+    if (simd >= Simd::vec128)
+        ii += map128<V4>(op,param,in+ii,out+ii,num-ii);
+#endif
+    (void)simd;
+    for (; ii<num; ++ii)
+        out[ii] = apply<V1>(op,param,in[ii]);
+}
+
+}
+
+void
+approxLut_(Floats const & lut,float base,float scale,float const * in,float * out,size_t num)
+{
+    size_t          ii = 0;
+#ifdef FG_AVX2
+    FGASSERT(lut.size() > 1);
+    if (simdLevel() == Simd::avx2)
+        ii = lutAvx2(lut,base,scale,in,out,num);
+#endif
+    lutScalar(lut,base,scale,in+ii,out+ii,num-ii);
+}
+
+void
+approxLut_(Doubles const & lut,double base,double scale,double const * in,double * out,size_t num)
+{lutScalar(lut,base,scale,in,out,num); }
+
+void
+approxExp_(float const * in,float * out,size_t num)
+{mapApprox(Op::exp,0.0f,in,out,num); }
+
+void
+approxLog_(float const * in,float * out,size_t num)
+{mapApprox(Op::log,0.0f,in,out,num); }
+
+void
+approxPow_(float const * base,float exponent,float * out,size_t num)
+{mapApprox(Op::pow,exponent,base,out,num); }
+
+void
+approxRsqrt_(float const * in,float * out,size_t num)
+{mapApprox(Op::rsqrt,0.0f,in,out,num); }
+
+void
+approxSin_(float const * in,float * out,size_t num)
+{mapApprox(Op::sin,0.0f,in,out,num); }
+
+void
+approxCos_(float const * in,float * out,size_t num)
+{mapApprox(Op::cos,0.0f,in,out,num); }
+
+namespace {
+
 struct  Sine
 {
     double
@@ -22,9 +602,92 @@ struct  Sine
     {return std::sin(x); }
 };
 
+// Error of 'v' in units of the last place of the correctly rounded float result 'ref':
+double
+ulpErr(float v,double ref)
+{
+    float           r = float(ref);
+    int             e = (r == 0.0f) ? -126 : std::max(std::ilogb(r),-126);
+    return std::abs(double(v) - ref) / std::ldexp(1.0,e-23);
+}
+
+template<class Ref>
+double
+maxUlpErr(Floats const & in,Floats const & out,Ref ref)
+{
+    double          ret = 0.0;
+    for (size_t ii=0; ii<in.size(); ++ii)
+        ret = std::max(ret,ulpErr(out[ii],ref(double(in[ii]))));
+    return ret;
+}
+
+void
+testSimd()
+{
+    size_t          num = 100003;       // Not a multiple of the vector widths
+    Floats          in(num),
+                    out(num);
+    for (Simd simd : {Simd::scalar,Simd::vec128,Simd::avx2}) {
+        setSimdLevel(simd);
+        for (float & v : in)
+            v = float(randUniform(-87.0,88.0));
+        approxExp_(in.data(),out.data(),num);
+        FGASSERT(maxUlpErr(in,out,[](double x){return std::exp(x); }) <= 2.0);
+        for (float & v : in)
+            v = std::exp(float(randUniform(-87.0,88.0)));
+        in[0] = 1.0f;
+        approxLog_(in.data(),out.data(),num);
+        FGASSERT(out[0] == 0.0f);
+        FGASSERT(maxUlpErr(in,out,[](double x){return std::log(x); }) <= 2.0);
+        for (float ex : {-2.5f,0.5f,3.0f}) {
+            for (float & v : in)
+                v = std::exp(float(randUniform(-5.0,5.0)));
+            approxPow_(in.data(),ex,out.data(),num);
+            for (size_t ii=0; ii<num; ++ii) {
+                double          lp = double(ex) * std::log(double(in[ii]));
+                FGASSERT(ulpErr(out[ii],std::exp(lp)) <= 3.0 * (1.0 + std::abs(lp)));
+            }
+        }
+        for (float & v : in)
+            v = std::exp(float(randUniform(-80.0,80.0)));
+        approxRsqrt_(in.data(),out.data(),num);
+        FGASSERT(maxUlpErr(in,out,[](double x){return 1.0/std::sqrt(x); }) <= 4.0);
+        for (float & v : in)
+            v = float(randUniform(-8192.0,8192.0));
+        in[0] = 0.0f;
+        approxSin_(in.data(),out.data(),num);
+        FGASSERT(out[0] == 0.0f);
+        for (size_t ii=0; ii<num; ++ii)
+            FGASSERT(std::abs(out[ii] - std::sin(double(in[ii]))) <= std::ldexp(1.0,-23));
+        approxCos_(in.data(),out.data(),num);
+        FGASSERT(out[0] == 1.0f);
+        for (size_t ii=0; ii<num; ++ii)
+            FGASSERT(std::abs(out[ii] - std::cos(double(in[ii]))) <= std::ldexp(1.0,-23));
+        // Out of range:
+        in[0] = -200.0f;
+        in[1] = 100.0f;
+        approxExp_(in.data(),out.data(),num);
+        FGASSERT(out[0] == 0.0f);
+        uint32          bits;                           // Compare bits since -ffast-math assumes finite values
+        memcpy(&bits,&out[1],4);
+        FGASSERT(bits == 0x7F800000U);
+        // Batch LUT evaluation matches the scalar version including clamping:
+        FgApproxFunc<float>     af([](float x){return std::sin(x); },-1.0f,2.0f,100);
+        for (float & v : in)
+            v = float(randUniform(-1.5,2.5));
+        af(in.data(),out.data(),num);
+        for (size_t ii=0; ii<num; ++ii)
+            FGASSERT(std::abs(out[ii] - af(in[ii])) < 1.0e-5f);
+    }
+    setSimdLevel(simdSupported());
+}
+
+}
+
 void
 fgApproxFuncTest(const CLArgs &)
 {
+    testSimd();
     const double        accuracy = 0.0001;
     for (uint ii=0; ii<10; ++ii)
     {
@@ -54,6 +717,13 @@ fgApproxFuncTest(const CLArgs &)
         xx = base + len + 1.001;
         delta = std::abs(sine(base+len) - af(xx));
         FGASSERT(delta < accuracy);
+        // Batch:
+        Doubles         xs(77);
+        for (double & x : xs)
+            x = randUniform(base-1.0,base+len+1.0);
+        Doubles         ys = af(xs);
+        for (size_t jj=0; jj<xs.size(); ++jj)
+            FGASSERT(std::abs(ys[jj] - af(xs[jj])) < 1.0e-12);
     }
 }
 
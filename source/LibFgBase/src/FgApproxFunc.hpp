@@ -3,7 +3,8 @@
 // Use, modification and distribution is subject to the MIT License,
 // see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
 //
-// Simple function approximation using interpolated LUT.
+// Simple function approximation using interpolated LUT, and vectorized float approximations of
+// common transcendental functions for bulk array evaluation.
 // Possible future optimization: Use Chebyshev approximation.
 //
 
@@ -17,6 +18,12 @@
 
 namespace Fg {
 
+// Batch interpolated LUT evaluation with clamping (see below). The 'float' version uses AVX2 gathers:
+void
+approxLut_(Floats const & lut,float base,float scale,float const * in,float * out,size_t num);
+void
+approxLut_(Doubles const & lut,double base,double scale,double const * in,double * out,size_t num);
+
 template<class Float>   // 'float' or 'double'
 struct  FgApproxFunc
 {
@@ -44,7 +51,7 @@ struct  FgApproxFunc
 
     // Values outside specified range are clamped:
     Float
-    operator()(Float val)
+    operator()(Float val) const
     {
         Float   valLut = m_lutScale * (val - m_lutBase),
                 valFlr = std::floor(valLut);
@@ -59,8 +66,48 @@ struct  FgApproxFunc
             idxHi = idxLo = int(m_lut.size()-1);
         return (wgtLo * m_lut[idxLo] + wgtHi * m_lut[idxHi]);
     }
+
+    // Batch version of the above. 'out' may equal 'in':
+    void
+    operator()(Float const * in,Float * out,size_t num) const
+    {approxLut_(m_lut,m_lutBase,m_lutScale,in,out,num); }
+
+    Svec<Float>
+    operator()(Svec<Float> const & vals) const
+    {
+        Svec<Float>         ret(vals.size());
+        operator()(vals.data(),ret.data(),vals.size());
+        return ret;
+    }
 };
 
+// Vectorized (AVX2/FMA, SSE2 or NEON according to 'simdLevel()') float approximations over arrays,
+// using Cephes-style range reduction and minimax polynomials. 'out' may equal 'in'. Error bounds
+// are in units in the last place (ULP) of the correctly rounded result, over the given domain:
+
+// Max 2 ULP. Results overflow to +inf above 88.72 and are zero below -103.9:
+void
+approxExp_(float const * in,float * out,size_t num);
+
+// Max 2 ULP for positive normal inputs. Zero gives -inf and negative values give NaN:
+void
+approxLog_(float const * in,float * out,size_t num);
+
+// exp(exponent * log(base)) so the error grows with the magnitude of the result's natural log:
+// max 3(1 + |exponent*ln(base)|) ULP, for positive bases:
+void
+approxPow_(float const * base,float exponent,float * out,size_t num);
+
+// Hardware reciprocal square root estimate refined by Newton-Raphson. Max 4 ULP for positive normals:
+void
+approxRsqrt_(float const * in,float * out,size_t num);
+
+// Absolute error max 2^-23 for |x| < 8192, degrading beyond:
+void
+approxSin_(float const * in,float * out,size_t num);
+void
+approxCos_(float const * in,float * out,size_t num);
+
 }
 
 #endif
@@ -20,20 +20,25 @@ using namespace std;
 namespace Fg {
 
 void fg3dTest(CLArgs const &);
+void fgApproxFuncTest(CLArgs const &);
 void fgBoostSerializationTest(CLArgs const &);
 void fgCmdTestDfg(CLArgs const &);
+void fgCmdImgopsTest(CLArgs const &);
+void fgCmdMeshopsTest(CLArgs const &);
 void fgExceptionTest(CLArgs const &);
 void fgFileSystemTest(CLArgs const &);
 void fgOpenTest(CLArgs const &);
 void fgGeometryTest(CLArgs const &);
 void fgGridTrianglesTest(CLArgs const &);
 void fgImageTest(CLArgs const &);
+void fgLoadCacheTest(CLArgs const &);
 void fgMatrixSolverTest(CLArgs const &);
 void fgMathTest(CLArgs const &);
 void fgMatrixCTest(CLArgs const &);
 void fgMatrixVTest(CLArgs const &);
 void fgMetaFormatTest(CLArgs const &);
 void fgMorphTest(CLArgs const &);
+void fgParallelTest(CLArgs const &);
 void fgPathTest(CLArgs const &);
 void fgQuaternionTest(CLArgs const &);
 void fgCmdRenderTest(CLArgs const &);
@@ -51,6 +56,7 @@ fgCmdBaseTests()
 {
     Cmds      cmds {
         {fg3dTest,"3d"},
+        {fgApproxFuncTest,"approxFunc"},
         {fgBoostSerializationTest,"boostSerialization"},
         {fgCmdTestDfg,"dataflow"},
         {fgExceptionTest,"exception"},
@@ -59,12 +65,16 @@ fgCmdBaseTests()
         {fgGeometryTest,"geometry"},
         {fgGridTrianglesTest,"gridTriangles"},
         {fgImageTest,"image"},
+        {fgCmdImgopsTest,"imgops","image command"},
+        {fgLoadCacheTest,"loadCache"},
         {fgMatrixSolverTest,"matSol","Matrix Solver"},
         {fgMathTest,"math"},
         {fgMatrixCTest,"matC","MatrixC"},
         {fgMatrixVTest,"matV","MatrixV"},
+        {fgCmdMeshopsTest,"meshops","mesh command"},
         {fgMetaFormatTest,"metaFormat"},
         {fgMorphTest,"morph"},
+        {fgParallelTest,"parallel"},
         {fgPathTest,"path"},
         {fgQuaternionTest,"quaternion"},
         {fgCmdRenderTest,"rendc","render command"},
@@ -10,6 +10,12 @@
 #include "FgSyntax.hpp"
 #include "FgMetaFormat.hpp"
 #include "FgImageIo.hpp"
+#include "FgImageTiled.hpp"
+#include "FgFileSystem.hpp"
+#include "FgParallel.hpp"
+#include "FgParse.hpp"
+#include "FgTime.hpp"
+#include "FgTestUtils.hpp"
 
 using namespace std;
 
@@ -76,6 +82,345 @@ shrink2(const CLArgs & args)
     imgSaveAnyFormat(syntax.next(),img);
 }
 
+ResampleFilter
+parseFilter(Syntax & syntax,string const & name)
+{
+    if (name == "box")
+        return ResampleFilter::box;
+    if (name == "triangle")
+        return ResampleFilter::triangle;
+    if (name == "mitchell")
+        return ResampleFilter::mitchell;
+    if (name == "lanczos3")
+        return ResampleFilter::lanczos3;
+    syntax.error("Unknown filter",name);
+    return ResampleFilter::box;
+}
+
+void
+tile(const CLArgs & args)
+{
+    Syntax    syntax(args,
+        "[-s <tileSize>] <in>.<ext> <out>.fgt\n"
+        "    <ext>      - " + imgFileExtensionsDescription() + "\n"
+        "    <tileSize> - Defaults to 256\n"
+        "    Converts an image to a tiled image file for out-of-core processing"
+        );
+    uint        tileSize = 256;
+    if (syntax.peekNext() == "-s") {
+        syntax.next();
+        tileSize = syntax.nextAs<uint>();
+    }
+    ImgC4UC     img = imgLoadAnyFormat(syntax.next());
+    imgSaveTiled(syntax.next(),img,tileSize);
+}
+
+void
+untile(const CLArgs & args)
+{
+    Syntax    syntax(args,
+        "<in>.fgt <out>.<ext>\n"
+        "    <ext>      - " + imgFileExtensionsDescription()
+        );
+    ImgTiled<RgbaUC>    img(syntax.next());
+    imgSaveAnyFormat(syntax.next(),img.toImg());
+}
+
+void
+resizeTiled(const CLArgs & args)
+{
+    Syntax    syntax(args,
+        "<in>.fgt <out>.fgt <width> <height> [<filter>]\n"
+        "    <filter>   - (box | triangle | mitchell | lanczos3) defaults to mitchell\n"
+        "    Resizes a tiled image one band of rows at a time within a fixed memory budget (64MB) rather than\n"
+        "    loading the whole image. Very large vertical reductions may exceed it by the source rows of one output row"
+        );
+    ImgTiled<RgbaUC>    src(syntax.next());
+    string              dst = syntax.next();
+    Vec2UI              dims;
+    dims[0] = syntax.nextAs<uint>();
+    dims[1] = syntax.nextAs<uint>();
+    ResampleFilter      filter = ResampleFilter::mitchell;
+    if (syntax.more())
+        filter = parseFilter(syntax,syntax.next());
+    imgResizeTiled(src,dst,dims,filter,src.tileSize());
+}
+
+// One step of the per-image op chain:
+struct  ImgOp
+{
+    String              name;
+    Vec2UI              dims;           // For resize
+    ResampleFilter      filter = ResampleFilter::mitchell;
+    Sptr<ImgC4UC>       img;            // For addalpha and composite. Shared read-only by all threads
+
+    void
+    apply(ImgC4UC & img) const;
+};
+
+void
+ImgOp::apply(ImgC4UC & dst) const
+{
+    if (name == "shrink2")
+        dst = fgImgShrink2(dst);
+    else if (name == "resize")
+        dst = imgResize(dst,dims,filter);
+    else {
+        if (img->dims() != dst.dims())
+            fgThrow(name+" image dimensions differ from",toString(dst.dims()));
+        if (name == "addalpha")
+            for (size_t ii=0; ii<dst.numPixels(); ++ii)
+                dst[ii].alpha() = (*img)[ii].rec709();
+        else
+            fgComposite_(img->cview(),dst.view());
+    }
+}
+
+ImgOp
+parseOp(Syntax & syntax,String const & arg)
+{
+    ImgOp               ret;
+    size_t              eq = arg.find('=');
+    ret.name = arg.substr(0,eq);
+    String              val = (eq == String::npos) ? String() : arg.substr(eq+1);
+    if (ret.name == "shrink2")
+        return ret;
+    if (val.empty())
+        syntax.error("Missing value for op",arg);
+    if (ret.name == "resize") {
+        Strings             parts = splitChar(val,':');
+        Strings             wh = splitChar(parts[0],'x');
+        if (wh.size() != 2)
+            syntax.error("Invalid resize dimensions",arg);
+        ret.dims = Vec2UI(fgFromStr<uint>(wh[0]).val(),fgFromStr<uint>(wh[1]).val());
+        if (parts.size() > 1)
+            ret.filter = parseFilter(syntax,parts[1]);
+    }
+    else if ((ret.name == "addalpha") || (ret.name == "composite"))
+        ret.img = make_shared<ImgC4UC>(imgLoadAnyFormat(val));
+    else
+        syntax.error("Unknown op",arg);
+    return ret;
+}
+
+struct  ImgBatchItem
+{
+    Ustring             in;
+    Ustring             out;
+    String              data;           // Encoded input then encoded output
+    size_t              bytesIn = 0;
+    size_t              bytesOut = 0;
+    double              ms = 0.0;       // Decode, ops and encode
+    String              error;
+    bool                done = false;   // Reached the writer
+};
+
+// Message of the exception currently being handled. Only call from within a catch block:
+String
+currentErrorMsg()
+{
+    try {
+        throw;
+    }
+    catch (FgException const & e) {
+        return e.tr_message();
+    }
+    catch (std::exception const & e) {
+        return e.what();
+    }
+    catch (...) {
+        return "unknown exception";
+    }
+}
+
+void
+batch(const CLArgs & args)
+{
+    Syntax    syntax(args,
+        "[-t <threads>] [-q <quality>] (<manifest>.(csv|xml) | <inPattern> <outDir> <extOut>) <op>*\n"
+        "    <threads>  - maximum number of concurrent decode/encode workers (default: number of cores)\n"
+        "    <quality>  - JPEG output quality [1,100] (default 75)\n"
+        "    <manifest>.csv - each line is: <in>.<ext>,<out>.<ext>\n"
+        "    <manifest>.xml - the same records as a serialized list of lists of strings\n"
+        "    <inPattern> - input images by simple glob (eg. 'photos/*.jpg')\n"
+        "    <outDir>   - each output is saved here with the input base name and extension <extOut>\n"
+        "    <op>       - applied in order to each image:\n"
+        "        shrink2\n"
+        "        resize=<width>x<height>[:(box|triangle|mitchell|lanczos3)]\n"
+        "        addalpha=<alpha>.<ext>   - greyscale of <alpha> becomes the alpha channel\n"
+        "        composite=<overlay>.<ext> - composite <overlay> (with alpha) over the image\n"
+        "    <ext>      - " + imgFileExtensionsDescription() + "\n"
+        "    Files are read, processed and written in a pipeline: one thread reads, the workers decode,\n"
+        "    apply the ops and encode, and one thread writes. Queues between the stages are bounded so\n"
+        "    memory use does not depend on the number of files. Errors are reported per file."
+        );
+    uint                maxThreads = 0;
+    int                 quality = 75;
+    while (syntax.peekNext()[0] == '-') {
+        String              opt = syntax.next();
+        if (opt == "-t")
+            maxThreads = syntax.nextAs<uint>();
+        else if (opt == "-q")
+            quality = syntax.nextAs<int>();
+        else
+            syntax.error("Unknown option",opt);
+    }
+    Svec<ImgBatchItem>  items;
+    Ustring             arg0 = syntax.next();
+    Ustring             ext0 = fgToLower(Path(arg0).ext);
+    if ((ext0 == "csv") || (ext0 == "xml")) {
+        Stringss            records;
+        if (ext0 == "csv")
+            records = fgLoadCsv(arg0);
+        else
+            fgLoadXml(arg0,records);
+        for (Strings const & rec : records) {
+            if (rec.empty() || rec[0].empty() || (rec[0][0] == '#'))
+                continue;
+            if (rec.size() < 2)
+                fgThrow("Manifest record needs input and output",rec[0]);
+            ImgBatchItem        item;
+            item.in = rec[0];
+            item.out = rec[1];
+            items.push_back(item);
+        }
+    }
+    else {
+        Path                inPath(arg0);
+        Ustring             outDir = fgAsDirectory(syntax.next()),
+                            extOut = syntax.next();
+        fgCreatePath(outDir);
+        Ustrings            fnames = globFiles(inPath);
+        sort(fnames.begin(),fnames.end());
+        for (Ustring const & fname : fnames) {
+            ImgBatchItem        item;
+            item.in = inPath.dir() + fname;
+            item.out = outDir + fgPathToBase(fname) + "." + extOut;
+            items.push_back(item);
+        }
+    }
+    Svec<ImgOp>         ops;
+    while (syntax.more())
+        ops.push_back(parseOp(syntax,syntax.next()));
+    if (items.empty())
+        syntax.error("No input files");
+    uint                numWorkers = (maxThreads == 0) ? threadsNum() : maxThreads;
+    // Each queue holds at most a couple of items per worker:
+    BoundedQueue<size_t>    toDecode(2*numWorkers),
+                            toWrite(2*numWorkers);
+    // Exceptions must not escape the stage threads (that would terminate the program) so all are caught
+    // and reported with the affected files:
+    String              stageError;
+    mutex               stageMutex;
+    auto                setStageError = [&](String const & msg)
+    {
+        lock_guard<mutex>   lock(stageMutex);
+        if (stageError.empty())
+            stageError = msg;
+    };
+    FgTimer             timer;
+    thread              reader([&]()
+    {
+        try {
+            for (size_t ii=0; ii<items.size(); ++ii) {
+                ImgBatchItem &      item = items[ii];
+                try {
+                    item.data = fgSlurp(item.in);
+                    item.bytesIn = item.data.size();
+                }
+                catch (...) {
+                    item.error = currentErrorMsg();
+                }
+                toDecode.push(ii);
+            }
+        }
+        catch (...) {
+            setStageError(currentErrorMsg());
+        }
+        toDecode.close();
+    });
+    // Workers run as their own stage so the writer below can run concurrently:
+    thread              workers([&]()
+    {
+        try {
+            parallelFor(numWorkers,[&](size_t)
+            {
+                size_t              ii;
+                while (toDecode.pop(ii)) {
+                    ImgBatchItem &      item = items[ii];
+                    if (item.error.empty()) {
+                        FgTimer             itemTimer;
+                        try {
+                            ImgC4UC             img = imgDecodeAnyFormat(
+                                reinterpret_cast<uchar const *>(item.data.data()),item.data.size());
+                            for (ImgOp const & op : ops)
+                                op.apply(img);
+                            item.data = imgEncodeAnyFormat(img,fgToLower(Path(item.out).ext).m_str,quality);
+                        }
+                        catch (...) {
+                            item.error = currentErrorMsg();
+                        }
+                        item.ms = double(itemTimer.readMs());
+                    }
+                    toWrite.push(ii);
+                }
+            },numWorkers);
+        }
+        catch (...) {
+            setStageError(currentErrorMsg());
+            size_t              ii;
+            while (toDecode.pop(ii))            // Don't leave the reader blocked on a full queue
+                {}
+        }
+        toWrite.close();
+    });
+    size_t              ii;
+    while (toWrite.pop(ii)) {
+        ImgBatchItem &      item = items[ii];
+        if (item.error.empty()) {
+            try {
+                fgDump(item.data,item.out,false);
+                item.bytesOut = item.data.size();
+            }
+            catch (...) {
+                item.error = currentErrorMsg();
+            }
+        }
+        String().swap(item.data);
+        item.done = true;
+    }
+    reader.join();
+    workers.join();
+    for (ImgBatchItem & item : items)
+        if (!item.done && item.error.empty())
+            item.error = "not processed: " + (stageError.empty() ? String("pipeline stopped") : stageError);
+    double              secs = timer.read();
+    size_t              numFailed = 0,
+                        bytesIn = 0,
+                        bytesOut = 0;
+    double              sumMs = 0.0;
+    for (ImgBatchItem const & item : items) {
+        fgout << fgnl << item.in << " -> " << item.out << " : ";
+        if (item.error.empty())
+            fgout << item.ms << " ms";
+        else {
+            fgout << "FAILED: " << item.error;
+            ++numFailed;
+        }
+        bytesIn += item.bytesIn;
+        bytesOut += item.bytesOut;
+        sumMs += item.ms;
+    }
+    // Guard against a zero duration from the millisecond timer:
+    double              rate = 1.0 / std::max(secs,0.001),
+                        mb = 1024.0 * 1024.0;
+    fgout << fgnl << items.size()-numFailed << " of " << items.size() << " images in " << secs << " s"
+        << " (" << items.size()*rate << " images/s, " << bytesIn/mb*rate << " MB/s in, "
+        << bytesOut/mb*rate << " MB/s out, " << sumMs/std::max(secs*1000.0,1.0) << "x concurrency)";
+    if (numFailed > 0)
+        fgThrow("Batch image failures",toString(numFailed));
+}
+
 void
 formats(const CLArgs &)
 {
@@ -100,13 +445,58 @@ imgops(const CLArgs & args)
 {
     vector<Cmd>   ops;
     ops.push_back(Cmd(addalpha,"addalpha","Add/replace an alpha channel from an another image"));
+    ops.push_back(Cmd(batch,"batch","Convert and process many images concurrently"));
     ops.push_back(Cmd(composite,"composite","Composite an image with transparency over another"));
     ops.push_back(Cmd(convert,"convert","Convert images between different formats"));
     ops.push_back(Cmd(formats,"formats","List all supported formats by file extension"));
+    ops.push_back(Cmd(resizeTiled,"resizeTiled","Resize a tiled image out-of-core"));
     ops.push_back(Cmd(shrink2,"shrink2","Shrink images by a factor of 2"));
+    ops.push_back(Cmd(tile,"tile","Convert an image to a tiled image file"));
+    ops.push_back(Cmd(untile,"untile","Convert a tiled image file to an image"));
     doMenu(args,ops);
 }
 
+void
+fgCmdImgopsTest(CLArgs const & args)
+{
+    FGTESTDIR
+    // Files with read, decode and per-file errors alongside good ones, more than the queue capacity
+    // (2 per worker) so that the stages block on each other:
+    Strings             lines;
+    for (uint ii=0; ii<8; ++ii) {
+        String              in = "in" + toString(ii) + ".png",
+                            out = "out" + toString(ii) + ((ii%2 == 0) ? ".png" : ".jpg");
+        if (ii == 3) {
+            in = "bad.png";
+            fgDump(String("not an image"),in);
+        }
+        else if (ii == 5)
+            in = "missing.png";
+        else
+            imgSaveAnyFormat(in,ImgC4UC(Vec2UI(40+ii,30),RgbaUC(uchar(ii*30),100,200,255)));
+        lines.push_back(in + "," + out);
+    }
+    fgDump(cat(lines,"\n")+"\n",String("manifest.csv"));
+    bool                failed = false;
+    try {
+        imgops(splitChar("image batch -t 2 manifest.csv resize=20x15 shrink2"));
+    }
+    catch (FgException const &) {
+        failed = true;
+    }
+    FGASSERT(failed);
+    for (uint ii=0; ii<8; ++ii) {
+        Ustring             out = "out" + toString(ii) + ((ii%2 == 0) ? ".png" : ".jpg");
+        if ((ii == 3) || (ii == 5))
+            FGASSERT(!fileExists(out));
+        else
+            FGASSERT(imgLoadAnyFormat(out).dims() == Vec2UI(10,7));
+    }
+    // Glob input with no failures:
+    imgops(splitChar("image batch -t 3 in*.png outdir png shrink2"));
+    FGASSERT(imgLoadAnyFormat("outdir/in7.png").dims() == Vec2UI(23,15));
+}
+
 Cmd
 fgCmdImgopsInfo()
 {return Cmd(imgops,"image","Image operations"); }
@@ -17,6 +17,13 @@
 #include "Fg3dTopology.hpp"
 #include "Fg3dDisplay.hpp"
 #include "FgBestN.hpp"
+#include "FgImageIo.hpp"
+#include "FgLoadCache.hpp"
+#include "FgParallel.hpp"
+#include "FgParse.hpp"
+#include "FgTime.hpp"
+#include "FgTestUtils.hpp"
+#include <future>
 
 using namespace std;
 
@@ -57,6 +64,202 @@ convert(const CLArgs & args)
     meshSaveAnyFormat(mesh,syntax.next());
 }
 
+// Decoded textures shared across all conversions in a batch. All textures, whether listed explicitly
+// or loaded by the mesh readers (via 'ImgLoadOverride'), are decoded once per path. Those loaded by
+// the readers are copied into each mesh, so are then also shared by content, so each distinct image
+// is held in memory only once regardless of how many meshes use it:
+struct  TextureStore
+{
+    mutex                                               mtx;
+    map<Ustring,shared_future<Sptr<ImgC4UC> > >         byPath;
+    map<String,Sptr<ImgC4UC> >                          byContent;
+    size_t                                              numDecoded = 0;
+    size_t                                              numShared = 0;
+
+    Sptr<ImgC4UC>
+    load(Ustring const & fname)
+    {
+        Ustring                         key = Path(fname).root ? fname : fgGetCurrentDir() + fname;
+        promise<Sptr<ImgC4UC> >         prom;
+        shared_future<Sptr<ImgC4UC> >   fut;
+        bool                            first = false;
+        {
+            lock_guard<mutex>   lock(mtx);
+            auto                it = byPath.find(key);
+            if (it == byPath.end()) {
+                fut = prom.get_future().share();
+                byPath[key] = fut;
+                first = true;
+                ++numDecoded;
+            }
+            else {
+                fut = it->second;
+                ++numShared;
+            }
+        }
+        if (first) {                    // Other threads wanting this texture wait on the future
+            try {
+                prom.set_value(make_shared<ImgC4UC>(imgLoadAnyFormat(fname)));
+            }
+            catch (...) {
+                prom.set_exception(current_exception());
+            }
+        }
+        return fut.get();
+    }
+
+    void
+    dedupe_(Sptr<ImgC4UC> & img)
+    {
+        if (!img || img->m_data.empty())
+            return;
+        String              key = toString(img->dims()) + contentHash(
+            reinterpret_cast<char const *>(img->m_data.data()),img->numPixels()*sizeof(RgbaUC));
+        lock_guard<mutex>   lock(mtx);
+        auto                it = byContent.find(key);
+        if (it == byContent.end())
+            byContent[key] = img;
+        else if (it->second != img) {
+            img = it->second;
+            ++numShared;
+        }
+    }
+};
+
+struct  BatchItem
+{
+    Ustring             in;
+    Ustring             out;
+    Ustrings            albedos;    // Optional, assigned to surfaces in order
+    double              ms = 0.0;
+    size_t              numVerts = 0;
+    size_t              numFacets = 0;
+    String              error;
+};
+
+void
+convertBatch(const CLArgs & args)
+{
+    Syntax    syntax(args,
+        "[-t <threads>] (<manifest>.(csv|xml) | <inPattern> <outDir> <extOut>)\n"
+        "    <threads> - maximum number of concurrent conversions (default: number of cores)\n"
+        "    <manifest>.csv - each line is: <in>.<extIn>,<out>.<extOut>(,<albedo>.<img>)*\n"
+        "    <manifest>.xml - the same records as a serialized list of lists of strings\n"
+        "    <inPattern> - input meshes by simple glob (eg. 'models/*.obj')\n"
+        "    <outDir> - each output is saved here with the input base name and extension <extOut>\n"
+        "    <extIn> = " + meshLoadFormatsCLDescription() + "\n"
+        "    <extOut> = " + meshSaveFormatsCLDescription() + "\n"
+        "    <img> = " + imgFileExtensionsDescription() + "\n"
+        "    Albedo images are assigned to surfaces in order, replacing any referenced by the input.\n"
+        "    Conversion errors are reported per file and do not stop the batch."
+        );
+    uint                maxThreads = 0;
+    if (syntax.peekNext() == "-t") {
+        syntax.next();
+        maxThreads = syntax.nextAs<uint>();
+    }
+    Svec<BatchItem>     items;
+    Ustring             arg0 = syntax.next();
+    if (!syntax.more()) {
+        Ustring             ext = fgToLower(Path(arg0).ext);
+        Stringss            records;
+        if (ext == "csv")
+            records = fgLoadCsv(arg0);
+        else if (ext == "xml")
+            fgLoadXml(arg0,records);
+        else
+            syntax.error("Unrecognized manifest extension",arg0);
+        for (Strings const & rec : records) {
+            if (rec.empty() || rec[0].empty() || (rec[0][0] == '#'))
+                continue;
+            if (rec.size() < 2)
+                fgThrow("Manifest record needs at least input and output",rec[0]);
+            BatchItem           item;
+            item.in = rec[0];
+            item.out = rec[1];
+            for (size_t ii=2; ii<rec.size(); ++ii)
+                if (!rec[ii].empty())
+                    item.albedos.push_back(rec[ii]);
+            items.push_back(item);
+        }
+    }
+    else {
+        Path                inPath(arg0);
+        Ustring             outDir = fgAsDirectory(syntax.next()),
+                            extOut = syntax.next();
+        fgCreatePath(outDir);
+        Ustrings            fnames = globFiles(inPath);
+        sort(fnames.begin(),fnames.end());
+        for (Ustring const & fname : fnames) {
+            BatchItem           item;
+            item.in = inPath.dir() + fname;
+            item.out = outDir + fgPathToBase(fname) + "." + extOut;
+            items.push_back(item);
+        }
+    }
+    if (items.empty())
+        syntax.error("No input files");
+    TextureStore        textures;
+    FgTimer             timer;
+    parallelFor(items.size(),[&](size_t ii)
+    {
+        BatchItem &         item = items[ii];
+        FgTimer             itemTimer;
+        try {
+            Mesh                mesh;
+            {
+                ImgLoadOverride     ovr([&textures](Ustring const & fname){return *textures.load(fname); });
+                mesh = meshLoadAnyFormat(item.in);
+            }
+            if (item.albedos.size() > mesh.surfaces.size())
+                fgThrow("More albedo images than surfaces in",item.in);
+            for (size_t ss=0; ss<item.albedos.size(); ++ss)
+                mesh.surfaces[ss].material.albedoMap = textures.load(item.albedos[ss]);
+            for (Surf & surf : mesh.surfaces)
+                textures.dedupe_(surf.material.albedoMap);
+            meshSaveAnyFormat(mesh,item.out);
+            item.numVerts = mesh.verts.size();
+            item.numFacets = mesh.numFacets();
+        }
+        catch (FgException const & e) {
+            item.error = e.tr_message();
+        }
+        catch (std::exception const & e) {
+            item.error = e.what();
+        }
+        catch (...) {
+            item.error = "Unknown exception";
+        }
+        item.ms = double(itemTimer.readMs());
+    },maxThreads);
+    double              secs = timer.read();
+    size_t              numFailed = 0,
+                        numVerts = 0,
+                        numFacets = 0;
+    double              sumMs = 0.0;
+    for (BatchItem const & item : items) {
+        fgout << fgnl << item.in << " -> " << item.out << " : ";
+        if (item.error.empty())
+            fgout << item.ms << " ms";
+        else {
+            fgout << "FAILED: " << item.error;
+            ++numFailed;
+        }
+        numVerts += item.numVerts;
+        numFacets += item.numFacets;
+        sumMs += item.ms;
+    }
+    // Guard against a zero duration from the millisecond timer:
+    double              rate = 1.0 / std::max(secs,0.001);
+    fgout << fgnl << items.size()-numFailed << " of " << items.size() << " converted in " << secs << " s"
+        << " (" << items.size()*rate << " files/s, " << numVerts*rate << " verts/s, "
+        << numFacets*rate << " facets/s, " << sumMs/std::max(secs*1000.0,1.0) << "x concurrency)"
+        << fgnl << textures.numDecoded << " textures decoded, " << textures.byContent.size()
+        << " distinct, " << textures.numShared << " shared in memory";
+    if (numFailed > 0)
+        fgThrow("Batch conversion failures",toString(numFailed));
+}
+
 void
 copyUvList(const CLArgs & args)
 {
@@ -872,6 +1075,7 @@ meshops(const CLArgs & args)
     vector<Cmd>   ops;
     ops.push_back(Cmd(combinesurfs,"combinesurfs","Combine surfaces from meshes with identical vertex lists"));
     ops.push_back(Cmd(convert,"convert","Convert the mesh between different formats"));
+    ops.push_back(Cmd(convertBatch,"convertBatch","Convert many meshes concurrently from a manifest or file pattern"));
     ops.push_back(Cmd(copyUvList,"copyUvList","Copy UV list from one mesh to another with same UV count"));
     ops.push_back(Cmd(copyUvs,"copyUvs","Copy UVs from one mesh to another with identical facet structure"));
     ops.push_back(Cmd(copyverts,"copyverts","Copy verts from one mesh to another with same vertex count"));
@@ -901,6 +1105,39 @@ meshops(const CLArgs & args)
 
 }
 
+void
+fgCmdMeshopsTest(CLArgs const & args)
+{
+    FGTESTDIR
+    setLoadCacheDir(Ustring());                 // Texture loads must not be satisfied by the cache
+    // Two meshes referencing the same texture file:
+    Ustring             dd = dataDir() + "base/";
+    Mesh                mouth = loadTri(dd+"Mouth.tri");
+    mouth.surfaces[0].setAlbedoMap(imgLoadAnyFormat(dd+"MouthSmall.png"));
+    savePly("m0.ply",fgSvec(mouth));
+    fileCopy("m0.ply","m1.ply");
+    {
+        TextureStore        textures;
+        Meshes              meshes;
+        for (Ustring const & fname : {Ustring("m0.ply"),Ustring("m1.ply")}) {
+            ImgLoadOverride     ovr([&textures](Ustring const & f){return *textures.load(f); });
+            meshes.push_back(meshLoadAnyFormat(fname));
+        }
+        FGASSERT(textures.numDecoded == 1);
+        for (Mesh & mesh : meshes)
+            textures.dedupe_(mesh.surfaces[0].material.albedoMap);
+        FGASSERT(meshes[0].surfaces[0].material.albedoMap == meshes[1].surfaces[0].material.albedoMap);
+        FGASSERT(meshes[0].surfaces[0].material.albedoMap->m_data == mouth.surfaces[0].material.albedoMap->m_data);
+    }
+    meshops(splitChar("mesh convertBatch -t 2 m*.ply out ply"));
+    for (char const * base : {"m0","m1"}) {
+        Mesh                mesh = meshLoadAnyFormat(String("out/")+base+".ply");
+        FGASSERT(mesh.numTriEquivs() == mouth.numTriEquivs());
+        FGASSERT(mesh.surfaces[0].material.albedoMap);
+        FGASSERT(mesh.surfaces[0].material.albedoMap->dims() == mouth.surfaces[0].material.albedoMap->dims());
+    }
+}
+
 Cmd
 fgCmdMeshopsInfo()
 {return Cmd(meshops,"mesh","3D Mesh tools"); }
@@ -146,9 +146,10 @@ clamp(const CLArgs & args)
     FgKdTree        kd(seam);
     float           scale = fgMaxElem(cDims(mesh.verts)),
                     closeSqr = sqr(scale / 10000.0f);
+    FgMagPnts       closest = kd.closest(mesh.verts);
     set<uint>       clampVertInds;
-    for (size_t ii=0; ii<mesh.verts.size(); ++ii)
-        if (kd.closest(mesh.verts[ii]).mag < closeSqr)
+    for (size_t ii=0; ii<closest.size(); ++ii)
+        if (closest[ii].mag < closeSqr)
             clampVertInds.insert(uint(ii));
     for (Morph & morph : mesh.deltaMorphs)
         for (uint ii : clampVertInds)
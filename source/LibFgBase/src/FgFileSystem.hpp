@@ -199,6 +199,41 @@ getCreationTime(const Ustring & path,uint64 & time);
 std::time_t
 getLastWriteTime(const Ustring & node);
 
+// Nanoseconds since the epoch, at whatever resolution the file system records (which may be seconds):
+uint64
+getLastWriteTimeNs(Ustring const & node);
+
+// Read-only memory mapping of an entire file, released on destruction. Throws on failure:
+class   MappedFile
+{
+public:
+    explicit
+    MappedFile(Ustring const & fname);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile const &) = delete;
+    MappedFile & operator=(MappedFile const &) = delete;
+
+    char const *
+    data() const
+    {return m_data; }
+
+    size_t
+    size() const
+    {return m_size; }
+
+    // Hint that the given byte range won't be needed soon so the OS can drop its pages from memory
+    // (they are transparently re-read from the file if accessed again):
+    void
+    discard(size_t offset,size_t size) const;
+
+private:
+    char const *        m_data = nullptr;   // nullptr for an empty file
+    size_t              m_size = 0;
+    void *              m_handle = nullptr; // Platform-specific mapping object if required
+};
+
 // Return true if any of the sources have a 'last write time' newer than any of the sinks,
 // of if any of the sinks don't exist (an error results if any of the sources don't exist):
 bool
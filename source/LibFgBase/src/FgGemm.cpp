@@ -0,0 +1,555 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Packed-panel GEMM:
+//
+// * C is computed in tiles of up to MC x NC elements, in parallel across tiles for large products.
+// * Within a tile, the depth is processed in KC slices: the slice of op(A) is packed into MR-row
+//   slivers and the slice of op(B) into NR-column slivers, so the micro-kernel reads both
+//   contiguously. Transposed operands are handled by the packing.
+// * The micro-kernel holds an MR x NR block of C in registers across the whole slice.
+//
+
+#include "stdafx.h"
+
+#include "FgMatrixV.hpp"
+#include "FgParallel.hpp"
+#include "FgSimd.hpp"
+
+using namespace std;
+
+namespace Fg {
+
+namespace {
+
+size_t constexpr    KC = 256,           // Depth of packed slices
+                    MC = 96,            // Rows in a tile. Multiple of all MR
+                    NC = 256;           // Columns in a tile. Multiple of all NR
+
+// Element (rr,cc) of op(M) is data[rr*rs + cc*cs]:
+template<class T>
+struct  Operand
+{
+    T const *           data;
+    size_t              rs;
+    size_t              cs;
+
+    Operand(MatV<T> const & m,bool trans) :
+        data(m.m_data.data()), rs(trans ? 1 : m.ncols), cs(trans ? m.ncols : 1)
+    {}
+
+    T
+    operator()(size_t rr,size_t cc) const
+    {return data[rr*rs + cc*cs]; }
+};
+
+template<class T>
+struct  Kernel
+{
+    size_t              MR;
+    size_t              NR;
+    // Adds the product of the packed slivers (depth 'kc') to the 'mr' x 'nr' block at 'c':
+    void                (*fn)(size_t kc,T const * a,T const * b,T * c,size_t ldc,size_t mr,size_t nr);
+};
+
+// Adds the MR x NR 'tile' into the 'mr' x 'nr' block at 'c':
+template<class T>
+void
+addTile(T const * tile,size_t NR,T * c,size_t ldc,size_t mr,size_t nr)
+{
+    for (size_t ii=0; ii<mr; ++ii)
+        for (size_t jj=0; jj<nr; ++jj)
+            c[ii*ldc+jj] += tile[ii*NR+jj];
+}
+
+template<class T>
+void
+kernelScalar(size_t kc,T const * a,T const * b,T * c,size_t ldc,size_t mr,size_t nr)
+{
+    T                   acc[4*4] = {};
+    for (size_t kk=0; kk<kc; ++kk, a+=4, b+=4)
+        for (size_t ii=0; ii<4; ++ii)
+            for (size_t jj=0; jj<4; ++jj)
+                acc[ii*4+jj] += a[ii] * b[jj];
+    addTile(acc,4,c,ldc,mr,nr);
+}
+
+#if defined(FG_SSE2) || defined(FG_NEON)
+
+// 128-bit vector operations:
+#ifdef FG_SSE2
+struct  V4F
+{
+    typedef float       T;
+    typedef __m128      V;
+    static size_t constexpr W = 4;
+    static V    zero() {return _mm_setzero_ps(); }
+    static V    load(T const * p) {return _mm_loadu_ps(p); }
+    static void store(T * p,V v) {_mm_storeu_ps(p,v); }
+    static V    bcast(T const * p) {return _mm_set1_ps(*p); }
+    static V    add(V x,V y) {return _mm_add_ps(x,y); }
+    static V    madd(V a,V b,V c) {return _mm_add_ps(c,_mm_mul_ps(a,b)); }
+};
+struct  V2D
+{
+    typedef double      T;
+    typedef __m128d     V;
+    static size_t constexpr W = 2;
+    static V    zero() {return _mm_setzero_pd(); }
+    static V    load(T const * p) {return _mm_loadu_pd(p); }
+    static void store(T * p,V v) {_mm_storeu_pd(p,v); }
+    static V    bcast(T const * p) {return _mm_set1_pd(*p); }
+    static V    add(V x,V y) {return _mm_add_pd(x,y); }
+    static V    madd(V a,V b,V c) {return _mm_add_pd(c,_mm_mul_pd(a,b)); }
+};
+#else
+struct  V4F
+{
+    typedef float       T;
+    typedef float32x4_t V;
+    static size_t constexpr W = 4;
+    static V    zero() {return vdupq_n_f32(0.0f); }
+    static V    load(T const * p) {return vld1q_f32(p); }
+    static void store(T * p,V v) {vst1q_f32(p,v); }
+    static V    bcast(T const * p) {return vld1q_dup_f32(p); }
+    static V    add(V x,V y) {return vaddq_f32(x,y); }
+#ifdef __aarch64__
+    static V    madd(V a,V b,V c) {return vfmaq_f32(c,a,b); }
+#else
+    static V    madd(V a,V b,V c) {return vmlaq_f32(c,a,b); }
+#endif
+};
+#ifdef __aarch64__
+#define FG_GEMM_V2D
+struct  V2D
+{
+    typedef double      T;
+    typedef float64x2_t V;
+    static size_t constexpr W = 2;
+    static V    zero() {return vdupq_n_f64(0.0); }
+    static V    load(T const * p) {return vld1q_f64(p); }
+    static void store(T * p,V v) {vst1q_f64(p,v); }
+    static V    bcast(T const * p) {return vld1q_dup_f64(p); }
+    static V    add(V x,V y) {return vaddq_f64(x,y); }
+    static V    madd(V a,V b,V c) {return vfmaq_f64(c,a,b); }
+};
+#endif
+#endif
+#ifdef FG_SSE2
+#define FG_GEMM_V2D
+#endif
+
+// c0,c1 += a * (b0,b1):
+template<class S>
+inline void
+madd2(typename S::V a,typename S::V b0,typename S::V b1,typename S::V & c0,typename S::V & c1)
+{
+    c0 = S::madd(a,b0,c0);
+    c1 = S::madd(a,b1,c1);
+}
+
+template<class S>
+inline void
+add2(typename S::T * c,typename S::V c0,typename S::V c1)
+{
+    S::store(c,S::add(S::load(c),c0));
+    S::store(c+S::W,S::add(S::load(c+S::W),c1));
+}
+
+template<class S>
+inline void
+store2(typename S::T * c,typename S::V c0,typename S::V c1)
+{
+    S::store(c,c0);
+    S::store(c+S::W,c1);
+}
+
+// 4 x 2W block:
+template<class S>
+void
+kernel128(size_t kc,typename S::T const * a,typename S::T const * b,typename S::T * c,size_t ldc,size_t mr,size_t nr)
+{
+    typedef typename S::T   T;
+    typedef typename S::V   V;
+    size_t constexpr    NR = 2*S::W;
+    V                   c00 = S::zero(), c01 = S::zero(),
+                        c10 = S::zero(), c11 = S::zero(),
+                        c20 = S::zero(), c21 = S::zero(),
+                        c30 = S::zero(), c31 = S::zero();
+    for (size_t kk=0; kk<kc; ++kk, a+=4, b+=NR) {
+        V                   b0 = S::load(b),
+                            b1 = S::load(b+S::W);
+        madd2<S>(S::bcast(a  ),b0,b1,c00,c01);
+        madd2<S>(S::bcast(a+1),b0,b1,c10,c11);
+        madd2<S>(S::bcast(a+2),b0,b1,c20,c21);
+        madd2<S>(S::bcast(a+3),b0,b1,c30,c31);
+    }
+    if ((mr == 4) && (nr == NR)) {
+        add2<S>(c      ,c00,c01);
+        add2<S>(c+ldc  ,c10,c11);
+        add2<S>(c+2*ldc,c20,c21);
+        add2<S>(c+3*ldc,c30,c31);
+    }
+    else {
+        T                   tile[4*NR];
+        store2<S>(tile     ,c00,c01);
+        store2<S>(tile+NR  ,c10,c11);
+        store2<S>(tile+2*NR,c20,c21);
+        store2<S>(tile+3*NR,c30,c31);
+        addTile(tile,NR,c,ldc,mr,nr);
+    }
+}
+
+#endif
+
+#ifdef FG_AVX2
+
+// The AVX2 kernels are written out for each type since all functions they inline must share their
+// target attribute:
+
+FG_TARGET_AVX2_FMA
+inline void
+madd2(__m256 a,__m256 b0,__m256 b1,__m256 & c0,__m256 & c1)
+{
+    c0 = _mm256_fmadd_ps(a,b0,c0);
+    c1 = _mm256_fmadd_ps(a,b1,c1);
+}
+
+FG_TARGET_AVX2_FMA
+inline void
+add2(float * c,__m256 c0,__m256 c1)
+{
+    _mm256_storeu_ps(c,_mm256_add_ps(_mm256_loadu_ps(c),c0));
+    _mm256_storeu_ps(c+8,_mm256_add_ps(_mm256_loadu_ps(c+8),c1));
+}
+
+FG_TARGET_AVX2_FMA
+inline void
+store2(float * c,__m256 c0,__m256 c1)
+{
+    _mm256_storeu_ps(c,c0);
+    _mm256_storeu_ps(c+8,c1);
+}
+
+// 6 x 16 block:
+FG_TARGET_AVX2_FMA
+void
+kernelAvx2(size_t kc,float const * a,float const * b,float * c,size_t ldc,size_t mr,size_t nr)
+{
+    __m256              c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps(),
+                        c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps(),
+                        c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps(),
+                        c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps(),
+                        c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps(),
+                        c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+    for (size_t kk=0; kk<kc; ++kk, a+=6, b+=16) {
+        __m256              b0 = _mm256_loadu_ps(b),
+                            b1 = _mm256_loadu_ps(b+8);
+        madd2(_mm256_broadcast_ss(a  ),b0,b1,c00,c01);
+        madd2(_mm256_broadcast_ss(a+1),b0,b1,c10,c11);
+        madd2(_mm256_broadcast_ss(a+2),b0,b1,c20,c21);
+        madd2(_mm256_broadcast_ss(a+3),b0,b1,c30,c31);
+        madd2(_mm256_broadcast_ss(a+4),b0,b1,c40,c41);
+        madd2(_mm256_broadcast_ss(a+5),b0,b1,c50,c51);
+    }
+    if ((mr == 6) && (nr == 16)) {
+        add2(c      ,c00,c01);
+        add2(c+ldc  ,c10,c11);
+        add2(c+2*ldc,c20,c21);
+        add2(c+3*ldc,c30,c31);
+        add2(c+4*ldc,c40,c41);
+        add2(c+5*ldc,c50,c51);
+    }
+    else {
+        float               tile[6*16];
+        store2(tile     ,c00,c01);
+        store2(tile+16  ,c10,c11);
+        store2(tile+2*16,c20,c21);
+        store2(tile+3*16,c30,c31);
+        store2(tile+4*16,c40,c41);
+        store2(tile+5*16,c50,c51);
+        addTile(tile,16,c,ldc,mr,nr);
+    }
+}
+
+FG_TARGET_AVX2_FMA
+inline void
+madd2(__m256d a,__m256d b0,__m256d b1,__m256d & c0,__m256d & c1)
+{
+    c0 = _mm256_fmadd_pd(a,b0,c0);
+    c1 = _mm256_fmadd_pd(a,b1,c1);
+}
+
+FG_TARGET_AVX2_FMA
+inline void
+add2(double * c,__m256d c0,__m256d c1)
+{
+    _mm256_storeu_pd(c,_mm256_add_pd(_mm256_loadu_pd(c),c0));
+    _mm256_storeu_pd(c+4,_mm256_add_pd(_mm256_loadu_pd(c+4),c1));
+}
+
+FG_TARGET_AVX2_FMA
+inline void
+store2(double * c,__m256d c0,__m256d c1)
+{
+    _mm256_storeu_pd(c,c0);
+    _mm256_storeu_pd(c+4,c1);
+}
+
+// 6 x 8 block:
+FG_TARGET_AVX2_FMA
+void
+kernelAvx2(size_t kc,double const * a,double const * b,double * c,size_t ldc,size_t mr,size_t nr)
+{
+    __m256d             c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd(),
+                        c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd(),
+                        c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd(),
+                        c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd(),
+                        c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd(),
+                        c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+    for (size_t kk=0; kk<kc; ++kk, a+=6, b+=8) {
+        __m256d             b0 = _mm256_loadu_pd(b),
+                            b1 = _mm256_loadu_pd(b+4);
+        madd2(_mm256_broadcast_sd(a  ),b0,b1,c00,c01);
+        madd2(_mm256_broadcast_sd(a+1),b0,b1,c10,c11);
+        madd2(_mm256_broadcast_sd(a+2),b0,b1,c20,c21);
+        madd2(_mm256_broadcast_sd(a+3),b0,b1,c30,c31);
+        madd2(_mm256_broadcast_sd(a+4),b0,b1,c40,c41);
+        madd2(_mm256_broadcast_sd(a+5),b0,b1,c50,c51);
+    }
+    if ((mr == 6) && (nr == 8)) {
+        add2(c      ,c00,c01);
+        add2(c+ldc  ,c10,c11);
+        add2(c+2*ldc,c20,c21);
+        add2(c+3*ldc,c30,c31);
+        add2(c+4*ldc,c40,c41);
+        add2(c+5*ldc,c50,c51);
+    }
+    else {
+        double              tile[6*8];
+        store2(tile    ,c00,c01);
+        store2(tile+8  ,c10,c11);
+        store2(tile+2*8,c20,c21);
+        store2(tile+3*8,c30,c31);
+        store2(tile+4*8,c40,c41);
+        store2(tile+5*8,c50,c51);
+        addTile(tile,8,c,ldc,mr,nr);
+    }
+}
+
+#endif
+
+// The 256-bit kernels are wasteful when 'N' is much less than their block width:
+
+Kernel<float>
+selectKernel(float,size_t N)
+{
+    Simd                simd = simdLevel();
+#ifdef FG_AVX2
+    if ((simd == Simd::avx2) && (N > 8))
+        return {6,16,kernelAvx2};
+#endif
+#if defined(FG_SSE2) || defined(FG_NEON)
+    if (simd >= Simd::vec128)
+        return {4,8,kernel128<V4F>};
+#endif
+    (void)simd;
+    (void)N;
+    return {4,4,kernelScalar<float>};
+}
+
+Kernel<double>
+selectKernel(double,size_t N)
+{
+    Simd                simd = simdLevel();
+#ifdef FG_AVX2
+    if ((simd == Simd::avx2) && (N > 4))
+        return {6,8,kernelAvx2};
+#endif
+#ifdef FG_GEMM_V2D
+    if (simd >= Simd::vec128)
+        return {4,4,kernel128<V2D>};
+#endif
+    (void)simd;
+    (void)N;
+    return {4,4,kernelScalar<double>};
+}
+
+// Packs rows [r0,r0+mc) and depth [k0,k0+kc) of op(A) into MR-row slivers of kc x MR, zero padded:
+template<class T>
+void
+packA(Operand<T> A,size_t r0,size_t mc,size_t k0,size_t kc,size_t MR,T * dst)
+{
+    for (size_t ii=0; ii<mc; ii+=MR) {
+        size_t              mr = cMin(MR,mc-ii);
+        for (size_t kk=0; kk<kc; ++kk) {
+            T const *           src = A.data + (r0+ii)*A.rs + (k0+kk)*A.cs;
+            for (size_t rr=0; rr<mr; ++rr)
+                *dst++ = src[rr*A.rs];
+            for (size_t rr=mr; rr<MR; ++rr)
+                *dst++ = T(0);
+        }
+    }
+}
+
+// Packs depth [k0,k0+kc) and columns [c0,c0+nc) of op(B) into NR-column slivers of kc x NR, zero padded:
+template<class T>
+void
+packB(Operand<T> B,size_t k0,size_t kc,size_t c0,size_t nc,size_t NR,T * dst)
+{
+    for (size_t jj=0; jj<nc; jj+=NR) {
+        size_t              nr = cMin(NR,nc-jj);
+        for (size_t kk=0; kk<kc; ++kk) {
+            T const *           src = B.data + (k0+kk)*B.rs + (c0+jj)*B.cs;
+            for (size_t cc=0; cc<nr; ++cc)
+                *dst++ = src[cc*B.cs];
+            for (size_t cc=nr; cc<NR; ++cc)
+                *dst++ = T(0);
+        }
+    }
+}
+
+size_t
+roundUp(size_t v,size_t m)
+{return (v + m - 1) / m * m; }
+
+// Adds op(A) * op(B) over rows [r0,r0+mc) and columns [c0,c0+nc) into C:
+template<class T>
+void
+gemmTile(Kernel<T> const & kern,size_t K,Operand<T> A,Operand<T> B,MatV<T> & C,size_t r0,size_t mc,size_t c0,size_t nc)
+{
+    // Re-used across calls since small products are frequent:
+    thread_local Svec<T>    bufA,
+                            bufB;
+    size_t              kcMax = cMin(K,KC);
+    bufA.resize(roundUp(mc,kern.MR)*kcMax);
+    bufB.resize(roundUp(nc,kern.NR)*kcMax);
+    T *                 c = C.m_data.data() + r0*C.ncols + c0;
+    for (size_t k0=0; k0<K; k0+=KC) {
+        size_t              kc = cMin(KC,K-k0);
+        packA(A,r0,mc,k0,kc,kern.MR,bufA.data());
+        packB(B,k0,kc,c0,nc,kern.NR,bufB.data());
+        for (size_t jj=0; jj<nc; jj+=kern.NR) {
+            T const *           b = bufB.data() + jj*kc;
+            for (size_t ii=0; ii<mc; ii+=kern.MR)
+                kern.fn(kc,bufA.data()+ii*kc,b,c+ii*C.ncols+jj,C.ncols,cMin(kern.MR,mc-ii),cMin(kern.NR,nc-jj));
+        }
+    }
+}
+
+template<class T>
+MatV<T>
+gemmT(MatV<T> const & A,MatV<T> const & B,bool transA,bool transB,bool threads)
+{
+    size_t              M = transA ? A.ncols : A.nrows,
+                        K = transA ? A.nrows : A.ncols,
+                        N = transB ? B.nrows : B.ncols;
+    FGASSERT(K == (transB ? B.ncols : B.nrows));
+    MatV<T>             C(M,N,T(0));
+    if ((M == 0) || (N == 0) || (K == 0))
+        return C;
+    Operand<T>          opA(A,transA),
+                        opB(B,transB);
+    // Packing is not worthwhile for tiny products:
+    if (M*N*K < 512) {
+        for (size_t rr=0; rr<M; ++rr)
+            for (size_t kk=0; kk<K; ++kk) {
+                T                   a = opA(rr,kk);
+                for (size_t cc=0; cc<N; ++cc)
+                    C.rc(rr,cc) += a * opB(kk,cc);
+            }
+        return C;
+    }
+    Kernel<T>           kern = selectKernel(T(0),N);
+    size_t              tilesM = (M + MC - 1) / MC,
+                        tilesN = (N + NC - 1) / NC;
+    auto                fn = [&](size_t tt)
+    {
+        size_t              r0 = (tt / tilesN) * MC,
+                            c0 = (tt % tilesN) * NC;
+        gemmTile(kern,K,opA,opB,C,r0,cMin(MC,M-r0),c0,cMin(NC,N-c0));
+    };
+    // Thread start-up costs tens of microseconds:
+    if (threads && (tilesM*tilesN > 1) && (double(M)*N*K > 1.0e6))
+        parallelFor(tilesM*tilesN,fn);
+    else
+        for (size_t tt=0; tt<tilesM*tilesN; ++tt)
+            fn(tt);
+    return C;
+}
+
+template<class T>
+void
+syrkT(MatV<T> const & A,MatV<T> & C)
+{
+    size_t              N = A.ncols,
+                        K = A.nrows;
+    FGASSERT((C.nrows == N) && (C.ncols == N));
+    if ((N == 0) || (K == 0))
+        return;
+    Operand<T>          opA(A,true),
+                        opB(A,false);
+    Kernel<T>           kern = selectKernel(T(0),N);
+    // Only the tiles which intersect the upper triangle:
+    Svec<Vec2UI>        tiles;
+    for (size_t r0=0; r0<N; r0+=MC)
+        for (size_t c0=(r0/NC)*NC; c0<N; c0+=NC)
+            tiles.push_back(Vec2UI(uint(r0),uint(c0)));
+    auto                fn = [&](size_t tt)
+    {
+        size_t              r0 = tiles[tt][0],
+                            c0 = tiles[tt][1];
+        gemmTile(kern,K,opA,opB,C,r0,cMin(MC,N-r0),c0,cMin(NC,N-c0));
+    };
+    if ((tiles.size() > 1) && (double(N)*N*K > 2.0e6))
+        parallelFor(tiles.size(),fn);
+    else
+        for (size_t tt=0; tt<tiles.size(); ++tt)
+            fn(tt);
+}
+
+template<class T>
+Svec<MatV<T> >
+gemmBatchT(Svec<MatV<T> > const & As,Svec<MatV<T> > const & Bs,bool transA,bool transB)
+{
+    FGASSERT(As.size() == Bs.size());
+    Svec<MatV<T> >      ret(As.size());
+    parallelForBlocks(As.size(),16,[&](size_t lo,size_t hi)
+    {
+        for (size_t ii=lo; ii<hi; ++ii)
+            ret[ii] = gemmT(As[ii],Bs[ii],transA,transB,false);
+    });
+    return ret;
+}
+
+}
+
+MatF
+gemm(MatF const & A,MatF const & B,bool transA,bool transB)
+{return gemmT(A,B,transA,transB,true); }
+
+MatD
+gemm(MatD const & A,MatD const & B,bool transA,bool transB)
+{return gemmT(A,B,transA,transB,true); }
+
+void
+syrkUpper_(MatF const & A,MatF & C)
+{syrkT(A,C); }
+
+void
+syrkUpper_(MatD const & A,MatD & C)
+{syrkT(A,C); }
+
+Svec<MatF>
+gemmBatch(Svec<MatF> const & As,Svec<MatF> const & Bs,bool transA,bool transB)
+{return gemmBatchT(As,Bs,transA,transB); }
+
+Svec<MatD>
+gemmBatch(Svec<MatD> const & As,Svec<MatD> const & Bs,bool transA,bool transB)
+{return gemmBatchT(As,Bs,transA,transB); }
+
+}
+
+// */
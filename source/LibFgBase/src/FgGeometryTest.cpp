@@ -15,6 +15,10 @@
 #include "FgBounds.hpp"
 #include "FgMath.hpp"
 #include "FgMain.hpp"
+#include "FgAffineC.hpp"
+#include "FgSimd.hpp"
+#include "FgKdTree.hpp"
+#include "FgTriAabbTree.hpp"
 
 using namespace std;
 
@@ -285,6 +289,179 @@ testLineFacetIntersect()
     FGASSERT(ret.val() == Vec3D(s,s,0));
 }
 
+static
+void
+testAffineBatch()
+{
+    Affine3F            xf {Mat33F::randNormal(),Vec3F::randNormal()};
+    Mat44F              prj = xf.asHomogenous();
+    prj.cr(0,3) = 0.1f;                                     // Perspective divide on X
+    prj.cr(3,3) = 5.0f;
+    for (Simd simd : {Simd::scalar,Simd::vec128,Simd::avx2}) {
+        setSimdLevel(simd);
+        for (size_t num : {0,1,7,13,100,70001}) {           // Largest runs across threads
+            Vec3Fs              pts(num);
+            for (Vec3F & p : pts)
+                p = Vec3F::randNormal();
+            Vec3Fs              ref(num),
+                                prjRef(num);
+            for (size_t ii=0; ii<num; ++ii) {
+                ref[ii] = xf.linear * pts[ii] + xf.translation;
+                Vec4F               h = prj * fgAsHomogVec(pts[ii]);
+                prjRef[ii] = h.subMatrix<3,1>(0,0) / h[3];
+            }
+            auto                check = [&](Vec3Fs const & vs,Vec3Fs const & rs)
+            {
+                for (size_t ii=0; ii<num; ++ii)
+                    FGASSERT(fgMaxElem(mapAbs(vs[ii]-rs[ii])) < 1.0e-5f * (1.0f + fgMaxElem(mapAbs(rs[ii]))));
+            };
+            check(mapXft(pts,xf),ref);
+            check(projectXf(prj,pts),prjRef);
+            Vec3Fs              inPlace = pts;
+            mapXf_(inPlace,xf);
+            check(inPlace,ref);
+            // Structure of arrays:
+            Floats              soa(num*3),
+                                soaOut(num*3);
+            for (size_t ii=0; ii<num; ++ii)
+                for (uint dd=0; dd<3; ++dd)
+                    soa[dd*num+ii] = pts[ii][dd];
+            float const *       in[3] = {soa.data(),soa.data()+num,soa.data()+2*num};
+            float *             out[3] = {soaOut.data(),soaOut.data()+num,soaOut.data()+2*num};
+            affineXfSoa_(xf,in,out,num);
+            Vec3Fs              res(num);
+            for (size_t ii=0; ii<num; ++ii)
+                res[ii] = Vec3F(out[0][ii],out[1][ii],out[2][ii]);
+            check(res,ref);
+        }
+    }
+    setSimdLevel(simdSupported());
+}
+
+static
+void
+testKdTree()
+{
+    for (size_t num : {1,5,9,1000}) {
+        Vec3Fs              pnts(num);
+        for (Vec3F & p : pnts)
+            p = Vec3F::randNormal();
+        if (num > 10) {
+            pnts[7] = pnts[3];                  // Duplicates
+            for (size_t ii=num/2; ii<num; ++ii)
+                pnts[ii][2] = 0.0f;             // Planar subset
+        }
+        FgKdTree            kd(pnts);
+        Vec3Fs              queries(100);
+        for (Vec3F & q : queries)
+            q = Vec3F::randNormal() * 1.5f;
+        queries[0] = pnts[0];
+        FgMagPnts           bulk = kd.closest(queries);
+        uint                k = 6;
+        Svec<FgMagPnts>     bulkK = kd.closestK(queries,k);
+        for (size_t qq=0; qq<queries.size(); ++qq) {
+            Vec3F               q = queries[qq];
+            // Brute force, sorted by distance:
+            Svec<pair<float,uint> > ref(num);
+            for (size_t ii=0; ii<num; ++ii)
+                ref[ii] = make_pair((pnts[ii]-q).mag(),uint(ii));
+            sort(ref.begin(),ref.end());
+            FgMagPnt            cls = kd.closest(q);
+            FGASSERT(cls.mag == ref[0].first);
+            FGASSERT(pnts[cls.idx] == cls.pnt);
+            FGASSERT(bulk[qq].mag == cls.mag);
+            FgMagPnts           knn = kd.closestK(q,k);
+            FGASSERT(knn.size() == std::min(size_t(k),num));
+            for (size_t ii=0; ii<knn.size(); ++ii) {
+                FGASSERT(knn[ii].mag == ref[ii].first);
+                FGASSERT(pnts[knn[ii].idx] == knn[ii].pnt);
+                FGASSERT(bulkK[qq][ii].mag == knn[ii].mag);
+            }
+            // Radius between the 20th and 21st closest so rounding doesn't matter:
+            size_t              numWithin = std::min(num,size_t(20));
+            while ((numWithin < num) && (ref[numWithin].first == ref[numWithin-1].first))
+                ++numWithin;                    // Duplicates
+            float               magR = (numWithin < num) ?
+                                    0.5f * (ref[numWithin-1].first + ref[numWithin].first) :
+                                    2.0f * ref.back().first + 1.0f;
+            FgMagPnts           within = kd.withinRadius(q,std::sqrt(magR));
+            FGASSERT(within.size() == numWithin);
+            for (size_t ii=0; ii<within.size(); ++ii)
+                FGASSERT(within[ii].mag == ref[ii].first);
+        }
+    }
+}
+
+static
+void
+testTriAabbTree()
+{
+    // Wavy height field grid plus a few degenerate triangles:
+    uint                sz = 30;
+    Vec3Fs              verts;
+    Vec3UIs             tris;
+    for (uint yy=0; yy<sz; ++yy)
+        for (uint xx=0; xx<sz; ++xx)
+            verts.push_back(Vec3F(xx,yy,std::sin(0.3f*xx)*std::cos(0.2f*yy)*3.0f) / float(sz));
+    for (uint yy=0; yy+1<sz; ++yy) {
+        for (uint xx=0; xx+1<sz; ++xx) {
+            uint                v = yy*sz + xx;
+            tris.push_back(Vec3UI(v,v+1,v+sz+1));
+            tris.push_back(Vec3UI(v,v+sz+1,v+sz));
+        }
+    }
+    tris.push_back(Vec3UI(0,0,0));
+    tris.push_back(Vec3UI(0,1,2));
+    tris.push_back(Vec3UI(3,3,4));
+    Vec3Fs              queries(200);
+    for (Vec3F & q : queries)
+        q = Vec3F(0.5f) + Vec3F::randNormal() * 0.5f;
+    queries[0] = verts[sz+1];
+    auto                check = [&](TriAabbTree const & tree)
+    {
+        TriClosests         bulk = tree.closest(queries);
+        for (size_t qq=0; qq<queries.size(); ++qq) {
+            Vec3D               q(queries[qq]);
+            double              refMag = numeric_limits<double>::max();
+            for (Vec3UI t : tris) {
+                FgVecMag            vm = fgClosestPointInTri(q,Vec3D(verts[t[0]]),Vec3D(verts[t[1]]),Vec3D(verts[t[2]]));
+                setIfLess(refMag,vm.mag);
+            }
+            TriClosest          cls = tree.closest(queries[qq]);
+            // The reference can be slightly worse near edges due to its own tolerances:
+            FGASSERT(cls.mag < refMag + 1.0e-5 * (refMag + 1.0e-2));
+            FGASSERT(cls.mag >= refMag * 0.999);
+            FGASSERT(std::abs((cls.pos - queries[qq]).mag() - cls.mag) < 1.0e-5 * (refMag + 1.0e-2));
+            Vec3UI              t = tris[cls.triIdx];
+            Vec3F               pos = verts[t[0]]*cls.baryCoord[0] + verts[t[1]]*cls.baryCoord[1] + verts[t[2]]*cls.baryCoord[2];
+            FGASSERT((pos - cls.pos).mag() < 1.0e-10f);
+            FGASSERT(std::abs(cls.baryCoord[0]+cls.baryCoord[1]+cls.baryCoord[2] - 1.0f) < 1.0e-5f);
+            for (uint dd=0; dd<3; ++dd)
+                FGASSERT(cls.baryCoord[dd] > -1.0e-5f);
+            FGASSERT(bulk[qq].mag == cls.mag);
+            FGASSERT(bulk[qq].triIdx == cls.triIdx);
+        }
+    };
+    TriAabbTree         tree(verts,tris);
+    check(tree);
+    for (Vec3F & v : verts)
+        v += Vec3F::randNormal() * 0.01f;
+    tree.refit(verts);
+    check(tree);
+    TriAabbTree         single(verts,Vec3UIs(1,tris[5]));
+    FGASSERT(single.closest(queries[1]).triIdx == 0);
+    // Two equal vertices with the query beside the remaining edge:
+    Vec3F               v0 = verts[sz],
+                        v1 = verts[sz+1],
+                        mid = (v0 + v1) * 0.5f,
+                        off = crossProduct(v1-v0,Vec3F(0,0,1));
+    TriAabbTree         collapsed(verts,Vec3UIs(1,Vec3UI(sz,sz,sz+1)));
+    TriClosest          cls = collapsed.closest(mid + off);
+    FGASSERT(std::abs(cls.mag - off.mag()) < 1.0e-5f * off.mag());
+    FGASSERT((cls.pos - mid).mag() < 1.0e-5f * off.mag());
+    FGASSERT(std::abs(cls.baryCoord[0]+cls.baryCoord[1]+cls.baryCoord[2] - 1.0f) < 1.0e-5f);
+}
+
 void
 fgGeometryTest(const CLArgs &)
 {
@@ -297,6 +474,9 @@ fgGeometryTest(const CLArgs &)
     testRayPlaneIntersect();
     testPointInTriangle();
     testLineFacetIntersect();
+    testAffineBatch();
+    testKdTree();
+    testTriAabbTree();
 }
 
 void
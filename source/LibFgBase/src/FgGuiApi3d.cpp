@@ -35,11 +35,7 @@ intersectMeshes(
         RendMesh const &       rendMesh = rendMeshes[mm];
         Mesh const &        mesh = rendMesh.origMeshN.cref();
         Vec3Fs const &         verts = rendMesh.posedVertsN.cref();
-        Vec3Fs                 pvs(verts.size());
-        for (size_t ii=0; ii<pvs.size(); ++ii) {
-            Vec4F            v = invXform * fgAsHomogVec(verts[ii]);
-            pvs[ii] = v.subMatrix<3,1>(0,0) / v[3];
-        }
+        Vec3Fs                 pvs = projectXf(invXform,verts);
         for (size_t ss=0; ss<mesh.surfaces.size(); ++ss) {
             const Surf & surf = mesh.surfaces[ss];
             size_t              numTriEquivs = surf.numTriEquivs();
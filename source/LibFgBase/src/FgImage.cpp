@@ -7,7 +7,9 @@
 #include "stdafx.h"
 
 #include "FgImage.hpp"
+#include "FgImageResample.hpp"
 #include "FgMath.hpp"
+#include "FgParallel.hpp"
 
 using namespace std;
 
@@ -258,13 +260,11 @@ fgImgShrinkHgt2(const ImgC4UC & src)
     return dst;
 }
 
-// RGBA -> mono uses rec709
 void
 imgConvert_(const ImgC4UC &src,ImgUC &dst)
 {
-    dst.resize(src.width(),src.height());
-    for (size_t ii=0; ii<dst.numPixels(); ++ii)
-        dst[ii] = src[ii].rec709();
+    dst.resize(src.dims());
+    luminanceRow_(src.data(),dst.data(),dst.numPixels());
 }
 
 void    imgConvert_(const ImgUC &src,ImgC4UC &dst)
@@ -276,6 +276,20 @@ void    imgConvert_(const ImgUC &src,ImgC4UC &dst)
     }
 }
 
+void
+imgConvert_(ImgC4UC const & src,ImgC4F & dst)
+{
+    dst.resize(src.dims());
+    convertRow_(src.data(),dst.data(),dst.numPixels());
+}
+
+void
+imgConvert_(ImgC4F const & src,ImgC4UC & dst)
+{
+    dst.resize(src.dims());
+    convertRow_(src.data(),dst.data(),dst.numPixels());
+}
+
 void
 fgImgPntRescaleConvert(
     const ImgD    &src,
@@ -315,77 +329,12 @@ fgImgGetIrcsToBounds(
 
 void
 fgImgResize(
-	const ImgC4UC & src,
-	ImgC4UC       & dst)
+    const ImgC4UC & src,
+    ImgC4UC       & dst)
 {
     FGASSERT(!src.empty());
     FGASSERT(!dst.empty());
-    typedef ImgC4UC          ImageType;
-    typedef ImageType::PixelType PixelType;
-	uint        swid = src.width(),
-                shgt = src.height(),
-                wid = dst.width(),
-                hgt = dst.height();
-    if ((wid == swid) && (hgt == shgt)) {
-        dst = src;
-		return;
-	}
-	float   sx = (float)wid / (float)swid,
-            sy   = (float)hgt / (float)shgt;
-	const PixelType *srcPtr = src.data();
-	PixelType       *dstPtr	= dst.data();
-	uint        srcStep = src.width(),
-                dstStep  = dst.width();
-	float       ex    = 1.0f / sx,
-                ey      = 1.0f / sy,
-                invArea	= 1.0f / (ex * ey);
-	for	(uint yDstRcs=0; yDstRcs<hgt; yDstRcs++) {
-		// Calculate the y pixel bounds in the source image IRCS
-		// Note that we need to check the upper bound since
-		// this algorithm will want to add an out of bounds pixel
-		// with weight 0. This still works with the weighting
-		// algorithm in the inner loop since the float value
-		// will only ever just hit the out of bounds integer
-		// value and not exceed it.
-		float	yblo = (float)yDstRcs * ey,
-				ybhi = yblo + ey;
-		uint	yblob = (uint)yblo,
-				ybhib = (uint)ybhi;
-		if (ybhib >= shgt)
-            --ybhib;
-		for (uint xDstRcs=0; xDstRcs<wid; xDstRcs++) {
-            // Calculate the x pixel bounds in the source image IRCS
-			float	xblo = (float)xDstRcs * ex,
-					xbhi = xblo + ex;
-			uint	xblob = (uint)xblo,
-					xbhib = (uint)xbhi;
-			if (xbhib >= swid)
-                --xbhib;
-            // Now sum up the contributions of the source pixels
-            // that fall within this back-projected window.
-			Rgba<float> acc, fpix;
-			for (uint yy=yblob; yy<=ybhib; yy++) {
-				float	yfac = 1.0f;
-				if (yy == yblob)
-					yfac -= yblo - (float)yblob;
-				if (yy == ybhib)
-					yfac -= (float)(ybhib+1) - ybhi;
-				for (uint xx=xblob; xx<=xbhib; xx++) {
-					float	xfac = 1.0f;
-					if (xx == xblob)
-						xfac -= xblo - (float)xblob;
-					if (xx == xbhib)
-						xfac -= (float)(xbhib+1) - xbhi;
-					scast_(srcPtr[yy*srcStep + xx],fpix);
-					acc += fpix * xfac * yfac;
-				}
-			}
-            // Divide by the area of the back-project and convert
-            // back to fixed point.
-            round_(acc * invArea,dstPtr[xDstRcs]);
-		}
-		dstPtr += dstStep;
-	}
+    dst = imgResize(src,dst.dims(),ResampleFilter::box);
 }
 
 ImgC4UC
@@ -466,14 +415,40 @@ fgPaintDot(ImgC4UC & img,Vec2F ipcs,Vec4UC c,uint radius)
 
 // Creates a mipmap from the given image; the original will be downsampled
 // to a power of 2 if necessary:
-vector<ImgC4UC>
-fgMipMap(const ImgC4UC & img)
-{
-    vector<ImgC4UC>     ret(log2Ceil(fgMinElem(img.dims()))); // To min elem size 2
-    fgResizePow2Ceil_(img,ret[0]);   // Just copies if already pow2 dims
-    for (size_t sl=1; sl<ret.size(); ++sl) {
-        const ImgC4UC & src = ret[sl-1];
-        ret[sl] = fgImgShrink2(src);
+ImgPyramid<RgbaUC>
+mipMapPyramid(ImgC4UC const & img)
+{
+    Svec<Vec2UI>        dims(log2Ceil(fgMinElem(img.dims())));  // To min elem size 2
+    if (dims.empty())
+        return ImgPyramid<RgbaUC>();
+    ImgC4UC             top;
+    fgResizePow2Ceil_(img,top);     // Just copies if already pow2 dims
+    dims[0] = top.dims();
+    for (size_t ll=1; ll<dims.size(); ++ll)
+        dims[ll] = dims[ll-1] / 2U;
+    ImgPyramid<RgbaUC>  ret(dims);
+    copy(top.m_data.begin(),top.m_data.end(),ret.levelPtr(0));
+    for (size_t ll=1; ll<dims.size(); ++ll) {
+        size_t              sw = dims[ll-1][0],
+                            dw = dims[ll][0];
+        RgbaUC const *      src = ret.levelPtr(ll-1);
+        RgbaUC *            dst = ret.levelPtr(ll);
+        parallelForBlocks(dims[ll][1],16,[=](size_t lo,size_t hi)
+        {
+            for (size_t yd=lo; yd<hi; ++yd) {
+                RgbaUC const *      s1 = src + 2*yd*sw;
+                RgbaUC const *      s2 = s1 + sw;
+                RgbaUC *            d = dst + yd*dw;
+                // As 'fgImgShrink2':
+                for (size_t xd=0; xd<dw; ++xd) {
+                    size_t              xs1 = xd * 2,
+                                        xs2 = xs1 + 1;
+                    RgbaUS              acc = RgbaUS(s1[xs1]) + RgbaUS(s1[xs2]) +
+                                              RgbaUS(s2[xs1]) + RgbaUS(s2[xs2]) + RgbaUS(1,1,1,1);
+                    d[xd] = RgbaUC(acc/4);
+                }
+            }
+        });
     }
     return ret;
 }
@@ -489,16 +464,91 @@ fgImgToF3(const ImgC4UC & img)
     return ret;
 }
 
-Img3Fs
-fgSsi(const Img3F & img,uchar borderPolicy)
+namespace {
+
+// Vertical [1 2 1] pass for row 'yy' of an image of height 'hgt', given that row within a
+// buffer of contiguous rows of width 'wid':
+void
+ssiSmoothVert(Vec3F const * row,size_t yy,size_t wid,size_t hgt,uchar borderPolicy,float factor,Vec3F * dst)
+{
+    float               edge = float(2+borderPolicy) * factor;
+    if (yy == 0)
+        for (size_t xx=0; xx<wid; ++xx)
+            dst[xx] = row[xx]*edge + row[xx+wid]*factor;
+    else if (yy == hgt-1)
+        for (size_t xx=0; xx<wid; ++xx)
+            dst[xx] = row[xx-wid]*factor + row[xx]*edge;
+    else
+        fgSmoothFloatVert(row-wid,row,row+wid,dst,uint(wid),factor);
+}
+
+// Smooths 'src' twice into 'dst' and decimates the result into 'next', in parallel bands of rows.
+// Each band recomputes the 2 rows of overlap it needs on each side so the bands are independent:
+void
+ssiLevel(Vec3F const * src,Vec2UI dims,uchar borderPolicy,Vec3F * dst,Vec3F * next)
 {
-    Img3Fs        ret(log2Floor(fgMinElem(img.dims()))+1);
-    ret[0] = img;
-    for (size_t ii=0; ii<ret.size()-1; ++ii) {
-        fgSmoothFloat(ret[ii],ret[ii],borderPolicy);
-        fgSmoothFloat(ret[ii],ret[ii],borderPolicy);
-        fgShrink2Float(ret[ii],ret[ii+1]);
+    size_t const        band = 32;      // Even so each 2x2 block lies within a band
+    size_t              wid = dims[0],
+                        hgt = dims[1],
+                        nextWid = wid/2,
+                        nextHgt = hgt/2;
+    parallelFor((hgt+band-1)/band,[=](size_t bb)
+    {
+        size_t              y0 = bb*band,
+                            y1 = std::min(y0+band,hgt),
+                            hLo = (y0 < 2) ? 0 : y0-2,      // Rows needed after horizontal passes
+                            hHi = std::min(y1+2,hgt),
+                            vLo = (y0 < 1) ? 0 : y0-1,      // Rows needed after first vertical pass
+                            vHi = std::min(y1+1,hgt);
+        Vec3Fs              tmp(wid),
+                            hs((hHi-hLo)*wid),
+                            vs((vHi-vLo)*wid);
+        for (size_t yy=hLo; yy<hHi; ++yy) {
+            fgSmoothFloat1D(src+yy*wid,tmp.data(),uint(wid),borderPolicy);
+            fgSmoothFloat1D(tmp.data(),&hs[(yy-hLo)*wid],uint(wid),borderPolicy);
+        }
+        for (size_t yy=vLo; yy<vHi; ++yy)
+            ssiSmoothVert(&hs[(yy-hLo)*wid],yy,wid,hgt,borderPolicy,1.0f,&vs[(yy-vLo)*wid]);
+        // All 4 passes are normalized at once:
+        for (size_t yy=y0; yy<y1; ++yy)
+            ssiSmoothVert(&vs[(yy-vLo)*wid],yy,wid,hgt,borderPolicy,1.0f/256.0f,dst+yy*wid);
+        // As 'fgShrink2Float':
+        for (size_t yn=y0/2; (yn<nextHgt) && (2*yn+1<y1); ++yn) {
+            Vec3F const *       r0 = dst + 2*yn*wid;
+            Vec3F const *       r1 = r0 + wid;
+            Vec3F *             n = next + yn*nextWid;
+            for (size_t xn=0; xn<nextWid; ++xn)
+                n[xn] = (r0[2*xn] + r0[2*xn+1] + r1[2*xn+1] + r1[2*xn]) / 4.0f;
+        }
+    });
+}
+
+}
+
+ImgPyramid<Vec3F>
+ssiPyramid(const Img3F & img,uchar borderPolicy)
+{
+    Svec<Vec2UI>        dims(log2Floor(fgMinElem(img.dims()))+1);
+    dims[0] = img.dims();
+    for (size_t ll=1; ll<dims.size(); ++ll)
+        dims[ll] = dims[ll-1] / 2U;
+    ImgPyramid<Vec3F>   ret(dims);
+    size_t              last = dims.size()-1;
+    // Unsmoothed input for each intermediate level alternates between two scratch buffers.
+    // The last level is not smoothed so it is decimated directly into place:
+    Vec3Fs              scratch[2];
+    Vec3F const *       src = img.data();
+    for (size_t ll=0; ll<last; ++ll) {
+        Vec3F *             next = ret.levelPtr(last);
+        if (ll+1 < last) {
+            scratch[ll%2].resize(dims[ll+1].cmpntsProduct());
+            next = scratch[ll%2].data();
+        }
+        ssiLevel(src,dims[ll],borderPolicy,ret.levelPtr(ll),next);
+        src = next;
     }
+    if (last == 0)
+        copy(img.m_data.begin(),img.m_data.end(),ret.levelPtr(0));
     return ret;
 }
 
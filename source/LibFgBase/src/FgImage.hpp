@@ -69,7 +69,7 @@ sampleAlpha(const ImgC4UC & img,Vec2F coordIucs);
 // Sample an image with coordinates clipped to image boundaries:
 template<typename T>
 typename Traits<T>::Floating
-sampleClip(Img<T> const & img,Vec2F coordIucs)
+sampleClip(ImgCView<T> const & img,Vec2F coordIucs)
 {
     typedef typename Traits<T>::Floating    Acc;
     Acc                 ret(0);
@@ -80,6 +80,10 @@ sampleClip(Img<T> const & img,Vec2F coordIucs)
     }
     return ret;
 }
+template<typename T>
+typename Traits<T>::Floating
+sampleClip(Img<T> const & img,Vec2F coordIucs)
+{return sampleClip(img.cview(),coordIucs); }
 
 template<class T>
 Mat<T,2,2>
@@ -181,12 +185,34 @@ fgImgMagnify(const Img<T> & img,size_t fac)
     return ret;
 }
 
+// Vectorized (see FgSimd.hpp) row kernels for RGBA pixels:
+
+// In-place alpha weighting, identical to 'Rgba::alphaWeight':
+void    alphaWeightRow_(RgbaUC * pixels,size_t num);
+// Inverse of the above, rounded and clamped. Color is zero where alpha is zero:
+void    alphaUnweightRow_(RgbaUC * pixels,size_t num);
+// In-place compositing of alpha-weighted pixels, identical to 'fgCompositeFragmentUnweighted':
+void    compositeRow_(RgbaUC const * foreground,RgbaUC * background,size_t num);
+// Rec.709 luminance in fixed point, rounded down. Greys are unchanged:
+void    luminanceRow_(RgbaUC const * src,uchar * dst,size_t num);
+void    convertRow_(RgbaUC const * src,RgbaF * dst,size_t num);
+// Clamped to [0,255] then rounded down:
+void    convertRow_(RgbaF const * src,RgbaUC * dst,size_t num);
+
+// RGBA -> mono uses rec709 (see 'luminanceRow_'):
 void
 imgConvert_(const ImgC4UC & src,ImgUC & dst);
 
 void
 imgConvert_(const ImgUC & src,ImgC4UC & dst);
 
+void
+imgConvert_(ImgC4UC const & src,ImgC4F & dst);
+
+// Channel values are clamped to [0,255] then rounded down:
+void
+imgConvert_(ImgC4F const & src,ImgC4UC & dst);
+
 inline
 ImgC4UC
 imgUcTo4Uc(ImgUC const & img)
@@ -198,8 +224,7 @@ imgUcTo4Uc(ImgUC const & img)
 
 // Resize to the destination image dimensions, by shrinking or expanding in each dimension.
 // Samples the exact proportional amount of the source image covered by the destination image
-// pixel for shrinking dimensions, which effectively uses bilinear interpolation for dilating
-// dimensions:
+// pixel. Same as 'imgResize' with the box filter; see FgImageResample.hpp for smoother filters:
 void
 fgImgResize(
     const ImgC4UC & src,
@@ -238,15 +263,17 @@ fgImgFlipVertical(Img<T> & img)
 
 template<class T>
 Img<T>
-fgFlipHoriz(const Img<T> & img)
+fgFlipHoriz(ImgCView<T> const & img)
 {
     Img<T>  ret(img.dims());
-    uint        xh = img.width()-1;
-    for (uint yy=0; yy<img.height(); ++yy) {
-        for (uint xx=0; xx<img.width(); ++xx)
-            ret.xy(xh-xx,yy) = img.xy(xx,yy); }
+    for (uint yy=0; yy<img.height(); ++yy)
+        std::reverse_copy(img.rowPtr(yy),img.rowPtr(yy)+img.width(),ret.rowPtr(yy));
     return ret;
 }
+template<class T>
+Img<T>
+fgFlipHoriz(const Img<T> & img)
+{return fgFlipHoriz(img.cview()); }
 
 template<class T>
 inline void
@@ -287,20 +314,40 @@ fgSmoothUint1D(
         dstPtr[ii] = Acc(srcPtr[ii-1]) + Acc(srcPtr[ii])*2 + Acc(srcPtr[ii+1]);
     dstPtr[num-1] = Acc(srcPtr[num-2]) + Acc(srcPtr[num-1])*(2+borderPolicy);
 }
+template<class T>
+void
+fgSmoothUintVert(
+    const typename FgConvTraits<T>::Acc *a0,
+    const typename FgConvTraits<T>::Acc *a1,
+    const typename FgConvTraits<T>::Acc *a2,
+    T                   *dstPtr,
+    uint                num)
+{
+    typedef typename FgConvTraits<T>::Acc     Acc;
+    // Add 7 to minimize rounding bias. Adding 8 would bias the other way so we have to
+    // settle for a small amount of downward rounding bias unless we want to pseudo-randomize:
+    for (uint xx=0; xx<num; ++xx)
+        dstPtr[xx] = T((a0[xx] + a1[xx]*2 + a2[xx] + Acc(7)) / 16);
+}
+// Vectorized (see FgSimd.hpp) overloads of the above for the common pixel types, with identical results:
+void    fgSmoothUint1D(const uchar *,ushort *,uint,uchar);
+void    fgSmoothUint1D(const RgbaUC *,RgbaUS *,uint,uchar);
+void    fgSmoothUintVert(const ushort *,const ushort *,const ushort *,uchar *,uint);
+void    fgSmoothUintVert(const RgbaUS *,const RgbaUS *,const RgbaUS *,RgbaUC *,uint);
 // Applies a [1 2 1] outer product 2D kernel smoothing using border replication to an
 // UNISGNED INTEGER channel image in a preicsion-friendly, cache-friendly way.
 // The Source and desination images can be the same, for in-place convolution:
 template<class T>
 void
 fgSmoothUint(
-    const Img<T> &  src,
-    Img<T> &        dst,
+    ImgCView<T> const & src,
+    ImgView<T> const &  dst,                // Must have same dims as 'src'
     uchar               borderPolicy=1)     // 0 - zero border policy, 1 - replication border policy
 {
     typedef typename FgConvTraits<T>::Acc     Acc;
     FGASSERT((src.width() > 1) && (src.height() > 1));  // Algorithm not designed for dim < 2
     FGASSERT((borderPolicy == 0) || (borderPolicy == 1));
-    dst.resize(src.width(),src.height());
+    FGASSERT(src.dims() == dst.dims());
     Img<Acc> acc(src.width(),3);                  // Accumulator image
     T           *dstPtr = dst.rowPtr(0);
     Acc         *accPtr0,
@@ -309,8 +356,6 @@ fgSmoothUint(
     fgSmoothUint1D(src.rowPtr(0),accPtr1,src.width(),borderPolicy);
     fgSmoothUint1D(src.rowPtr(1),accPtr2,src.width(),borderPolicy);
     for (uint xx=0; xx<src.width(); xx++) {
-        // Add 7 to minimize rounding bias. Adding 8 would bias the other way so we have to
-        // settle for a small amount of downward rounding bias unless we want to pseudo-randomize:
         Acc        tmp = accPtr1[xx]*(2+borderPolicy) + accPtr2[xx] + Acc(7);
         dstPtr[xx] = T(tmp / 16);
     }
@@ -320,21 +365,31 @@ fgSmoothUint(
         accPtr1 = acc.rowPtr(yy%3),
         accPtr2 = acc.rowPtr((yy+1)%3);
         fgSmoothUint1D(src.rowPtr(yy+1),accPtr2,src.width(),borderPolicy);
-        for (uint xx=0; xx<src.width(); ++xx)
-            dstPtr[xx] = T((accPtr0[xx] + accPtr1[xx]*2 + accPtr2[xx] + Acc(7)) / 16);
+        fgSmoothUintVert(accPtr0,accPtr1,accPtr2,dstPtr,src.width());
     }
     dstPtr = dst.rowPtr(dst.height()-1);
     for (uint xx=0; xx<dst.width(); ++xx)
         dstPtr[xx] = T((accPtr1[xx] + accPtr2[xx]*(2+borderPolicy) + Acc(7)) / 16);
 }
 template<class T>
+void
+fgSmoothUint(const Img<T> & src,Img<T> & dst,uchar borderPolicy=1)
+{
+    dst.resize(src.dims());
+    fgSmoothUint(src.cview(),dst.view(),borderPolicy);
+}
+template<class T>
 Img<T>
-fgSmoothUint(const Img<T> & src,uchar borderPolicy=1)
+fgSmoothUint(ImgCView<T> const & src,uchar borderPolicy=1)
 {
-    Img<T>      ret;
-    fgSmoothUint(src,ret,borderPolicy);
+    Img<T>      ret(src.dims());
+    fgSmoothUint(src,ret.view(),borderPolicy);
     return ret;
 }
+template<class T>
+Img<T>
+fgSmoothUint(const Img<T> & src,uchar borderPolicy=1)
+{return fgSmoothUint(src.cview(),borderPolicy); }
 
 // Use of the __restrict keyword for the pointer args below made no speed difference here (msvc2012).
 // Perhaps the compiler is smart enough to look at the calling context:
@@ -353,38 +408,65 @@ fgSmoothFloat1D(
 }
 template<class T>
 void
-fgSmoothFloat2D(
-    const T *   srcPtr,
-    T *         dstPtr,         // Must not overlap with srcPtr
+fgSmoothFloatVert(
+    const T *   a0,
+    const T *   a1,
+    const T *   a2,
+    T *         dstPtr,
     uint        wid,
-    uint        hgt,
-    uchar       borderPolicy,   // See below
-    float       fac=1.0f/4.0f)  // Per-axis kernel normalization factor
+    float       factor)
 {
+    for (uint xx=0; xx<wid; ++xx)
+        dstPtr[xx] = (a0[xx] + a1[xx] * 2 + a2[xx]) * factor;
+}
+// Vectorized overloads of the above:
+void    fgSmoothFloat1D(const float *,float *,uint,uchar);
+void    fgSmoothFloat1D(const Vec3F *,Vec3F *,uint,uchar);
+void    fgSmoothFloatVert(const float *,const float *,const float *,float *,uint,float);
+void    fgSmoothFloatVert(const Vec3F *,const Vec3F *,const Vec3F *,Vec3F *,uint,float);
+template<class T>
+void
+fgSmoothFloat2D(
+    ImgCView<T> const & src,
+    ImgView<T> const &  dst,            // Same dims as 'src'. Can be the same memory for in-place
+    uchar               borderPolicy,   // See below
+    float               fac=1.0f/4.0f)  // Per-axis kernel normalization factor
+{
+    FGASSERT(src.dims() == dst.dims());
+    uint        wid = src.width(),
+                hgt = src.height();
     float       factor = fac*fac;
     Img<T>     acc(wid,3);
-    T           *accPtr0,
+    T           *dstPtr = dst.rowPtr(0),
+                *accPtr0,
                 *accPtr1 = acc.rowPtr(0),
                 *accPtr2 = acc.rowPtr(1);
-    fgSmoothFloat1D(srcPtr,accPtr1,wid,borderPolicy);
-    srcPtr += wid;
-    fgSmoothFloat1D(srcPtr,accPtr2,wid,borderPolicy);
+    fgSmoothFloat1D(src.rowPtr(0),accPtr1,wid,borderPolicy);
+    fgSmoothFloat1D(src.rowPtr(1),accPtr2,wid,borderPolicy);
     for (uint xx=0; xx<wid; ++xx)
         dstPtr[xx] = (accPtr1[xx]*(2+borderPolicy) + accPtr2[xx]) * factor;
     for (uint yy=1; yy<hgt-1; ++yy) {
-        dstPtr += wid;
-        srcPtr += wid;
+        dstPtr = dst.rowPtr(yy);
         accPtr0 = acc.rowPtr((yy-1)%3);
         accPtr1 = acc.rowPtr(yy%3);
         accPtr2 = acc.rowPtr((yy+1)%3);
-        fgSmoothFloat1D(srcPtr,accPtr2,wid,borderPolicy);
-        for (uint xx=0; xx<wid; ++xx)
-            dstPtr[xx] = (accPtr0[xx] + accPtr1[xx] * 2 + accPtr2[xx]) * factor;
+        fgSmoothFloat1D(src.rowPtr(yy+1),accPtr2,wid,borderPolicy);
+        fgSmoothFloatVert(accPtr0,accPtr1,accPtr2,dstPtr,wid,factor);
     }
-    dstPtr += wid;
+    dstPtr = dst.rowPtr(hgt-1);
     for (uint xx=0; xx<wid; ++xx)
         dstPtr[xx] = (accPtr1[xx] + accPtr2[xx]*(2+borderPolicy)) * factor;
 }
+template<class T>
+void
+fgSmoothFloat2D(
+    const T *   srcPtr,
+    T *         dstPtr,
+    uint        wid,
+    uint        hgt,
+    uchar       borderPolicy,
+    float       fac=1.0f/4.0f)
+{fgSmoothFloat2D(ImgCView<T>(srcPtr,Vec2UI(wid,hgt)),ImgView<T>(dstPtr,Vec2UI(wid,hgt)),borderPolicy,fac); }
 // Applies a [1 2 1] outer product 2D kernel smoothing to a floating point channel
 // image in a cache-friendly way.
 // The Source and destination images can be the same, for in-place convolution.
@@ -398,7 +480,18 @@ fgSmoothFloat(
     FGASSERT((src.width() > 1) && (src.height() > 1));  // Algorithm not designed for dim < 2
     FGASSERT((borderPolicy == 0) || (borderPolicy == 1));
     dst.resize(src.dims());
-    fgSmoothFloat2D(src.data(),dst.data(),src.width(),src.height(),borderPolicy);
+    fgSmoothFloat2D(src.cview(),dst.view(),borderPolicy);
+}
+template<class T>
+void
+fgSmoothFloat(
+    ImgCView<T> const & src,
+    ImgView<T> const &  dst,                // Same dims as 'src'
+    uchar               borderPolicy)
+{
+    FGASSERT((src.width() > 1) && (src.height() > 1));
+    FGASSERT((borderPolicy == 0) || (borderPolicy == 1));
+    fgSmoothFloat2D(src,dst,borderPolicy);
 }
 
 // Only defined for binarized images, output is binarized:
@@ -440,6 +533,9 @@ fgConvolveFloatHoriz(
         dstPtr[sz-1] += srcPtrs[jj][sz-2] * krn.rc(jj,0) +
                         srcPtrs[jj][sz-1] * (krn.rc(jj,1)+krn.rc(jj,2)*borderPolicy);
 }
+// Vectorized overloads of the above:
+void    fgConvolveFloatHoriz(const float * srcPtrs[3],const Mat33F &,float *,uint,uchar);
+void    fgConvolveFloatHoriz(const Vec3F * srcPtrs[3],const Mat33F &,Vec3F *,uint,uchar);
 template<class Pixel>
 void
 fgConvolveFloat(
@@ -550,25 +646,22 @@ fgImgSsd(
 
 template<class T>
 Img<T>
-fgJoinHoriz(const Img<T> & l,const Img<T> & r)
+fgJoinHoriz(ImgCView<T> const & l,ImgCView<T> const & r)
 {
-    Img<T>      ret;
     if (l.empty())
-        ret = r;
-    else if (r.empty())
-        ret = l;
-    else {
-        FGASSERT(l.height() == r.height());
-        ret.resize(l.width()+r.width(),l.height());
-        Vec2UI       off;
-        for (Iter2UI it(l.dims()); it.valid(); it.next())
-            ret[it()] = l[it()];
-        off[0] += l.dims()[0];
-        for (Iter2UI it(r.dims()); it.valid(); it.next())
-            ret[it()+off] = r[it()];
-    }
+        return Img<T>(r);
+    if (r.empty())
+        return Img<T>(l);
+    FGASSERT(l.height() == r.height());
+    Img<T>      ret(l.width()+r.width(),l.height());
+    imgCopy_(l,ret.view(Vec2UI(0),l.dims()));
+    imgCopy_(r,ret.view(Vec2UI(l.width(),0),r.dims()));
     return ret;
 }
+template<class T>
+Img<T>
+fgJoinHoriz(const Img<T> & l,const Img<T> & r)
+{return fgJoinHoriz(l.cview(),r.cview()); }
 
 template<class T>
 Img<T>
@@ -584,55 +677,61 @@ fgJoinHoriz(const Img<T> & l,const Img<T> & c,const Img<T> & r)
     else {
         FGASSERT((l.height() == c.height()) && (c.height() == r.height()));
         ret.resize(l.width()+c.width()+r.width(),l.height());
-        Vec2UI   off;
-        for (Iter2UI it(l.dims()); it.valid(); it.next())
-            ret[it()] = l[it()];
-        off[0] += l.dims()[0];
-        for (Iter2UI it(c.dims()); it.valid(); it.next())
-            ret[it()+off] = c[it()];
-        off[0] += c.dims()[0];
-        for (Iter2UI it(r.dims()); it.valid(); it.next())
-            ret[it()+off] = r[it()];
+        imgCopy_(l.cview(),ret.view(Vec2UI(0),l.dims()));
+        imgCopy_(c.cview(),ret.view(Vec2UI(l.width(),0),c.dims()));
+        imgCopy_(r.cview(),ret.view(Vec2UI(l.width()+c.width(),0),r.dims()));
     }
     return ret;
 }
 
 template<class T>
 Img<T>
-fgJoinVert(const Img<T> & t,const Img<T> & b)
+fgJoinVert(ImgCView<T> const & t,ImgCView<T> const & b)
 {
-    Img<T>      ret;
     if (t.empty())
-        ret = b;
-    else if (b.empty())
-        ret = t;
-    else {
-        FGASSERT(t.width() == b.width());
-        ret.resize(t.width(),t.height()+b.height());
-        Vec2UI   off;
-        for (Iter2UI it(t.dims()); it.valid(); it.next())
-            ret[it()] = t[it()];
-        off[1] += t.dims()[1];
-        for (Iter2UI it(b.dims()); it.valid(); it.next())
-            ret[it()+off] = b[it()];
-    }
+        return Img<T>(b);
+    if (b.empty())
+        return Img<T>(t);
+    FGASSERT(t.width() == b.width());
+    Img<T>      ret(t.width(),t.height()+b.height());
+    imgCopy_(t,ret.view(Vec2UI(0),t.dims()));
+    imgCopy_(b,ret.view(Vec2UI(0,t.height()),b.dims()));
     return ret;
 }
+template<class T>
+Img<T>
+fgJoinVert(const Img<T> & t,const Img<T> & b)
+{return fgJoinVert(t.cview(),b.cview()); }
 
 template<class T>
 Img<T>
 fgJoinVert(const Svec<Img<T> > & v)
 {
-    Img<T>  ret;
-    for (size_t ii=0; ii<v.size(); ++ii)
-        ret = fgJoinVert(ret,v[ii]);
+    uint        wid = 0,
+                hgt = 0;
+    for (Img<T> const & img : v) {
+        if (img.empty())
+            continue;
+        FGASSERT((wid == 0) || (img.width() == wid));
+        wid = img.width();
+        hgt += img.height();
+    }
+    Img<T>      ret(wid,hgt);
+    uint        row = 0;
+    for (Img<T> const & img : v) {
+        if (img.empty())
+            continue;
+        imgCopy_(img.cview(),ret.view(Vec2UI(0,row),img.dims()));
+        row += img.height();
+    }
     return ret;
 }
 
+// For cropping without padding use a view instead (eg. 'Img::cview(offset,dims)'), which does not copy:
 template<class T>
 Img<T>
 fgCropPad(
-    const Img<T> &  src,
+    ImgCView<T> const & src,
     Vec2UI           dims,
     Vec2I            offset = Vec2I(0),
     T                   fill = T())
@@ -642,23 +741,46 @@ fgCropPad(
         Mat22I        srcBnds = Mat22I(fgRangeToBounds(src.dims())),
                         dstBnds = Mat22I(fgRangeToBounds(dims)),
                         range = fgBoundsIntersection(srcBnds-fgJoinHoriz(offset,offset),dstBnds);
-        for (Iter2I it(fgInclToExcl(range)); it.valid(); it.next())
-            ret[Vec2UI(it())] = src[Vec2UI(it()+offset)];
+        Mat22I          excl = fgInclToExcl(range);
+        if ((excl[0] < excl[1]) && (excl[2] < excl[3])) {
+            Vec2UI          lo(excl[0],excl[2]),
+                            sz(excl[1]-excl[0],excl[3]-excl[2]);
+            imgCopy_(src.sub(Vec2UI(Vec2I(lo)+offset),sz),ret.view(lo,sz));
+        }
     }
     return ret;
 }
-
-// Requires alpha-weighted color values:
 template<class T>
 Img<T>
-fgComposite(
-    const Img<T> &  foreground,
-    const Img<T> &  background)
+fgCropPad(
+    const Img<T> &  src,
+    Vec2UI           dims,
+    Vec2I            offset = Vec2I(0),
+    T                   fill = T())
+{return fgCropPad(src.cview(),dims,offset,fill); }
+
+// Requires alpha-weighted color values. Composites in-place onto 'background', which can be
+// a view of a region of a larger image:
+inline
+void
+fgComposite_(
+    ImgCView<RgbaUC> const &    foreground,
+    ImgView<RgbaUC> const &     background)
 {
     FGASSERT(foreground.dims() == background.dims());
-    Img<T>      ret(foreground.dims());
-    for (size_t ii=0; ii<ret.numPixels(); ++ii)
-        ret[ii] = fgCompositeFragmentUnweighted(foreground[ii],background[ii]);
+    for (uint yy=0; yy<foreground.height(); ++yy)
+        compositeRow_(foreground.rowPtr(yy),background.rowPtr(yy),foreground.width());
+}
+
+// Requires alpha-weighted color values:
+inline
+ImgC4UC
+fgComposite(
+    ImgC4UC const &     foreground,
+    ImgC4UC const &     background)
+{
+    ImgC4UC     ret = background;
+    fgComposite_(foreground.cview(),ret.view());
     return ret;
 }
 
@@ -691,10 +813,13 @@ fgRotate90(
 inline
 void
 fgAlphaWeight(ImgC4UC & img)
-{
-    for (size_t ii=0; ii<img.numPixels(); ++ii)
-        img[ii].alphaWeight();
-}
+{alphaWeightRow_(img.data(),img.numPixels()); }
+
+// Inverse of the above:
+inline
+void
+fgAlphaUnweight(ImgC4UC & img)
+{alphaUnweightRow_(img.data(),img.numPixels()); }
 
 // Does any pixel contain an alpha value less than 254 ? (returns false if empty)
 bool
@@ -714,11 +839,64 @@ fgPaintDot(ImgC4UC & img,Vec2I ircs,Vec4UC color=fgRed(),uint radius=3);
 void
 fgPaintDot(ImgC4UC & img,Vec2F ipcs,Vec4UC color=fgRed(),uint radius=3);
 
+// All levels of an image pyramid in a single allocation, largest level first:
+template<class T>
+struct  ImgPyramid
+{
+    Svec<T>             data;
+    Svec<Vec2UI>        dims;           // Of each level
+    Svec<size_t>        offsets;        // Start of each level in 'data'
+
+    ImgPyramid() {}
+
+    explicit
+    ImgPyramid(Svec<Vec2UI> const & levelDims) : dims(levelDims)
+    {
+        size_t              sz = 0;
+        for (Vec2UI d : dims) {
+            offsets.push_back(sz);
+            sz += d.cmpntsProduct();
+        }
+        data.resize(sz);
+    }
+
+    size_t
+    numLevels() const
+    {return dims.size(); }
+
+    T *
+    levelPtr(size_t ll)
+    {return data.data() + offsets[ll]; }
+
+    T const *
+    levelPtr(size_t ll) const
+    {return data.data() + offsets[ll]; }
+
+    Img<T>
+    level(size_t ll) const
+    {return Img<T>(dims[ll],levelPtr(ll)); }
+
+    Svec<Img<T> >
+    levels() const
+    {
+        Svec<Img<T> >       ret;
+        for (size_t ll=0; ll<numLevels(); ++ll)
+            ret.push_back(level(ll));
+        return ret;
+    }
+};
+
 // Returns only 2-block-filtered 2-subsampled images of the original.
 // Smallest is when the largest dimension is of size 1 (smallest dim clamped to size 1).
 // Non power-of-2 dimensions are truncated when subsampled.
+// Each level is computed in parallel by row bands:
+ImgPyramid<RgbaUC>
+mipMapPyramid(ImgC4UC const & img);
+
+inline
 Svec<ImgC4UC>
-fgMipMap(const ImgC4UC & img);
+fgMipMap(const ImgC4UC & img)
+{return mipMapPyramid(img).levels(); }
 
 // Convert, no scaling:
 Img3F
@@ -726,11 +904,17 @@ fgImgToF3(const ImgC4UC &);
 
 // Scale space image (3 channel float). Returns image pyramid from largest (same as source but smoothed)
 // to smallest dimension equal to 2. Non power of 2 dimensions are simply rounded down at each level:
-Img3Fs
-fgSsi(
+// Each level is smoothed and decimated in a single pass by parallel row bands:
+ImgPyramid<Vec3F>
+ssiPyramid(
     const Img3F & img,                // Source image
     uchar           borderPolicy=0);    // 0: border is value 0, 1: border is mirrored
 
+inline
+Img3Fs
+fgSsi(const Img3F & img,uchar borderPolicy=0)
+{return ssiPyramid(img,borderPolicy).levels(); }
+
 // Returns the transforms from ITCS to IPCS for each corresponding SSI level given the original image dims,
 // principal point and FOV. Takes into account the dimension rounding for non power of 2 dimensions:
 AffineEw2Fs
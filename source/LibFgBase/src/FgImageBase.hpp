@@ -5,9 +5,13 @@
 //
 // Simple left-to-right, top-to-bottom (row major), tightly-packed, unaligned image templated by pixel type.
 // 
+// ImgView / ImgCView are non-owning (mutable / const) views of an image or of a rectangular region of one,
+// whose rows are 'm_stride' pixels apart. They allow cropping and tiling without copies.
+//
 // INVARIANTS:
 //
 // m_data.size() = m_dims[0] * m_dims[1];
+// m_stride >= m_dims[0] for views
 //
 // COORDINATE SYSTEMS:
 //
@@ -41,6 +45,141 @@
 
 namespace Fg {
 
+// The viewed memory must outlive the view, and an 'Img' must not be resized while viewed:
+template<typename T>
+struct  ImgView
+{
+    T *             m_ptr = nullptr;        // Top left pixel
+    Vec2UI          m_dims = Vec2UI(0);     // [width,height]
+    size_t          m_stride = 0;           // Pixels between the starts of consecutive rows
+
+    ImgView() {}
+
+    ImgView(T * ptr,Vec2UI dims,size_t stride)
+    : m_ptr(ptr), m_dims(dims), m_stride(stride)
+    {FGASSERT(stride >= dims[0]); }
+
+    // Tightly packed:
+    ImgView(T * ptr,Vec2UI dims)
+    : m_ptr(ptr), m_dims(dims), m_stride(dims[0])
+    {}
+
+    uint
+    width() const
+    {return m_dims[0]; }
+
+    uint
+    height() const
+    {return m_dims[1]; }
+
+    Vec2UI
+    dims() const
+    {return m_dims; }
+
+    size_t
+    stride() const
+    {return m_stride; }
+
+    size_t
+    numPixels() const
+    {return size_t(m_dims[0]) * m_dims[1]; }
+
+    bool
+    empty() const
+    {return (numPixels() == 0); }
+
+    T *
+    rowPtr(size_t row) const
+    {return m_ptr + row*m_stride; }
+
+    T &
+    xy(size_t ircs_x,size_t ircs_y) const
+    {
+        FGASSERT_FAST((ircs_x < m_dims[0]) && (ircs_y < m_dims[1]));
+        return m_ptr[ircs_y*m_stride+ircs_x];
+    }
+
+    T &
+    operator[](Vec2UI ircsPos) const
+    {return xy(ircsPos[0],ircsPos[1]); }
+
+    // Region of this view, which must lie within it:
+    ImgView
+    sub(Vec2UI offset,Vec2UI dims) const
+    {
+        FGASSERT((offset[0]+dims[0] <= m_dims[0]) && (offset[1]+dims[1] <= m_dims[1]));
+        return ImgView(m_ptr+offset[1]*m_stride+offset[0],dims,m_stride);
+    }
+};
+
+template<typename T>
+struct  ImgCView
+{
+    T const *       m_ptr = nullptr;
+    Vec2UI          m_dims = Vec2UI(0);
+    size_t          m_stride = 0;
+
+    ImgCView() {}
+
+    ImgCView(T const * ptr,Vec2UI dims,size_t stride)
+    : m_ptr(ptr), m_dims(dims), m_stride(stride)
+    {FGASSERT(stride >= dims[0]); }
+
+    ImgCView(T const * ptr,Vec2UI dims)
+    : m_ptr(ptr), m_dims(dims), m_stride(dims[0])
+    {}
+
+    ImgCView(ImgView<T> const & v)
+    : m_ptr(v.m_ptr), m_dims(v.m_dims), m_stride(v.m_stride)
+    {}
+
+    uint
+    width() const
+    {return m_dims[0]; }
+
+    uint
+    height() const
+    {return m_dims[1]; }
+
+    Vec2UI
+    dims() const
+    {return m_dims; }
+
+    size_t
+    stride() const
+    {return m_stride; }
+
+    size_t
+    numPixels() const
+    {return size_t(m_dims[0]) * m_dims[1]; }
+
+    bool
+    empty() const
+    {return (numPixels() == 0); }
+
+    T const *
+    rowPtr(size_t row) const
+    {return m_ptr + row*m_stride; }
+
+    T const &
+    xy(size_t ircs_x,size_t ircs_y) const
+    {
+        FGASSERT_FAST((ircs_x < m_dims[0]) && (ircs_y < m_dims[1]));
+        return m_ptr[ircs_y*m_stride+ircs_x];
+    }
+
+    T const &
+    operator[](Vec2UI ircsPos) const
+    {return xy(ircsPos[0],ircsPos[1]); }
+
+    ImgCView
+    sub(Vec2UI offset,Vec2UI dims) const
+    {
+        FGASSERT((offset[0]+dims[0] <= m_dims[0]) && (offset[1]+dims[1] <= m_dims[1]));
+        return ImgCView(m_ptr+offset[1]*m_stride+offset[0],dims,m_stride);
+    }
+};
+
 template<typename T>
 struct  Img
 {
@@ -78,6 +217,16 @@ struct  Img
     : m_dims(dims), m_data(pixels,pixels+dims[0]*dims[1])
     {}
 
+    // Deep copy of the viewed pixels:
+    explicit
+    Img(ImgCView<T> const & view)
+    : m_dims(view.dims())
+    {
+        m_data.reserve(view.numPixels());
+        for (size_t yy=0; yy<view.height(); ++yy)
+            m_data.insert(m_data.end(),view.rowPtr(yy),view.rowPtr(yy)+view.width());
+    }
+
     void
     clear()
     {m_data.clear(); m_dims = Vec2UI(0); }
@@ -201,12 +350,36 @@ struct  Img
     dataVec() const
     {return m_data; }
 
+    ImgView<T>
+    view()
+    {return ImgView<T>(data(),m_dims); }
+
+    ImgCView<T>
+    cview() const
+    {return ImgCView<T>(data(),m_dims); }
+
+    // Region of the image, which must lie within it:
+    ImgView<T>
+    view(Vec2UI offset,Vec2UI dims)
+    {return view().sub(offset,dims); }
+
+    ImgCView<T>
+    cview(Vec2UI offset,Vec2UI dims) const
+    {return cview().sub(offset,dims); }
+
+    operator ImgView<T>()
+    {return view(); }
+
+    operator ImgCView<T>() const
+    {return cview(); }
+
     bool
     operator==(const Img & rhs) const
     {return ((m_dims == rhs.m_dims) && (m_data == rhs.m_data)); }
 };
 
 typedef Img<uchar>     ImgUC;
+typedef Img<ushort>    ImgUS;
 typedef Img<float>     ImgF;
 typedef Img<double>    ImgD;
 
@@ -225,6 +398,17 @@ typedef Img<Arr4F>     Img4F;
 typedef Img<RgbaUC>    ImgC4UC;
 typedef Svec<ImgC4UC>  ImgC4UCs;
 typedef Img<RgbaF>     ImgC4F;
+typedef Img<RgbaUS>    ImgC4US;
+
+// Copy pixels between views of the same dimensions (which must not overlap):
+template<typename T>
+void
+imgCopy_(ImgCView<T> const & src,ImgView<T> const & dst)
+{
+    FGASSERT(src.dims() == dst.dims());
+    for (size_t yy=0; yy<src.height(); ++yy)
+        std::copy(src.rowPtr(yy),src.rowPtr(yy)+src.width(),dst.rowPtr(yy));
+}
 
 template<typename T,typename U>
 void
@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+
+#include "stdafx.h"
+
+#include "FgImageFilter.hpp"
+#include "FgImage.hpp"
+#include "FgBounds.hpp"
+
+using namespace std;
+
+namespace Fg {
+
+Floats
+gaussKernelHalf(float sigma)
+{
+    FGASSERT(sigma > 0.0f);
+    size_t              rad = size_t(ceil(3.0f*sigma));
+    Floats              ret(rad+1);
+    float               sum = 0.0f;
+    for (size_t ii=0; ii<=rad; ++ii) {
+        ret[ii] = exp(-0.5f * sqr(float(ii)/sigma));
+        sum += (ii == 0) ? ret[ii] : 2.0f*ret[ii];
+    }
+    for (float & k : ret)
+        k /= sum;
+    return ret;
+}
+
+GaussIir::GaussIir(float sigma)
+{
+    FGASSERT(sigma >= 0.5f);
+    double              q = (sigma >= 2.5f) ?
+                            0.98711*sigma - 0.96330 :
+                            3.97156 - 4.14554*sqrt(1.0-0.26891*sigma),
+                        q2 = q*q,
+                        q3 = q2*q,
+                        c0 = 1.57825 + 2.44413*q + 1.4281*q2 + 0.422205*q3,
+                        c1 = 2.44413*q + 2.85619*q2 + 1.26661*q3,
+                        c2 = -(1.4281*q2 + 1.26661*q3),
+                        c3 = 0.422205*q3;
+    b1 = float(c1/c0);
+    b2 = float(c2/c0);
+    b3 = float(c3/c0);
+    B = 1.0f - (b1+b2+b3);          // Unit DC gain
+}
+
+ImgUC
+imgBlurGauss(ImgUC const & img,float sigma)
+{
+    ImgF                tmp(img.dims());
+    for (size_t ii=0; ii<img.numPixels(); ++ii)
+        tmp[ii] = img[ii];
+    tmp = imgBlurGauss(tmp,sigma);
+    ImgUC               ret(img.dims());
+    for (size_t ii=0; ii<ret.numPixels(); ++ii)
+        ret[ii] = uchar(clampBounds(tmp[ii]+0.5f,0.0f,255.0f));
+    return ret;
+}
+
+ImgC4UC
+imgBlurGauss(ImgC4UC const & img,float sigma)
+{
+    ImgC4F              tmp(img.dims());
+    for (size_t ii=0; ii<img.numPixels(); ++ii)
+        tmp[ii] = RgbaF(img[ii]);
+    tmp = imgBlurGauss(tmp,sigma);
+    ImgC4UC             ret(img.dims());
+    for (size_t ii=0; ii<ret.numPixels(); ++ii)
+        for (uint cc=0; cc<4; ++cc)
+            ret[ii].m_c[cc] = uchar(clampBounds(tmp[ii].m_c[cc]+0.5f,0.0f,255.0f));
+    return ret;
+}
+
+}
+
+// */
@@ -0,0 +1,178 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Separable filters of arbitrary radius for floating point channel images (float, Vec3F, RgbaF etc.).
+//
+// * Each pass filters rows and writes its output transposed, so applying the same row pass twice
+//   does the vertical pass as row accesses too and restores the orientation.
+// * The transpose is done in small tiles of rows to stay in cache. Tiles are processed in parallel.
+// * Borders are replicated.
+//
+
+#ifndef FGIMAGEFILTER_HPP
+#define FGIMAGEFILTER_HPP
+
+#include "FgImageBase.hpp"
+#include "FgParallel.hpp"
+
+namespace Fg {
+
+// Applies 'fn(src,dst,num)' to each row of 'src', placing the result in the corresponding column of 'dst':
+template<class T,class Fn>
+void
+filterRowsTransposed(Img<T> const & src,Img<T> & dst,Fn const & fn)
+{
+    size_t const        tile = 16;
+    size_t              wid = src.width(),
+                        hgt = src.height();
+    dst.resize(Vec2UI(uint(hgt),uint(wid)));
+    parallelForBlocks(hgt,tile,[&](size_t lo,size_t hi)
+    {
+        Svec<T>             buf(tile*wid);
+        for (size_t y0=lo; y0<hi; y0+=tile) {
+            size_t              y1 = std::min(y0+tile,hi);
+            for (size_t yy=y0; yy<y1; ++yy)
+                fn(src.rowPtr(yy),&buf[(yy-y0)*wid],wid);
+            for (size_t x0=0; x0<wid; x0+=tile) {
+                size_t              x1 = std::min(x0+tile,wid);
+                for (size_t xx=x0; xx<x1; ++xx) {
+                    T *                 dstRow = dst.rowPtr(xx);
+                    for (size_t yy=y0; yy<y1; ++yy)
+                        dstRow[yy] = buf[(yy-y0)*wid+xx];
+                }
+            }
+        }
+    });
+}
+
+template<class T,class Fn>
+Img<T>
+filterSeparable(Img<T> const & img,Fn const & fn)
+{
+    Img<T>              tmp,
+                        ret;
+    if (img.numPixels() == 0)
+        return img;
+    filterRowsTransposed(img,tmp,fn);
+    filterRowsTransposed(tmp,ret,fn);
+    return ret;
+}
+
+// Copy of 'row' with 'pad' replicated border values on each side:
+template<class T>
+void
+padRow(T const * row,size_t num,size_t pad,Svec<T> & padded)
+{
+    padded.resize(num+2*pad);
+    for (size_t ii=0; ii<pad; ++ii) {
+        padded[ii] = row[0];
+        padded[pad+num+ii] = row[num-1];
+    }
+    std::copy(row,row+num,padded.begin()+pad);
+}
+
+// Normalized symmetric Gaussian kernel half from the centre out, radius ceil(3*sigma):
+Floats
+gaussKernelHalf(float sigma);
+
+// Convolve with the symmetric kernel given by its half from the centre out (ie. element 0 is the centre):
+template<class T>
+Img<T>
+imgFilterSymmetric(Img<T> const & img,Floats const & kernelHalf)
+{
+    FGASSERT(!kernelHalf.empty());
+    size_t              rad = kernelHalf.size()-1;
+    return filterSeparable(img,[&](T const * src,T * dst,size_t num)
+    {
+        Svec<T>             pad;
+        padRow(src,num,rad,pad);
+        for (size_t ii=0; ii<num; ++ii) {
+            size_t              cc = ii + rad;
+            T                   acc = pad[cc] * kernelHalf[0];
+            for (size_t kk=1; kk<=rad; ++kk)
+                acc += (pad[cc-kk] + pad[cc+kk]) * kernelHalf[kk];
+            dst[ii] = acc;
+        }
+    });
+}
+
+// Mean over a (2*radius+1)^2 box by running sums; cost does not depend on radius:
+template<class T>
+Img<T>
+imgBlurBox(Img<T> const & img,uint radius)
+{
+    float               fac = 1.0f / float(2*radius+1);
+    return filterSeparable(img,[=](T const * src,T * dst,size_t num)
+    {
+        Svec<T>             pad;
+        padRow(src,num,radius+1,pad);
+        T                   sum(0);
+        for (size_t ii=1; ii<2*radius+2; ++ii)
+            sum += pad[ii];
+        for (size_t ii=0; ii<num; ++ii) {
+            dst[ii] = sum * fac;
+            sum += pad[ii+2*radius+2] - pad[ii+1];
+        }
+    });
+}
+
+// Recursive Gaussian (Young & van Vliet 1995); cost does not depend on sigma. Accurate to about
+// 1% of the signal range for sigma >= 1:
+struct  GaussIir
+{
+    float               B,b1,b2,b3;         // Normalized by b0
+
+    explicit GaussIir(float sigma);
+};
+
+template<class T>
+Img<T>
+imgBlurGaussIir(Img<T> const & img,float sigma)
+{
+    GaussIir            c(sigma);
+    return filterSeparable(img,[&c](T const * src,T * dst,size_t num)
+    {
+        // Start from the steady state of the replicated border:
+        T                   w1 = src[0],
+                            w2 = w1,
+                            w3 = w1;
+        for (size_t ii=0; ii<num; ++ii) {
+            T                   w0 = src[ii]*c.B + w1*c.b1 + w2*c.b2 + w3*c.b3;
+            dst[ii] = w0;
+            w3 = w2;
+            w2 = w1;
+            w1 = w0;
+        }
+        w2 = w3 = w1;
+        for (size_t ii=num; ii>0; --ii) {
+            T                   w0 = dst[ii-1]*c.B + w1*c.b1 + w2*c.b2 + w3*c.b3;
+            dst[ii-1] = w0;
+            w3 = w2;
+            w2 = w1;
+            w1 = w0;
+        }
+    });
+}
+
+// Uses the exact kernel for small sigma and the recursive filter for large sigma:
+template<class T>
+Img<T>
+imgBlurGauss(Img<T> const & img,float sigma)
+{
+    if (sigma < 3.0f)
+        return imgFilterSymmetric(img,gaussKernelHalf(sigma));
+    return imgBlurGaussIir(img,sigma);
+}
+
+// As above for 8-bit images, with rounding to nearest on output:
+ImgUC
+imgBlurGauss(ImgUC const & img,float sigma);
+
+ImgC4UC
+imgBlurGauss(ImgC4UC const & img,float sigma);
+
+}
+
+#endif
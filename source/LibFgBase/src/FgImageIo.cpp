@@ -10,6 +10,8 @@
 #include "FgFileSystem.hpp"
 #include "FgScopeGuard.hpp"
 #include "FgCommand.hpp"
+#include "FgImageResample.hpp"
+#include "FgStdStream.hpp"
 
 using namespace std;
 
@@ -18,15 +20,25 @@ namespace Fg {
 void
 imgLoadAnyFormat(const Ustring & fname,ImgUC & ret)
 {
-    ImgC4UC     img = imgLoadAnyFormat(fname);
-    ret.resize(img.dims());
-    for (size_t ii=0; ii<ret.numPixels(); ++ii)
-        ret[ii] = img[ii].rec709();
+    imgConvert_(imgLoadAnyFormat(fname),ret);
 }
 
 void
 imgLoadAnyFormat(const Ustring & fname,ImgF & img)
 {
+    if (fgToLower(fgPathToExt(fname).m_str) == "pfm") {
+        img = imgLoadPfmGrey(fname);
+        return;
+    }
+    if (imgIs16Bit(fname)) {
+        ImgC4US     tmp = imgLoadPng16(fname);
+        img.resize(tmp.dims());
+        for (size_t ii=0; ii<tmp.numPixels(); ++ii) {
+            RgbaUS      p = tmp[ii];
+            img[ii] = rec709Lum(float(p.red()),float(p.green()),float(p.blue()),std::false_type()) / 257.0f;
+        }
+        return;
+    }
     ImgC4UC     tmp;
     imgLoadAnyFormat(fname,tmp);
     img.resize(tmp.dims());
@@ -42,6 +54,125 @@ imgSaveAnyFormat(const Ustring & fname,const ImgUC & img)
     imgSaveAnyFormat(fname,tmp);
 }
 
+namespace {
+
+bool
+hostLittleEndian()
+{
+    uint16      val = 1;
+    return (*reinterpret_cast<uchar*>(&val) == 1);
+}
+
+// Returns the number of channels. Rows are returned top to bottom in native byte order:
+uint
+loadPfm(Ustring const & fname,Vec2UI & dims,Floats & data)
+{
+    MappedFile          file(fname);
+    char const *        ptr = file.data();
+    size_t              size = file.size(),
+                        pos = 2;
+    if ((size < 2) || (ptr[0] != 'P') || ((ptr[1] != 'F') && (ptr[1] != 'f')))
+        fgThrow("Not a PFM file",fname);
+    uint                channels = (ptr[1] == 'F') ? 3 : 1;
+    // The header is 3 whitespace-separated ASCII tokens, the last followed by a single whitespace char:
+    Strings             tokens;
+    while (tokens.size() < 3) {
+        while ((pos < size) && isspace(ptr[pos]))
+            ++pos;
+        size_t              beg = pos;
+        while ((pos < size) && !isspace(ptr[pos]))
+            ++pos;
+        if ((pos == beg) || (pos == size))
+            fgThrow("PFM header truncated",fname);
+        tokens.push_back(String(ptr+beg,ptr+pos));
+    }
+    ++pos;
+    Opt<int>            wid = fgFromStr<int>(tokens[0]),
+                        hgt = fgFromStr<int>(tokens[1]);
+    double              scale = atof(tokens[2].c_str());
+    if (!wid.valid() || !hgt.valid() || (wid.val() <= 0) || (hgt.val() <= 0) || (scale == 0.0))
+        fgThrow("Invalid PFM header",fname);
+    dims = Vec2UI(wid.val(),hgt.val());
+    size_t              rowFloats = size_t(dims[0]) * channels;
+    if (size - pos < rowFloats * dims[1] * 4)
+        fgThrow("PFM file truncated",fname);
+    data.resize(rowFloats * dims[1]);
+    // Rows are stored bottom to top:
+    for (size_t yy=0; yy<dims[1]; ++yy)
+        memcpy(&data[yy*rowFloats],ptr+pos+(dims[1]-1-yy)*rowFloats*4,rowFloats*4);
+    // Negative scale means little-endian:
+    if ((scale < 0.0) != hostLittleEndian()) {
+        for (float & f : data) {
+            uchar *             b = reinterpret_cast<uchar*>(&f);
+            swap(b[0],b[3]);
+            swap(b[1],b[2]);
+        }
+    }
+    return channels;
+}
+
+void
+savePfm(Ustring const & fname,float const * data,Vec2UI dims,uint channels)
+{
+    if (dims.cmpntsProduct() == 0)
+        fgThrow("Cannot save empty image to file",fname);
+    Ofstream            ofs(fname);
+    ofs << ((channels == 3) ? "PF" : "Pf") << "\n" << dims[0] << " " << dims[1] << "\n"
+        << (hostLittleEndian() ? "-1.0" : "1.0") << "\n";
+    size_t              rowFloats = size_t(dims[0]) * channels;
+    for (size_t yy=dims[1]; yy>0; --yy)
+        ofs.write(reinterpret_cast<char const *>(data+(yy-1)*rowFloats),rowFloats*4);
+    if (ofs.fail())
+        fgThrow("Unable to write image, check drive free space.",fname);
+}
+
+}
+
+ImgF
+imgLoadPfmGrey(Ustring const & fname)
+{
+    Vec2UI              dims;
+    Floats              data;
+    if (loadPfm(fname,dims,data) != 1)
+        fgThrow("PFM file is not greyscale",fname);
+    return ImgF(dims,data);
+}
+
+Img3F
+imgLoadPfm(Ustring const & fname)
+{
+    Vec2UI              dims;
+    Floats              data;
+    uint                channels = loadPfm(fname,dims,data);
+    Img3F               ret(dims);
+    if (channels == 3)
+        memcpy(static_cast<void*>(ret.data()),data.data(),data.size()*4);
+    else
+        for (size_t ii=0; ii<ret.numPixels(); ++ii)
+            ret[ii] = Vec3F(data[ii]);
+    return ret;
+}
+
+void
+imgSavePfm(Ustring const & fname,ImgF const & img)
+{savePfm(fname,img.data(),img.dims(),1); }
+
+void
+imgSavePfm(Ustring const & fname,Img3F const & img)
+{
+    static_assert(sizeof(Vec3F) == 12,"Vec3F must be packed");
+    savePfm(fname,reinterpret_cast<float const *>(img.data()),img.dims(),3);
+}
+
+void
+imgSavePfm(Ustring const & fname,ImgC4F const & img)
+{
+    Img3F               rgb(img.dims());
+    for (size_t ii=0; ii<img.numPixels(); ++ii)
+        rgb[ii] = Vec3F(img[ii].red(),img[ii].green(),img[ii].blue());
+    imgSavePfm(fname,rgb);
+}
+
 vector<string>
 imgFileExtensions()
 {
@@ -90,6 +221,34 @@ imgFindLoadAnyFormat(const Ustring & baseName,ImgC4UC & img)
     return true;
 }
 
+ImgC4UC
+imgLoadThumbnail(Ustring const & fname,Vec2UI maxDims)
+{
+    FGASSERT((maxDims[0] > 0) && (maxDims[1] > 0));
+    string              ext = fgToLower(fgPathToExt(fname).m_str);
+    bool                jpeg = ((ext == "jpg") || (ext == "jpeg"));
+    Vec2UI              dims = jpeg ? imgJpegDims(fname) : Vec2UI(0);
+    ImgC4UC             img;
+    if (jpeg) {
+        double              scale = std::min(double(maxDims[0])/dims[0],double(maxDims[1])/dims[1]);
+        Vec2UI              target(uint(dims[0]*scale),uint(dims[1]*scale));
+        // Largest DCT scaling whose output (rounded up) is no smaller than the target:
+        uint                denom = 8;
+        while ((denom > 1) && (((dims[0]+denom-1)/denom < target[0]) || ((dims[1]+denom-1)/denom < target[1])))
+            denom /= 2;
+        img = imgLoadJpeg(fname,denom);
+    }
+    else
+        img = imgLoadAnyFormat(fname);
+    double              scale = std::min(double(maxDims[0])/img.width(),double(maxDims[1])/img.height());
+    if (scale >= 1.0)
+        return img;
+    Vec2UI              thumb(std::max(uint(img.width()*scale+0.5),1U),std::max(uint(img.height()*scale+0.5),1U));
+    for (uint dd=0; dd<2; ++dd)
+        thumb[dd] = std::min(thumb[dd],maxDims[dd]);
+    return imgResize(img,thumb,ResampleFilter::box);
+}
+
 void
 fgImgTestWrite(const CLArgs & args)
 {
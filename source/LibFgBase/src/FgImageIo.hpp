@@ -16,18 +16,80 @@
 namespace Fg {
 
 void    imgLoadAnyFormat(Ustring const & fname,ImgC4UC & img);
+// Values are in [0,255] but retain the extra precision of 16 bit files and load PFM files as is:
 void    imgLoadAnyFormat(Ustring const & fname,ImgF & img);
 void    imgLoadAnyFormat(Ustring const & fname,ImgUC & img);
 
 ImgC4UC
 imgLoadAnyFormat(Ustring const & fname);
 
+// While an instance exists, calls to 'imgLoadAnyFormat' (for ImgC4UC) on the same thread are passed to
+// 'load' instead, eg. so that textures referenced by many meshes in a batch are decoded only once.
+// Calls made by 'load' itself are not overridden:
+struct  ImgLoadOverride
+{
+    std::function<ImgC4UC(Ustring const &)> load;
+    ImgLoadOverride *                       prev;
+
+    explicit
+    ImgLoadOverride(std::function<ImgC4UC(Ustring const &)> const & load);
+    ~ImgLoadOverride();
+
+    ImgLoadOverride(ImgLoadOverride const &) = delete;
+    void operator=(ImgLoadOverride const &) = delete;
+};
+
 void
 imgSaveAnyFormat(Ustring const & fname,const ImgC4UC & img);
 
 void
 imgSaveAnyFormat(Ustring const & fname,const ImgUC & img);
 
+// Decode an image file's contents already in memory, in any of the formats supported above:
+ImgC4UC
+imgDecodeAnyFormat(uchar const * data,size_t size);
+
+// Encode to the file format given by its extension (eg. 'png'). JPEG uses 'quality' [1,100]:
+String
+imgEncodeAnyFormat(ImgC4UC const & img,String const & ext,int quality=75);
+
+// 16 bits per channel PNG, for displacement and normal maps etc. Loading accepts any PNG bit depth
+// (8 bit values are scaled by 257 so 0xFF maps to 0xFFFF) and greyscale is the rec.709 luminance:
+ImgUS
+imgLoadPng16Grey(Ustring const & fname);
+
+ImgC4US
+imgLoadPng16(Ustring const & fname);
+
+// True if the file is a 16 bits per channel PNG:
+bool
+imgIs16Bit(Ustring const & fname);
+
+void
+imgSavePng16(Ustring const & fname,ImgUS const & img);
+
+void
+imgSavePng16(Ustring const & fname,ImgC4US const & img);
+
+// Portable float map (.pfm): lossless greyscale ('Pf') or RGB ('PF') 32 bit floats with no alpha channel.
+// Loading a greyscale file as RGB replicates the channel. Use 'imgSaveTiled' (FgImageTiled.hpp) for
+// other pixel types such as RgbaF:
+ImgF
+imgLoadPfmGrey(Ustring const & fname);
+
+Img3F
+imgLoadPfm(Ustring const & fname);
+
+void
+imgSavePfm(Ustring const & fname,ImgF const & img);
+
+void
+imgSavePfm(Ustring const & fname,Img3F const & img);
+
+// Saves the (alpha-weighted) colour channels only:
+void
+imgSavePfm(Ustring const & fname,ImgC4F const & img);
+
 // List of filename extensions of supported image file formats in LOWER CASE:
 Strings
 imgFileExtensions();
@@ -62,9 +124,35 @@ imgEncodeJpeg(uint wid,uint hgt,uchar const * data,int quality);
 Uchars
 imgEncodeJpeg(ImgC4UC const & img,int quality=100);
 
-// Decode from JFIF format blob (can be read from JFIF format .jpg file):
+// Decode from JFIF format blob (can be read from JFIF format .jpg file). 'scaleDenom' of 2, 4 or 8 scales
+// the image down by that factor (rounding up) during the inverse DCT, which is several times faster
+// than decoding at full size:
+ImgC4UC
+imgDecodeJpeg(Uchars const & jfifBlob,uint scaleDenom=1);
+
 ImgC4UC
-imgDecodeJpeg(Uchars const & jfifBlob);
+imgDecodeJpeg(uchar const * jfifData,size_t size,uint scaleDenom=1);
+
+// As above directly from a memory-mapped file:
+ImgC4UC
+imgLoadJpeg(Ustring const & fname,uint scaleDenom=1);
+
+// Reads only the header:
+Vec2UI
+imgJpegDims(Ustring const & fname);
+
+// Load an image scaled to fit within 'maxDims', preserving aspect ratio (images already within are
+// returned as is). JPEGs are decoded at reduced resolution when possible:
+ImgC4UC
+imgLoadThumbnail(Ustring const & fname,Vec2UI maxDims);
+
+// zlib (RFC 1950) streams using the same codec as PNG I/O. 'inflatedSize' must be known in advance
+// (as it is for the compressed arrays of container formats such as FBX):
+String
+zlibInflate(char const * zdata,size_t zsize,size_t inflatedSize);
+
+String
+zlibDeflate(char const * data,size_t size);
 
 }
 
@@ -9,6 +9,9 @@
 #include "FgImageIo.hpp"
 #include "FgFileSystem.hpp"
 #include "FgStdio.hpp"
+#include "FgLoadCache.hpp"
+#include "FgStdStream.hpp"
+#include "FgScopeGuard.hpp"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -26,9 +29,11 @@ struct  StbiFree
     ~StbiFree() {stbi_image_free(data); }
 };
 
-void
-imgLoadAnyFormat(const Ustring & fname,ImgC4UC & img)
+static
+ImgC4UC
+imgDecodeFile(const Ustring & fname)
 {
+    ImgC4UC             img;
     FILE *              fPtr = fgOpen(fname,false);     // Throws if unable to open
     int                 width,height,channels;
     // Request 4 channels if available:
@@ -44,6 +49,28 @@ imgLoadAnyFormat(const Ustring & fname,ImgC4UC & img)
     if (width*height <= 0)
         fgThrow("Invalid image dimensions",Vec2I(width,height));
     img = ImgC4UC(Vec2UI(width,height),reinterpret_cast<RgbaUC*>(data));
+    return img;
+}
+
+static thread_local ImgLoadOverride * s_loadOverride = nullptr;
+
+ImgLoadOverride::ImgLoadOverride(function<ImgC4UC(Ustring const &)> const & l) : load(l), prev(s_loadOverride)
+{s_loadOverride = this; }
+
+ImgLoadOverride::~ImgLoadOverride()
+{s_loadOverride = prev; }
+
+void
+imgLoadAnyFormat(const Ustring & fname,ImgC4UC & img)
+{
+    if (s_loadOverride != nullptr) {
+        ImgLoadOverride *   ovr = s_loadOverride;
+        s_loadOverride = ovr->prev;
+        ScopeGuard          sg([ovr](){s_loadOverride = ovr; });
+        img = ovr->load(fname);
+    }
+    else
+        img = imgLoadCached(fname,"imgLoadAnyFormat1",imgDecodeFile);
 }
 
 ImgC4UC
@@ -61,6 +88,56 @@ writeToFile(void *context,void * data,int size)
     fwrite(data,1,size,reinterpret_cast<FILE*>(context));
 }
 
+ImgC4UC
+imgDecodeAnyFormat(uchar const * data,size_t size)
+{
+    // libjpeg is considerably faster than stb for JPEG:
+    if ((size > 2) && (data[0] == 0xFF) && (data[1] == 0xD8))
+        return imgDecodeJpeg(data,size);
+    int                 width,height,channels;
+    uchar *             pix = stbi_load_from_memory(data,int(size),&width,&height,&channels,4);
+    if (pix == nullptr)
+        fgThrow("Unable to decode image",stbi__g_failure_reason);
+    StbiFree            sf(pix);
+    if (width*height <= 0)
+        fgThrow("Invalid image dimensions",Vec2I(width,height));
+    return ImgC4UC(Vec2UI(width,height),reinterpret_cast<RgbaUC*>(pix));
+}
+
+static
+void
+writeToString(void * context,void * data,int size)
+{
+    char const *        ptr = reinterpret_cast<char const *>(data);
+    reinterpret_cast<String*>(context)->append(ptr,ptr+size);
+}
+
+String
+imgEncodeAnyFormat(ImgC4UC const & img,String const & extension,int quality)
+{
+    if (img.numPixels() == 0)
+        fgThrow("Cannot encode empty image");
+    String              ext = fgToLower(extension),
+                        ret;
+    int                 wid = int(img.width()),
+                        hgt = int(img.height()),
+                        ok;
+    const uchar         *data = &img.m_data[0].m_c[0];
+    if ((ext == "jpg") || (ext == "jpeg"))
+        ok = stbi_write_jpg_to_func(writeToString,&ret,wid,hgt,4,data,quality);
+    else if (ext == "png")
+        ok = stbi_write_png_to_func(writeToString,&ret,wid,hgt,4,data,wid*4);
+    else if (ext == "bmp")
+        ok = stbi_write_bmp_to_func(writeToString,&ret,wid,hgt,4,data);
+    else if (ext == "tga")
+        ok = stbi_write_tga_to_func(writeToString,&ret,wid,hgt,4,data);
+    else
+        fgThrow("File extension is not a supported image output format",ext);
+    if (ok == 0)
+        fgThrow("Unable to encode image",ext);
+    return ret;
+}
+
 void
 imgSaveAnyFormat(const Ustring & fname,const ImgC4UC & img)
 {
@@ -110,4 +187,177 @@ saveJfif(ImgC4UC const & img,Ustring const & fname,uint quality)
         fgThrow("Unable to save JFIF image, check drive free space.",fname);
 }
 
+static
+Svec<ushort>
+decodePng16(Ustring const & fname,Vec2UI & dims)
+{
+    MappedFile          file(fname);
+    int                 width,height,channels;
+    // stb converts any bit depth to 16 bits on request:
+    ushort *            data = stbi_load_16_from_memory(reinterpret_cast<uchar const *>(file.data()),
+                            int(file.size()),&width,&height,&channels,4);
+    if (data == nullptr) {
+        FgException     e;
+        e.pushMsg("Unable to decode image",stbi__g_failure_reason);
+        e.pushMsg("Unable to load image from file",fname.m_str);
+        throw e;
+    }
+    StbiFree            sf(reinterpret_cast<uchar*>(data));
+    if (width*height <= 0)
+        fgThrow("Invalid image dimensions",Vec2I(width,height));
+    dims = Vec2UI(width,height);
+    return Svec<ushort>(data,data+dims.cmpntsProduct()*4);
+}
+
+ImgC4US
+imgLoadPng16(Ustring const & fname)
+{
+    Vec2UI              dims;
+    Svec<ushort>        data = decodePng16(fname,dims);
+    return ImgC4US(dims,reinterpret_cast<RgbaUS const *>(data.data()));
+}
+
+ImgUS
+imgLoadPng16Grey(Ustring const & fname)
+{
+    Vec2UI              dims;
+    Svec<ushort>        data = decodePng16(fname,dims);
+    ImgUS               ret(dims);
+    for (size_t ii=0; ii<ret.numPixels(); ++ii) {
+        ushort const *      p = &data[ii*4];
+        ret[ii] = rec709Lum(p[0],p[1],p[2],std::true_type());
+    }
+    return ret;
+}
+
+bool
+imgIs16Bit(Ustring const & fname)
+{
+    MappedFile          file(fname);
+    return (stbi_is_16_bit_from_memory(reinterpret_cast<uchar const *>(file.data()),int(file.size())) != 0);
+}
+
+// stb_image_write only writes 8 bit PNGs but exposes its CRC:
+static
+void
+writePngChunk(Ofstream & ofs,char const * tag,uchar const * data,size_t size)
+{
+    FGASSERT(size < (1U << 31));
+    Svec<uchar>         buf(tag,tag+4);
+    if (size > 0)
+        buf.insert(buf.end(),data,data+size);
+    uint                crc = stbiw__crc32(buf.data(),int(buf.size()));
+    uchar               len[4],
+                        crcb[4];
+    for (uint ii=0; ii<4; ++ii) {
+        len[ii] = uchar(size >> (24-8*ii));
+        crcb[ii] = uchar(crc >> (24-8*ii));
+    }
+    ofs.write(reinterpret_cast<char const *>(len),4);
+    ofs.write(reinterpret_cast<char const *>(buf.data()),buf.size());
+    ofs.write(reinterpret_cast<char const *>(crcb),4);
+}
+
+static
+void
+savePng16(Ustring const & fname,ushort const * data,Vec2UI dims,uint channels)
+{
+    if (dims.cmpntsProduct() == 0)
+        fgThrow("Cannot save empty image to file",fname);
+    size_t              bpp = channels * 2,
+                        rowBytes = dims[0] * bpp;
+    // Each row is stored big-endian with the PNG filter that gives the smallest absolute residuals,
+    // as chosen by stb for 8 bit images:
+    Svec<uchar>         prev(rowBytes,0),
+                        curr(rowBytes),
+                        line(rowBytes),
+                        best(rowBytes),
+                        filtered;
+    filtered.reserve((rowBytes+1)*dims[1]);
+    for (size_t yy=0; yy<dims[1]; ++yy) {
+        ushort const *      src = data + yy*dims[0]*channels;
+        for (size_t ii=0; ii<rowBytes/2; ++ii) {
+            curr[2*ii] = uchar(src[ii] >> 8);
+            curr[2*ii+1] = uchar(src[ii]);
+        }
+        int                 bestType = 0;
+        size_t              bestSum = numeric_limits<size_t>::max();
+        for (int type=0; type<5; ++type) {
+            size_t              sum = 0;
+            for (size_t ii=0; ii<rowBytes; ++ii) {
+                int                 a = (ii < bpp) ? 0 : curr[ii-bpp],
+                                    b = prev[ii],
+                                    c = (ii < bpp) ? 0 : prev[ii-bpp],
+                                    pred = 0;
+                if (type == 1)
+                    pred = a;
+                else if (type == 2)
+                    pred = b;
+                else if (type == 3)
+                    pred = (a + b) >> 1;
+                else if (type == 4)
+                    pred = stbiw__paeth(a,b,c);
+                line[ii] = uchar(curr[ii] - pred);
+                sum += abs(int(static_cast<signed char>(line[ii])));
+            }
+            if (sum < bestSum) {
+                bestSum = sum;
+                bestType = type;
+                best.swap(line);
+            }
+        }
+        filtered.push_back(uchar(bestType));
+        filtered.insert(filtered.end(),best.begin(),best.end());
+        prev.swap(curr);
+    }
+    String              zdata = zlibDeflate(reinterpret_cast<char const *>(filtered.data()),filtered.size());
+    uchar               ihdr[13] = {
+        uchar(dims[0]>>24),uchar(dims[0]>>16),uchar(dims[0]>>8),uchar(dims[0]),
+        uchar(dims[1]>>24),uchar(dims[1]>>16),uchar(dims[1]>>8),uchar(dims[1]),
+        16,                                     // Bit depth
+        uchar((channels == 4) ? 6 : 0),         // Colour type RGBA or greyscale
+        0,0,0};                                 // Deflate, adaptive filtering, no interlace
+    uchar const         sig[8] = {137,80,78,71,13,10,26,10};
+    Ofstream            ofs(fname);
+    ofs.write(reinterpret_cast<char const *>(sig),8);
+    writePngChunk(ofs,"IHDR",ihdr,13);
+    writePngChunk(ofs,"IDAT",reinterpret_cast<uchar const *>(zdata.data()),zdata.size());
+    writePngChunk(ofs,"IEND",nullptr,0);
+    if (ofs.fail())
+        fgThrow("Unable to write image, check drive free space.",fname);
+}
+
+void
+imgSavePng16(Ustring const & fname,ImgUS const & img)
+{savePng16(fname,img.data(),img.dims(),1); }
+
+void
+imgSavePng16(Ustring const & fname,ImgC4US const & img)
+{savePng16(fname,reinterpret_cast<ushort const *>(img.data()),img.dims(),4); }
+
+String
+zlibInflate(char const * zdata,size_t zsize,size_t inflatedSize)
+{
+    String              ret(inflatedSize,'\0');
+    if (inflatedSize == 0)
+        return ret;
+    int                 num = stbi_zlib_decode_buffer(&ret[0],int(inflatedSize),zdata,int(zsize));
+    if (num != int(inflatedSize))
+        fgThrow("Corrupt zlib stream",toString(num)+" of "+toString(inflatedSize));
+    return ret;
+}
+
+String
+zlibDeflate(char const * data,size_t size)
+{
+    int                 len = 0;
+    // stbi_zlib_compress takes non-const but does not modify the input:
+    uchar *             zdata = stbi_zlib_compress(reinterpret_cast<uchar*>(const_cast<char*>(data)),int(size),&len,stbi_write_png_compression_level);
+    if (zdata == nullptr)
+        fgThrow("zlib compression failed",size);
+    String              ret(reinterpret_cast<char*>(zdata),size_t(len));
+    STBIW_FREE(zdata);
+    return ret;
+}
+
 }
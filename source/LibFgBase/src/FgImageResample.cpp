@@ -0,0 +1,351 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+
+#include "stdafx.h"
+
+#include "FgImageResample.hpp"
+#include "FgBounds.hpp"
+#include "FgMath.hpp"
+#include "FgParallel.hpp"
+#include "FgSimd.hpp"
+
+using namespace std;
+
+namespace Fg {
+
+namespace {
+
+double
+filterSupport(ResampleFilter filter)
+{
+    if (filter == ResampleFilter::triangle)
+        return 1.0;
+    if (filter == ResampleFilter::mitchell)
+        return 2.0;
+    return 3.0;
+}
+
+double
+sinc(double x)
+{
+    if (x == 0.0)
+        return 1.0;
+    x *= pi();
+    return sin(x) / x;
+}
+
+double
+filterValue(ResampleFilter filter,double x)
+{
+    x = std::abs(x);
+    if (filter == ResampleFilter::triangle)
+        return (x < 1.0) ? 1.0 - x : 0.0;
+    if (filter == ResampleFilter::mitchell) {
+        double const    B = 1.0/3.0,
+                        C = 1.0/3.0;
+        if (x < 1.0)
+            return ((12-9*B-6*C)*x*x*x + (-18+12*B+6*C)*x*x + (6-2*B)) / 6.0;
+        if (x < 2.0)
+            return ((-B-6*C)*x*x*x + (6*B+30*C)*x*x + (-12*B-48*C)*x + (8*B+24*C)) / 6.0;
+        return 0.0;
+    }
+    return (x < 3.0) ? sinc(x) * sinc(x/3.0) : 0.0;
+}
+
+ResampleTaps
+calcTaps(size_t srcSize,size_t dstSize,ResampleFilter filter)
+{
+    double              scale = double(dstSize) / double(srcSize);
+    Svec<Doubles>       ws(dstSize);
+    Svec<size_t>        los(dstSize);
+    for (size_t jj=0; jj<dstSize; ++jj) {
+        Doubles &           w = ws[jj];
+        if (filter == ResampleFilter::box) {
+            // Overlap of the output pixel's source extent with each source pixel:
+            double              lo = jj / scale,
+                                hi = (jj+1) / scale;
+            size_t              ilo = size_t(lo),
+                                ihi = std::min(size_t(ceil(hi)),srcSize);
+            los[jj] = ilo;
+            for (size_t ii=ilo; ii<ihi; ++ii)
+                w.push_back(std::min(hi,double(ii+1)) - std::max(lo,double(ii)));
+        }
+        else {
+            double              fscale = std::min(scale,1.0),
+                                support = filterSupport(filter) / fscale,
+                                centre = (jj + 0.5) / scale - 0.5;
+            int                 ilo = int(ceil(centre - support)),
+                                ihi = int(floor(centre + support)),
+                                top = int(srcSize) - 1;
+            size_t              clo = size_t(clampBounds(ilo,0,top));
+            los[jj] = clo;
+            w.resize(size_t(clampBounds(ihi,0,top)) - clo + 1,0.0);
+            // Samples beyond the border fold onto the edge pixel (replication):
+            for (int ii=ilo; ii<=ihi; ++ii)
+                w[size_t(clampBounds(ii,0,top)) - clo] += filterValue(filter,(ii - centre) * fscale);
+        }
+        double              sum = cSum(w);
+        FGASSERT(sum > 0.0);
+        for (double & v : w)
+            v /= sum;
+    }
+    ResampleTaps        ret;
+    for (Doubles const & w : ws)
+        ret.num = std::max(ret.num,w.size());
+    ret.first.resize(dstSize);
+    ret.weights.resize(dstSize*ret.num,0.0f);
+    for (size_t jj=0; jj<dstSize; ++jj) {
+        // Shift the window back at the far border so all taps are valid indices:
+        size_t              first = std::min(los[jj],srcSize-ret.num),
+                            off = los[jj] - first;
+        ret.first[jj] = first;
+        for (size_t kk=0; kk<ws[jj].size(); ++kk)
+            ret.weights[jj*ret.num+off+kk] = float(ws[jj][kk]);
+    }
+    return ret;
+}
+
+inline float    toFloat(uchar v) {return float(v); }
+inline float    toFloat(float v) {return v; }
+
+inline void     fromFloat(float v,uchar & r) {r = uchar(clampBounds(v,0.0f,255.0f) + 0.5f); }
+inline void     fromFloat(float v,float & r) {r = v; }
+
+#ifdef FG_SSE2
+inline __m128   load4(uchar const * p)
+{
+    int32           v;
+    memcpy(&v,p,4);
+    __m128i const   zero = _mm_setzero_si128();
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(v),zero),zero));
+}
+inline __m128   load4(float const * p) {return _mm_loadu_ps(p); }
+#endif
+
+#ifdef FG_NEON
+inline float32x4_t  load4(uchar const * p)
+{
+    uint8x8_t       v = vreinterpret_u8_u32(vld1_dup_u32(reinterpret_cast<uint32_t const *>(p)));
+    return vcvtq_f32_u32(vmovl_u16(vget_low_u16(vmovl_u8(v))));
+}
+inline float32x4_t  load4(float const * p) {return vld1q_f32(p); }
+#endif
+
+// Resample one row of 'C' channel pixels horizontally:
+template<class S>
+void
+resampleRow(S const * src,float * dst,ResampleTaps const & taps,size_t dstWid,size_t C,Simd simd)
+{
+    size_t              nt = taps.num;
+    size_t              xx = 0;
+#if defined(FG_SSE2) || defined(FG_NEON)
+    if ((C == 4) && (simd >= Simd::vec128)) {
+        for (; xx<dstWid; ++xx) {
+            S const *           s = src + taps.first[xx]*4;
+            float const *       w = &taps.weights[xx*nt];
+#ifdef FG_SSE2
+            __m128              acc = _mm_setzero_ps();
+            for (size_t kk=0; kk<nt; ++kk)
+                acc = _mm_add_ps(acc,_mm_mul_ps(_mm_set1_ps(w[kk]),load4(s+kk*4)));
+            _mm_storeu_ps(dst+xx*4,acc);
+#else
+            float32x4_t         acc = vdupq_n_f32(0.0f);
+            for (size_t kk=0; kk<nt; ++kk)
+                acc = vaddq_f32(acc,vmulq_n_f32(load4(s+kk*4),w[kk]));
+            vst1q_f32(dst+xx*4,acc);
+#endif
+        }
+    }
+#endif
+    for (; xx<dstWid; ++xx) {
+        S const *           s = src + taps.first[xx]*C;
+        float const *       w = &taps.weights[xx*nt];
+        for (size_t cc=0; cc<C; ++cc) {
+            float               acc = 0.0f;
+            for (size_t kk=0; kk<nt; ++kk)
+                acc += w[kk] * toFloat(s[kk*C+cc]);
+            dst[xx*C+cc] = acc;
+        }
+    }
+}
+
+#ifdef FG_AVX2
+FG_TARGET_AVX2
+size_t
+accumulateAvx2(float const * src,float w,float * acc,size_t num)
+{
+    __m256              wv = _mm256_set1_ps(w);
+    size_t              ii = 0;
+    for (; ii+8<=num; ii+=8)
+        _mm256_storeu_ps(acc+ii,_mm256_add_ps(_mm256_loadu_ps(acc+ii),_mm256_mul_ps(wv,_mm256_loadu_ps(src+ii))));
+    return ii;
+}
+#endif
+
+// acc += w * src:
+void
+accumulate(float const * src,float w,float * acc,size_t num,Simd simd)
+{
+    size_t              ii = 0;
+#ifdef FG_AVX2
+    if (simd == Simd::avx2)
+        ii = accumulateAvx2(src,w,acc,num);
+#endif
+#ifdef FG_SSE2
+    if (simd >= Simd::vec128) {
+        __m128              wv = _mm_set1_ps(w);
+        for (; ii+4<=num; ii+=4)
+            _mm_storeu_ps(acc+ii,_mm_add_ps(_mm_loadu_ps(acc+ii),_mm_mul_ps(wv,_mm_loadu_ps(src+ii))));
+    }
+#endif
+#ifdef FG_NEON
+    if (simd >= Simd::vec128)
+        for (; ii+4<=num; ii+=4)
+            vst1q_f32(acc+ii,vaddq_f32(vld1q_f32(acc+ii),vmulq_n_f32(vld1q_f32(src+ii),w)));
+#endif
+    for (; ii<num; ++ii)
+        acc[ii] += w * src[ii];
+}
+
+// Computes destination rows [dstLo,dstLo+dstNum) of the resize from 'srcDims' to 'dstDims'.
+// 'src' points to source row 'srcLo' and must include all rows given by 'srcRows':
+template<class T>
+void
+resize(
+    T const *           src,
+    size_t              srcStride,      // In pixels
+    size_t              srcLo,
+    Vec2UI              srcDims,
+    T *                 dst,
+    size_t              dstStride,      // In pixels
+    size_t              dstLo,
+    size_t              dstNum,
+    Vec2UI              dstDims,
+    size_t              C,
+    ResampleTaps const & tx,
+    ResampleTaps const & ty)
+{
+    size_t              dstWid = dstDims[0],
+                        rowSize = dstWid*C;
+    FGASSERT((tx.first.size() == dstWid) && (ty.first.size() == dstDims[1]));
+    FGASSERT((tx.first.back()+tx.num <= srcDims[0]) && (ty.first.back()+ty.num <= srcDims[1]));
+    Simd                simd = simdLevel();
+    // Only the source rows used by some output row need the horizontal pass:
+    size_t              rowLo = ty.first[dstLo],
+                        rowHi = ty.first[dstLo+dstNum-1] + ty.num;
+    FGASSERT(rowLo >= srcLo);
+    Floats              tmp((rowHi-rowLo)*rowSize);
+    parallelForBlocks(rowHi-rowLo,8,[&](size_t lo,size_t hi)
+    {
+        for (size_t yy=lo; yy<hi; ++yy)
+            resampleRow(src+(rowLo-srcLo+yy)*srcStride*C,&tmp[yy*rowSize],tx,dstWid,C,simd);
+    });
+    parallelForBlocks(dstNum,8,[&](size_t lo,size_t hi)
+    {
+        Floats              acc(rowSize);
+        for (size_t yy=lo; yy<hi; ++yy) {
+            size_t              row = dstLo + yy;
+            std::fill(acc.begin(),acc.end(),0.0f);
+            for (size_t kk=0; kk<ty.num; ++kk) {
+                float               w = ty.weights[row*ty.num+kk];
+                if (w != 0.0f)
+                    accumulate(&tmp[(ty.first[row]+kk-rowLo)*rowSize],w,acc.data(),rowSize,simd);
+            }
+            T *                 d = dst + yy*dstStride*C;
+            for (size_t ii=0; ii<rowSize; ++ii)
+                fromFloat(acc[ii],d[ii]);
+        }
+    });
+}
+
+template<class Pixel,class T>
+Img<Pixel>
+resizeImg(ImgCView<Pixel> const & src,Vec2UI dims,ResampleFilter filter)
+{
+    size_t const        C = sizeof(Pixel) / sizeof(T);
+    static_assert(sizeof(Pixel) == C*sizeof(T),"Pixel channels must be densely packed");
+    if (src.dims() == dims)
+        return Img<Pixel>(src);
+    Img<Pixel>          ret(dims);
+    if ((src.numPixels() == 0) || (ret.numPixels() == 0))
+        return ret;
+    resize(reinterpret_cast<T const *>(src.rowPtr(0)),src.stride(),0,src.dims(),
+           reinterpret_cast<T *>(ret.data()),dims[0],0,dims[1],dims,C,
+           calcTaps(src.width(),dims[0],filter),calcTaps(src.height(),dims[1],filter));
+    return ret;
+}
+
+template<class Pixel,class T>
+void
+resizeRows(
+    ImgCView<Pixel> const & srcRows,
+    uint                srcLo,
+    Vec2UI              srcDims,
+    ImgView<Pixel> const & dstRows,
+    uint                dstLo,
+    Vec2UI              dstDims,
+    ResampleTaps const & tx,
+    ResampleTaps const & ty)
+{
+    size_t const        C = sizeof(Pixel) / sizeof(T);
+    FGASSERT((srcRows.width() == srcDims[0]) && (dstRows.width() == dstDims[0]));
+    FGASSERT(dstLo+dstRows.height() <= dstDims[1]);
+    if (dstRows.empty())
+        return;
+    Vec2UI              need = resizeSrcRows(ty,dstLo,dstLo+dstRows.height());
+    FGASSERT((need[0] >= srcLo) && (need[1] <= srcLo+srcRows.height()));
+    resize(reinterpret_cast<T const *>(srcRows.rowPtr(0)),srcRows.stride(),srcLo,srcDims,
+           reinterpret_cast<T *>(dstRows.rowPtr(0)),dstRows.stride(),dstLo,dstRows.height(),dstDims,C,tx,ty);
+}
+
+}
+
+ImgC4UC
+imgResize(ImgCView<RgbaUC> const & src,Vec2UI dims,ResampleFilter filter)
+{return resizeImg<RgbaUC,uchar>(src,dims,filter); }
+
+ImgC4F
+imgResize(ImgCView<RgbaF> const & src,Vec2UI dims,ResampleFilter filter)
+{return resizeImg<RgbaF,float>(src,dims,filter); }
+
+Img3F
+imgResize(ImgCView<Vec3F> const & src,Vec2UI dims,ResampleFilter filter)
+{return resizeImg<Vec3F,float>(src,dims,filter); }
+
+ImgUC
+imgResize(ImgCView<uchar> const & src,Vec2UI dims,ResampleFilter filter)
+{return resizeImg<uchar,uchar>(src,dims,filter); }
+
+ImgF
+imgResize(ImgCView<float> const & src,Vec2UI dims,ResampleFilter filter)
+{return resizeImg<float,float>(src,dims,filter); }
+
+ResampleTaps
+resampleTaps(uint srcSize,uint dstSize,ResampleFilter filter)
+{return calcTaps(srcSize,dstSize,filter); }
+
+Vec2UI
+resizeSrcRows(ResampleTaps const & ty,uint dstLo,uint dstHi)
+{
+    FGASSERT((dstLo < dstHi) && (dstHi <= ty.first.size()));
+    return Vec2UI(uint(ty.first[dstLo]),uint(ty.first[dstHi-1]+ty.num));
+}
+
+void
+imgResizeRows_(ImgCView<RgbaUC> const & srcRows,uint srcLo,Vec2UI srcDims,
+               ImgView<RgbaUC> const & dstRows,uint dstLo,Vec2UI dstDims,
+               ResampleTaps const & tx,ResampleTaps const & ty)
+{resizeRows<RgbaUC,uchar>(srcRows,srcLo,srcDims,dstRows,dstLo,dstDims,tx,ty); }
+
+void
+imgResizeRows_(ImgCView<RgbaF> const & srcRows,uint srcLo,Vec2UI srcDims,
+               ImgView<RgbaF> const & dstRows,uint dstLo,Vec2UI dstDims,
+               ResampleTaps const & tx,ResampleTaps const & ty)
+{resizeRows<RgbaF,float>(srcRows,srcLo,srcDims,dstRows,dstLo,dstDims,tx,ty); }
+
+}
+
+// */
@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Separable polyphase image resizing:
+//
+// * The filter weights are computed once for each output column and each output row.
+// * The horizontal pass over the source rows and the vertical pass over the output rows both run
+//   in parallel across rows with SIMD inner loops (see FgSimd.hpp).
+// * Borders are replicated. 8-bit outputs are rounded and clamped since the Mitchell and Lanczos
+//   filters have negative lobes.
+// * The source can be a view of a region of a larger image (an 'Img' converts implicitly).
+//
+
+#ifndef FGIMAGERESAMPLE_HPP
+#define FGIMAGERESAMPLE_HPP
+
+#include "FgImageBase.hpp"
+
+namespace Fg {
+
+enum struct ResampleFilter
+{
+    // Exact area coverage of each output pixel (as 'fgImgResize'). Blocky when expanding:
+    box,
+    // Bilinear when expanding, tent-weighted average when shrinking:
+    triangle,
+    // Mitchell-Netravali (B=C=1/3). Good general purpose choice:
+    mitchell,
+    // Sharpest but can ring at hard edges:
+    lanczos3,
+};
+
+ImgC4UC
+imgResize(ImgCView<RgbaUC> const & src,Vec2UI dims,ResampleFilter filter=ResampleFilter::mitchell);
+
+ImgC4F
+imgResize(ImgCView<RgbaF> const & src,Vec2UI dims,ResampleFilter filter=ResampleFilter::mitchell);
+
+Img3F
+imgResize(ImgCView<Vec3F> const & src,Vec2UI dims,ResampleFilter filter=ResampleFilter::mitchell);
+
+ImgUC
+imgResize(ImgCView<uchar> const & src,Vec2UI dims,ResampleFilter filter=ResampleFilter::mitchell);
+
+ImgF
+imgResize(ImgCView<float> const & src,Vec2UI dims,ResampleFilter filter=ResampleFilter::mitchell);
+
+// Resizing in bands of rows, for images too large to hold in memory (see FgImageTiled.hpp).
+// The taps for each axis are computed once per resize and shared by all bands.
+
+// Weights for each output sample along one axis, padded with zeros to the same number of taps:
+struct  ResampleTaps
+{
+    size_t              num = 0;        // Taps per output sample
+    Svec<size_t>        first;          // First source index for each output sample (non-decreasing)
+    Floats              weights;        // 'num' weights for each output sample
+};
+
+ResampleTaps
+resampleTaps(uint srcSize,uint dstSize,ResampleFilter filter=ResampleFilter::mitchell);
+
+// Source rows [lo,hi) needed to compute destination rows [dstLo,dstHi) given the vertical taps:
+Vec2UI
+resizeSrcRows(ResampleTaps const & ty,uint dstLo,uint dstHi);
+
+// Computes the rows of 'dstRows', starting at row 'dstLo' of the 'dstDims' resize of a 'srcDims' image,
+// with horizontal taps 'tx' and vertical taps 'ty' for that resize. 'srcRows' starts at source row
+// 'srcLo' and must include the rows given by 'resizeSrcRows'. The horizontal pass holds a float
+// buffer of those source rows at the output width:
+void
+imgResizeRows_(ImgCView<RgbaUC> const & srcRows,uint srcLo,Vec2UI srcDims,
+               ImgView<RgbaUC> const & dstRows,uint dstLo,Vec2UI dstDims,
+               ResampleTaps const & tx,ResampleTaps const & ty);
+
+void
+imgResizeRows_(ImgCView<RgbaF> const & srcRows,uint srcLo,Vec2UI srcDims,
+               ImgView<RgbaF> const & dstRows,uint dstLo,Vec2UI dstDims,
+               ResampleTaps const & tx,ResampleTaps const & ty);
+
+}
+
+#endif
@@ -0,0 +1,477 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Vectorized row kernels for the [1 2 1] smoothing and 3x3 convolution templates in FgImage.hpp.
+// Multi-channel pixels are treated as flat arrays of channel values with a horizontal neighbour
+// stride equal to the number of channels. Each vector loop handles as many whole vectors as fit
+// and returns where the scalar loop must finish. Operations are done in the same order as the
+// generic templates so the integer results are identical.
+//
+
+#include "stdafx.h"
+
+#include "FgImage.hpp"
+#include "FgSimd.hpp"
+
+using namespace std;
+
+namespace Fg {
+
+namespace {
+
+// [1 2 1] over uchar channels into ushort accumulators, interior range [beg,end):
+
+#ifdef FG_SSE2
+size_t
+smoothHorizUcSse2(uchar const * s,ushort * d,size_t C,size_t beg,size_t end)
+{
+    __m128i const       zero = _mm_setzero_si128();
+    size_t              ii = beg;
+    for (; ii+16<=end; ii+=16) {
+        __m128i         l = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s+ii-C)),
+                        m = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s+ii)),
+                        r = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s+ii+C)),
+                        lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(l,zero),
+                            _mm_slli_epi16(_mm_unpacklo_epi8(m,zero),1)),_mm_unpacklo_epi8(r,zero)),
+                        hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(l,zero),
+                            _mm_slli_epi16(_mm_unpackhi_epi8(m,zero),1)),_mm_unpackhi_epi8(r,zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d+ii),lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d+ii+8),hi);
+    }
+    return ii;
+}
+#endif
+
+#ifdef FG_AVX2
+FG_TARGET_AVX2
+size_t
+smoothHorizUcAvx2(uchar const * s,ushort * d,size_t C,size_t beg,size_t end)
+{
+    size_t              ii = beg;
+    for (; ii+16<=end; ii+=16) {
+        __m256i         l = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s+ii-C))),
+                        m = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s+ii))),
+                        r = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s+ii+C)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(d+ii),
+            _mm256_add_epi16(_mm256_add_epi16(l,_mm256_slli_epi16(m,1)),r));
+    }
+    return ii;
+}
+#endif
+
+#ifdef FG_NEON
+size_t
+smoothHorizUcNeon(uchar const * s,ushort * d,size_t C,size_t beg,size_t end)
+{
+    size_t              ii = beg;
+    for (; ii+8<=end; ii+=8) {
+        uint16x8_t      l = vmovl_u8(vld1_u8(s+ii-C)),
+                        m = vmovl_u8(vld1_u8(s+ii)),
+                        r = vmovl_u8(vld1_u8(s+ii+C));
+        vst1q_u16(d+ii,vaddq_u16(vaddq_u16(l,vshlq_n_u16(m,1)),r));
+    }
+    return ii;
+}
+#endif
+
+void
+smoothHorizUc(uchar const * s,ushort * d,size_t num,size_t C,uchar borderPolicy)
+{
+    for (size_t cc=0; cc<C; ++cc) {
+        d[cc] = ushort(s[cc]*(2+borderPolicy) + s[cc+C]);
+        d[num-C+cc] = ushort(s[num-2*C+cc] + s[num-C+cc]*(2+borderPolicy));
+    }
+    size_t              ii = C,
+                        end = num-C;
+    Simd                simd = simdLevel();
+#ifdef FG_AVX2
+    if (simd == Simd::avx2)
+        ii = smoothHorizUcAvx2(s,d,C,ii,end);
+#endif
+#ifdef FG_SSE2
+    if (simd >= Simd::vec128)
+        ii = smoothHorizUcSse2(s,d,C,ii,end);
+#endif
+#ifdef FG_NEON
+    if (simd >= Simd::vec128)
+        ii = smoothHorizUcNeon(s,d,C,ii,end);
+#endif
+    for (; ii<end; ++ii)
+        d[ii] = ushort(s[ii-C] + s[ii]*2 + s[ii+C]);
+}
+
+// (a0 + 2*a1 + a2 + 7) / 16 from ushort accumulators to uchar:
+
+#ifdef FG_SSE2
+size_t
+smoothVertUcSse2(ushort const * a0,ushort const * a1,ushort const * a2,uchar * d,size_t num)
+{
+    __m128i const       seven = _mm_set1_epi16(7);
+    size_t              ii = 0;
+    for (; ii+16<=num; ii+=16) {
+        __m128i         lo = _mm_add_epi16(_mm_add_epi16(_mm_add_epi16(
+                            _mm_loadu_si128(reinterpret_cast<__m128i const *>(a0+ii)),
+                            _mm_slli_epi16(_mm_loadu_si128(reinterpret_cast<__m128i const *>(a1+ii)),1)),
+                            _mm_loadu_si128(reinterpret_cast<__m128i const *>(a2+ii))),seven),
+                        hi = _mm_add_epi16(_mm_add_epi16(_mm_add_epi16(
+                            _mm_loadu_si128(reinterpret_cast<__m128i const *>(a0+ii+8)),
+                            _mm_slli_epi16(_mm_loadu_si128(reinterpret_cast<__m128i const *>(a1+ii+8)),1)),
+                            _mm_loadu_si128(reinterpret_cast<__m128i const *>(a2+ii+8))),seven);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d+ii),
+            _mm_packus_epi16(_mm_srli_epi16(lo,4),_mm_srli_epi16(hi,4)));
+    }
+    return ii;
+}
+#endif
+
+#ifdef FG_AVX2
+FG_TARGET_AVX2
+size_t
+smoothVertUcAvx2(ushort const * a0,ushort const * a1,ushort const * a2,uchar * d,size_t num)
+{
+    __m256i const       seven = _mm256_set1_epi16(7);
+    size_t              ii = 0;
+    for (; ii+16<=num; ii+=16) {
+        __m256i         sum = _mm256_add_epi16(_mm256_add_epi16(_mm256_add_epi16(
+                            _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a0+ii)),
+                            _mm256_slli_epi16(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(a1+ii)),1)),
+                            _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a2+ii))),seven),
+                        // Packing is per 128-bit lane so gather the two low quadwords:
+                        packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(
+                            _mm256_srli_epi16(sum,4),_mm256_srli_epi16(sum,4)),0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d+ii),_mm256_castsi256_si128(packed));
+    }
+    return ii;
+}
+#endif
+
+#ifdef FG_NEON
+size_t
+smoothVertUcNeon(ushort const * a0,ushort const * a1,ushort const * a2,uchar * d,size_t num)
+{
+    uint16x8_t const    seven = vdupq_n_u16(7);
+    size_t              ii = 0;
+    for (; ii+8<=num; ii+=8) {
+        uint16x8_t      sum = vaddq_u16(vaddq_u16(vaddq_u16(vld1q_u16(a0+ii),
+                            vshlq_n_u16(vld1q_u16(a1+ii),1)),vld1q_u16(a2+ii)),seven);
+        vst1_u8(d+ii,vshrn_n_u16(sum,4));
+    }
+    return ii;
+}
+#endif
+
+void
+smoothVertUc(ushort const * a0,ushort const * a1,ushort const * a2,uchar * d,size_t num)
+{
+    size_t              ii = 0;
+    Simd                simd = simdLevel();
+#ifdef FG_AVX2
+    if (simd == Simd::avx2)
+        ii = smoothVertUcAvx2(a0,a1,a2,d,num);
+#endif
+#ifdef FG_SSE2
+    if (simd >= Simd::vec128)
+        ii += smoothVertUcSse2(a0+ii,a1+ii,a2+ii,d+ii,num-ii);
+#endif
+#ifdef FG_NEON
+    if (simd >= Simd::vec128)
+        ii += smoothVertUcNeon(a0+ii,a1+ii,a2+ii,d+ii,num-ii);
+#endif
+    for (; ii<num; ++ii)
+        d[ii] = uchar((a0[ii] + a1[ii]*2 + a2[ii] + 7) / 16);
+}
+
+// [1 2 1] over float channels, interior range [beg,end):
+
+#ifdef FG_SSE2
+size_t
+smoothHorizFSse2(float const * s,float * d,size_t C,size_t beg,size_t end)
+{
+    __m128 const        two = _mm_set1_ps(2.0f);
+    size_t              ii = beg;
+    for (; ii+4<=end; ii+=4)
+        _mm_storeu_ps(d+ii,_mm_add_ps(_mm_add_ps(_mm_loadu_ps(s+ii-C),
+            _mm_mul_ps(_mm_loadu_ps(s+ii),two)),_mm_loadu_ps(s+ii+C)));
+    return ii;
+}
+#endif
+
+#ifdef FG_AVX2
+FG_TARGET_AVX2
+size_t
+smoothHorizFAvx2(float const * s,float * d,size_t C,size_t beg,size_t end)
+{
+    __m256 const        two = _mm256_set1_ps(2.0f);
+    size_t              ii = beg;
+    for (; ii+8<=end; ii+=8)
+        _mm256_storeu_ps(d+ii,_mm256_add_ps(_mm256_add_ps(_mm256_loadu_ps(s+ii-C),
+            _mm256_mul_ps(_mm256_loadu_ps(s+ii),two)),_mm256_loadu_ps(s+ii+C)));
+    return ii;
+}
+#endif
+
+#ifdef FG_NEON
+size_t
+smoothHorizFNeon(float const * s,float * d,size_t C,size_t beg,size_t end)
+{
+    size_t              ii = beg;
+    for (; ii+4<=end; ii+=4)
+        vst1q_f32(d+ii,vaddq_f32(vaddq_f32(vld1q_f32(s+ii-C),
+            vmulq_n_f32(vld1q_f32(s+ii),2.0f)),vld1q_f32(s+ii+C)));
+    return ii;
+}
+#endif
+
+void
+smoothHorizF(float const * s,float * d,size_t num,size_t C,uchar borderPolicy)
+{
+    for (size_t cc=0; cc<C; ++cc) {
+        d[cc] = s[cc]*(2+borderPolicy) + s[cc+C];
+        d[num-C+cc] = s[num-2*C+cc] + s[num-C+cc]*(2+borderPolicy);
+    }
+    size_t              ii = C,
+                        end = num-C;
+    Simd                simd = simdLevel();
+#ifdef FG_AVX2
+    if (simd == Simd::avx2)
+        ii = smoothHorizFAvx2(s,d,C,ii,end);
+#endif
+#ifdef FG_SSE2
+    if (simd >= Simd::vec128)
+        ii = smoothHorizFSse2(s,d,C,ii,end);
+#endif
+#ifdef FG_NEON
+    if (simd >= Simd::vec128)
+        ii = smoothHorizFNeon(s,d,C,ii,end);
+#endif
+    for (; ii<end; ++ii)
+        d[ii] = s[ii-C] + s[ii]*2 + s[ii+C];
+}
+
+// (a0 + 2*a1 + a2) * fac over float channels:
+
+#ifdef FG_SSE2
+size_t
+smoothVertFSse2(float const * a0,float const * a1,float const * a2,float * d,size_t num,float fac)
+{
+    __m128 const        two = _mm_set1_ps(2.0f),
+                        f = _mm_set1_ps(fac);
+    size_t              ii = 0;
+    for (; ii+4<=num; ii+=4)
+        _mm_storeu_ps(d+ii,_mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_loadu_ps(a0+ii),
+            _mm_mul_ps(_mm_loadu_ps(a1+ii),two)),_mm_loadu_ps(a2+ii)),f));
+    return ii;
+}
+#endif
+
+#ifdef FG_AVX2
+FG_TARGET_AVX2
+size_t
+smoothVertFAvx2(float const * a0,float const * a1,float const * a2,float * d,size_t num,float fac)
+{
+    __m256 const        two = _mm256_set1_ps(2.0f),
+                        f = _mm256_set1_ps(fac);
+    size_t              ii = 0;
+    for (; ii+8<=num; ii+=8)
+        _mm256_storeu_ps(d+ii,_mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_loadu_ps(a0+ii),
+            _mm256_mul_ps(_mm256_loadu_ps(a1+ii),two)),_mm256_loadu_ps(a2+ii)),f));
+    return ii;
+}
+#endif
+
+#ifdef FG_NEON
+size_t
+smoothVertFNeon(float const * a0,float const * a1,float const * a2,float * d,size_t num,float fac)
+{
+    size_t              ii = 0;
+    for (; ii+4<=num; ii+=4)
+        vst1q_f32(d+ii,vmulq_n_f32(vaddq_f32(vaddq_f32(vld1q_f32(a0+ii),
+            vmulq_n_f32(vld1q_f32(a1+ii),2.0f)),vld1q_f32(a2+ii)),fac));
+    return ii;
+}
+#endif
+
+void
+smoothVertF(float const * a0,float const * a1,float const * a2,float * d,size_t num,float fac)
+{
+    size_t              ii = 0;
+    Simd                simd = simdLevel();
+#ifdef FG_AVX2
+    if (simd == Simd::avx2)
+        ii = smoothVertFAvx2(a0,a1,a2,d,num,fac);
+#endif
+#ifdef FG_SSE2
+    if (simd >= Simd::vec128)
+        ii += smoothVertFSse2(a0+ii,a1+ii,a2+ii,d+ii,num-ii,fac);
+#endif
+#ifdef FG_NEON
+    if (simd >= Simd::vec128)
+        ii += smoothVertFNeon(a0+ii,a1+ii,a2+ii,d+ii,num-ii,fac);
+#endif
+    for (; ii<num; ++ii)
+        d[ii] = (a0[ii] + a1[ii]*2 + a2[ii]) * fac;
+}
+
+// 3x3 correlation over float channels, interior range [beg,end). Each kernel row is summed
+// then accumulated, as in the generic template:
+
+#ifdef FG_SSE2
+size_t
+convHorizFSse2(float const * s[3],Mat33F const & krn,float * d,size_t C,size_t beg,size_t end)
+{
+    __m128              k[9];
+    for (uint jj=0; jj<9; ++jj)
+        k[jj] = _mm_set1_ps(krn[jj]);
+    size_t              ii = beg;
+    for (; ii+4<=end; ii+=4) {
+        __m128          acc = _mm_setzero_ps();
+        for (uint jj=0; jj<3; ++jj)
+            acc = _mm_add_ps(acc,_mm_add_ps(_mm_add_ps(
+                _mm_mul_ps(_mm_loadu_ps(s[jj]+ii-C),k[jj*3]),
+                _mm_mul_ps(_mm_loadu_ps(s[jj]+ii),k[jj*3+1])),
+                _mm_mul_ps(_mm_loadu_ps(s[jj]+ii+C),k[jj*3+2])));
+        _mm_storeu_ps(d+ii,acc);
+    }
+    return ii;
+}
+#endif
+
+#ifdef FG_AVX2
+FG_TARGET_AVX2
+size_t
+convHorizFAvx2(float const * s[3],Mat33F const & krn,float * d,size_t C,size_t beg,size_t end)
+{
+    __m256              k[9];
+    for (uint jj=0; jj<9; ++jj)
+        k[jj] = _mm256_set1_ps(krn[jj]);
+    size_t              ii = beg;
+    for (; ii+8<=end; ii+=8) {
+        __m256          acc = _mm256_setzero_ps();
+        for (uint jj=0; jj<3; ++jj)
+            acc = _mm256_add_ps(acc,_mm256_add_ps(_mm256_add_ps(
+                _mm256_mul_ps(_mm256_loadu_ps(s[jj]+ii-C),k[jj*3]),
+                _mm256_mul_ps(_mm256_loadu_ps(s[jj]+ii),k[jj*3+1])),
+                _mm256_mul_ps(_mm256_loadu_ps(s[jj]+ii+C),k[jj*3+2])));
+        _mm256_storeu_ps(d+ii,acc);
+    }
+    return ii;
+}
+#endif
+
+#ifdef FG_NEON
+size_t
+convHorizFNeon(float const * s[3],Mat33F const & krn,float * d,size_t C,size_t beg,size_t end)
+{
+    size_t              ii = beg;
+    for (; ii+4<=end; ii+=4) {
+        float32x4_t     acc = vdupq_n_f32(0.0f);
+        for (uint jj=0; jj<3; ++jj)
+            acc = vaddq_f32(acc,vaddq_f32(vaddq_f32(
+                vmulq_n_f32(vld1q_f32(s[jj]+ii-C),krn[jj*3]),
+                vmulq_n_f32(vld1q_f32(s[jj]+ii),krn[jj*3+1])),
+                vmulq_n_f32(vld1q_f32(s[jj]+ii+C),krn[jj*3+2])));
+        vst1q_f32(d+ii,acc);
+    }
+    return ii;
+}
+#endif
+
+void
+convHorizF(float const * s[3],Mat33F const & krn,float * d,size_t num,size_t C,uchar borderPolicy)
+{
+    for (size_t cc=0; cc<C; ++cc) {
+        float           lo = 0.0f,
+                        hi = 0.0f;
+        for (uint jj=0; jj<3; ++jj) {
+            lo += s[jj][cc] * (krn.rc(jj,0)*borderPolicy + krn.rc(jj,1)) + s[jj][cc+C] * krn.rc(jj,2);
+            hi += s[jj][num-2*C+cc] * krn.rc(jj,0) +
+                  s[jj][num-C+cc] * (krn.rc(jj,1)+krn.rc(jj,2)*borderPolicy);
+        }
+        d[cc] = lo;
+        d[num-C+cc] = hi;
+    }
+    size_t              ii = C,
+                        end = num-C;
+    Simd                simd = simdLevel();
+#ifdef FG_AVX2
+    if (simd == Simd::avx2)
+        ii = convHorizFAvx2(s,krn,d,C,ii,end);
+#endif
+#ifdef FG_SSE2
+    if (simd >= Simd::vec128)
+        ii = convHorizFSse2(s,krn,d,C,ii,end);
+#endif
+#ifdef FG_NEON
+    if (simd >= Simd::vec128)
+        ii = convHorizFNeon(s,krn,d,C,ii,end);
+#endif
+    for (; ii<end; ++ii) {
+        float           acc = 0.0f;
+        for (uint jj=0; jj<3; ++jj)
+            acc += s[jj][ii-C] * krn.rc(jj,0) + s[jj][ii] * krn.rc(jj,1) + s[jj][ii+C] * krn.rc(jj,2);
+        d[ii] = acc;
+    }
+}
+
+static_assert(sizeof(Vec3F) == 3*sizeof(float),"Vec3F must be densely packed");
+static_assert(sizeof(RgbaUS) == 4*sizeof(ushort),"RgbaUS must be densely packed");
+
+template<class Pixel>
+float const *
+flat(Pixel const * p)
+{return reinterpret_cast<float const *>(p); }
+
+}
+
+void
+fgSmoothUint1D(uchar const * srcPtr,ushort * dstPtr,uint num,uchar borderPolicy)
+{smoothHorizUc(srcPtr,dstPtr,num,1,borderPolicy); }
+
+void
+fgSmoothUint1D(RgbaUC const * srcPtr,RgbaUS * dstPtr,uint num,uchar borderPolicy)
+{
+    smoothHorizUc(&srcPtr[0].m_c[0],&dstPtr[0].m_c[0],size_t(num)*4,4,borderPolicy);
+}
+
+void
+fgSmoothUintVert(ushort const * a0,ushort const * a1,ushort const * a2,uchar * dst,uint num)
+{smoothVertUc(a0,a1,a2,dst,num); }
+
+void
+fgSmoothUintVert(RgbaUS const * a0,RgbaUS const * a1,RgbaUS const * a2,RgbaUC * dst,uint num)
+{
+    smoothVertUc(&a0[0].m_c[0],&a1[0].m_c[0],&a2[0].m_c[0],&dst[0].m_c[0],size_t(num)*4);
+}
+
+void
+fgSmoothFloat1D(float const * srcPtr,float * dstPtr,uint wid,uchar borderPolicy)
+{smoothHorizF(srcPtr,dstPtr,wid,1,borderPolicy); }
+
+void
+fgSmoothFloat1D(Vec3F const * srcPtr,Vec3F * dstPtr,uint wid,uchar borderPolicy)
+{smoothHorizF(flat(srcPtr),&dstPtr[0][0],size_t(wid)*3,3,borderPolicy); }
+
+void
+fgSmoothFloatVert(float const * a0,float const * a1,float const * a2,float * dst,uint wid,float factor)
+{smoothVertF(a0,a1,a2,dst,wid,factor); }
+
+void
+fgSmoothFloatVert(Vec3F const * a0,Vec3F const * a1,Vec3F const * a2,Vec3F * dst,uint wid,float factor)
+{smoothVertF(flat(a0),flat(a1),flat(a2),&dst[0][0],size_t(wid)*3,factor); }
+
+void
+fgConvolveFloatHoriz(float const * srcPtrs[3],Mat33F const & krn,float * dstPtr,uint sz,uchar borderPolicy)
+{convHorizF(srcPtrs,krn,dstPtr,sz,1,borderPolicy); }
+
+void
+fgConvolveFloatHoriz(Vec3F const * srcPtrs[3],Mat33F const & krn,Vec3F * dstPtr,uint sz,uchar borderPolicy)
+{
+    float const *       s[3] = {flat(srcPtrs[0]),flat(srcPtrs[1]),flat(srcPtrs[2])};
+    convHorizF(s,krn,&dstPtr[0][0],size_t(sz)*3,3,borderPolicy);
+}
+
+}
+
+// */
@@ -14,6 +14,11 @@
 #include "FgApproxEqual.hpp"
 #include "FgCommand.hpp"
 #include "FgSyntax.hpp"
+#include "FgSimd.hpp"
+#include "FgImageFilter.hpp"
+#include "FgImageResample.hpp"
+#include "FgImageTiled.hpp"
+#include "FgImageIo.hpp"
 
 using namespace std;
 
@@ -87,6 +92,473 @@ testConvolve(const CLArgs &)
     FGASSERT(fgApproxEqual(i0.m_data,i1.m_data));
 }
 
+// Direct evaluation of the [1 2 1] outer product kernel with integer rounding as in 'fgSmoothUint':
+uchar
+smoothUintRef(const Img<uchar> & img,int xx,int yy,uchar borderPolicy)
+{
+    int                 wgt[3] = {1,2,1},
+                        sum = 0,
+                        wid = int(img.width()),
+                        hgt = int(img.height());
+    for (int dy=-1; dy<2; ++dy) {
+        for (int dx=-1; dx<2; ++dx) {
+            int             x = xx+dx,
+                            y = yy+dy;
+            if ((x < 0) || (x >= wid) || (y < 0) || (y >= hgt)) {
+                if (borderPolicy == 0)
+                    continue;
+                x = std::min(std::max(x,0),wid-1);
+                y = std::min(std::max(y,0),hgt-1);
+            }
+            sum += wgt[dx+1] * wgt[dy+1] * img.xy(x,y);
+        }
+    }
+    return uchar((sum + 7) / 16);
+}
+
+// The vectorized kernels must match the scalar ones exactly for integer pixels and closely for float:
+void
+testSmoothSimd(const CLArgs &)
+{
+    randSeedRepeatable();
+    Svec<Simd>          levels = {Simd::scalar,Simd::vec128,Simd::avx2};
+    for (uint wid : {2,3,5,17,33,70}) {
+        for (uint hgt : {2,3,9}) {
+            Img<uchar>          imgU(wid,hgt);
+            ImgC4UC             imgC(wid,hgt);
+            ImgF                imgF(wid,hgt);
+            Img3F               img3(wid,hgt);
+            for (size_t ii=0; ii<imgU.numPixels(); ++ii) {
+                imgU[ii] = uchar(randUint(256));
+                for (uint cc=0; cc<4; ++cc)
+                    imgC[ii].m_c[cc] = uchar(randUint(256));
+                imgF[ii] = float(randUniform());
+                img3[ii] = Vec3F(float(randUniform()),float(randUniform()),float(randUniform()));
+            }
+            Mat33F              krn(1,2,3,4,5,6,7,8,9);
+            for (uchar bp=0; bp<2; ++bp) {
+                Svec<Img<uchar> >   resU;
+                Svec<ImgC4UC>       resC;
+                Svec<ImgF>          resF,convF;
+                Svec<Img3F>         res3,conv3;
+                for (Simd level : levels) {
+                    setSimdLevel(level);
+                    resU.push_back(fgSmoothUint(imgU,bp));
+                    resC.push_back(fgSmoothUint(imgC,bp));
+                    ImgF                f,cf;
+                    Img3F               v,cv;
+                    fgSmoothFloat(imgF,f,bp);
+                    fgSmoothFloat(img3,v,bp);
+                    fgConvolveFloat(imgF,krn,cf,bp);
+                    fgConvolveFloat(img3,krn,cv,bp);
+                    resF.push_back(f);
+                    res3.push_back(v);
+                    convF.push_back(cf);
+                    conv3.push_back(cv);
+                }
+                for (uint yy=0; yy<hgt; ++yy)
+                    for (uint xx=0; xx<wid; ++xx)
+                        FGASSERT(resU[0].xy(xx,yy) == smoothUintRef(imgU,xx,yy,bp));
+                for (size_t ll=1; ll<levels.size(); ++ll) {
+                    FGASSERT(resU[ll].m_data == resU[0].m_data);
+                    FGASSERT(resC[ll].m_data == resC[0].m_data);
+                    FGASSERT(fgApproxEqual(resF[ll].m_data,resF[0].m_data));
+                    FGASSERT(fgApproxEqual(convF[ll].m_data,convF[0].m_data));
+                    FGASSERT(fgApproxEqual(res3[ll].m_data,res3[0].m_data));
+                    FGASSERT(fgApproxEqual(conv3[ll].m_data,conv3[0].m_data));
+                }
+            }
+        }
+    }
+    setSimdLevel(simdSupported());
+}
+
+void
+testRgbaSimd(const CLArgs &)
+{
+    randSeedRepeatable();
+    Svec<Simd>          levels = {Simd::scalar,Simd::vec128,Simd::avx2};
+    for (uint num : {1,3,4,7,8,17,64,101}) {
+        ImgC4UC             fg(num,1),
+                            bg(num,1);
+        ImgC4F              fl(num,1);
+        for (size_t ii=0; ii<num; ++ii) {
+            for (uint cc=0; cc<4; ++cc) {
+                fg[ii].m_c[cc] = uchar(randUint(256));
+                bg[ii].m_c[cc] = uchar(randUint(256));
+                fl[ii].m_c[cc] = float(randUniform(-50.0,300.0));
+            }
+        }
+        fg[0].alpha() = 0;                          // Exercise the zero alpha case
+        fgAlphaWeight(bg);                          // Valid alpha-weighted backgrounds
+        Svec<ImgC4UC>       weighted,unweighted,composited,toUc;
+        Svec<ImgUC>         lum;
+        Svec<ImgC4F>        toF;
+        for (Simd level : levels) {
+            setSimdLevel(level);
+            ImgC4UC             w = fg,
+                                u,
+                                c = bg,
+                                uc;
+            fgAlphaWeight(w);
+            u = w;
+            fgAlphaUnweight(u);
+            fgComposite_(w.cview(),c.view());
+            ImgUC               l;
+            ImgC4F              f;
+            imgConvert_(fg,l);
+            imgConvert_(fg,f);
+            imgConvert_(fl,uc);
+            weighted.push_back(w);
+            unweighted.push_back(u);
+            composited.push_back(c);
+            lum.push_back(l);
+            toF.push_back(f);
+            toUc.push_back(uc);
+        }
+        for (size_t ii=0; ii<num; ++ii) {
+            RgbaUC              w = fg[ii];
+            w.alphaWeight();
+            FGASSERT(weighted[0][ii] == w);
+            FGASSERT(composited[0][ii] == fgCompositeFragmentUnweighted(w,bg[ii]));
+            FGASSERT(lum[0][ii] == fg[ii].rec709());
+            for (uint cc=0; cc<4; ++cc) {
+                FGASSERT(toF[0][ii].m_c[cc] == float(fg[ii].m_c[cc]));
+                FGASSERT(toUc[0][ii].m_c[cc] == uchar(clampBounds(fl[ii].m_c[cc],0.0f,255.0f)));
+            }
+            // Re-weighting the unweighted values is lossless:
+            RgbaUC              u = unweighted[0][ii];
+            u.alphaWeight();
+            FGASSERT(u == w);
+        }
+        for (size_t ll=1; ll<levels.size(); ++ll) {
+            FGASSERT(weighted[ll] == weighted[0]);
+            FGASSERT(unweighted[ll] == unweighted[0]);
+            FGASSERT(composited[ll] == composited[0]);
+            FGASSERT(lum[ll] == lum[0]);
+            FGASSERT(toF[ll] == toF[0]);
+            FGASSERT(toUc[ll] == toUc[0]);
+        }
+    }
+    setSimdLevel(simdSupported());
+    // Luminance leaves greys unchanged:
+    ImgC4UC             greys(256,1);
+    ImgUC               lum;
+    for (uint ii=0; ii<256; ++ii)
+        greys[ii] = RgbaUC(uchar(ii),uchar(ii),uchar(ii),255);
+    imgConvert_(greys,lum);
+    for (uint ii=0; ii<256; ++ii)
+        FGASSERT(lum[ii] == ii);
+}
+
+// Direct 2D evaluation of a separable symmetric kernel with border replication:
+float
+filterRef(const ImgF & img,Floats const & half,int xx,int yy)
+{
+    int                 rad = int(half.size())-1,
+                        wid = int(img.width()),
+                        hgt = int(img.height());
+    float               ret = 0.0f;
+    for (int dy=-rad; dy<=rad; ++dy) {
+        for (int dx=-rad; dx<=rad; ++dx) {
+            int             x = std::min(std::max(xx+dx,0),wid-1),
+                            y = std::min(std::max(yy+dy,0),hgt-1);
+            ret += half[std::abs(dx)] * half[std::abs(dy)] * img.xy(x,y);
+        }
+    }
+    return ret;
+}
+
+void
+testFilter(const CLArgs &)
+{
+    randSeedRepeatable();
+    ImgF                img(37,23);             // Non-square and not a multiple of the tile size
+    for (size_t ii=0; ii<img.numPixels(); ++ii)
+        img[ii] = float(randUniform());
+    Floats              gauss = gaussKernelHalf(1.5f),
+                        box(4,1.0f/7.0f);
+    ImgF                g = imgBlurGauss(img,1.5f),
+                        b = imgBlurBox(img,3);
+    for (uint yy=0; yy<img.height(); ++yy) {
+        for (uint xx=0; xx<img.width(); ++xx) {
+            FGASSERT(std::abs(g.xy(xx,yy)-filterRef(img,gauss,xx,yy)) < 0.00001f);
+            FGASSERT(std::abs(b.xy(xx,yy)-filterRef(img,box,xx,yy)) < 0.00001f);
+        }
+    }
+    // The recursive Gaussian should be close to the exact one away from the borders:
+    ImgF                big(160,120);
+    for (size_t ii=0; ii<big.numPixels(); ++ii)
+        big[ii] = float(randUniform());
+    ImgF                exact = imgFilterSymmetric(big,gaussKernelHalf(4.0f)),
+                        iir = imgBlurGaussIir(big,4.0f);
+    for (uint yy=20; yy<big.height()-20; ++yy)
+        for (uint xx=20; xx<big.width()-20; ++xx)
+            FGASSERT(std::abs(exact.xy(xx,yy)-iir.xy(xx,yy)) < 0.01f);
+    // Constant images are unchanged including at the borders:
+    Img3F               flat(50,30,Vec3F(0.25f,0.5f,0.75f));
+    Img3F               flatIir = imgBlurGaussIir(flat,10.0f);
+    for (Vec3F const & p : flatIir.m_data)
+        FGASSERT(fgMaxElem(mapAbs(p-Vec3F(0.25f,0.5f,0.75f))) < 0.0001f);
+    ImgC4UC             flat4(40,20,RgbaUC(10,20,30,255));
+    FGASSERT(imgBlurGauss(flat4,5.0f).m_data == flat4.m_data);
+}
+
+void
+testResample(const CLArgs &)
+{
+    randSeedRepeatable();
+    Svec<ResampleFilter>    filters = {ResampleFilter::box,ResampleFilter::triangle,
+                                       ResampleFilter::mitchell,ResampleFilter::lanczos3};
+    ImgC4UC             img(24,18);
+    for (RgbaUC & p : img.m_data)
+        for (uint cc=0; cc<4; ++cc)
+            p.m_c[cc] = uchar(randUint(256));
+    // Halving with the box filter is the rounded 2x2 mean:
+    ImgC4UC             half = imgResize(img,Vec2UI(12,9),ResampleFilter::box);
+    for (uint yy=0; yy<9; ++yy) {
+        for (uint xx=0; xx<12; ++xx) {
+            for (uint cc=0; cc<4; ++cc) {
+                uint                sum = 2;
+                for (uint jj=0; jj<2; ++jj)
+                    for (uint ii=0; ii<2; ++ii)
+                        sum += img.xy(2*xx+ii,2*yy+jj).m_c[cc];
+                FGASSERT(half.xy(xx,yy).m_c[cc] == sum/4);
+            }
+        }
+    }
+    ImgC4UC             flat(13,7,RgbaUC(10,100,200,255));
+    ImgF                ramp(16,4);
+    for (uint yy=0; yy<ramp.height(); ++yy)
+        for (uint xx=0; xx<ramp.width(); ++xx)
+            ramp.xy(xx,yy) = float(xx);
+    for (ResampleFilter filter : filters) {
+        // Constant images are unchanged:
+        for (Vec2UI dims : {Vec2UI(5,3),Vec2UI(13,7),Vec2UI(40,29)})
+            FGASSERT(imgResize(flat,dims,filter).m_data == Svec<RgbaUC>(dims.cmpntsProduct(),flat[0]));
+        // Vectorized and scalar passes agree:
+        ImgC4UC             i0,i1;
+        setSimdLevel(Simd::scalar);
+        i0 = imgResize(img,Vec2UI(37,11),filter);
+        setSimdLevel(simdSupported());
+        i1 = imgResize(img,Vec2UI(37,11),filter);
+        FGASSERT(fgImgApproxEqual(i0,i1,1));
+    }
+    // Linear functions are reproduced away from the borders when expanding:
+    ImgF                lin = imgResize(ramp,Vec2UI(32,8),ResampleFilter::triangle);
+    for (uint xx=2; xx<30; ++xx)
+        FGASSERT(std::abs(lin.xy(xx,3) - (xx+0.5f)/2.0f + 0.5f) < 0.0001f);
+}
+
+void
+testView(const CLArgs &)
+{
+    randSeedRepeatable();
+    ImgC4UC             img(40,30);
+    for (RgbaUC & p : img.m_data)
+        for (uint cc=0; cc<4; ++cc)
+            p.m_c[cc] = uchar(randUint(256));
+    Img3F               imgF(40,30);
+    for (Vec3F & p : imgF.m_data)
+        p = Vec3F(float(randUniform()),float(randUniform()),float(randUniform()));
+    Vec2UI              off(7,5),
+                        dims(21,16);
+    ImgCView<RgbaUC>    view = img.cview(off,dims);
+    ImgC4UC             crop = fgCropPad(img,dims,Vec2I(off));
+    // Views share storage with the source:
+    FGASSERT(view.stride() == img.width());
+    FGASSERT(&view.xy(0,0) == &img.xy(off[0],off[1]));
+    FGASSERT(ImgC4UC(view) == crop);
+    FGASSERT(ImgC4UC(view.sub(Vec2UI(3,2),Vec2UI(5,4))) == fgCropPad(img,Vec2UI(5,4),Vec2I(off)+Vec2I(3,2)));
+    // Algorithms on views give the same results as on copies:
+    FGASSERT(fgCropPad(view,Vec2UI(30,20),Vec2I(-2,3)) == fgCropPad(crop,Vec2UI(30,20),Vec2I(-2,3)));
+    FGASSERT(fgFlipHoriz(view) == fgFlipHoriz(crop));
+    FGASSERT(fgSmoothUint(view) == fgSmoothUint(crop));
+    FGASSERT(fgJoinHoriz(view,view) == fgJoinHoriz(crop,crop));
+    FGASSERT(fgJoinVert(view,view) == fgJoinVert(crop,crop));
+    for (ResampleFilter filter : {ResampleFilter::box,ResampleFilter::lanczos3})
+        FGASSERT(imgResize(view,Vec2UI(13,29),filter) == imgResize(crop,Vec2UI(13,29),filter));
+    Img3F               cropF = fgCropPad(imgF,dims,Vec2I(off)),
+                        smoothF(dims),
+                        refF;
+    fgSmoothFloat(imgF.cview(off,dims),smoothF.view(),1);
+    fgSmoothFloat(cropF,refF,1);
+    FGASSERT(smoothF == refF);
+    FGASSERT(sampleClip(imgF.cview(off,dims),Vec2F(0.3f,0.6f)) == sampleClip(cropF,Vec2F(0.3f,0.6f)));
+    // Writing through views only touches the region:
+    ImgC4UC             dst(40,30,RgbaUC(0,0,0,0)),
+                        ref = fgCropPad(crop,Vec2UI(40,30),-Vec2I(off),RgbaUC(0,0,0,0));
+    fgComposite_(crop.cview(),dst.view(off,dims));
+    FGASSERT(dst == ref);
+    fgSmoothUint(crop.cview(),dst.view(off,dims));
+    imgCopy_(fgSmoothUint(crop).cview(),ref.view(off,dims));
+    FGASSERT(dst == ref);
+}
+
+void
+testTiled(const CLArgs & args)
+{
+    FGTESTDIR
+    randSeedRepeatable();
+    ImgC4UC             img(300,170);
+    for (RgbaUC & p : img.m_data)
+        for (uint cc=0; cc<4; ++cc)
+            p.m_c[cc] = uchar(randUint(256));
+    // Write in uneven bands of rows:
+    {
+        ImgTiledWriter<RgbaUC>  w("img.fgt",img.dims(),64);
+        w.addRows(img.cview(Vec2UI(0),Vec2UI(300,50)));
+        w.addRows(img.cview(Vec2UI(0,50),Vec2UI(300,120)));
+        w.finish();
+    }
+    ImgTiled<RgbaUC>    tiled("img.fgt",2);
+    FGASSERT(tiled.dims() == img.dims());
+    FGASSERT(tiled.numTiles() == Vec2UI(5,3));
+    FGASSERT(tiled.toImg() == img);
+    FGASSERT(tiled.rows(60,131) == fgCropPad(img,Vec2UI(300,71),Vec2I(0,60)));
+    ImgCView<RgbaUC>    edge = tiled.tile(Vec2UI(4,2));
+    FGASSERT(ImgC4UC(edge) == fgCropPad(img,Vec2UI(44,42),Vec2I(256,128)));
+    for (uint ii=0; ii<100; ++ii) {
+        Vec2F               pos(float(randUniform(-0.1,1.1)),float(randUniform(-0.1,1.1)));
+        FGASSERT(sampleClip(tiled,pos) == sampleClip(img,pos));
+    }
+    // Banded resize matches the in-memory resize exactly, including small budgets giving many bands
+    // and a budget below that of a single output row:
+    for (Vec2UI dims : {Vec2UI(97,61),Vec2UI(611,333)}) {
+        for (size_t budget : {size_t(1)<<26,size_t(50000),size_t(100)}) {
+            imgResizeTiled(tiled,"rsz.fgt",dims,ResampleFilter::lanczos3,32,budget);
+            FGASSERT(ImgTiled<RgbaUC>("rsz.fgt").toImg() == imgResize(img,dims,ResampleFilter::lanczos3));
+        }
+    }
+}
+
+double
+meanAbsDiff(ImgC4UC const & i0,ImgC4UC const & i1)
+{
+    FGASSERT(i0.dims() == i1.dims());
+    double              acc = 0.0;
+    for (size_t ii=0; ii<i0.numPixels(); ++ii)
+        for (uint cc=0; cc<3; ++cc)
+            acc += std::abs(int(i0[ii].m_c[cc]) - int(i1[ii].m_c[cc]));
+    return acc / (3.0 * i0.numPixels());
+}
+
+void
+testJpeg(const CLArgs &)
+{
+    Ustring             fname = dataDir() + "base/Jane.jpg";
+    ImgC4UC             full = imgLoadAnyFormat(fname),
+                        ijg = imgLoadJpeg(fname);
+    Vec2UI              dims = full.dims();
+    FGASSERT(imgJpegDims(fname) == dims);
+    // Different decoders differ only by IDCT and upsampling rounding:
+    FGASSERT(meanAbsDiff(full,ijg) < 1.0);
+    for (uint denom : {2U,4U,8U}) {
+        ImgC4UC             small = imgLoadJpeg(fname,denom);
+        Vec2UI              sd = (dims + Vec2UI(denom-1)) / denom;
+        FGASSERT(small.dims() == sd);
+        FGASSERT(meanAbsDiff(small,imgResize(full,sd,ResampleFilter::box)) < 3.0);
+    }
+    // The encoder round trips:
+    ImgC4UC             rt = imgDecodeJpeg(imgEncodeJpeg(ijg,100));
+    FGASSERT(meanAbsDiff(rt,ijg) < 1.0);
+    ImgC4UC             thumb = imgLoadThumbnail(fname,Vec2UI(100,100));
+    FGASSERT(fgMaxElem(thumb.dims()) == 100);
+    FGASSERT((thumb.width() <= 100) && (thumb.height() <= 100));
+    // In-memory codecs used by batch conversion. PNG is lossless:
+    String              png = imgEncodeAnyFormat(thumb,"png");
+    FGASSERT(imgDecodeAnyFormat(reinterpret_cast<uchar const *>(png.data()),png.size()) == thumb);
+    String              jpg = fgSlurp(fname);
+    FGASSERT(imgDecodeAnyFormat(reinterpret_cast<uchar const *>(jpg.data()),jpg.size()) == ijg);
+}
+
+void
+testHdr(const CLArgs & args)
+{
+    FGTESTDIR
+    randSeedRepeatable();
+    Vec2UI              dims(37,23);
+    ImgC4US             rgba(dims);
+    ImgUS               grey(dims);
+    Img3F               rgb(dims);
+    for (size_t ii=0; ii<rgba.numPixels(); ++ii) {
+        for (uint cc=0; cc<4; ++cc)
+            rgba[ii].m_c[cc] = ushort(randUint(65536));
+        grey[ii] = ushort(randUint(65536));
+        rgb[ii] = Vec3F(randNormalF(),randNormalF(),randNormalF()) * 1.0e3f;
+    }
+    imgSavePng16("rgba.png",rgba);
+    imgSavePng16("grey.png",grey);
+    FGASSERT(imgIs16Bit("rgba.png"));
+    FGASSERT(imgLoadPng16("rgba.png") == rgba);
+    FGASSERT(imgLoadPng16Grey("grey.png") == grey);
+    FGASSERT(imgLoadPng16Grey("rgba.png")[3] == rgba[3].rec709());
+    // 8 bit files load at full 16 bit range:
+    ImgC4UC             img8(dims,RgbaUC(255,0,128,255));
+    imgSaveAnyFormat("img8.png",img8);
+    FGASSERT(!imgIs16Bit("img8.png"));
+    FGASSERT(imgLoadPng16("img8.png")[0] == RgbaUS(65535,0,128*257,65535));
+    // Greyscale float load retains 16 bit precision:
+    ImgF                greyF;
+    imgLoadAnyFormat("grey.png",greyF);
+    FGASSERT(std::abs(greyF[7]*257.0f-float(grey[7])) < 0.1f);
+    imgSavePfm("rgb.pfm",rgb);
+    FGASSERT(imgLoadPfm("rgb.pfm") == rgb);
+    ImgF                fl(dims);
+    for (size_t ii=0; ii<fl.numPixels(); ++ii)
+        fl[ii] = rgb[ii][0];
+    imgSavePfm("grey.pfm",fl);
+    FGASSERT(imgLoadPfmGrey("grey.pfm") == fl);
+    imgLoadAnyFormat("grey.pfm",greyF);
+    FGASSERT(greyF == fl);
+    FGASSERT(imgLoadPfm("grey.pfm")[5] == Vec3F(fl[5]));
+}
+
+void
+testPyramid(const CLArgs &)
+{
+    randSeedRepeatable();
+    // Mipmaps match repeated 'fgImgShrink2' exactly, including the power of 2 resize:
+    for (Vec2UI dims : {Vec2UI(64,32),Vec2UI(50,37)}) {
+        ImgC4UC             img(dims);
+        for (RgbaUC & p : img.m_data)
+            for (uint cc=0; cc<4; ++cc)
+                p.m_c[cc] = uchar(randUint(256));
+        ImgC4UCs            mip = fgMipMap(img);
+        ImgC4UC             ref;
+        fgResizePow2Ceil_(img,ref);
+        FGASSERT(mip.size() == log2Ceil(fgMinElem(dims)));
+        for (ImgC4UC const & m : mip) {
+            FGASSERT(m.m_data == ref.m_data);
+            ref = fgImgShrink2(ref);
+        }
+    }
+    // SSI matches repeated in-place smoothing and decimation, to rounding. Taller than one
+    // row band so the band overlaps are exercised:
+    for (uchar bp=0; bp<2; ++bp) {
+        for (Vec2UI dims : {Vec2UI(97,75),Vec2UI(2,2),Vec2UI(1,5)}) {
+            Img3F               img(dims);
+            for (Vec3F & p : img.m_data)
+                for (uint cc=0; cc<3; ++cc)
+                    p[cc] = float(randUniform());
+            ImgPyramid<Vec3F>   ssi = ssiPyramid(img,bp);
+            Img3F               ref = img;
+            FGASSERT(ssi.numLevels() == log2Floor(fgMinElem(dims))+1);
+            for (size_t ll=0; ll<ssi.numLevels(); ++ll) {
+                if (ll+1 < ssi.numLevels()) {
+                    fgSmoothFloat(ref,ref,bp);
+                    fgSmoothFloat(ref,ref,bp);
+                }
+                Img3F               lev = ssi.level(ll);
+                FGASSERT(lev.dims() == ref.dims());
+                for (size_t ii=0; ii<lev.numPixels(); ++ii)
+                    FGASSERT(fgMaxElem(mapAbs(lev[ii]-ref[ii])) < 0.00001f);
+                ref = fgShrink2Float(ref);
+            }
+        }
+    }
+}
+
 }
 
 void
@@ -107,6 +579,15 @@ fgImageTest(const CLArgs & args)
     vector<Cmd>       cmds;
     cmds.push_back(Cmd(composite,"composite"));
     cmds.push_back(Cmd(testConvolve,"conv"));
+    cmds.push_back(Cmd(testSmoothSimd,"smoothSimd"));
+    cmds.push_back(Cmd(testRgbaSimd,"rgbaSimd"));
+    cmds.push_back(Cmd(testFilter,"filter"));
+    cmds.push_back(Cmd(testResample,"resample"));
+    cmds.push_back(Cmd(testPyramid,"pyramid"));
+    cmds.push_back(Cmd(testView,"view"));
+    cmds.push_back(Cmd(testTiled,"tiled"));
+    cmds.push_back(Cmd(testJpeg,"jpeg"));
+    cmds.push_back(Cmd(testHdr,"hdr"));
     cmds.push_back(Cmd(fgImgTestWrite,"write"));
     doMenu(args,cmds,true,false,true);
 }
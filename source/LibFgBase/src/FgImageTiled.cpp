@@ -0,0 +1,222 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+
+#include "stdafx.h"
+
+#include "FgImageTiled.hpp"
+
+using namespace std;
+
+namespace Fg {
+
+namespace {
+
+char const      s_magic[8] = {'F','G','T','I','L','E','D','1'};
+size_t const    s_page = 4096;              // File layout alignment. Independent of the OS page size
+
+struct  Header
+{
+    char            magic[8];
+    uint32          pixelSize;
+    uint32          width;
+    uint32          height;
+    uint32          tileSize;
+};
+
+size_t
+tileBytes(uint tileSize,size_t pixelSize)
+{
+    size_t          sz = size_t(tileSize) * tileSize * pixelSize;
+    return (sz + s_page - 1) / s_page * s_page;
+}
+
+}
+
+ImgTiledBase::ImgTiledBase(Ustring const & fname,size_t pixelSize,size_t cacheTiles)
+: m_file(fname), m_pixelSize(pixelSize), m_cacheTiles(std::max(cacheTiles,size_t(1)))
+{
+    Header          hdr;
+    if (m_file.size() < s_page)
+        fgThrow("Tiled image file header truncated",fname);
+    memcpy(&hdr,m_file.data(),sizeof(hdr));
+    if (memcmp(hdr.magic,s_magic,sizeof(s_magic)) != 0)
+        fgThrow("Not a tiled image file",fname);
+    if (hdr.pixelSize != pixelSize)
+        fgThrow("Tiled image file has a different pixel type",fname);
+    if (hdr.tileSize == 0)
+        fgThrow("Tiled image file has invalid tile size",fname);
+    m_dims = Vec2UI(hdr.width,hdr.height);
+    m_tileSize = hdr.tileSize;
+    m_tileBytes = tileBytes(m_tileSize,m_pixelSize);
+    if (m_file.size() < s_page + numTiles().cmpntsProduct()*m_tileBytes)
+        fgThrow("Tiled image file truncated",fname);
+}
+
+Vec2UI
+ImgTiledBase::tileDims(Vec2UI tileIdx) const
+{
+    FGASSERT((tileIdx[0] < numTiles()[0]) && (tileIdx[1] < numTiles()[1]));
+    Vec2UI          lo = tileIdx * m_tileSize;
+    return Vec2UI(std::min(m_tileSize,m_dims[0]-lo[0]),std::min(m_tileSize,m_dims[1]-lo[1]));
+}
+
+char const *
+ImgTiledBase::tilePtr(Vec2UI tileIdx) const
+{
+    FGASSERT((tileIdx[0] < numTiles()[0]) && (tileIdx[1] < numTiles()[1]));
+    size_t          idx = size_t(tileIdx[1]) * numTiles()[0] + tileIdx[0];
+    {
+        lock_guard<mutex>   lock(m_mutex);
+        auto                it = m_lruPos.find(idx);
+        if (it != m_lruPos.end())
+            m_lru.splice(m_lru.begin(),m_lru,it->second);
+        else {
+            m_lru.push_front(idx);
+            m_lruPos[idx] = m_lru.begin();
+            if (m_lru.size() > m_cacheTiles) {
+                size_t          old = m_lru.back();
+                m_lru.pop_back();
+                m_lruPos.erase(old);
+                m_file.discard(s_page+old*m_tileBytes,m_tileBytes);
+            }
+        }
+    }
+    return m_file.data() + s_page + idx*m_tileBytes;
+}
+
+char const *
+ImgTiledBase::pixelPtr(size_t xx,size_t yy) const
+{
+    FGASSERT_FAST((xx < m_dims[0]) && (yy < m_dims[1]));
+    size_t          tx = xx / m_tileSize,
+                    ty = yy / m_tileSize,
+                    pix = (yy - ty*m_tileSize) * m_tileSize + (xx - tx*m_tileSize);
+    return tilePtr(Vec2UI(uint(tx),uint(ty))) + pix*m_pixelSize;
+}
+
+ImgTiledWriterBase::ImgTiledWriterBase(Ustring const & fname,Vec2UI dims,uint tileSize,size_t pixelSize)
+: m_ofs(fname), m_dims(dims), m_tileSize(tileSize), m_pixelSize(pixelSize)
+{
+    FGASSERT(tileSize > 0);
+    m_tileBytes = tileBytes(tileSize,pixelSize);
+    Header          hdr;
+    memcpy(hdr.magic,s_magic,sizeof(s_magic));
+    hdr.pixelSize = uint32(pixelSize);
+    hdr.width = dims[0];
+    hdr.height = dims[1];
+    hdr.tileSize = tileSize;
+    Svec<char>      page(s_page,0);
+    memcpy(page.data(),&hdr,sizeof(hdr));
+    m_ofs.write(page.data(),page.size());
+}
+
+void
+ImgTiledWriterBase::addRows(char const * data,size_t rowBytes,size_t strideBytes,uint num)
+{
+    FGASSERT(rowBytes == m_dims[0]*m_pixelSize);
+    FGASSERT(m_rows+num <= m_dims[1]);
+    for (uint rr=0; rr<num; ++rr) {
+        char const *        row = data + rr*strideBytes;
+        m_band.insert(m_band.end(),row,row+rowBytes);
+        ++m_rows;
+        if ((m_rows % m_tileSize == 0) || (m_rows == m_dims[1]))
+            writeBand();
+    }
+}
+
+void
+ImgTiledWriterBase::writeBand()
+{
+    size_t              rowBytes = m_dims[0] * m_pixelSize,
+                        bandRows = m_band.size() / std::max(rowBytes,size_t(1)),
+                        tileRowBytes = m_tileSize * m_pixelSize;
+    Svec<char>          tile(m_tileBytes);
+    for (uint tx=0; tx*m_tileSize<m_dims[0]; ++tx) {
+        std::fill(tile.begin(),tile.end(),0);
+        size_t              x0 = size_t(tx) * m_tileSize * m_pixelSize,
+                            len = std::min(tileRowBytes,rowBytes-x0);
+        for (size_t yy=0; yy<bandRows; ++yy)
+            memcpy(&tile[yy*tileRowBytes],&m_band[yy*rowBytes+x0],len);
+        m_ofs.write(tile.data(),tile.size());
+    }
+    m_band.clear();
+}
+
+void
+ImgTiledWriterBase::finish()
+{
+    if (m_rows != m_dims[1])
+        fgThrow("Tiled image writer finished before all rows were added",toString(m_rows));
+    m_ofs.close();
+    if (m_ofs.fail())
+        fgThrow("Error writing tiled image file");
+}
+
+namespace {
+
+template<class T>
+void
+resizeTiled(
+    ImgTiled<T> const &     src,
+    Ustring const &         dstName,
+    Vec2UI                  dims,
+    ResampleFilter          filter,
+    uint                    tileSize,
+    size_t                  memBudget)
+{
+    ImgTiledWriter<T>   dst(dstName,dims,tileSize);
+    ResampleTaps        tx = resampleTaps(src.dims()[0],dims[0],filter),
+                        ty = resampleTaps(src.dims()[1],dims[1],filter);
+    size_t const        C = sizeof(T) / sizeof(typename T::ValueType);
+    // Each source row in a band is held as read and again after the horizontal pass as floats
+    // at the output width:
+    size_t              srcRowBytes = size_t(src.dims()[0]) * sizeof(T) + size_t(dims[0]) * C * sizeof(float),
+                        dstRowBytes = size_t(dims[0]) * sizeof(T);
+    auto                bandBytes = [&](uint lo,uint hi)
+    {
+        Vec2UI              need = resizeSrcRows(ty,lo,hi);
+        return (need[1]-need[0]) * srcRowBytes + (hi-lo) * dstRowBytes;
+    };
+    // Each band starts where the last ended so sizing all bands is one pass over the output rows:
+    uint                d0 = 0;
+    while (d0 < dims[1]) {
+        uint                d1 = d0 + 1;
+        while ((d1 < dims[1]) && (bandBytes(d0,d1+1) <= memBudget))
+            ++d1;
+        Vec2UI              need = resizeSrcRows(ty,d0,d1);
+        Img<T>              band(dims[0],d1-d0);
+        imgResizeRows_(src.rows(need[0],need[1]).cview(),need[0],src.dims(),band.view(),d0,dims,tx,ty);
+        dst.addRows(band);
+        d0 = d1;
+    }
+    dst.finish();
+}
+
+}
+
+void
+imgResizeTiled(
+    ImgTiled<RgbaUC> const &    src,
+    Ustring const &             dstName,
+    Vec2UI                      dims,
+    ResampleFilter              filter,
+    uint                        tileSize,
+    size_t                      memBudget)
+{resizeTiled(src,dstName,dims,filter,tileSize,memBudget); }
+
+void
+imgResizeTiled(
+    ImgTiled<RgbaF> const &     src,
+    Ustring const &             dstName,
+    Vec2UI                      dims,
+    ResampleFilter              filter,
+    uint                        tileSize,
+    size_t                      memBudget)
+{resizeTiled(src,dstName,dims,filter,tileSize,memBudget); }
+
+}
+
+// */
@@ -0,0 +1,234 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Tiled images stored in a memory-mapped file, for images too large to hold in memory
+// (eg. 32K x 32K texture atlases are 4GB as RGBA8):
+//
+// * File format (.fgt): a one page header then square tiles in row-major tile order. Each tile holds
+//   tileSize^2 row-major pixels (edge tiles are padded) and starts on a page boundary.
+// * Pixels are stored as raw POD in native byte order. Only the pixel size is checked on load.
+// * Only the most recently used tiles (an LRU cache of fixed size) are kept resident; the pages of
+//   other tiles are released back to the OS, so processing tile by tile or band by band uses memory
+//   proportional to the cache size rather than the image size.
+//
+
+#ifndef FGIMAGETILED_HPP
+#define FGIMAGETILED_HPP
+
+#include "FgImage.hpp"
+#include "FgImageResample.hpp"
+#include "FgFileSystem.hpp"
+#include "FgStdStream.hpp"
+#include <list>
+
+namespace Fg {
+
+// Untyped implementation of the reader:
+class   ImgTiledBase
+{
+public:
+    ImgTiledBase(Ustring const & fname,size_t pixelSize,size_t cacheTiles);
+
+    Vec2UI
+    dims() const
+    {return m_dims; }
+
+    uint
+    tileSize() const
+    {return m_tileSize; }
+
+    // Number of tiles in each dimension:
+    Vec2UI
+    numTiles() const
+    {return (m_dims + Vec2UI(m_tileSize-1)) / m_tileSize; }
+
+    // Dimensions of the given tile, which are smaller than the tile size for edge tiles:
+    Vec2UI
+    tileDims(Vec2UI tileIdx) const;
+
+protected:
+    // First pixel of the given tile. Marks the tile as most recently used:
+    char const *
+    tilePtr(Vec2UI tileIdx) const;
+
+    // Marks the pixel's tile as most recently used. For many pixels, access by tile is faster:
+    char const *
+    pixelPtr(size_t ircs_x,size_t ircs_y) const;
+
+private:
+    MappedFile                  m_file;
+    Vec2UI                      m_dims;
+    uint                        m_tileSize;
+    size_t                      m_pixelSize;
+    size_t                      m_tileBytes;        // Including padding to the page boundary
+    size_t                      m_cacheTiles;
+    mutable std::mutex          m_mutex;
+    mutable std::list<size_t>   m_lru;              // Most recently used first
+    mutable std::unordered_map<size_t,std::list<size_t>::iterator> m_lruPos;
+};
+
+template<class T>
+class   ImgTiled : public ImgTiledBase
+{
+public:
+    explicit
+    ImgTiled(Ustring const & fname,size_t cacheTiles=64)
+    : ImgTiledBase(fname,sizeof(T),cacheTiles)
+    {}
+
+    // Zero-copy view of the given tile. Valid for the lifetime of this object:
+    ImgCView<T>
+    tile(Vec2UI tileIdx) const
+    {
+        T const *           ptr = reinterpret_cast<T const *>(tilePtr(tileIdx));
+        return ImgCView<T>(ptr,tileDims(tileIdx),tileSize());
+    }
+
+    T const &
+    xy(size_t ircs_x,size_t ircs_y) const
+    {return *reinterpret_cast<T const *>(pixelPtr(ircs_x,ircs_y)); }
+
+    T const &
+    operator[](Vec2UI ircs) const
+    {return xy(ircs[0],ircs[1]); }
+
+    // Copy of the full-width band of rows [lo,hi), fetched tile by tile:
+    Img<T>
+    rows(uint lo,uint hi) const
+    {
+        FGASSERT((lo <= hi) && (hi <= dims()[1]));
+        Img<T>              ret(dims()[0],hi-lo);
+        uint                ts = tileSize();
+        for (uint ty=lo/ts; ty*ts<hi; ++ty) {
+            uint                y0 = std::max(lo,ty*ts),
+                                y1 = std::min(hi,(ty+1)*ts);
+            for (uint tx=0; tx<numTiles()[0]; ++tx) {
+                ImgCView<T>         t = tile(Vec2UI(tx,ty));
+                imgCopy_(t.sub(Vec2UI(0,y0-ty*ts),Vec2UI(t.width(),y1-y0)),
+                         ret.view(Vec2UI(tx*ts,y0-lo),Vec2UI(t.width(),y1-y0)));
+            }
+        }
+        return ret;
+    }
+
+    Img<T>
+    toImg() const
+    {return rows(0,dims()[1]); }
+};
+
+// Untyped implementation of the writer:
+class   ImgTiledWriterBase
+{
+public:
+    ImgTiledWriterBase(Ustring const & fname,Vec2UI dims,uint tileSize,size_t pixelSize);
+
+    Vec2UI
+    dims() const
+    {return m_dims; }
+
+    uint
+    tileSize() const
+    {return m_tileSize; }
+
+    // Number of rows added so far:
+    uint
+    numRows() const
+    {return m_rows; }
+
+    // Throws if not all rows have been added:
+    void
+    finish();
+
+protected:
+    // Pixel rows of the full image width, in order:
+    void
+    addRows(char const * data,size_t rowBytes,size_t strideBytes,uint num);
+
+private:
+    Ofstream            m_ofs;
+    Vec2UI              m_dims;
+    uint                m_tileSize;
+    size_t              m_pixelSize;
+    size_t              m_tileBytes;
+    uint                m_rows = 0;
+    Svec<char>          m_band;             // Rows of the current band of tiles
+
+    void
+    writeBand();
+};
+
+// Accepts the image in bands of rows so no more than one band of tiles is held in memory:
+template<class T>
+class   ImgTiledWriter : public ImgTiledWriterBase
+{
+public:
+    ImgTiledWriter(Ustring const & fname,Vec2UI dims,uint tileSize=256)
+    : ImgTiledWriterBase(fname,dims,tileSize,sizeof(T))
+    {}
+
+    void
+    addRows(ImgCView<T> const & rows)
+    {
+        FGASSERT(rows.width() == dims()[0]);
+        if (!rows.empty())
+            ImgTiledWriterBase::addRows(reinterpret_cast<char const *>(rows.rowPtr(0)),
+                rows.width()*sizeof(T),rows.stride()*sizeof(T),rows.height());
+    }
+};
+
+template<class T>
+void
+imgSaveTiled(Ustring const & fname,ImgCView<T> const & img,uint tileSize=256)
+{
+    ImgTiledWriter<T>   w(fname,img.dims(),tileSize);
+    w.addRows(img);
+    w.finish();
+}
+
+template<class T>
+void
+imgSaveTiled(Ustring const & fname,Img<T> const & img,uint tileSize=256)
+{imgSaveTiled(fname,img.cview(),tileSize); }
+
+// Sample with coordinates clipped to image boundaries (see 'sampleClip' in FgImage.hpp):
+template<typename T>
+typename Traits<T>::Floating
+sampleClip(ImgTiled<T> const & img,Vec2F coordIucs)
+{
+    typedef typename Traits<T>::Floating    Acc;
+    Acc                 ret(0);
+    Mat<CoordWgt,2,2>   bc = blerpCoordsClip(img.dims(),coordIucs);
+    for (uint ii=0; ii<4; ++ii) {
+        CoordWgt        cw = bc.m[ii];
+        ret += Acc(img[cw.coordIrcs]) * cw.wgt;
+    }
+    return ret;
+}
+
+// Resize a tiled image into a new tiled file, one band of output rows at a time. The band heights
+// are chosen so that the source rows, their float buffer from the horizontal pass and the output
+// rows held in memory stay within 'memBudget' bytes, except that at least one output row (and all
+// its source rows) is always computed:
+void
+imgResizeTiled(
+    ImgTiled<RgbaUC> const &    src,
+    Ustring const &             dstName,
+    Vec2UI                      dims,
+    ResampleFilter              filter=ResampleFilter::mitchell,
+    uint                        tileSize=256,
+    size_t                      memBudget=size_t(1)<<26);
+
+void
+imgResizeTiled(
+    ImgTiled<RgbaF> const &     src,
+    Ustring const &             dstName,
+    Vec2UI                      dims,
+    ResampleFilter              filter=ResampleFilter::mitchell,
+    uint                        tileSize=256,
+    size_t                      memBudget=size_t(1)<<26);
+
+}
+
+#endif
@@ -13,6 +13,7 @@
 #include "FgException.hpp"
 #include "FgImage.hpp"
 #include "FgStdString.hpp"
+#include "FgFileSystem.hpp"
 
 #ifdef _MSC_VER
 // _setjmp and C++ object destruction is non-portable.
@@ -53,10 +54,33 @@ using namespace std;
 
 namespace Fg {
 
+static
+bool
+readJpegDims(JOCTET const * data,size_t size,Vec2UI & dims)
+{
+    jpeg_decompress_struct cinfo;
+    IJGErrorManager jerr;
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = fgIJGErrorExit;
+    bool                succeeded = false;
+    if (setjmp(jerr.setjmp_buffer) == 0) {
+        jpeg_create_decompress(&cinfo);
+        jpeg_mem_src(&cinfo,data,size);
+        jpeg_read_header(&cinfo,TRUE);
+        dims = Vec2UI(cinfo.image_width,cinfo.image_height);
+        succeeded = true;
+    }
+    jpeg_destroy_decompress(&cinfo);
+    return succeeded;
+}
+
+// Scanlines are decoded directly into the image rows with no intermediate buffer:
 static
 bool
 loadJpeg(
-    const vector<uchar> &   jpgBuffer,
+    JOCTET const *      data,
+    size_t              size,
+    uint                scaleDenom,     // 1, 2, 4 or 8
     ImgC4UC &           img)
 {
     jpeg_decompress_struct cinfo;
@@ -69,15 +93,13 @@ loadJpeg(
     bool                allocError = false;
     Vec2UI           allocErrorSz;
 
-    vector<uchar>       buff;
-
     switch(setjmp(jerr.setjmp_buffer))
     {
         case 0:
         {
             // DO NOT ALLOCATE ANY C++ OBJECTS HERE OR ELSE THERE COULD BE A MEMORY LEAK
             jpeg_create_decompress(&cinfo);
-            jpeg_mem_src(&cinfo,&jpgBuffer[0],jpgBuffer.size());
+            jpeg_mem_src(&cinfo,data,size);
             jpeg_read_header(&cinfo,TRUE);
 
             // We need to do this because libjpeg does not do a very good job at guessing.
@@ -97,11 +119,13 @@ loadJpeg(
             }
             // We always want RGB out
             cinfo.out_color_space = JCS_RGB;
+            // Scaling is done in the IDCT so the skipped coefficients are never computed:
+            cinfo.scale_num = 1;
+            cinfo.scale_denom = scaleDenom;
             jpeg_start_decompress(&cinfo);
             // Must try-catch C++ allocations to avoid memory leaks here:
             try {
                 img.resize(cinfo.output_width,cinfo.output_height);
-                buff.resize(img.width()*3);
             }
             catch(...)
             {
@@ -110,23 +134,24 @@ loadJpeg(
                 allocErrorSz = Vec2UI(cinfo.output_width,cinfo.output_height);
                 goto cleanup;
             }
-            uchar*              buffer = &buff[0];
-            uint                row = 0;
+            uint                wid = img.width();
             // Here we use the library's state variable cinfo.output_scanline as the
             // loop counter, so that we don't have to keep track ourselves:
             while (cinfo.output_scanline < cinfo.output_height) {
-                // jpeg_read_scanlines expects an array of pointers to scanlines.
-                // Here the array is only one element long, but you could ask for
-                // more than one scanline at a time if that's more convenient:
-                jpeg_read_scanlines(&cinfo,&buffer,1);
-                uchar         *ptr = buffer;
-                for (uint col=0; col<img.width(); col++) {
-                    img.xy(col,row).red() = *ptr++;
-                    img.xy(col,row).green() = *ptr++;
-                    img.xy(col,row).blue() = *ptr++;
-                    img.xy(col,row).alpha() = 255;
+                // Decode RGB into the last 3/4 of the RGBA row then expand forwards in place.
+                // Each write is behind the next unread input:
+                uchar *             row = &img.rowPtr(cinfo.output_scanline)->m_c[0];
+                JSAMPROW            rgb = row + wid;
+                jpeg_read_scanlines(&cinfo,&rgb,1);
+                for (uint col=0; col<wid; col++) {
+                    uchar           r = rgb[3*col],
+                                    g = rgb[3*col+1],
+                                    b = rgb[3*col+2];
+                    row[4*col] = r;
+                    row[4*col+1] = g;
+                    row[4*col+2] = b;
+                    row[4*col+3] = 255;
                 }
-                row++;
             }
             jpeg_finish_decompress(&cinfo);
             goto ok;
@@ -174,7 +199,8 @@ saveJpeg(
 
     bool succeeded = false;
 
-    vector<uchar> img_buffer(wid*hgt*3);
+    // Only one scanline is converted at a time:
+    vector<uchar> img_buffer(wid*3);
 
     switch(setjmp(jerr.setjmp_buffer))
     {
@@ -197,20 +223,15 @@ saveJpeg(
 
             jpeg_start_compress(&cinfo, TRUE);
 
-            for(uint yy=0; yy<hgt; yy++) {
-                const uchar *   srcPtr = srcImg + yy*wid*4;
-                size_t          dstOff = yy*wid*3;
-                for(uint xx=0; xx<wid; xx++) {
-                    img_buffer[dstOff+xx*3] = srcPtr[xx*4];
-                    img_buffer[dstOff+xx*3+1] = srcPtr[xx*4+1];
-                    img_buffer[dstOff+xx*3+2] = srcPtr[xx*4+2];
-                }
-            }
-
-            uint row_stride = wid * 3;
+            row_pointer[0] = &img_buffer[0];
             while(cinfo.next_scanline < cinfo.image_height)
             {
-                row_pointer[0] = &img_buffer[cinfo.next_scanline * row_stride];
+                const uchar *   srcPtr = srcImg + size_t(cinfo.next_scanline)*wid*4;
+                for(uint xx=0; xx<wid; xx++) {
+                    img_buffer[xx*3] = srcPtr[xx*4];
+                    img_buffer[xx*3+1] = srcPtr[xx*4+1];
+                    img_buffer[xx*3+2] = srcPtr[xx*4+2];
+                }
                 jpeg_write_scanlines(&cinfo,row_pointer,1);
             }
             jpeg_finish_compress(&cinfo);
@@ -254,12 +275,42 @@ imgEncodeJpeg(const ImgC4UC & img,int quality)
 }
 
 ImgC4UC
-imgDecodeJpeg(Uchars const & data)
+imgDecodeJpeg(uchar const * data,size_t size,uint scaleDenom)
 {
+    FGASSERT((scaleDenom == 1) || (scaleDenom == 2) || (scaleDenom == 4) || (scaleDenom == 8));
     ImgC4UC         ret;
-    if(!loadJpeg(data,ret))
+    if(!loadJpeg(data,size,scaleDenom,ret))
         fgThrow("Could not decode as JPEG/JFIF");
     return ret;
 }
 
+ImgC4UC
+imgDecodeJpeg(Uchars const & data,uint scaleDenom)
+{
+    if (data.empty())
+        fgThrow("Could not decode empty JPEG/JFIF");
+    return imgDecodeJpeg(data.data(),data.size(),scaleDenom);
+}
+
+ImgC4UC
+imgLoadJpeg(Ustring const & fname,uint scaleDenom)
+{
+    FGASSERT((scaleDenom == 1) || (scaleDenom == 2) || (scaleDenom == 4) || (scaleDenom == 8));
+    MappedFile      file(fname);
+    ImgC4UC         ret;
+    if (!loadJpeg(reinterpret_cast<JOCTET const *>(file.data()),file.size(),scaleDenom,ret))
+        fgThrow("Could not decode JPEG/JFIF file",fname);
+    return ret;
+}
+
+Vec2UI
+imgJpegDims(Ustring const & fname)
+{
+    MappedFile      file(fname);
+    Vec2UI          ret;
+    if (!readJpegDims(reinterpret_cast<JOCTET const *>(file.data()),file.size(),ret))
+        fgThrow("Could not read JPEG/JFIF header",fname);
+    return ret;
+}
+
 }
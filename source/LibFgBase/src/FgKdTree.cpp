@@ -8,107 +8,210 @@
 
 #include "FgKdTree.hpp"
 #include "FgMath.hpp"
+#include "FgBounds.hpp"
+#include "FgParallel.hpp"
 
 using namespace std;
 
 namespace Fg {
 
-FgKdTree::FgKdTree(const std::vector<Vec3F> & verts)
+namespace {
+
+// Ranges this small are searched linearly rather than split further:
+size_t constexpr    s_leafSize = 8;
+
+inline FgMagPnt
+magPnt(float mag,Vec3F pnt,uint idx)
 {
-    FGASSERT(verts.size() > 0);
-    m_tree.reserve(verts.size());
-    createNode(verts,0);
+    FgMagPnt        ret;
+    ret.mag = mag;
+    ret.pnt = pnt;
+    ret.idx = idx;
+    return ret;
 }
 
-FgMagPnt
-FgKdTree::closest(Vec3F pos) const
-{
-    FgMagPnt    none;
-    none.mag = numeric_limits<float>::max();
-    return findBest(pos,none,uint(m_tree.size()-1),0);
+inline bool
+lessMag(const FgMagPnt & lhs,const FgMagPnt & rhs)
+{return (lhs.mag < rhs.mag); }
+
 }
 
-struct  Less
+FgKdTree::FgKdTree(const vector<Vec3F> & pnts) :
+    m_pnts(pnts.size()),
+    m_dims(pnts.size(),0)
 {
-    uint    dim;
-
-    Less(uint d) : dim(d) {}
+    FGASSERT(pnts.size() > 0);
+    FGASSERT(pnts.size() < size_t(numeric_limits<uint>::max()));
+    for (size_t ii=0; ii<pnts.size(); ++ii) {
+        m_pnts[ii].pos = pnts[ii];
+        m_pnts[ii].idx = uint(ii);
+    }
+    build(0,m_pnts.size());
+}
 
-    bool
-    operator()(Vec3F lhs,Vec3F rhs)
-    {return (lhs[dim] < rhs[dim]); }
-};
+void
+FgKdTree::build(size_t lo,size_t hi)
+{
+    if (hi - lo <= s_leafSize)
+        return;
+    Vec3F           bmin = m_pnts[lo].pos,
+                    bmax = bmin;
+    for (size_t ii=lo+1; ii<hi; ++ii) {
+        for (uint dd=0; dd<3; ++dd) {
+            setIfLess(bmin[dd],m_pnts[ii].pos[dd]);
+            setIfGreater(bmax[dd],m_pnts[ii].pos[dd]);
+        }
+    }
+    Vec3F           ext = bmax - bmin;
+    uint            dim = (ext[0] > ext[1]) ? ((ext[0] > ext[2]) ? 0 : 2) : ((ext[1] > ext[2]) ? 1 : 2);
+    size_t          mid = (lo + hi) / 2;
+    nth_element(m_pnts.begin()+lo,m_pnts.begin()+mid,m_pnts.begin()+hi,
+        [dim](const Pnt & l,const Pnt & r){return (l.pos[dim] < r.pos[dim]); });
+    m_dims[mid] = uchar(dim);
+    build(lo,mid);
+    build(mid+1,hi);
+}
 
-uint
-FgKdTree::createNode(const vector<Vec3F> & v,uint dim)
+void
+FgKdTree::findClosest(size_t lo,size_t hi,Vec3F pos,FgMagPnt & best) const
 {
-    FGASSERT(v.size() > 0);
-    if (v.size() == 1) {
-        m_tree.push_back(Node(v[0]));
-        return uint(m_tree.size()-1);
+    if (hi - lo <= s_leafSize) {
+        for (size_t ii=lo; ii<hi; ++ii) {
+            float           mag = (m_pnts[ii].pos - pos).mag();
+            if (mag < best.mag)
+                best = magPnt(mag,m_pnts[ii].pos,m_pnts[ii].idx);
+        }
+        return;
+    }
+    size_t          mid = (lo + hi) / 2;
+    const Pnt &     p = m_pnts[mid];
+    float           mag = (p.pos - pos).mag();
+    if (mag < best.mag)
+        best = magPnt(mag,p.pos,p.idx);
+    float           delta = pos[m_dims[mid]] - p.pos[m_dims[mid]];
+    // Search the side containing 'pos' first, then the other only if the splitting plane is closer:
+    if (delta < 0.0f) {
+        findClosest(lo,mid,pos,best);
+        if (sqr(delta) < best.mag)
+            findClosest(mid+1,hi,pos,best);
+    }
+    else {
+        findClosest(mid+1,hi,pos,best);
+        if (sqr(delta) < best.mag)
+            findClosest(lo,mid,pos,best);
     }
-    vector<Vec3F>    verts(v);
-    sort(verts.begin(),verts.end(),Less(dim));  // Smallest first
-    uint        split = uint(verts.size() / 2),
-                newDim = (dim+1)%3;
-    if (verts.size() > 2)
-        m_tree.push_back(
-            Node(
-                verts[split],
-                createNode(
-                    vector<Vec3F>(verts.begin(),verts.begin()+split),
-                    newDim),
-                createNode(
-                    vector<Vec3F>(verts.begin()+split+1,verts.end()),
-                    newDim)));
-    else
-        m_tree.push_back(
-            Node(
-                verts[split],
-                createNode(
-                    vector<Vec3F>(verts.begin(),verts.begin()+split),
-                    newDim)));
-    return uint(m_tree.size()-1);
 }
 
-FgMagPnt
-FgKdTree::findBest(const Vec3F & pos,FgMagPnt best,uint rootIdx,uint dim) const
+void
+FgKdTree::findClosestK(size_t lo,size_t hi,Vec3F pos,uint k,FgMagPnts & heap) const
 {
-    const uint      maxDepth = 18;
-    FGASSERT(m_tree.size() < (1 << (maxDepth-2)));      // Safe bound check
-    Valid<uint>   idxArr[maxDepth];                   // keep on stack for speed
-    idxArr[0] = rootIdx;
-    int             idxCnt = 0;
-    do {
-        uint    idx = idxArr[idxCnt].val();
-        idxArr[++idxCnt] =
-            (pos[dim] < m_tree[idx].vert[dim]) ?
-                m_tree[idx].idxLo :
-                m_tree[idx].idxHi;
-        dim = (dim+1)%3;
+    auto            consider = [&](const Pnt & p)
+    {
+        float           mag = (p.pos - pos).mag();
+        if (heap.size() < k) {
+            heap.push_back(magPnt(mag,p.pos,p.idx));
+            push_heap(heap.begin(),heap.end(),lessMag);
+        }
+        else if (mag < heap.front().mag) {
+            pop_heap(heap.begin(),heap.end(),lessMag);
+            heap.back() = magPnt(mag,p.pos,p.idx);
+            push_heap(heap.begin(),heap.end(),lessMag);
+        }
+    };
+    if (hi - lo <= s_leafSize) {
+        for (size_t ii=lo; ii<hi; ++ii)
+            consider(m_pnts[ii]);
+        return;
+    }
+    size_t          mid = (lo + hi) / 2;
+    consider(m_pnts[mid]);
+    float           delta = pos[m_dims[mid]] - m_pnts[mid].pos[m_dims[mid]];
+    size_t          nearLo = lo, nearHi = mid,
+                    farLo = mid+1, farHi = hi;
+    if (delta >= 0.0f) {
+        swap(nearLo,farLo);
+        swap(nearHi,farHi);
     }
-    while (idxArr[idxCnt].valid());
-    --idxCnt;
-    dim = (dim+2)%3;
-    do {
-        const Node &    node = m_tree[idxArr[idxCnt].val()];
-        float          mag = (node.vert-pos).mag();
-        if (mag < best.mag) {
-            best.mag = mag;
-            best.pnt = node.vert;
+    findClosestK(nearLo,nearHi,pos,k,heap);
+    if ((heap.size() < k) || (sqr(delta) < heap.front().mag))
+        findClosestK(farLo,farHi,pos,k,heap);
+}
+
+void
+FgKdTree::findWithin(size_t lo,size_t hi,Vec3F pos,float magMax,FgMagPnts & found) const
+{
+    if (hi - lo <= s_leafSize) {
+        for (size_t ii=lo; ii<hi; ++ii) {
+            float           mag = (m_pnts[ii].pos - pos).mag();
+            if (mag <= magMax)
+                found.push_back(magPnt(mag,m_pnts[ii].pos,m_pnts[ii].idx));
         }
-        float           planeDelta = pos[dim] - node.vert[dim];
-        Valid<uint>   mirrorIdx =
-            (planeDelta > 0.0) ? node.idxLo : node.idxHi;
-        if (mirrorIdx.valid() && (sqr(planeDelta) < best.mag))
-            best = findBest(pos,best,mirrorIdx.val(),(dim+1)%3);
-        --idxCnt;
-        dim = (dim+2)%3;
+        return;
     }
-    while (idxCnt >= 0);
+    size_t          mid = (lo + hi) / 2;
+    const Pnt &     p = m_pnts[mid];
+    float           mag = (p.pos - pos).mag(),
+                    delta = pos[m_dims[mid]] - p.pos[m_dims[mid]];
+    if (mag <= magMax)
+        found.push_back(magPnt(mag,p.pos,p.idx));
+    if ((delta < 0.0f) || (sqr(delta) <= magMax))
+        findWithin(lo,mid,pos,magMax,found);
+    if ((delta >= 0.0f) || (sqr(delta) <= magMax))
+        findWithin(mid+1,hi,pos,magMax,found);
+}
+
+FgMagPnt
+FgKdTree::closest(Vec3F pos) const
+{
+    FgMagPnt        best = magPnt(numeric_limits<float>::max(),Vec3F(0),0);
+    findClosest(0,m_pnts.size(),pos,best);
     return best;
 }
 
+FgMagPnts
+FgKdTree::closestK(Vec3F pos,uint k) const
+{
+    FgMagPnts       ret;
+    ret.reserve(k);
+    if (k > 0)
+        findClosestK(0,m_pnts.size(),pos,k,ret);
+    sort_heap(ret.begin(),ret.end(),lessMag);
+    return ret;
+}
+
+FgMagPnts
+FgKdTree::withinRadius(Vec3F pos,float radius) const
+{
+    FgMagPnts       ret;
+    findWithin(0,m_pnts.size(),pos,sqr(radius),ret);
+    sort(ret.begin(),ret.end(),lessMag);
+    return ret;
+}
+
+FgMagPnts
+FgKdTree::closest(const Svec<Vec3F> & queries) const
+{
+    FgMagPnts       ret(queries.size());
+    parallelForBlocks(queries.size(),256,[&](size_t lo,size_t hi)
+    {
+        for (size_t ii=lo; ii<hi; ++ii)
+            ret[ii] = closest(queries[ii]);
+    });
+    return ret;
+}
+
+Svec<FgMagPnts>
+FgKdTree::closestK(const Svec<Vec3F> & queries,uint k) const
+{
+    Svec<FgMagPnts> ret(queries.size());
+    parallelForBlocks(queries.size(),64,[&](size_t lo,size_t hi)
+    {
+        for (size_t ii=lo; ii<hi; ++ii)
+            ret[ii] = closestK(queries[ii],k);
+    });
+    return ret;
+}
+
 }
 
 // */
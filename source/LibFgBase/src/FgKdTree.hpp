@@ -2,6 +2,13 @@
 // Copyright (c) 2019 Singular Inversions Inc.
 //
 
+//
+// 3D KD-tree for nearest neighbour, k nearest neighbour and radius queries.
+//
+// * The points are stored in tree order in a single array: each subtree is a contiguous range with
+//   its splitting point at the middle, so there are no node links and no size limit.
+// * Ranges are split on their axis of largest extent using 'nth_element' in place, O(n log n).
+// * Queries are threadsafe. The bulk versions run across threads.
 //
 
 #ifndef FGKDTREE_HPP
@@ -16,35 +23,61 @@ namespace Fg {
 struct  FgMagPnt
 {
     float       mag;        // Squared distance to closest point
-    Vec3F    pnt;        // Closest point
+    Vec3F       pnt;        // Closest point
+    uint        idx;        // Index of closest point in the array given to the tree constructor
 };
 
+typedef Svec<FgMagPnt>  FgMagPnts;
+
 class   FgKdTree
 {
 public:
+    explicit
     FgKdTree(const Svec<Vec3F> & pnts);   // Must be non-empty
 
+    size_t
+    size() const
+    {return m_pnts.size(); }
+
     FgMagPnt
     closest(Vec3F pos) const;
 
+    // The 'k' closest points (or all if fewer), closest first:
+    FgMagPnts
+    closestK(Vec3F pos,uint k) const;
+
+    // All points with distance <= 'radius', closest first:
+    FgMagPnts
+    withinRadius(Vec3F pos,float radius) const;
+
+    // Bulk versions of the above, with one result per query:
+    FgMagPnts
+    closest(const Svec<Vec3F> & queries) const;
+
+    Svec<FgMagPnts>
+    closestK(const Svec<Vec3F> & queries,uint k) const;
+
 private:
-    struct  Node
+    struct  Pnt
     {
-        Node(Vec3F v) : vert(v) {}
-        Node(Vec3F v,uint l) : vert(v), idxLo(l) {}
-        Node(Vec3F v,uint l,uint h) : vert(v), idxLo(l), idxHi(h) {}
-
-        Vec3F        vert;
-        Valid<uint>   idxLo;
-        Valid<uint>   idxHi;
+        Vec3F           pos;
+        uint            idx;        // In the constructor argument
     };
-    Svec<Node>   m_tree;
+    Svec<Pnt>       m_pnts;         // In tree order
+    Svec<uchar>     m_dims;         // Split axis of the subtree centred at each point
 
-    uint
-    createNode(const Svec<Vec3F> & verts,uint dim);
+    void
+    build(size_t lo,size_t hi);
 
-    FgMagPnt
-    findBest(const Vec3F & pos,FgMagPnt currBest,uint rootIdx,uint dim) const;
+    void
+    findClosest(size_t lo,size_t hi,Vec3F pos,FgMagPnt & best) const;
+
+    // 'heap' is a max-heap on 'mag' of at most 'k' elements:
+    void
+    findClosestK(size_t lo,size_t hi,Vec3F pos,uint k,FgMagPnts & heap) const;
+
+    void
+    findWithin(size_t lo,size_t hi,Vec3F pos,float magMax,FgMagPnts & found) const;
 };
 
 }
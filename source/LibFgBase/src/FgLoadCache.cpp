@@ -0,0 +1,554 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+
+#include "stdafx.h"
+
+#include "FgLoadCache.hpp"
+#include "FgFileSystem.hpp"
+#include "FgHex.hpp"
+#include "FgCommand.hpp"
+#include "FgTestUtils.hpp"
+#include "Fg3dMeshIo.hpp"
+#include "FgImageIo.hpp"
+#include "FgScopeGuard.hpp"
+#include "MurmurHash3.h"
+
+using namespace std;
+
+namespace Fg {
+
+namespace {
+
+// Change these when the corresponding entry encoding changes so old entries are ignored:
+char const      meshKind[] = "mesh2";
+char const      imgKind[] = "img2";
+
+mutex           s_dirMutex;
+bool            s_dirInit = false;
+Ustring         s_dir;
+// Dependencies of the cached load in progress on this thread, if any:
+thread_local Ustrings * s_deps = nullptr;
+
+// Entries are raw native-endian dumps; they are a local cache not an interchange format:
+struct  CacheWriter
+{
+    String          out;
+
+    template<class T>
+    void
+    pod(T val)
+    {out.append(reinterpret_cast<char const *>(&val),sizeof(T)); }
+
+    template<class T>
+    void
+    vec(Svec<T> const & v)
+    {
+        pod(uint64(v.size()));
+        if (!v.empty())
+            out.append(reinterpret_cast<char const *>(&v[0]),v.size()*sizeof(T));
+    }
+
+    void
+    str(String const & s)
+    {
+        pod(uint64(s.size()));
+        out += s;
+    }
+
+    void
+    img(Sptr<ImgC4UC> const & ptr)
+    {
+        pod(uchar(ptr ? 1 : 0));
+        if (ptr) {
+            pod(ptr->dims());
+            vec(ptr->m_data);
+        }
+    }
+};
+
+struct  CacheReader
+{
+    char const *    ptr;
+    char const *    end;
+
+    CacheReader(char const * data,size_t size) : ptr(data), end(data+size) {}
+
+    void
+    need(uint64 num) const
+    {
+        if (num > uint64(end-ptr))
+            fgThrow("Load cache entry truncated");
+    }
+
+    template<class T>
+    T
+    pod()
+    {
+        need(sizeof(T));
+        T           ret;
+        memcpy(static_cast<void *>(&ret),ptr,sizeof(T));
+        ptr += sizeof(T);
+        return ret;
+    }
+
+    // Number of following items, each at least one byte. Checked so corrupt entries can't request
+    // huge allocations:
+    size_t
+    count()
+    {
+        uint64      num = pod<uint64>();
+        need(num);
+        return size_t(num);
+    }
+
+    template<class T>
+    Svec<T>
+    vec()
+    {
+        uint64      num = pod<uint64>();
+        if (num > uint64(end-ptr)/sizeof(T))
+            fgThrow("Load cache entry truncated");
+        Svec<T>     ret(num);
+        if (num > 0)
+            memcpy(static_cast<void *>(&ret[0]),ptr,num*sizeof(T));
+        ptr += num*sizeof(T);
+        return ret;
+    }
+
+    String
+    str()
+    {
+        size_t      num = count();
+        String      ret(ptr,num);
+        ptr += num;
+        return ret;
+    }
+
+    Sptr<ImgC4UC>
+    img()
+    {
+        if (pod<uchar>() == 0)
+            return Sptr<ImgC4UC>();
+        Vec2UI      dims = pod<Vec2UI>();
+        Svec<RgbaUC> data = vec<RgbaUC>();
+        if (data.size() != size_t(dims[0])*dims[1])
+            fgThrow("Load cache entry image size mismatch");
+        return make_shared<ImgC4UC>(dims,data);
+    }
+};
+
+void
+encodeMesh(CacheWriter & wr,Mesh const & mesh)
+{
+    wr.str(mesh.name.m_str);
+    wr.vec(mesh.verts);
+    wr.vec(mesh.uvs);
+    wr.pod(uint64(mesh.surfaces.size()));
+    for (Surf const & surf : mesh.surfaces) {
+        wr.str(surf.name.m_str);
+        wr.vec(surf.tris.vertInds);
+        wr.vec(surf.tris.uvInds);
+        wr.vec(surf.quads.vertInds);
+        wr.vec(surf.quads.uvInds);
+        wr.pod(uint64(surf.surfPoints.size()));
+        for (SurfPoint const & sp : surf.surfPoints) {
+            wr.pod(sp.triEquivIdx);
+            wr.pod(sp.weights);
+            wr.str(sp.label);
+        }
+        wr.pod(uchar(surf.material.shiny ? 1 : 0));
+        wr.img(surf.material.albedoMap);
+        wr.img(surf.material.specularMap);
+    }
+    wr.pod(uint64(mesh.deltaMorphs.size()));
+    for (Morph const & morph : mesh.deltaMorphs) {
+        wr.str(morph.name.m_str);
+        wr.vec(morph.verts);
+    }
+    wr.pod(uint64(mesh.targetMorphs.size()));
+    for (IndexedMorph const & morph : mesh.targetMorphs) {
+        wr.str(morph.name.m_str);
+        wr.vec(morph.baseInds);
+        wr.vec(morph.verts);
+    }
+    wr.pod(uint64(mesh.markedVerts.size()));
+    for (MarkedVert const & mv : mesh.markedVerts) {
+        wr.pod(mv.idx);
+        wr.str(mv.label);
+    }
+}
+
+Mesh
+decodeMesh(CacheReader & rd)
+{
+    Mesh                ret;
+    ret.name = rd.str();
+    ret.verts = rd.vec<Vec3F>();
+    ret.uvs = rd.vec<Vec2F>();
+    ret.surfaces.resize(rd.count());
+    for (Surf & surf : ret.surfaces) {
+        surf.name = rd.str();
+        surf.tris.vertInds = rd.vec<Vec3UI>();
+        surf.tris.uvInds = rd.vec<Vec3UI>();
+        surf.quads.vertInds = rd.vec<Vec4UI>();
+        surf.quads.uvInds = rd.vec<Vec4UI>();
+        surf.surfPoints.resize(rd.count());
+        for (SurfPoint & sp : surf.surfPoints) {
+            sp.triEquivIdx = rd.pod<uint>();
+            sp.weights = rd.pod<Vec3F>();
+            sp.label = rd.str();
+        }
+        surf.material.shiny = (rd.pod<uchar>() != 0);
+        surf.material.albedoMap = rd.img();
+        surf.material.specularMap = rd.img();
+    }
+    ret.deltaMorphs.resize(rd.count());
+    for (Morph & morph : ret.deltaMorphs) {
+        morph.name = rd.str();
+        morph.verts = rd.vec<Vec3F>();
+    }
+    ret.targetMorphs.resize(rd.count());
+    for (IndexedMorph & morph : ret.targetMorphs) {
+        morph.name = rd.str();
+        morph.baseInds = rd.vec<uint>();
+        morph.verts = rd.vec<Vec3F>();
+    }
+    ret.markedVerts.resize(rd.count());
+    for (MarkedVert & mv : ret.markedVerts) {
+        mv.idx = rd.pod<uint>();
+        mv.label = rd.str();
+    }
+    return ret;
+}
+
+void
+encodeImg(CacheWriter & wr,ImgC4UC const & img)
+{
+    wr.pod(img.dims());
+    wr.vec(img.m_data);
+}
+
+ImgC4UC
+decodeImg(CacheReader & rd)
+{
+    Vec2UI              dims = rd.pod<Vec2UI>();
+    Svec<RgbaUC>        pixels = rd.vec<RgbaUC>();
+    if (pixels.size() != size_t(dims[0])*dims[1])
+        fgThrow("Load cache entry image size mismatch");
+    return ImgC4UC(dims,pixels);
+}
+
+// Write to a uniquely named temporary then rename so that readers in other processes
+// never see a partially written file:
+void
+writeAtomic(Ustring const & fname,String const & data)
+{
+    random_device       rd;
+    Ustring             tmp = fname + ".tmp" + fgAsHex(uint32(rd()));
+    try {
+        fgDump(data,tmp,false);
+    }
+    catch (...) {
+        boost::system::error_code   ec;         // Don't leave a partial file but report the original error
+        boost::filesystem::remove(tmp.ns(),ec);
+        throw;
+    }
+    try {
+        fgRename(tmp,fname);
+    }
+    catch (...) {
+        // Another process may have won the race; either way the entry is not needed:
+        pathRemove(tmp);
+    }
+}
+
+Ustring
+absPath(Ustring const & fname)
+{return Path(fname).root ? fname : fgGetCurrentDir() + fname; }
+
+// Modification time (to the file system's resolution) and size, used to detect changed files without
+// reading them:
+String
+fileStamp(Ustring const & fname)
+{
+    if (!fileExists(fname))
+        return "none";
+    return toString(getLastWriteTimeNs(fname)) + " " + toString(boost::filesystem::file_size(fname.ns()));
+}
+
+// Record 'fname' as a dependency of any enclosing cached load on this thread:
+void
+addDepend(Ustring const & fname)
+{
+    if (s_deps != nullptr) {
+        Ustring             name = absPath(fname);
+        if (!fgContains(*s_deps,name))
+            s_deps->push_back(name);
+    }
+}
+
+// Returns the entry path for 'fname' as decoded 'kind' by 'loaderId'. Only reads 'fname' (to hash it)
+// if its modification time or size have changed since it was last indexed:
+Ustring
+entryPath(Ustring const & dir,Ustring const & fname,char const * kind,String const & loaderId)
+{
+    String              idxKey = absPath(fname).m_str,
+                        stamp = fileStamp(fname) + " ",
+                        hash;
+    Ustring             idxName = dir + "idx" + contentHash(idxKey.data(),idxKey.size());
+    if (fileExists(idxName)) {
+        String              idx = fgSlurp(idxName);
+        if ((idx.size() == stamp.size()+32) && (idx.compare(0,stamp.size(),stamp) == 0))
+            hash = idx.substr(stamp.size());
+    }
+    if (hash.empty()) {
+        {
+            MappedFile          src(fname);
+            hash = contentHash(src.data(),src.size());
+        }
+        writeAtomic(idxName,stamp+hash);
+    }
+    String              entryKey = hash + "\n" + kind + "\n" + loaderId;
+    return dir + contentHash(entryKey.data(),entryKey.size()) + "." + kind;
+}
+
+// Entries start with the dependency file names and their stamps at the time of the load:
+void
+writeDepends(CacheWriter & wr,Ustrings const & deps)
+{
+    wr.pod(uint64(deps.size()));
+    for (Ustring const & dep : deps) {
+        wr.str(dep.m_str);
+        wr.str(fileStamp(dep));
+    }
+}
+
+// Returns false if any dependency has changed:
+bool
+readDepends(CacheReader & rd)
+{
+    Ustrings            deps(rd.count());
+    bool                ret = true;
+    for (Ustring & dep : deps) {
+        dep = rd.str();
+        if (rd.str() != fileStamp(dep))
+            ret = false;
+    }
+    if (ret)
+        for (Ustring const & dep : deps)
+            addDepend(dep);
+    return ret;
+}
+
+template<class T>
+T
+loadCached(
+    Ustring const &                                 fname,
+    char const *                                    kind,
+    String const &                                  loaderId,
+    function<T(Ustring const &)> const &            load,
+    function<void(CacheWriter &,T const &)> const & encode,
+    function<T(CacheReader &)> const &              decode)
+{
+    Ustring             dir = loadCacheDir();
+    if (dir.empty())
+        return load(fname);
+    addDepend(fname);
+    if (!fileExists(fname))                     // Let the loader report any file errors
+        return load(fname);
+    Ustring             entry;
+    try {
+        entry = entryPath(dir,fname,kind,loaderId);
+        if (fileExists(entry)) {
+            MappedFile          map(entry);
+            CacheReader         rd(map.data(),map.size());
+            if (readDepends(rd)) {
+                T                   ret = decode(rd);
+                if (rd.ptr != rd.end)
+                    fgThrow("Load cache entry has trailing data");
+                return ret;
+            }
+        }
+    }
+    // Any failure of the cache (I/O error, corrupt entry) falls back to a normal load, and
+    // a corrupt or stale entry is replaced below:
+    catch (...) {}
+    Ustrings            deps;
+    T                   ret;
+    {
+        Ustrings *          outer = s_deps;
+        s_deps = &deps;
+        ScopeGuard          sg([outer](){s_deps = outer; });
+        ret = load(fname);
+    }
+    for (Ustring const & dep : deps)
+        addDepend(dep);
+    if (!entry.empty()) {
+        try {
+            CacheWriter         wr;
+            writeDepends(wr,deps);
+            encode(wr,ret);
+            writeAtomic(entry,wr.out);
+        }
+        // Failure to update the cache (eg. disk full) must not fail the load:
+        catch (...) {}
+    }
+    return ret;
+}
+
+}
+
+void
+setLoadCacheDir(Ustring const & dir)
+{
+    lock_guard<mutex>   lock(s_dirMutex);
+    s_dir = dir;
+    if (!s_dir.empty()) {
+        if (!s_dir.endsWith("/") && !s_dir.endsWith("\\"))
+            s_dir += "/";
+        fgCreatePath(s_dir);
+    }
+    s_dirInit = true;
+}
+
+Ustring
+loadCacheDir()
+{
+    {
+        lock_guard<mutex>   lock(s_dirMutex);
+        if (s_dirInit)
+            return s_dir;
+    }
+    char const *        env = getenv("FG_LOAD_CACHE");
+    setLoadCacheDir((env == nullptr) ? Ustring() : Ustring(env));
+    return loadCacheDir();
+}
+
+String
+contentHash(char const * data,size_t size)
+{
+    // MurmurHash3 takes an int length so chain the hash across chunks for very large data:
+    size_t const        chunk = size_t(1) << 30;
+    uint64              hash[2] = {0,0};
+    size_t              pos = 0;
+    do {
+        size_t              num = std::min(size-pos,chunk);
+        MurmurHash3_x64_128(data+pos,int(num),uint32(hash[0] ^ hash[1]),hash);
+        pos += num;
+    } while (pos < size);
+    return fgAsHex(hash[0]) + fgAsHex(hash[1]);
+}
+
+void
+loadCacheDepends(Ustring const & fname)
+{
+    if (!loadCacheDir().empty())
+        addDepend(fname);
+}
+
+Mesh
+meshLoadCached(Ustring const & fname,String const & loaderId,function<Mesh(Ustring const &)> const & load)
+{return loadCached<Mesh>(fname,meshKind,loaderId,load,encodeMesh,decodeMesh); }
+
+ImgC4UC
+imgLoadCached(Ustring const & fname,String const & loaderId,function<ImgC4UC(Ustring const &)> const & load)
+{return loadCached<ImgC4UC>(fname,imgKind,loaderId,load,encodeImg,decodeImg); }
+
+void
+fgLoadCacheTest(CLArgs const & args)
+{
+    FGTESTDIR
+    Ustring             dd = dataDir() + "base/";
+    fileCopy(dd+"Mouth.tri","mouth.tri");
+    fileCopy(dd+"Glasses.tga","glasses.tga");
+    setLoadCacheDir("cache");
+    size_t              numMeshLoads = 0,
+                        numImgLoads = 0;
+    auto                loadMesh = [&numMeshLoads](Ustring const & fname)
+    {
+        ++numMeshLoads;
+        Mesh                ret = loadTri(fname);
+        ret.surfaces[0].setAlbedoMap(ImgC4UC(Vec2UI(5,3),RgbaUC(1,2,3,4)));
+        return ret;
+    };
+    auto                loadImg = [&numImgLoads](Ustring const & fname)
+    {
+        ++numImgLoads;
+        return imgLoadAnyFormat(fname);
+    };
+    Mesh                m0 = meshLoadCached("mouth.tri","test",loadMesh),
+                        m1 = meshLoadCached("mouth.tri","test",loadMesh);
+    ImgC4UC             i0 = imgLoadCached("glasses.tga","test",loadImg),
+                        i1 = imgLoadCached("glasses.tga","test",loadImg);
+    FGASSERT((numMeshLoads == 1) && (numImgLoads == 1));
+    FGASSERT(m1.verts == m0.verts);
+    FGASSERT(m1.uvs == m0.uvs);
+    FGASSERT(m1.surfaces.size() == m0.surfaces.size());
+    FGASSERT(m1.surfaces[0].tris.vertInds == m0.surfaces[0].tris.vertInds);
+    FGASSERT(m1.surfaces[0].quads.uvInds == m0.surfaces[0].quads.uvInds);
+    FGASSERT(m1.surfaces[0].material.albedoMap->m_data == m0.surfaces[0].material.albedoMap->m_data);
+    FGASSERT(m1.numMorphs() == m0.numMorphs());
+    for (size_t ii=0; ii<m0.numMorphs(); ++ii)
+        FGASSERT(m1.morphSingle(ii) == m0.morphSingle(ii));
+    FGASSERT(m1.markedVerts.size() == m0.markedVerts.size());
+    FGASSERT((i1.dims() == i0.dims()) && (i1.m_data == i0.m_data));
+    // Identical content at another path shares the entry:
+    fileCopy("mouth.tri","copy.tri");
+    meshLoadCached("copy.tri","test",loadMesh);
+    FGASSERT(numMeshLoads == 1);
+    // A different loader does not:
+    meshLoadCached("copy.tri","test2",loadMesh);
+    FGASSERT(numMeshLoads == 2);
+    // Changed content is reloaded:
+    fileCopy(dd+"Glasses.tri","mouth.tri",true);
+    Mesh                m2 = meshLoadCached("mouth.tri","test",loadMesh);
+    FGASSERT(numMeshLoads == 3);
+    FGASSERT(m2.verts.size() != m0.verts.size());
+    // Changes to dependencies, declared or loaded via the cache, cause a reload:
+    imgSaveAnyFormat("tex.png",ImgC4UC(Vec2UI(4,4),RgbaUC(9)));
+    auto                loadDeps = [&](Ustring const & fname)
+    {
+        Mesh                ret = loadMesh(fname);
+        loadCacheDepends("extra.txt");
+        ret.surfaces[0].setAlbedoMap(imgLoadCached("tex.png","test",loadImg));
+        return ret;
+    };
+    meshLoadCached("copy.tri","test3",loadDeps);
+    meshLoadCached("copy.tri","test3",loadDeps);
+    FGASSERT((numMeshLoads == 4) && (numImgLoads == 2));
+    fgDump(String("extra"),"extra.txt");        // Previously missing
+    meshLoadCached("copy.tri","test3",loadDeps);
+    FGASSERT((numMeshLoads == 5) && (numImgLoads == 2));
+    // Changes are detected by modification time and size, and the time may have a coarse resolution:
+    imgSaveAnyFormat("tex.png",ImgC4UC(Vec2UI(100,50),RgbaUC(9)));
+    Mesh                m3 = meshLoadCached("copy.tri","test3",loadDeps);
+    FGASSERT((numMeshLoads == 6) && (numImgLoads == 3));
+    FGASSERT(m3.surfaces[0].material.albedoMap->dims() == Vec2UI(100,50));
+    // Corrupt entries, including sizes larger than the entry, fall back to a normal load:
+    for (Ustring const & fname : directoryContents("cache").filenames)
+        if (!fname.beginsWith("idx"))
+            fgDump(String(64,char(0x7F)),"cache/"+fname,false);
+    Mesh                m4 = meshLoadCached("copy.tri","test3",loadDeps);
+    FGASSERT(numMeshLoads == 7);
+    FGASSERT(m4.verts == m0.verts);
+    // A same-size rewrite is detected where the file system records sub-second times:
+    uint64              t0 = getLastWriteTimeNs("tex.png");
+    uintmax_t           sz0 = boost::filesystem::file_size("tex.png");
+    size_t              numImgs = numImgLoads;
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    imgSaveAnyFormat("tex.png",ImgC4UC(Vec2UI(100,50),RgbaUC(7)));
+    FGASSERT(boost::filesystem::file_size("tex.png") == sz0);
+    if ((t0 % 1000000000ULL != 0) || (getLastWriteTimeNs("tex.png") % 1000000000ULL != 0)) {
+        Mesh                m5 = meshLoadCached("copy.tri","test3",loadDeps);
+        FGASSERT((numMeshLoads == 8) && (numImgLoads == numImgs+1));
+        FGASSERT(m5.surfaces[0].material.albedoMap->m_data[0] == RgbaUC(7));
+    }
+    setLoadCacheDir(Ustring());
+}
+
+}
+
+// */
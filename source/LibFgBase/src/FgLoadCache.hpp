@@ -0,0 +1,59 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Opt-in on-disk cache of decoded meshes and images, for when the same source files are loaded
+// repeatedly across commands and processes:
+//
+// * Enabled by 'setLoadCacheDir' or by setting the environment variable FG_LOAD_CACHE to a directory.
+// * Entries are keyed by the MurmurHash3 of the source file contents and a loader identifier, so
+//   identical files at different paths share an entry. A small index per source path records its
+//   modification time and size so that unchanged sources are not re-read to be hashed.
+// * Entries also record the modification time and size of the files the loader depended on (eg. texture
+//   images) and are reloaded if any of those change.
+// * Modification times are compared to the file system's resolution. Where that is coarse (eg. 1s or
+//   2s on some network and FAT file systems) a file rewritten with the same size within that interval
+//   is not detected; clear the cache or touch the file again after that interval.
+// * Any failure of the cache itself (I/O errors, corrupt entries) falls back to a normal load.
+// * A cache hit is a single memory mapped read of the raw entry.
+// * Entries are written to a temporary file then renamed so concurrent processes never see partial
+//   entries. Nothing is evicted; delete the directory to clear the cache.
+//
+
+#ifndef FGLOADCACHE_HPP
+#define FGLOADCACHE_HPP
+
+#include "Fg3dMesh.hpp"
+#include "FgImage.hpp"
+
+namespace Fg {
+
+// The directory is created if necessary. Overrides FG_LOAD_CACHE. The empty string disables caching:
+void
+setLoadCacheDir(Ustring const & dir);
+
+// Returns the delimited cache directory, or the empty string if caching is disabled:
+Ustring
+loadCacheDir();
+
+// 128-bit MurmurHash3 (x64) as a 32 digit hex string:
+String
+contentHash(char const * data,size_t size);
+
+// Returns 'load(fname)', via the cache if enabled. 'loaderId' identifies the loader and must change
+// whenever the loader's output for a given file changes:
+Mesh
+meshLoadCached(Ustring const & fname,String const & loaderId,std::function<Mesh(Ustring const &)> const & load);
+
+ImgC4UC
+imgLoadCached(Ustring const & fname,String const & loaderId,std::function<ImgC4UC(Ustring const &)> const & load);
+
+// Called by loaders to declare a file (which need not exist) affecting the result of the current cached
+// load. Files loaded via the above are recorded automatically:
+void
+loadCacheDepends(Ustring const & fname);
+
+}
+
+#endif
@@ -8,6 +8,7 @@
 
 #include "FgMath.hpp"
 #include "FgRandom.hpp"
+#include "FgSimd.hpp"
 #include "FgSyntax.hpp"
 
 using namespace std;
@@ -178,11 +179,88 @@ testFgRand()
     FGASSERT(std::abs(rms * 3.0 - 1.0) < 0.01);
 }
 
+static
+void
+testRandStream()
+{
+    {
+        // Known answer from the Philox reference implementation (zero key and counter):
+        RandStream          rs(0);
+        FGASSERT(rs() == 0x6627E8D5U);
+        FGASSERT(rs() == 0xE169C58DU);
+        FGASSERT(rs() == 0xBC57AC4CU);
+        FGASSERT(rs() == 0x9B00DBD8U);
+    }
+    RandStream          rs0(42,7),
+                        rs1(42,7),
+                        rs2(42,8);
+    Uints               seq(11);
+    for (uint & v : seq)
+        v = rs0();
+    for (uint v : seq)
+        FGASSERT(rs1() == v);
+    FGASSERT(rs2() != seq[0]);
+    rs1.seek(6);
+    FGASSERT(rs1.position() == 6);
+    FGASSERT(rs1() == seq[6]);
+    // Vectorized fill matches sequential outputs, including from part way through a block:
+    for (Simd simd : {Simd::scalar,Simd::vec128,Simd::avx2}) {
+        setSimdLevel(simd);
+        RandStream          a(5,2),
+                            b(5,2);
+        a();
+        b();
+        Uints               bits(1001);
+        a.fill_(bits.data(),bits.size());
+        for (uint v : bits)
+            FGASSERT(v == b());
+        FGASSERT(a.position() == b.position());
+    }
+    setSimdLevel(simdSupported());
+    // Threaded bulk fills give the same values as serial ones:
+    size_t              num = 3*65536 + 77,
+                        piece = 65536;
+    Floats              normals(num),
+                        pieces(num),
+                        uniforms(num);
+    RandStream          big(3,1),
+                        small(3,1);
+    big.normal_(normals.data(),num);
+    for (size_t ii=0; ii<num; ii+=piece)
+        small.normal_(pieces.data()+ii,std::min(piece,num-ii));
+    FGASSERT(normals == pieces);
+    FGASSERT(big.position() == small.position());
+    big.uniform_(uniforms.data(),num);
+    for (size_t ii=0; ii<num; ii+=piece)
+        small.uniform_(pieces.data()+ii,std::min(piece,num-ii));
+    FGASSERT(uniforms == pieces);
+    // Moments:
+    double              mean = 0.0,
+                        var = 0.0,
+                        umean = 0.0;
+    size_t              tails = 0;
+    for (size_t ii=0; ii<num; ++ii) {
+        mean += normals[ii];
+        var += sqr(normals[ii]);
+        tails += (std::abs(normals[ii]) > 3.0f) ? 1 : 0;
+        umean += uniforms[ii];
+        FGASSERT((uniforms[ii] >= 0.0f) && (uniforms[ii] < 1.0f));
+    }
+    mean /= num;
+    var /= num;
+    umean /= num;
+    FGASSERT(std::abs(mean) < 0.01);
+    FGASSERT(std::abs(var - 1.0) < 0.01);
+    FGASSERT(std::abs(umean - 0.5) < 0.01);
+    FGASSERT(std::abs(double(tails)/num - 0.0027) < 0.0005);   // Two-sided 3 sigma
+}
+
 void
 fgMathTest(const CLArgs &)
 {
     OutPush       op("Testing rand");
     testFgRand();
+    testRandStream();
 }
 
 // The following code is a modified part of the 'fastermath' library:
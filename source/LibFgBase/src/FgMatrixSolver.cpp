@@ -8,6 +8,7 @@
 
 #include "FgMath.hpp"
 #include "FgMatrixSolver.hpp"
+#include "FgMatrixSparse.hpp"
 #include "FgRandom.hpp"
 #include "FgMain.hpp"
 #include "FgTime.hpp"
@@ -29,6 +30,83 @@ FgEigsRsm::matrix() const
     return vecs * rhs;
 }
 
+CovarianceAcc::CovarianceAcc(size_t dim,size_t blockSize) :
+    m_dim(dim), m_sum(dim,0.0), m_block(blockSize,dim,0.0), m_acc(dim,dim,0.0)
+{FGASSERT(blockSize > 0); }
+
+void
+CovarianceAcc::add(Doubles const & sample)
+{
+    FGASSERT(sample.size() == m_dim);
+    addSample(sample.data());
+}
+
+void
+CovarianceAcc::add(MatD const & samples)
+{
+    FGASSERT(samples.ncols == m_dim);
+    for (size_t rr=0; rr<samples.nrows; ++rr)
+        addSample(&samples.rc(rr,0));
+}
+
+void
+CovarianceAcc::addSample(double const * sample)
+{
+    if (m_num == 0)
+        m_shift.assign(sample,sample+m_dim);
+    double *            row = &m_block.rc(m_blockRows,0);
+    for (size_t ii=0; ii<m_dim; ++ii) {
+        row[ii] = sample[ii] - m_shift[ii];
+        m_sum[ii] += row[ii];
+    }
+    ++m_num;
+    if (++m_blockRows == m_block.nrows)
+        flush();
+}
+
+void
+CovarianceAcc::flush()
+{
+    if (m_blockRows == 0)
+        return;
+    if (m_blockRows < m_block.nrows) {
+        MatD                part(m_blockRows,m_dim);
+        copy(m_block.m_data.begin(),m_block.m_data.begin()+part.m_data.size(),part.m_data.begin());
+        syrkUpper_(part,m_acc);
+    }
+    else
+        syrkUpper_(m_block,m_acc);
+    m_blockRows = 0;
+}
+
+Doubles
+CovarianceAcc::mean() const
+{
+    FGASSERT(m_num > 0);
+    Doubles             ret(m_dim);
+    for (size_t ii=0; ii<m_dim; ++ii)
+        ret[ii] = m_shift[ii] + m_sum[ii] / double(m_num);
+    return ret;
+}
+
+MatD
+CovarianceAcc::covariance()
+{
+    FGASSERT(m_num > 1);
+    flush();
+    double              n = double(m_num),
+                        s = 1.0 / (n - 1.0);
+    MatD                ret(m_dim,m_dim);
+    for (size_t rr=0; rr<m_dim; ++rr) {
+        for (size_t cc=rr; cc<m_dim; ++cc) {
+            double              v = (m_acc.rc(rr,cc) - m_sum[rr] * m_sum[cc] / n) * s;
+            ret.rc(rr,cc) = v;
+            ret.rc(cc,rr) = v;
+        }
+    }
+    return ret;
+}
+
 namespace {
 
 MatD
@@ -152,6 +230,212 @@ testSymmEigenTime(const CLArgs & args)
     FGASSERT(residual < tol);
 }
 
+void
+testSolve(const CLArgs &)
+{
+    randSeedRepeatable();
+    for (uint dim : {5,150}) {
+        MatD                A = MatD::randNormal(dim,dim),
+                            B = MatD::randNormal(dim,3);
+        Opt<MatD>           X = fgSolve(A,B);
+        FGASSERT(X.valid());
+        FGASSERT(cRms((A * X.val() - B).m_data) < 1.0e-10);
+    }
+    MatD                S(3,3,1.0);
+    FGASSERT(!fgSolve(S,MatD(3,1,1.0)).valid());
+}
+
+void
+testCovariance(const CLArgs &)
+{
+    randSeedRepeatable();
+    // SYRK against GEMM over multiple tiles:
+    MatD                A = MatD::randNormal(50,300),
+                        C(300,300,0.0),
+                        R = gemm(A,A,true,false);
+    syrkUpper_(A,C);
+    for (size_t rr=0; rr<C.nrows; ++rr)
+        for (size_t cc=rr; cc<C.ncols; ++cc)
+            FGASSERT(std::abs(C.rc(rr,cc)-R.rc(rr,cc)) < 1.0e-10);
+    // Samples with a large offset and a decaying spectrum:
+    size_t              N = 300,
+                        D = 60;
+    MatD                X = MatD::randNormal(N,D) * 0.01;
+    for (size_t ii=0; ii<8; ++ii) {
+        Doubles             dir = randNormals(D);
+        double              scale = std::pow(0.5,double(ii)) / std::sqrt(cMag(dir));
+        for (size_t rr=0; rr<N; ++rr) {
+            double              w = randNormal() * scale;
+            for (size_t cc=0; cc<D; ++cc)
+                X.rc(rr,cc) += w * dir[cc];
+        }
+    }
+    for (double & x : X.m_data)
+        x += 1000.0;
+    // Direct calculation:
+    MatD                Xc = X;
+    Doubles             mean(D,0.0);
+    for (size_t rr=0; rr<N; ++rr)
+        for (size_t cc=0; cc<D; ++cc)
+            mean[cc] += X.rc(rr,cc) / double(N);
+    for (size_t rr=0; rr<N; ++rr)
+        for (size_t cc=0; cc<D; ++cc)
+            Xc.rc(rr,cc) -= mean[cc];
+    MatD                cov = matMul(Xc.transpose(),Xc) * (1.0 / double(N-1));
+    double              tol = cMax(cov.m_data) * 1.0e-9;
+    CovarianceAcc       acc(D,7);                           // Exercises partial block flushes
+    for (size_t rr=0; rr<100; ++rr)
+        acc.add(X.rowVec(uint(rr)).m_data);
+    acc.add(X.subMatrix(100,0,N-100,D));
+    FGASSERT(acc.numSamples() == N);
+    FGASSERT(cMax(mapAbs(acc.mean()-mean)) < 1.0e-9);
+    FGASSERT(cMax(mapAbs((acc.covariance()-cov).m_data)) < tol);
+    // Randomized top-k against the full eigensystem:
+    size_t              K = 4;
+    Doubles             vals,vals2;
+    MatD                vecs,vecs2;
+    fgEigsRsm_(cov,vals,vecs);
+    pcaRandomized_(X,K,vals2,vecs2);
+    for (size_t ii=0; ii<K; ++ii) {
+        size_t              idx = D - K + ii;
+        FGASSERT(std::abs(vals2[ii]-vals[idx]) < vals[idx]*1.0e-3);
+        double              dot = 0.0;
+        for (size_t rr=0; rr<D; ++rr)
+            dot += vecs2.rc(rr,ii) * vecs.rc(rr,idx);
+        FGASSERT(std::abs(dot) > 0.999);
+    }
+}
+
+void
+testTopEigs(const CLArgs &)
+{
+    randSeedRepeatable();
+    for (uint dim : {20,300}) {
+        // Random eigenvectors with a decaying spectrum including negative values:
+        Doubles             vals,
+                            eigs(dim);
+        MatD                Q;
+        fgEigsRsm_(randSymmMatrix(dim),vals,Q);
+        for (uint ii=0; ii<dim; ++ii)
+            eigs[ii] = 100.0 / (ii + 1.0) - 1.0;
+        MatD                QL = Q;
+        for (uint rr=0; rr<dim; ++rr)
+            for (uint cc=0; cc<dim; ++cc)
+                QL.rc(rr,cc) *= eigs[cc];
+        MatD                A = gemm(QL,Q,false,true);
+        size_t              num = 8;
+        Doubles             topVals;
+        MatD                topVecs;
+        // Matrix-free interface:
+        auto                mul = [&A](Doubles const & x,Doubles & y) {y = A * x; };
+        fgEigsRsmTop_(dim,mul,num,topVals,topVecs);
+        for (size_t ii=0; ii<num; ++ii) {
+            size_t              idx = num - 1 - ii;             // 'eigs' is descending
+            FGASSERT(std::abs(topVals[ii]-eigs[idx]) < 1.0e-8 * eigs[0]);
+            double              dot = 0.0;
+            for (uint rr=0; rr<dim; ++rr)
+                dot += topVecs.rc(rr,ii) * Q.rc(rr,idx);
+            FGASSERT(std::abs(std::abs(dot)-1.0) < 1.0e-6);
+        }
+        Doubles             topVals2;
+        fgEigsRsmTop_(A,num,topVals2,topVecs);
+        FGASSERT(cMax(mapAbs(topVals2-topVals)) < 1.0e-8 * eigs[0]);
+    }
+    // Zero and rank-deficient operators, whose Krylov spaces break down early:
+    uint                dim = 40;
+    MatD                Q;
+    Doubles             vals;
+    fgEigsRsm_(randSymmMatrix(dim),vals,Q);
+    for (uint rank : {0,3}) {
+        Doubles             eigs(dim,0.0);
+        for (uint ii=0; ii<rank; ++ii)
+            eigs[ii] = 5.0 - ii;
+        MatD                QL = Q;
+        for (uint rr=0; rr<dim; ++rr)
+            for (uint cc=0; cc<dim; ++cc)
+                QL.rc(rr,cc) *= eigs[cc];
+        MatD                A = gemm(QL,Q,false,true);
+        size_t              num = 5;
+        Doubles             topVals;
+        MatD                topVecs;
+        fgEigsRsmTop_(A,num,topVals,topVecs);
+        for (size_t ii=0; ii<num; ++ii) {
+            size_t              idx = num - 1 - ii;
+            FGASSERT(std::abs(topVals[ii]-eigs[idx]) < 1.0e-8);
+            Doubles             v(dim);
+            for (uint rr=0; rr<dim; ++rr)
+                v[rr] = topVecs.rc(rr,ii);
+            FGASSERT(std::abs(cLen(v)-1.0) < 1.0e-8);
+            FGASSERT(cLen(A*v - v*topVals[ii]) < 1.0e-8);
+        }
+    }
+}
+
+// Grid graph Laplacian plus 'shift' on the diagonal, assembled per edge so there are duplicates:
+MatSparseD
+gridLaplacian(uint wid,uint hgt,double shift)
+{
+    Svec<SparseTriplet<double> >    ts;
+    auto                addEdge = [&](uint i0,uint i1,double w)
+    {
+        ts.push_back({i0,i0,w});
+        ts.push_back({i1,i1,w});
+        ts.push_back({i0,i1,-w});
+        ts.push_back({i1,i0,-w});
+    };
+    for (uint yy=0; yy<hgt; ++yy) {
+        for (uint xx=0; xx<wid; ++xx) {
+            uint                idx = yy*wid + xx;
+            ts.push_back({idx,idx,shift});
+            if (xx+1 < wid)
+                addEdge(idx,idx+1,1.0 + 0.1*xx);
+            if (yy+1 < hgt)
+                addEdge(idx,idx+wid,1.0 + 0.1*yy);
+        }
+    }
+    return MatSparseD(wid*hgt,wid*hgt,ts);
+}
+
+void
+testSparse(const CLArgs &)
+{
+    randSeedRepeatable();
+    MatSparseD          L = gridLaplacian(12,9,0.1);
+    uint                dim = L.nrows;
+    FGASSERT(L.numNonZero() == dim + 2*(11*9 + 12*8));
+    MatD                D = L.toDense();
+    Doubles             x = randNormals(dim),
+                        b = L * x;
+    FGASSERT(cMax(mapAbs(b - D * x)) < 1.0e-12);
+    // Direct:
+    SparseSolver        solver(L);
+    FGASSERT(cMax(mapAbs(solver.solve(b) - x)) < 1.0e-9);
+    MatD                X = MatD::randNormal(dim,3),
+                        X2 = solver.solve(D * X);
+    FGASSERT(cMax(mapAbs((X2 - X).m_data)) < 1.0e-9);
+    // New values with the same pattern:
+    MatSparseD          L2 = gridLaplacian(12,9,2.0);
+    FGASSERT(L2.samePattern(L));
+    solver.factor(L2);
+    FGASSERT(cMax(mapAbs(solver.solve(L2 * x) - x)) < 1.0e-9);
+    // Iterative:
+    Doubles             xc;
+    CgStats             stats = solveCg_(L,b,xc,1.0e-12);
+    FGASSERT(stats.residual <= 1.0e-12);
+    FGASSERT(stats.iters < dim);
+    FGASSERT(cMax(mapAbs(xc - x)) < 1.0e-8);
+    // Threaded product:
+    MatSparseD          big = gridLaplacian(400,300,0.1);
+    Doubles             y = randNormals(big.nrows),
+                        z = big * y;
+    for (uint ii=0; ii<big.nrows; ii+=997) {
+        double              acc = 0.0;
+        for (int jj=big.rowStarts[ii]; jj<big.rowStarts[ii+1]; ++jj)
+            acc += big.vals[jj] * y[big.colIdxs[jj]];
+        FGASSERT(acc == z[ii]);
+    }
+}
+
 void
 testSymmEigen(const CLArgs & args)
 {
@@ -169,6 +453,10 @@ fgMatrixSolverTest(const CLArgs & args)
     Cmds      cmds;
     cmds.push_back(Cmd(testAsymEigs,"asym","Arbitrary real matrix eigensystem"));
     cmds.push_back(Cmd(testSymmEigen,"symm","Real symmetric matrix eigensystem"));
+    cmds.push_back(Cmd(testSolve,"solve","Linear system"));
+    cmds.push_back(Cmd(testCovariance,"covar","Streaming covariance and randomized PCA"));
+    cmds.push_back(Cmd(testTopEigs,"top","Top-k symmetric eigensystem"));
+    cmds.push_back(Cmd(testSparse,"sparse","Sparse matrix and solvers"));
     doMenu(args,cmds,true);
 }
 
@@ -21,6 +21,98 @@ fgEigsRsm_(
     Doubles &            vals,   // RETURNED: Eigenvalues, smallest to largest
     MatD &         vecs);  // RETURNED: Col vectors are respective eigenvectors
 
+// Matrix-free real symmetric operator: 'y = A*x' (dim 'x' == dim 'y'):
+typedef std::function<void(Doubles const & x,Doubles & y)>  FnSymmMul;
+
+// The 'num' algebraically largest eigenpairs of a real symmetric operator of dimension 'dim' given
+// only by its product, by thick-restart Lanczos with full reorthogonalization. O(dim * num^2) time per
+// restart plus the products, so much faster than 'fgEigsRsm_' when 'num' << 'dim'. Converged when
+// the residual of each eigenpair is below 'tol' times the largest eigenvalue magnitude; if this is not
+// reached within 'maxRestarts' the best estimates are returned:
+void
+fgEigsRsmTop_(
+    size_t              dim,
+    FnSymmMul const &   mul,
+    size_t              num,
+    Doubles &           vals,           // RETURNED: Eigenvalues, smallest to largest
+    MatD &              vecs,           // RETURNED: Col vectors are respective eigenvectors
+    double              tol=1.0e-10,
+    size_t              maxRestarts=200);
+
+// As above for an explicit symmetric matrix:
+void
+fgEigsRsmTop_(
+    MatD const &        rsm,
+    size_t              num,
+    Doubles &           vals,
+    MatD &              vecs,
+    double              tol=1.0e-10,
+    size_t              maxRestarts=200);
+
+// Sample covariance accumulated one sample (or block of samples) at a time, so the samples need
+// not all be held in memory. Memory use is O(dim^2) regardless of the number of samples:
+// * Samples are buffered into blocks and accumulated with 'syrkUpper_', which updates only the upper
+//   triangle, in parallel.
+// * Samples are accumulated relative to the first sample to avoid cancellation when the mean is
+//   large relative to the spread (eg. mesh vertex coordinates).
+class   CovarianceAcc
+{
+public:
+    explicit
+    CovarianceAcc(size_t dim,size_t blockSize=64);
+
+    void
+    add(Doubles const & sample);
+
+    // Each row is a sample:
+    void
+    add(MatD const & samples);
+
+    size_t
+    numSamples() const
+    {return m_num; }
+
+    Doubles
+    mean() const;
+
+    // Unbiased sample covariance, normalized by N-1 (requires N > 1). Symmetric, so can be passed
+    // directly to 'fgEigsRsm_':
+    MatD
+    covariance();
+
+private:
+    size_t              m_dim;
+    Doubles             m_shift;        // First sample
+    Doubles             m_sum;          // Sum of shifted samples
+    MatD                m_block;        // Shifted samples not yet accumulated (as rows)
+    size_t              m_blockRows = 0;
+    MatD                m_acc;          // Upper triangle of the sum of shifted sample outer products
+    size_t              m_num = 0;
+
+    void
+    addSample(double const * sample);
+
+    void
+    flush();
+};
+
+// Top 'num' eigenpairs of the sample covariance of the rows of 'samples', by randomized truncated
+// SVD (Halko, Martinsson & Tropp 2011). Much faster than forming the covariance and calling
+// 'fgEigsRsm_' when 'num' is much less than the dimension. 'oversample' extra random directions and
+// 'powerIters' power iterations improve the accuracy when the spectrum decays slowly:
+void
+pcaRandomized_(
+    MatD const &        samples,            // Each row is a sample
+    size_t              num,
+    Doubles &           vals,               // RETURNED: Covariance eigenvalues, smallest to largest
+    MatD &              vecs,               // RETURNED: Col vectors are respective eigenvectors
+    size_t              oversample=10,
+    size_t              powerIters=2);
+
+// Solve AX = B for square A. Returns X if solvable, invalid if A is degenerate:
+Opt<MatD>
+fgSolve(MatD const & A,MatD const & B);
+
 struct  FgEigsRsm
 {
     Doubles              vals;   // Eigenvalues
@@ -8,6 +8,7 @@
 
 #include "FgMath.hpp"
 #include "FgMatrixSolver.hpp"
+#include "FgMatrixVEigen.hpp"
 #include "FgRandom.hpp"
 #include "FgMain.hpp"
 #include "FgTime.hpp"
@@ -15,18 +16,6 @@
 #include "FgApproxEqual.hpp"
 #include "FgSyntax.hpp"
 
-#ifdef _MSC_VER
-    #pragma warning(push,0)     // Eigen triggers lots of warnings
-#endif
-
-#define EIGEN_MPL2_ONLY     // Only use permissive licensed source files from Eigen
-#include "Eigen/Dense"
-#include "Eigen/Core"
-
-#ifdef _MSC_VER
-    #pragma warning(pop)
-#endif
-
 using namespace std;
 
 using namespace Eigen;
@@ -38,28 +27,228 @@ fgEigsRsm_(const MatD & rsm,Doubles & vals,MatD & vecs)
 {
     size_t              dim = rsm.ncols;
     FGASSERT(rsm.nrows == dim);
-    // Ensure exact symmetry (results will be wrong otherwise) and valid values and copy into Eigen format:
-    MatrixXd            mat(dim,dim);
-    for (size_t rr=0; rr<dim; ++rr) {
-        for (size_t cc=rr; cc<dim; ++cc) {
-            double          v = (rsm.rc(rr,cc) + rsm.rc(cc,rr)) * 0.5;
-            FGASSERT(boost::math::isfinite(v));
-            mat(rr,cc) = v;
-            mat(cc,rr) = v;
-        }
-    }
+    for (double v : rsm.m_data)
+        FGASSERT(boost::math::isfinite(v));
+    // Ensure exact symmetry (results will be wrong otherwise). The expression is evaluated directly
+    // into the solver's working storage so the input is not otherwise copied.
     // Eigen runtime is more than 3x faster than equivalent JAMA or NRC function on 1000x1000 random RSM,
     // but yields slightly larger residual errors than JAMA, which itself is about 2x larger than NRC:
-    SelfAdjointEigenSolver<MatrixXd>    es(mat);
-    const MatrixXd &    eigVecs = es.eigenvectors();
-    const VectorXd &    eigVals = es.eigenvalues();
+    auto                in = eigMap(rsm);
+    SelfAdjointEigenSolver<MatrixXd>    es((in + in.transpose()) * 0.5);
     vals.resize(dim);
     vecs.resize(dim,dim);
-    for (size_t rr=0; rr<dim; ++rr)
-        vals[rr] = eigVals(rr);
-    for (size_t rr=0; rr<dim; ++rr)
-        for (size_t cc=0; cc<dim; ++cc)
-            vecs.rc(rr,cc) = eigVecs(rr,cc);        // MatrixXd takes (row,col) order
+    eigMap(vals) = es.eigenvalues();
+    eigMap(vecs) = es.eigenvectors();
+}
+
+namespace {
+
+// Replace the columns of 'Y' with an orthonormal basis for their span:
+void
+orthonormalize_(MatD & Y)
+{
+    HouseholderQR<EigMatRm<double> >    qr(eigMap(Y));
+    eigMap(Y) = qr.householderQ() * MatrixXd::Identity(Y.nrows,Y.ncols);
+}
+
+}
+
+void
+pcaRandomized_(MatD const & X,size_t num,Doubles & vals,MatD & vecs,size_t oversample,size_t powerIters)
+{
+    size_t              N = X.nrows,
+                        D = X.ncols,
+                        L = cMin(num+oversample,cMin(N,D));
+    FGASSERT((N > 1) && (num > 0) && (num <= L));
+    Doubles             mean(D,0.0);
+    for (size_t rr=0; rr<N; ++rr)
+        for (size_t cc=0; cc<D; ++cc)
+            mean[cc] += X.rc(rr,cc);
+    for (double & m : mean)
+        m /= double(N);
+    // Products with the centred samples Xc = X - 1*mean^T without forming Xc:
+    auto                mulXc = [&](MatD const & M)         // Xc * M
+    {
+        MatD                ret = gemm(X,M);
+        Doubles             mm = mean * M;
+        for (size_t rr=0; rr<N; ++rr)
+            for (size_t cc=0; cc<M.ncols; ++cc)
+                ret.rc(rr,cc) -= mm[cc];
+        return ret;
+    };
+    auto                mulXcT = [&](MatD const & M)        // Xc^T * M
+    {
+        MatD                ret = gemm(X,M,true,false);
+        for (size_t cc=0; cc<M.ncols; ++cc) {
+            double              s = 0.0;
+            for (size_t rr=0; rr<N; ++rr)
+                s += M.rc(rr,cc);
+            for (size_t rr=0; rr<D; ++rr)
+                ret.rc(rr,cc) -= mean[rr] * s;
+        }
+        return ret;
+    };
+    // Orthonormal basis Q for the approximate range of Xc:
+    MatD                Q = mulXc(MatD::randNormal(D,L));
+    orthonormalize_(Q);
+    for (size_t ii=0; ii<powerIters; ++ii) {
+        MatD                Z = mulXcT(Q);
+        orthonormalize_(Z);
+        Q = mulXc(Z);
+        orthonormalize_(Q);
+    }
+    // Xc ~= Q * B where B = Q^T * Xc. The right singular vectors of B are found from the small
+    // eigensystem of B * B^T = U * S^2 * U^T, as V = B^T * U / S:
+    MatD                Bt = mulXcT(Q),
+                        BBt = gemm(Bt,Bt,true,false);
+    SelfAdjointEigenSolver<MatrixXd>    es(eigMap(BBt));
+    MatD                U(L,num);
+    vals.resize(num);
+    for (size_t ii=0; ii<num; ++ii) {
+        size_t              idx = L - num + ii;                 // Ascending order
+        double              s2 = cMax(es.eigenvalues()(idx),0.0);
+        vals[ii] = s2 / double(N-1);
+        double              f = (s2 > 0.0) ? 1.0 / std::sqrt(s2) : 0.0;
+        for (size_t rr=0; rr<L; ++rr)
+            U.rc(rr,ii) = es.eigenvectors()(rr,idx) * f;
+    }
+    vecs = gemm(Bt,U);
+}
+
+namespace {
+
+// Orthogonalize 'v' against 'basis' (twice, which is enough for full precision) and return its length:
+double
+orthogonalize_(Svec<Doubles> const & basis,Doubles & v)
+{
+    for (uint pass=0; pass<2; ++pass) {
+        for (Doubles const & b : basis) {
+            double              d = cDot(b,v);
+            for (size_t ii=0; ii<v.size(); ++ii)
+                v[ii] -= d * b[ii];
+        }
+    }
+    return cLen(v);
+}
+
+// Linear combination of 'vs' with coefficients given by column 'col' of 'S':
+Doubles
+combine(Svec<Doubles> const & vs,MatrixXd const & S,size_t col)
+{
+    Doubles             ret(vs[0].size(),0.0);
+    for (size_t jj=0; jj<vs.size(); ++jj) {
+        double              s = S(jj,col);
+        for (size_t ii=0; ii<ret.size(); ++ii)
+            ret[ii] += s * vs[jj][ii];
+    }
+    return ret;
+}
+
+}
+
+void
+fgEigsRsmTop_(
+    size_t              dim,
+    FnSymmMul const &   mul,
+    size_t              num,
+    Doubles &           vals,
+    MatD &              vecs,
+    double              tol,
+    size_t              maxRestarts)
+{
+    FGASSERT((num > 0) && (num <= dim));
+    size_t              M = cMin(dim,cMax(2*num,num+32)),       // Max basis size
+                        Q = cMin(num + (M-num)/2,M-1);          // Ritz vectors kept on restart
+    Svec<Doubles>       V,                                      // Orthonormal basis
+                        W;                                      // A * V
+    // Next basis vector, orthogonal to V. Replaced by a random vector if V spans an invariant subspace:
+    Doubles             next = randNormals(dim);
+    next = next / cLen(next);
+    MatrixXd            S;                                      // Ritz vector coefficients, ascending
+    VectorXd            theta;                                  // Ritz values
+    for (size_t iter=0; iter<=maxRestarts; ++iter) {
+        // Expand the Krylov basis:
+        while (V.size() < M) {
+            V.push_back(next);
+            W.push_back(Doubles(dim));
+            mul(V.back(),W.back());
+            FGASSERT(W.back().size() == dim);
+            if (V.size() == dim)                                // Whole space spanned
+                break;
+            next = W.back();
+            double              ref = cLen(next),
+                                len = orthogonalize_(V,next);
+            // Breakdown; 'len' is always much larger than this for a genuine Krylov direction.
+            // The absolute floor catches a zero 'W' (zero operator or null vector):
+            while ((len <= 1.0e-10 * ref) || (len <= std::numeric_limits<double>::min())) {
+                next = randNormals(dim);
+                ref = cLen(next);
+                len = orthogonalize_(V,next);
+            }
+            next = next / len;
+        }
+        // Rayleigh-Ritz on the basis:
+        size_t              P = V.size();
+        MatrixXd            H(P,P);
+        for (size_t rr=0; rr<P; ++rr)
+            for (size_t cc=rr; cc<P; ++cc)
+                H(rr,cc) = H(cc,rr) = (cDot(V[rr],W[cc]) + cDot(V[cc],W[rr])) * 0.5;
+        SelfAdjointEigenSolver<MatrixXd>    es(H);
+        S = es.eigenvectors();
+        theta = es.eigenvalues();
+        if (P == dim)
+            break;
+        double              scale = cMax(std::abs(theta(0)),std::abs(theta(P-1))),
+                            maxRes = 0.0;
+        for (size_t ii=P-num; ii<P; ++ii) {
+            Doubles             r = combine(W,S,ii) - combine(V,S,ii) * theta(ii);
+            maxRes = cMax(maxRes,cLen(r));
+        }
+        if ((maxRes <= tol * scale) || (iter == maxRestarts))
+            break;
+        // Thick restart with the top Q Ritz vectors. 'next' remains orthogonal to their span:
+        Svec<Doubles>       V2,W2;
+        for (size_t ii=P-Q; ii<P; ++ii) {
+            V2.push_back(combine(V,S,ii));
+            W2.push_back(combine(W,S,ii));
+        }
+        V.swap(V2);
+        W.swap(W2);
+    }
+    size_t              P = V.size();
+    vals.resize(num);
+    vecs.resize(dim,num);
+    for (size_t ii=0; ii<num; ++ii) {
+        size_t              idx = P - num + ii;
+        vals[ii] = theta(idx);
+        Doubles             v = combine(V,S,idx);
+        for (size_t rr=0; rr<dim; ++rr)
+            vecs.rc(rr,ii) = v[rr];
+    }
+}
+
+void
+fgEigsRsmTop_(MatD const & rsm,size_t num,Doubles & vals,MatD & vecs,double tol,size_t maxRestarts)
+{
+    FGASSERT(rsm.nrows == rsm.ncols);
+    auto                mul = [&rsm](Doubles const & x,Doubles & y)
+    {eigMap(y) = eigMap(rsm) * eigMap(x); };
+    fgEigsRsmTop_(rsm.nrows,mul,num,vals,vecs,tol,maxRestarts);
+}
+
+Opt<MatD>
+fgSolve(MatD const & A,MatD const & B)
+{
+    FGASSERT(A.nrows == A.ncols);
+    FGASSERT(A.nrows == B.nrows);
+    Opt<MatD>           ret;
+    auto                qr = eigMap(A).colPivHouseholderQr();
+    if (qr.isInvertible()) {
+        MatD                X(A.ncols,B.ncols);
+        eigMap(X) = qr.solve(eigMap(B));
+        ret = X;
+    }
+    return ret;
 }
 
 FgEigsRsmC<3>
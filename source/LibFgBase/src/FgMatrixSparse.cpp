@@ -0,0 +1,138 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+
+#include "stdafx.h"
+
+#include "FgMatrixSparse.hpp"
+#include "FgMatrixVEigen.hpp"
+#include "FgMath.hpp"
+
+#ifdef _MSC_VER
+    #pragma warning(push,0)
+#endif
+
+// The sparse Cholesky module is LGPL so is not available with EIGEN_MPL2_ONLY:
+#include "Eigen/SparseCore"
+#include "Eigen/SparseLU"
+
+#ifdef _MSC_VER
+    #pragma warning(pop)
+#endif
+
+using namespace std;
+
+using namespace Eigen;
+
+namespace Fg {
+
+namespace {
+
+typedef SparseMatrix<double,ColMajor,int>   EigSparse;
+
+// Copy to Eigen's compressed column format (the factorization requires it):
+EigSparse
+toEigen(MatSparseD const & A)
+{
+    Map<SparseMatrix<double,RowMajor,int> const>  map(A.nrows,A.ncols,int(A.numNonZero()),
+        A.rowStarts.data(),A.colIdxs.data(),A.vals.data());
+    return EigSparse(map);
+}
+
+}
+
+struct  SparseSolver::Impl
+{
+    MatSparseD                                  pattern;    // Values not used
+    SparseLU<EigSparse,COLAMDOrdering<int> >    lu;
+};
+
+SparseSolver::SparseSolver(MatSparseD const & A) : m_impl(make_shared<Impl>())
+{factor(A); }
+
+void
+SparseSolver::factor(MatSparseD const & A)
+{
+    FGASSERT(A.nrows == A.ncols);
+    EigSparse           M = toEigen(A);
+    if (!m_impl->pattern.samePattern(A)) {
+        m_impl->lu.analyzePattern(M);
+        m_impl->pattern = A;
+    }
+    m_impl->lu.factorize(M);
+    if (m_impl->lu.info() != Success)
+        fgThrow("SparseSolver unable to factor matrix",m_impl->lu.lastErrorMessage());
+}
+
+Doubles
+SparseSolver::solve(Doubles const & b) const
+{
+    FGASSERT(b.size() == m_impl->pattern.nrows);
+    Doubles             ret(b.size());
+    eigMap(ret) = m_impl->lu.solve(eigMap(b));
+    return ret;
+}
+
+MatD
+SparseSolver::solve(MatD const & B) const
+{
+    FGASSERT(B.nrows == m_impl->pattern.nrows);
+    // The solver requires column-major right-hand sides:
+    MatrixXd            X = m_impl->lu.solve(MatrixXd(eigMap(B)));
+    MatD                ret(B.nrows,B.ncols);
+    eigMap(ret) = X;
+    return ret;
+}
+
+CgStats
+solveCg_(MatSparseD const & A,Doubles const & b,Doubles & x,double tol,size_t maxIters)
+{
+    size_t              dim = A.nrows;
+    FGASSERT((A.ncols == dim) && (b.size() == dim));
+    if (maxIters == 0)
+        maxIters = dim;
+    if (x.size() != dim)
+        x.assign(dim,0.0);
+    Doubles             invDiag(dim);
+    for (uint ii=0; ii<dim; ++ii) {
+        double              d = A.rc(ii,ii);
+        FGASSERT(d > 0.0);
+        invDiag[ii] = 1.0 / d;
+    }
+    CgStats             ret {0,0.0};
+    double              bLen = cLen(b);
+    if (bLen == 0.0) {
+        x.assign(dim,0.0);
+        return ret;
+    }
+    Doubles             r = b - A * x,
+                        z(dim);
+    for (size_t ii=0; ii<dim; ++ii)
+        z[ii] = invDiag[ii] * r[ii];
+    Doubles             p = z;
+    double              rz = cDot(r,z);
+    ret.residual = cLen(r) / bLen;
+    while ((ret.residual > tol) && (ret.iters < maxIters)) {
+        Doubles             Ap = A * p;
+        double              alpha = rz / cDot(p,Ap);
+        for (size_t ii=0; ii<dim; ++ii) {
+            x[ii] += alpha * p[ii];
+            r[ii] -= alpha * Ap[ii];
+            z[ii] = invDiag[ii] * r[ii];
+        }
+        double              rzNew = cDot(r,z),
+                            beta = rzNew / rz;
+        rz = rzNew;
+        for (size_t ii=0; ii<dim; ++ii)
+            p[ii] = z[ii] + beta * p[ii];
+        ++ret.iters;
+        ret.residual = cLen(r) / bLen;
+    }
+    return ret;
+}
+
+}
+
+// */
@@ -0,0 +1,174 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Compressed sparse row (CSR) matrices and sparse linear solvers, eg. for mesh Laplacians.
+//
+// * Index arrays are 'int' so that Eigen can use the storage directly.
+//
+
+#ifndef FGMATRIXSPARSE_HPP
+#define FGMATRIXSPARSE_HPP
+
+#include "FgStdLibs.hpp"
+#include "FgMatrixV.hpp"
+#include "FgParallel.hpp"
+
+namespace Fg {
+
+template<class T>
+struct  SparseTriplet
+{
+    uint            row;
+    uint            col;
+    T               val;
+
+    SparseTriplet() {}
+    SparseTriplet(uint r,uint c,T v) : row(r), col(c), val(v) {}
+};
+
+template<class T>
+struct  MatSparse
+{
+    uint                nrows = 0;
+    uint                ncols = 0;
+    Svec<int>           rowStarts;      // Offset of each row in 'colIdxs' and 'vals', plus the total
+    Svec<int>           colIdxs;        // Ascending within each row
+    Svec<T>             vals;
+
+    MatSparse() : rowStarts(1,0) {}
+
+    // Duplicate entries are summed, as when assembling finite element matrices:
+    MatSparse(uint nr,uint nc,Svec<SparseTriplet<T> > const & triplets) :
+        nrows(nr), ncols(nc), rowStarts(nr+1,0)
+    {
+        FGASSERT(triplets.size() < size_t(std::numeric_limits<int>::max()));
+        for (SparseTriplet<T> const & t : triplets) {
+            FGASSERT((t.row < nr) && (t.col < nc));
+            ++rowStarts[t.row+1];
+        }
+        for (uint rr=0; rr<nr; ++rr)
+            rowStarts[rr+1] += rowStarts[rr];
+        Svec<std::pair<int,T> > entries(triplets.size());
+        Svec<int>           pos(rowStarts.begin(),rowStarts.end()-1);
+        for (SparseTriplet<T> const & t : triplets)
+            entries[pos[t.row]++] = std::make_pair(int(t.col),t.val);
+        colIdxs.reserve(entries.size());
+        vals.reserve(entries.size());
+        int                 start = 0;
+        for (uint rr=0; rr<nr; ++rr) {
+            auto                beg = entries.begin() + rowStarts[rr],
+                                end = entries.begin() + rowStarts[rr+1];
+            std::sort(beg,end,[](std::pair<int,T> const & l,std::pair<int,T> const & r)
+                {return (l.first < r.first); });
+            for (auto it=beg; it!=end; ++it) {
+                if ((int(colIdxs.size()) > start) && (colIdxs.back() == it->first))
+                    vals.back() += it->second;
+                else {
+                    colIdxs.push_back(it->first);
+                    vals.push_back(it->second);
+                }
+            }
+            rowStarts[rr] = start;
+            start = int(colIdxs.size());
+        }
+        rowStarts[nr] = start;
+    }
+
+    size_t
+    numNonZero() const
+    {return vals.size(); }
+
+    // Zero if not stored. O(log) in the number of row entries:
+    T
+    rc(uint row,uint col) const
+    {
+        FGASSERT((row < nrows) && (col < ncols));
+        auto                beg = colIdxs.begin() + rowStarts[row],
+                            end = colIdxs.begin() + rowStarts[row+1],
+                            it = std::lower_bound(beg,end,int(col));
+        return ((it != end) && (*it == int(col))) ? vals[it-colIdxs.begin()] : T(0);
+    }
+
+    bool
+    samePattern(MatSparse const & rhs) const
+    {return ((nrows == rhs.nrows) && (ncols == rhs.ncols) && (rowStarts == rhs.rowStarts) && (colIdxs == rhs.colIdxs)); }
+
+    MatV<T>
+    toDense() const
+    {
+        MatV<T>             ret(nrows,ncols,T(0));
+        for (uint rr=0; rr<nrows; ++rr)
+            for (int ii=rowStarts[rr]; ii<rowStarts[rr+1]; ++ii)
+                ret.rc(rr,colIdxs[ii]) = vals[ii];
+        return ret;
+    }
+};
+
+typedef MatSparse<float>    MatSparseF;
+typedef MatSparse<double>   MatSparseD;
+
+// Runs across threads for large matrices:
+template<class T>
+Svec<T>
+operator*(MatSparse<T> const & A,Svec<T> const & x)
+{
+    FGASSERT(x.size() == A.ncols);
+    Svec<T>             ret(A.nrows);
+    auto                fn = [&](size_t lo,size_t hi)
+    {
+        for (size_t rr=lo; rr<hi; ++rr) {
+            T                   acc(0);
+            for (int ii=A.rowStarts[rr]; ii<A.rowStarts[rr+1]; ++ii)
+                acc += A.vals[ii] * x[A.colIdxs[ii]];
+            ret[rr] = acc;
+        }
+    };
+    if (A.numNonZero() < 100000)
+        fn(0,A.nrows);
+    else
+        parallelForBlocks(A.nrows,4096,fn);
+    return ret;
+}
+
+// Direct solver for square sparse systems (LU with COLAMD fill-reducing ordering). The factorization
+// is kept so that solving for each new right-hand side is cheap, and re-factoring a matrix with the
+// same sparsity pattern (eg. new weights over the same mesh) re-uses the symbolic analysis:
+class   SparseSolver
+{
+public:
+    explicit
+    SparseSolver(MatSparseD const & A);
+
+    // Throws if A is singular:
+    void
+    factor(MatSparseD const & A);
+
+    Doubles
+    solve(Doubles const & b) const;
+
+    // Each column of 'B' is a right-hand side:
+    MatD
+    solve(MatD const & B) const;
+
+private:
+    struct  Impl;
+    std::shared_ptr<Impl>   m_impl;
+};
+
+struct  CgStats
+{
+    size_t          iters;
+    double          residual;       // |b - Ax| / |b|
+};
+
+// Jacobi-preconditioned conjugate gradient for symmetric positive definite 'A', using the threaded
+// product above. 'x' is used as the initial guess if it has the right size, otherwise zero. Stops when
+// the relative residual is below 'tol' or after 'maxIters' (0 for the dimension) iterations:
+CgStats
+solveCg_(MatSparseD const & A,Doubles const & b,Doubles & x,double tol=1.0e-10,size_t maxIters=0);
+
+}
+
+#endif
@@ -13,70 +13,21 @@
 #include "FgSyntax.hpp"
 #include "FgTime.hpp"
 #include "FgCommand.hpp"
-
-#ifdef _MSC_VER
-    #pragma warning(push,0)     // Eigen triggers lots of warnings
-#endif
-
-#define EIGEN_MPL2_ONLY     // Only use permissive licensed source files from Eigen
-#include "Eigen/Dense"
-#include "Eigen/Core"
-
-#ifdef _MSC_VER
-    #pragma warning(pop)
-#endif
+#include "FgSimd.hpp"
 
 using namespace std;
 
-using namespace Eigen;
-
 namespace Fg {
 
 template<>
 MatF
 operator*(const MatF & lhs,const MatF & rhs)
-{
-    if (lhs.ncols < 100)
-        return matMul(lhs,rhs);
-    FGASSERT(lhs.ncols == rhs.nrows);
-    MatrixXf            l(lhs.nrows,lhs.ncols),
-                        r(rhs.nrows,rhs.ncols);
-    for (size_t rr=0; rr<lhs.nrows; ++rr)
-        for (size_t cc=0; cc<lhs.ncols; ++cc)
-            l(rr,cc) = lhs.rc(rr,cc);
-    for (size_t rr=0; rr<rhs.nrows; ++rr)
-        for (size_t cc=0; cc<rhs.ncols; ++cc)
-            r(rr,cc) = rhs.rc(rr,cc);
-    MatrixXf            m = l * r;
-    MatF           ret(lhs.nrows,rhs.ncols);
-    for (size_t rr=0; rr<ret.nrows; ++rr)
-        for (size_t cc=0; cc<ret.ncols; ++cc)
-            ret.rc(rr,cc) = m(rr,cc);
-    return ret;
-}
+{return gemm(lhs,rhs); }
 
 template<>
 MatD
 operator*(const MatD & lhs,const MatD & rhs)
-{
-    if (lhs.ncols < 100)
-        return matMul(lhs,rhs);
-    FGASSERT(lhs.ncols == rhs.nrows);
-    MatrixXd            l(lhs.nrows,lhs.ncols),
-                        r(rhs.nrows,rhs.ncols);
-    for (size_t rr=0; rr<lhs.nrows; ++rr)
-        for (size_t cc=0; cc<lhs.ncols; ++cc)
-            l(rr,cc) = lhs.rc(rr,cc);
-    for (size_t rr=0; rr<rhs.nrows; ++rr)
-        for (size_t cc=0; cc<rhs.ncols; ++cc)
-            r(rr,cc) = rhs.rc(rr,cc);
-    MatrixXd            m = l * r;
-    MatD           ret(lhs.nrows,rhs.ncols);
-    for (size_t rr=0; rr<ret.nrows; ++rr)
-        for (size_t cc=0; cc<ret.ncols; ++cc)
-            ret.rc(rr,cc) = m(rr,cc);
-    return ret;
-}
+{return gemm(lhs,rhs); }
 
 double
 fgMatSumElems(const MatD & mat)
@@ -128,6 +79,54 @@ testCorrect(const CLArgs &)
     FGASSERT(N == R);
 }
 
+template<class T>
+MatV<T>
+randMat(size_t nrows,size_t ncols)
+{
+    Doubles             vals = randNormals(nrows*ncols);
+    return MatV<T>(nrows,ncols,Svec<T>(vals.begin(),vals.end()));
+}
+
+template<class T>
+void
+testGemmT(T tol)
+{
+    // Sizes cover tiny products, partial micro-kernel blocks, and multiple tiles and depth slices:
+    Svec<Vec3UI>        shapes = {{1,1,1},{3,3,3},{7,5,9},{13,33,17},{100,37,70},{130,300,270}};
+    for (Simd simd : {Simd::scalar,Simd::vec128,Simd::avx2}) {
+        setSimdLevel(simd);
+        for (Vec3UI s : shapes) {
+            MatV<T>             A = randMat<T>(s[0],s[1]),
+                                B = randMat<T>(s[1],s[2]),
+                                R = matMul(A,B),
+                                At = A.transpose(),
+                                Bt = B.transpose();
+            T                   lim = tol * std::sqrt(T(s[1]));
+            FGASSERT(cMax(mapAbs((gemm(A,B) - R).m_data)) < lim);
+            FGASSERT(cMax(mapAbs((gemm(At,B,true,false) - R).m_data)) < lim);
+            FGASSERT(cMax(mapAbs((gemm(A,Bt,false,true) - R).m_data)) < lim);
+            FGASSERT(cMax(mapAbs((gemm(At,Bt,true,true) - R).m_data)) < lim);
+        }
+    }
+    setSimdLevel(simdSupported());
+    Svec<MatV<T> >      As,Bs;
+    for (uint ii=0; ii<50; ++ii) {
+        As.push_back(randMat<T>(4,6));
+        Bs.push_back(randMat<T>(4,5));
+    }
+    Svec<MatV<T> >      Cs = gemmBatch(As,Bs,true,false);
+    for (size_t ii=0; ii<Cs.size(); ++ii)
+        FGASSERT(cMax(mapAbs((Cs[ii] - matMul(As[ii].transpose(),Bs[ii])).m_data)) < tol*3);
+}
+
+void
+testGemm(const CLArgs &)
+{
+    randSeedRepeatable();
+    testGemmT<float>(1.0e-5f);
+    testGemmT<double>(1.0e-13);
+}
+
 MatD
 tt0(const MatD & lhs,const MatD & rhs)
 {
@@ -287,17 +286,11 @@ eigenTest(const CLArgs & args)
         return;
     Syntax            syn(args,"<size>");
     size_t              sz = fgFromStr<size_t>(syn.next()).val();
-    MatrixXd            l(sz,sz),
-                        r(sz,sz);
-    for (size_t rr=0; rr<sz; ++rr) {
-        for (size_t cc=0; cc<sz; ++cc) {
-            l(rr,cc) = randUniform();
-            r(rr,cc) = randUniform();
-        }
-    }
+    MatD                l = MatD::randNormal(sz,sz),
+                        r = MatD::randNormal(sz,sz);
     {
-        FgTimeScope     ts("Eigen mat mul " + toString(sz));
-        MatrixXd        m = l * r;
+        FgTimeScope     ts("Mat mul " + toString(sz));
+        MatD            m = l * r;
     }
 }
 
@@ -308,7 +301,8 @@ fgMatrixVTest(const CLArgs & args)
 {
     vector<Cmd>   cmds;
     cmds.push_back(Cmd(testCorrect,"correct"));
-    cmds.push_back(Cmd(eigenTest,"tem","Time eigen mat mul"));
+    cmds.push_back(Cmd(testGemm,"gemm"));
+    cmds.push_back(Cmd(eigenTest,"tem","Time mat mul"));
     cmds.push_back(Cmd(testMul,"tlm","Time loop mat mul"));
     cmds.push_back(Cmd(loopStructTime,"lst","Loop structure timing experiment"));
     doMenu(args,cmds,true);
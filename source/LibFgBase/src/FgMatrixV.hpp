@@ -406,7 +406,7 @@ matMul(const MatV<T> & lhs,const MatV<T> & rhs)
 {
     FGASSERT(lhs.ncols == rhs.nrows);
     // Block sub-loop cache optimization - no multithreading or explicit SIMD.
-    // Use eigen instead if speed is important:
+    // Use 'gemm' (below) for float and double:
     size_t constexpr    CN = 64 / sizeof(T);    // Number of elements that fit in L1 Cache (est)
     MatV<T>             ret(lhs.nrows,rhs.ncols,static_cast<T>(0));
     for (size_t rr=0; rr<ret.nrows; rr+=CN) {
@@ -451,8 +451,7 @@ inline MatV<T>
 operator*(const MatV<T> & lhs,const MatV<T> & rhs)
 {return matMul(lhs,rhs); }
 
-// Specializations for float and double use Eigen library when matrix is large enough to be worth
-// copying over:
+// Specializations for float and double use 'gemm':
 template<>
 MatF
 operator*(const MatF & lhs,const MatF & rhs);
@@ -461,6 +460,31 @@ template<>
 MatD
 operator*(const MatD & lhs,const MatD & rhs);
 
+// General matrix multiply op(A) * op(B), where 'op' transposes its argument if the corresponding flag
+// is set, without forming the transpose. Uses packed panels with register-blocked AVX2/FMA, SSE2 or NEON
+// kernels (see FgSimd.hpp) and runs across threads for large products:
+MatF
+gemm(MatF const & A,MatF const & B,bool transA=false,bool transB=false);
+
+MatD
+gemm(MatD const & A,MatD const & B,bool transA=false,bool transB=false);
+
+// Symmetric rank-k update: adds A^T * A to the upper triangle (including the diagonal) of square 'C',
+// in about half the time of the equivalent 'gemm'. Elements below the diagonal are unspecified:
+void
+syrkUpper_(MatF const & A,MatF & C);
+
+void
+syrkUpper_(MatD const & A,MatD & C);
+
+// The products of corresponding elements of 'As' and 'Bs', eg. many small matrices of the same shape.
+// Runs across threads over the batch:
+Svec<MatF>
+gemmBatch(Svec<MatF> const & As,Svec<MatF> const & Bs,bool transA=false,bool transB=false);
+
+Svec<MatD>
+gemmBatch(Svec<MatD> const & As,Svec<MatD> const & Bs,bool transA=false,bool transB=false);
+
 template<class T>
 MatV<T>
 operator*(const T & lhs,const MatV<T> & rhs)
@@ -0,0 +1,63 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Zero-copy Eigen views of MatV storage:
+//
+// * MatV is row-major so the views are row-major 'Eigen::Map's. Eigen algorithms accept them
+//   directly and can write their results straight into a MatV of the right size.
+// * Include only from implementation files since Eigen is a very large header library.
+//
+
+#ifndef FGMATRIXVEIGEN_HPP
+#define FGMATRIXVEIGEN_HPP
+
+#include "FgMatrixV.hpp"
+
+#ifdef _MSC_VER
+    #pragma warning(push,0)     // Eigen triggers lots of warnings
+#endif
+
+#ifndef EIGEN_MPL2_ONLY
+    #define EIGEN_MPL2_ONLY     // Only use permissive licensed source files from Eigen
+#endif
+#include "Eigen/Dense"
+#include "Eigen/Core"
+
+#ifdef _MSC_VER
+    #pragma warning(pop)
+#endif
+
+namespace Fg {
+
+template<class T>
+using EigMatRm = Eigen::Matrix<T,Eigen::Dynamic,Eigen::Dynamic,Eigen::RowMajor>;
+
+template<class T>
+using EigVec = Eigen::Matrix<T,Eigen::Dynamic,1>;
+
+template<class T>
+Eigen::Map<EigMatRm<T> >
+eigMap(MatV<T> & mat)
+{return Eigen::Map<EigMatRm<T> >(mat.m_data.data(),mat.nrows,mat.ncols); }
+
+template<class T>
+Eigen::Map<EigMatRm<T> const>
+eigMap(MatV<T> const & mat)
+{return Eigen::Map<EigMatRm<T> const>(mat.m_data.data(),mat.nrows,mat.ncols); }
+
+// Column vector views:
+template<class T>
+Eigen::Map<EigVec<T> >
+eigMap(Svec<T> & vec)
+{return Eigen::Map<EigVec<T> >(vec.data(),vec.size()); }
+
+template<class T>
+Eigen::Map<EigVec<T> const>
+eigMap(Svec<T> const & vec)
+{return Eigen::Map<EigVec<T> const>(vec.data(),vec.size()); }
+
+}
+
+#endif
@@ -0,0 +1,177 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+
+#include "stdafx.h"
+
+#include "FgParallel.hpp"
+#include "FgDiagnostics.hpp"
+#include "FgStdVector.hpp"
+#include "FgCommand.hpp"
+#include <atomic>
+
+using namespace std;
+
+namespace Fg {
+
+namespace {
+
+thread_local bool   s_inParallel = false;
+
+}
+
+bool
+inParallel()
+{return s_inParallel; }
+
+ParallelScope::ParallelScope() : prev(s_inParallel)
+{s_inParallel = true; }
+
+ParallelScope::~ParallelScope()
+{s_inParallel = prev; }
+
+uint
+threadsNum()
+{
+    uint        ret = std::thread::hardware_concurrency();
+    return (ret == 0) ? 1 : ret;
+}
+
+void
+parallelFor(size_t num,function<void(size_t)> const & fn,uint maxThreads)
+{
+    if (maxThreads == 0)
+        maxThreads = threadsNum();
+    size_t              numThreads = std::min(num,size_t(maxThreads));
+    if ((numThreads < 2) || s_inParallel) {
+        for (size_t ii=0; ii<num; ++ii)
+            fn(ii);
+        return;
+    }
+    atomic<size_t>      next(0);
+    atomic<bool>        failed(false);
+    exception_ptr       error;
+    mutex               errorMutex;
+    auto                worker = [&]()
+    {
+        ParallelScope       scope;
+        for (;;) {
+            size_t          ii = next++;
+            if ((ii >= num) || failed)
+                return;
+            try {
+                fn(ii);
+            }
+            catch (...) {
+                lock_guard<mutex>   lock(errorMutex);
+                if (!failed) {
+                    error = current_exception();
+                    failed = true;
+                }
+            }
+        }
+    };
+    Svec<thread>        threads;
+    threads.reserve(numThreads-1);
+    for (size_t tt=1; tt<numThreads; ++tt)
+        threads.push_back(thread(worker));
+    worker();                               // The calling thread does its share
+    for (thread & t : threads)
+        t.join();
+    if (error)
+        rethrow_exception(error);
+}
+
+void
+parallelForBlocks(size_t num,size_t minBlock,function<void(size_t,size_t)> const & fn,uint maxThreads)
+{
+    FGASSERT(minBlock > 0);
+    if (maxThreads == 0)
+        maxThreads = threadsNum();
+    // A few blocks per thread helps balance uneven loads:
+    size_t          numBlocks = std::min(std::max(num/minBlock,size_t(1)),size_t(maxThreads)*4),
+                    blockSize = (num + numBlocks - 1) / numBlocks;
+    if (blockSize == 0)
+        return;
+    numBlocks = (num + blockSize - 1) / blockSize;
+    parallelFor(numBlocks,[&](size_t bb)
+    {
+        size_t      lo = bb * blockSize;
+        fn(lo,std::min(lo+blockSize,num));
+    },maxThreads);
+}
+
+void
+fgParallelTest(CLArgs const &)
+{
+    // Exceptions are re-thrown in the caller:
+    bool                caught = false;
+    try {
+        parallelFor(10,[](size_t ii){if (ii == 7) fgThrow("test"); },4);
+    }
+    catch (FgException const &) {
+        caught = true;
+    }
+    FGASSERT(caught);
+    // Nested calls and calls within a 'ParallelScope' run serially in the calling thread:
+    FGASSERT(!inParallel());
+    {
+        ParallelScope       scope;
+        FGASSERT(inParallel());
+        thread::id          id = this_thread::get_id();
+        parallelFor(8,[id](size_t){FGASSERT(this_thread::get_id() == id); },4);
+    }
+    FGASSERT(!inParallel());
+    parallelFor(4,[](size_t){FGASSERT(inParallel()); },4);
+    // A full queue blocks 'push' until an item is popped:
+    {
+        BoundedQueue<int>   queue(2);
+        queue.push(0);
+        queue.push(1);
+        atomic<bool>        pushed(false);
+        thread              producer([&](){queue.push(2); pushed = true; });
+        this_thread::sleep_for(chrono::milliseconds(50));
+        FGASSERT(!pushed);
+        int                 val;
+        FGASSERT(queue.pop(val) && (val == 0));
+        producer.join();
+        FGASSERT(pushed);
+        // Items pushed before closing are still popped, in order, then 'pop' returns false:
+        queue.close();
+        FGASSERT(queue.pop(val) && (val == 1));
+        FGASSERT(queue.pop(val) && (val == 2));
+        FGASSERT(!queue.pop(val));
+    }
+    // Multiple producers and consumers hand over every item exactly once:
+    {
+        BoundedQueue<size_t>    queue(3);
+        size_t                  num = 1000;
+        Svec<atomic<int> >      counts(num);
+        for (atomic<int> & c : counts)
+            c = 0;
+        thread                  producers([&]()
+        {
+            parallelFor(2,[&](size_t pp){for (size_t ii=pp; ii<num; ii+=2) queue.push(ii); },2);
+            queue.close();
+        });
+        Svec<thread>            consumers;
+        for (uint tt=0; tt<3; ++tt)
+            consumers.push_back(thread([&]()
+            {
+                size_t          ii;
+                while (queue.pop(ii))
+                    ++counts[ii];
+            }));
+        producers.join();
+        for (thread & t : consumers)
+            t.join();
+        for (atomic<int> const & c : counts)
+            FGASSERT(c == 1);
+    }
+}
+
+}
+
+// */
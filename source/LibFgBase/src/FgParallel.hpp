@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Simple data-parallel helpers over std::thread.
+//
+// * Work items are handed out dynamically so uneven item costs balance across threads.
+// * The first exception thrown by any item is re-thrown in the calling thread once all threads
+//   have joined; remaining items are skipped.
+// * Nested calls from within a parallel loop run serially in the calling thread, so library functions
+//   can parallelize internally without oversubscribing when called from parallel client code.
+//
+
+#ifndef FGPARALLEL_HPP
+#define FGPARALLEL_HPP
+
+#include "FgStdLibs.hpp"
+#include "FgTypes.hpp"
+#include "FgDiagnostics.hpp"
+#include <deque>
+
+namespace Fg {
+
+// Number of hardware threads (at least 1):
+uint
+threadsNum();
+
+// Calls 'fn(ii)' for each 'ii' in [0,num) across up to 'maxThreads' threads (0 for all hardware threads).
+// Runs in the calling thread when only one thread would be used:
+void
+parallelFor(size_t num,std::function<void(size_t)> const & fn,uint maxThreads=0);
+
+// Calls 'fn(lo,hi)' over contiguous blocks covering [0,num) of at least 'minBlock' items each.
+// Use when the per-item work is too small to dispatch individually (eg. image rows):
+void
+parallelForBlocks(size_t num,size_t minBlock,std::function<void(size_t,size_t)> const & fn,uint maxThreads=0);
+
+// True when called from within 'parallelFor' (or from a thread marked by 'ParallelScope'):
+bool
+inParallel();
+
+// Marks the current thread as running in parallel with others for its lifetime, eg. for client
+// pipeline threads, so nested 'parallelFor' calls run serially:
+struct  ParallelScope
+{
+    bool            prev;
+    ParallelScope();
+    ~ParallelScope();
+};
+
+// Blocking FIFO for handing work between the stages of a pipeline. 'push' blocks while the queue
+// is full, which bounds the memory held between stages:
+template<class T>
+class   BoundedQueue
+{
+public:
+    explicit
+    BoundedQueue(size_t capacity) : m_capacity(capacity)
+    {FGASSERT(capacity > 0); }
+
+    void
+    push(T const & val)
+    {
+        std::unique_lock<std::mutex>    lock(m_mutex);
+        m_notFull.wait(lock,[this]{return (m_items.size() < m_capacity); });
+        m_items.push_back(val);
+        m_notEmpty.notify_one();
+    }
+
+    // Blocks until an item is available. Returns false once the queue is closed and empty:
+    bool
+    pop(T & val)
+    {
+        std::unique_lock<std::mutex>    lock(m_mutex);
+        m_notEmpty.wait(lock,[this]{return (!m_items.empty() || m_closed); });
+        if (m_items.empty())
+            return false;
+        val = m_items.front();
+        m_items.pop_front();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    // No more items will be pushed:
+    void
+    close()
+    {
+        std::lock_guard<std::mutex>     lock(m_mutex);
+        m_closed = true;
+        m_notEmpty.notify_all();
+    }
+
+private:
+    size_t                      m_capacity;
+    bool                        m_closed = false;
+    std::deque<T>               m_items;
+    std::mutex                  m_mutex;
+    std::condition_variable     m_notFull;
+    std::condition_variable     m_notEmpty;
+};
+
+}
+
+#endif
@@ -12,6 +12,9 @@
 #include "FgImgDisplay.hpp"
 #include "FgMath.hpp"
 #include "FgAffine1.hpp"
+#include "FgApproxFunc.hpp"
+#include "FgParallel.hpp"
+#include "FgSimd.hpp"
 #include "FgMain.hpp"
 
 using namespace std;
@@ -29,7 +32,7 @@ struct      RNG
     RNG() : gen(rd()) {}
 };
 
-static RNG rng;
+thread_local RNG rng;
 
 }
 
@@ -174,6 +177,374 @@ std::vector<double>
 randNearUnits(size_t num)
 {return fgGenerate<double>(randNearUnit,num); }
 
+namespace {
+
+// Philox4x32-10 constants:
+uint32 constexpr    s_mul0 = 0xD2511F53U,
+                    s_mul1 = 0xCD9E8D57U,
+                    s_weyl0 = 0x9E3779B9U,      // Key schedule increments
+                    s_weyl1 = 0xBB67AE85U;
+
+inline uint32
+mulHiLo(uint32 a,uint32 b,uint32 & lo)
+{
+    uint64          p = uint64(a) * b;
+    lo = uint32(p);
+    return uint32(p >> 32);
+}
+
+// The 4 outputs for counter (block,ctrHi):
+void
+philoxScalar(uint32 const key[2],uint32 const ctrHi[2],uint64 block,uint32 * out)
+{
+    uint32          c0 = uint32(block),
+                    c1 = uint32(block >> 32),
+                    c2 = ctrHi[0],
+                    c3 = ctrHi[1],
+                    k0 = key[0],
+                    k1 = key[1];
+    for (uint rr=0; rr<10; ++rr) {
+        uint32          lo0,lo1,
+                        hi0 = mulHiLo(s_mul0,c0,lo0),
+                        hi1 = mulHiLo(s_mul1,c2,lo1);
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+        k0 += s_weyl0;
+        k1 += s_weyl1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+// The vectorized versions compute one block per lane then transpose so the output order matches:
+
+#ifdef FG_SSE2
+
+inline __m128i
+mulHiLo128(__m128i m,__m128i a,__m128i & lo)
+{
+    // 32x32->64 bit products of the even then odd lanes, then gather the low and high halves:
+    __m128i         pe = _mm_shuffle_epi32(_mm_mul_epu32(m,a),_MM_SHUFFLE(3,1,2,0)),
+                    po = _mm_shuffle_epi32(_mm_mul_epu32(m,_mm_srli_epi64(a,32)),_MM_SHUFFLE(3,1,2,0));
+    lo = _mm_unpacklo_epi32(pe,po);
+    return _mm_unpackhi_epi32(pe,po);
+}
+
+size_t
+philox128(uint32 const key[2],uint32 const ctrHi[2],uint64 block,size_t numBlocks,uint32 * out)
+{
+    __m128i         m0 = _mm_set1_epi32(int(s_mul0)),
+                    m1 = _mm_set1_epi32(int(s_mul1));
+    size_t          bb = 0;
+    for (; bb+4<=numBlocks; bb+=4) {
+        uint64          b = block + bb;
+        __m128i         c0 = _mm_setr_epi32(int(b),int(b+1),int(b+2),int(b+3)),
+                        c1 = _mm_setr_epi32(int(b>>32),int((b+1)>>32),int((b+2)>>32),int((b+3)>>32)),
+                        c2 = _mm_set1_epi32(int(ctrHi[0])),
+                        c3 = _mm_set1_epi32(int(ctrHi[1]));
+        uint32          k0 = key[0],
+                        k1 = key[1];
+        for (uint rr=0; rr<10; ++rr) {
+            __m128i         lo0,lo1,
+                            hi0 = mulHiLo128(m0,c0,lo0),
+                            hi1 = mulHiLo128(m1,c2,lo1);
+            c0 = _mm_xor_si128(_mm_xor_si128(hi1,c1),_mm_set1_epi32(int(k0)));
+            c1 = lo1;
+            c2 = _mm_xor_si128(_mm_xor_si128(hi0,c3),_mm_set1_epi32(int(k1)));
+            c3 = lo0;
+            k0 += s_weyl0;
+            k1 += s_weyl1;
+        }
+        __m128i         t0 = _mm_unpacklo_epi32(c0,c1),
+                        t1 = _mm_unpacklo_epi32(c2,c3),
+                        t2 = _mm_unpackhi_epi32(c0,c1),
+                        t3 = _mm_unpackhi_epi32(c2,c3);
+        __m128i *       o = reinterpret_cast<__m128i*>(out + bb*4);
+        _mm_storeu_si128(o,_mm_unpacklo_epi64(t0,t1));
+        _mm_storeu_si128(o+1,_mm_unpackhi_epi64(t0,t1));
+        _mm_storeu_si128(o+2,_mm_unpacklo_epi64(t2,t3));
+        _mm_storeu_si128(o+3,_mm_unpackhi_epi64(t2,t3));
+    }
+    return bb;
+}
+
+#endif
+
+#ifdef FG_AVX2
+
+FG_TARGET_AVX2
+inline __m256i
+mulHiLoAvx2(__m256i m,__m256i a,__m256i & lo)
+{
+    __m256i         pe = _mm256_shuffle_epi32(_mm256_mul_epu32(m,a),_MM_SHUFFLE(3,1,2,0)),
+                    po = _mm256_shuffle_epi32(_mm256_mul_epu32(m,_mm256_srli_epi64(a,32)),_MM_SHUFFLE(3,1,2,0));
+    lo = _mm256_unpacklo_epi32(pe,po);
+    return _mm256_unpackhi_epi32(pe,po);
+}
+
+FG_TARGET_AVX2
+size_t
+philoxAvx2(uint32 const key[2],uint32 const ctrHi[2],uint64 block,size_t numBlocks,uint32 * out)
+{
+    __m256i         m0 = _mm256_set1_epi32(int(s_mul0)),
+                    m1 = _mm256_set1_epi32(int(s_mul1));
+    size_t          bb = 0;
+    for (; bb+8<=numBlocks; bb+=8) {
+        int             lo[8],
+                        hi[8];
+        for (uint ii=0; ii<8; ++ii) {
+            lo[ii] = int(block + bb + ii);
+            hi[ii] = int((block + bb + ii) >> 32);
+        }
+        __m256i         c0 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(lo)),
+                        c1 = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(hi)),
+                        c2 = _mm256_set1_epi32(int(ctrHi[0])),
+                        c3 = _mm256_set1_epi32(int(ctrHi[1]));
+        uint32          k0 = key[0],
+                        k1 = key[1];
+        for (uint rr=0; rr<10; ++rr) {
+            __m256i         lo0,lo1,
+                            hi0 = mulHiLoAvx2(m0,c0,lo0),
+                            hi1 = mulHiLoAvx2(m1,c2,lo1);
+            c0 = _mm256_xor_si256(_mm256_xor_si256(hi1,c1),_mm256_set1_epi32(int(k0)));
+            c1 = lo1;
+            c2 = _mm256_xor_si256(_mm256_xor_si256(hi0,c3),_mm256_set1_epi32(int(k1)));
+            c3 = lo0;
+            k0 += s_weyl0;
+            k1 += s_weyl1;
+        }
+        // Blocks 0-3 are in the low 128-bit lanes and 4-7 in the high:
+        __m256i         t0 = _mm256_unpacklo_epi32(c0,c1),
+                        t1 = _mm256_unpacklo_epi32(c2,c3),
+                        t2 = _mm256_unpackhi_epi32(c0,c1),
+                        t3 = _mm256_unpackhi_epi32(c2,c3),
+                        u0 = _mm256_unpacklo_epi64(t0,t1),      // Blocks 0,4
+                        u1 = _mm256_unpackhi_epi64(t0,t1),      // 1,5
+                        u2 = _mm256_unpacklo_epi64(t2,t3),      // 2,6
+                        u3 = _mm256_unpackhi_epi64(t2,t3);      // 3,7
+        __m256i *       o = reinterpret_cast<__m256i*>(out + bb*4);
+        _mm256_storeu_si256(o,_mm256_permute2x128_si256(u0,u1,0x20));
+        _mm256_storeu_si256(o+1,_mm256_permute2x128_si256(u2,u3,0x20));
+        _mm256_storeu_si256(o+2,_mm256_permute2x128_si256(u0,u1,0x31));
+        _mm256_storeu_si256(o+3,_mm256_permute2x128_si256(u2,u3,0x31));
+    }
+    return bb;
+}
+
+#endif
+
+#ifdef FG_NEON
+
+inline uint32x4_t
+mulHiLo128(uint32x4_t m,uint32x4_t a,uint32x4_t & lo)
+{
+    uint32x4x2_t    p = vuzpq_u32(
+        vreinterpretq_u32_u64(vmull_u32(vget_low_u32(m),vget_low_u32(a))),
+        vreinterpretq_u32_u64(vmull_u32(vget_high_u32(m),vget_high_u32(a))));
+    lo = p.val[0];
+    return p.val[1];
+}
+
+size_t
+philox128(uint32 const key[2],uint32 const ctrHi[2],uint64 block,size_t numBlocks,uint32 * out)
+{
+    uint32x4_t      m0 = vdupq_n_u32(s_mul0),
+                    m1 = vdupq_n_u32(s_mul1);
+    size_t          bb = 0;
+    for (; bb+4<=numBlocks; bb+=4) {
+        uint32          lo[4],
+                        hi[4];
+        for (uint ii=0; ii<4; ++ii) {
+            lo[ii] = uint32(block + bb + ii);
+            hi[ii] = uint32((block + bb + ii) >> 32);
+        }
+        uint32x4x4_t    c;
+        c.val[0] = vld1q_u32(lo);
+        c.val[1] = vld1q_u32(hi);
+        c.val[2] = vdupq_n_u32(ctrHi[0]);
+        c.val[3] = vdupq_n_u32(ctrHi[1]);
+        uint32          k0 = key[0],
+                        k1 = key[1];
+        for (uint rr=0; rr<10; ++rr) {
+            uint32x4_t      lo0,lo1,
+                            hi0 = mulHiLo128(m0,c.val[0],lo0),
+                            hi1 = mulHiLo128(m1,c.val[2],lo1);
+            c.val[0] = veorq_u32(veorq_u32(hi1,c.val[1]),vdupq_n_u32(k0));
+            c.val[1] = lo1;
+            c.val[2] = veorq_u32(veorq_u32(hi0,c.val[3]),vdupq_n_u32(k1));
+            c.val[3] = lo0;
+            k0 += s_weyl0;
+            k1 += s_weyl1;
+        }
+        vst4q_u32(out+bb*4,c);                  // Interleaves
+    }
+    return bb;
+}
+
+#endif
+
+void
+philoxBlocks(uint32 const key[2],uint32 const ctrHi[2],uint64 block,size_t numBlocks,uint32 * out)
+{
+    Simd            simd = simdLevel();
+    size_t          bb = 0;
+#ifdef FG_AVX2
+    if (simd == Simd::avx2)
+        bb = philoxAvx2(key,ctrHi,block,numBlocks,out);
+#endif
+#if defined(FG_SSE2) || defined(FG_NEON)
+    if (simd >= Simd::vec128)
+        bb += philox128(key,ctrHi,block+bb,numBlocks-bb,out+bb*4);
+#endif
+    (void)simd;
+    for (; bb<numBlocks; ++bb)
+        philoxScalar(key,ctrHi,block+bb,out+bb*4);
+}
+
+// Bulk fills are split into blocks of this many outputs. A multiple of the chunk size below so that
+// each block starts at the same stream position as in a serial fill:
+size_t constexpr    s_parBlock = 1 << 16;
+// Bulk outputs are generated in chunks on the stack:
+size_t constexpr    s_chunk = 256;
+
+}
+
+RandStream::RandStream(uint64 seed,uint64 stream) :
+    m_key {uint32(seed),uint32(seed >> 32)},
+    m_stream {uint32(stream),uint32(stream >> 32)},
+    m_block(0),
+    m_idx(4)
+{}
+
+void
+RandStream::nextBlock()
+{
+    philoxScalar(m_key,m_stream,m_block,m_buf);
+    m_idx = 0;
+    ++m_block;
+}
+
+void
+RandStream::fill_(uint32 * out,size_t num)
+{
+    size_t          ii = 0;
+    for (; (ii<num) && (m_idx<4); ++ii)
+        out[ii] = m_buf[m_idx++];
+    size_t          numBlocks = (num - ii) / 4;
+    philoxBlocks(m_key,m_stream,m_block,numBlocks,out+ii);
+    m_block += numBlocks;
+    for (ii+=numBlocks*4; ii<num; ++ii)
+        out[ii] = operator()();
+}
+
+void
+RandStream::seek(uint64 pos)
+{
+    m_block = pos / 4;
+    m_idx = 4;
+    if (pos % 4 != 0) {
+        nextBlock();
+        m_idx = uint(pos % 4);
+    }
+}
+
+double
+RandStream::uniform()
+{
+    uint32          a = operator()() >> 5,
+                    b = operator()() >> 6;
+    return (double(a) * 67108864.0 + double(b)) * (1.0 / 9007199254740992.0);
+}
+
+void
+RandStream::uniformSerial_(float * out,size_t num)
+{
+    uint32          bits[s_chunk];
+    for (size_t ii=0; ii<num; ii+=s_chunk) {
+        size_t          nn = std::min(num-ii,s_chunk);
+        fill_(bits,nn);
+        for (size_t jj=0; jj<nn; ++jj)
+            out[ii+jj] = float(bits[jj] >> 8) * (1.0f / 16777216.0f);
+    }
+}
+
+void
+RandStream::normalSerial_(float * out,size_t num)
+{
+    uint32          bits[s_chunk];
+    float           u[s_chunk/2],       // Radius then its square root
+                    t[s_chunk/2],       // Angle
+                    c[s_chunk/2],
+                    s[s_chunk/2];
+    float constexpr scale = 1.0f / 16777216.0f;
+    for (size_t ii=0; ii<num; ii+=s_chunk) {
+        size_t          nn = std::min(num-ii,s_chunk),
+                        np = (nn + 1) / 2;
+        fill_(bits,np*2);
+        for (size_t jj=0; jj<np; ++jj) {
+            u[jj] = (float(bits[2*jj] >> 8) + 0.5f) * scale;      // (0,1) so the log is finite and non-zero
+            t[jj] = float(bits[2*jj+1] >> 8) * (scale * 2.0f * float(pi()));
+        }
+        approxLog_(u,u,np);
+        for (size_t jj=0; jj<np; ++jj)
+            u[jj] *= -2.0f;
+        approxRsqrt_(u,s,np);
+        for (size_t jj=0; jj<np; ++jj)
+            u[jj] *= s[jj];
+        approxCos_(t,c,np);
+        approxSin_(t,s,np);
+        float *         o = out + ii;
+        for (size_t jj=0; jj+1<nn; jj+=2) {
+            o[jj] = u[jj/2] * c[jj/2];
+            o[jj+1] = u[jj/2] * s[jj/2];
+        }
+        if (nn % 2 == 1)
+            o[nn-1] = u[np-1] * c[np-1];
+    }
+}
+
+void
+RandStream::uniform_(float * out,size_t num)
+{
+    if (num < 2*s_parBlock) {
+        uniformSerial_(out,num);
+        return;
+    }
+    uint64          pos = position();
+    parallelForBlocks(num,s_parBlock,[&](size_t lo,size_t hi)
+    {
+        RandStream          rs = *this;
+        rs.seek(pos + lo);
+        rs.uniformSerial_(out+lo,hi-lo);
+    });
+    seek(pos + num);
+}
+
+void
+RandStream::normal_(float * out,size_t num)
+{
+    if (num < 2*s_parBlock) {
+        normalSerial_(out,num);
+        return;
+    }
+    uint64          pos = position();
+    size_t          numBlocks = (num + s_parBlock - 1) / s_parBlock;
+    // Blocks must be aligned to the serial chunks so use fixed sizes rather than 'parallelForBlocks':
+    parallelFor(numBlocks,[&](size_t bb)
+    {
+        size_t              lo = bb * s_parBlock,
+                            hi = std::min(lo+s_parBlock,num);
+        RandStream          rs = *this;
+        rs.seek(pos + lo);
+        rs.normalSerial_(out+lo,hi-lo);
+    });
+    seek(pos + num + num % 2);
+}
+
 }
 
 // */
@@ -3,8 +3,9 @@
 // Use, modification and distribution is subject to the MIT License,
 // see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
 //
-// Not threadsafe. If threaded RNG is needed, make explicit generator for each thread so
-// that seeding policy for different threads is explicit:
+// The global functions use a generator for each thread, seeded from the system entropy source
+// unless 'randSeedRepeatable' is called from that thread. For reproducible parallel work use a
+// 'RandStream' for each work item (not each thread, since item scheduling varies between runs).
 //
 
 #ifndef FGRANDOM_HPP
@@ -16,6 +17,7 @@
 
 namespace Fg {
 
+// Seeds the calling thread's generator:
 void
 randSeedRepeatable(uint64 seed=42);
 
@@ -65,6 +67,83 @@ randNearUnit();
 Svec<double>
 randNearUnits(size_t num);
 
+// Counter-based generator (Philox4x32-10, Salmon et al. 2011). Each (seed,stream) pair gives an
+// independent sequence which can be positioned anywhere in O(1), so bulk fills can be split across
+// threads and still give exactly the same values as a serial fill. Satisfies the standard
+// UniformRandomBitGenerator requirements so can be used with <random> distributions:
+class   RandStream
+{
+public:
+    typedef uint32      result_type;
+
+    explicit
+    RandStream(uint64 seed,uint64 stream=0);
+
+    static constexpr uint32 min() {return 0; }
+    static constexpr uint32 max() {return 0xFFFFFFFFU; }
+
+    uint32
+    operator()()
+    {
+        if (m_idx == 4)
+            nextBlock();
+        return m_buf[m_idx++];
+    }
+
+    // Index of the next 32-bit output in the sequence:
+    uint64
+    position() const
+    {return (m_block * 4 - 4 + m_idx); }
+
+    void
+    seek(uint64 pos);
+
+    // Same as repeated calls to operator() but vectorized:
+    void
+    fill_(uint32 * out,size_t num);
+
+    // Uniform in [0,1) with 53 and 24 bits of precision respectively:
+    double
+    uniform();
+    float
+    uniformF()
+    {return float(operator()() >> 8) * (1.0f / 16777216.0f); }
+
+    // Bulk fills, run across threads for large 'num'. Each output consumes one 32-bit value (plus one
+    // for an odd final normal), so the stream position after a fill is predictable:
+    void
+    uniform_(float * out,size_t num);
+
+    // Box-Muller transform with vectorized log and sin/cos (see FgApproxFunc.hpp). Results are
+    // repeatable for a given SIMD level. Magnitudes are limited to 5.9 by the 24-bit uniforms:
+    void
+    normal_(float * out,size_t num);
+
+    Floats
+    normalFs(size_t num)
+    {
+        Floats          ret(num);
+        normal_(ret.data(),num);
+        return ret;
+    }
+
+private:
+    uint32          m_key[2];
+    uint32          m_stream[2];    // High words of the counter
+    uint64          m_block;        // Low words of the counter for the next block
+    uint32          m_buf[4];       // Outputs of the current block
+    uint            m_idx;          // Next unused in 'm_buf'
+
+    void
+    nextBlock();
+
+    void
+    uniformSerial_(float * out,size_t num);
+
+    void
+    normalSerial_(float * out,size_t num);
+};
+
 }
 
 #endif
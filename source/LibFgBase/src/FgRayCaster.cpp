@@ -120,7 +120,7 @@ FgRayCaster::cast(Vec2F posIucs) const
                     Vec3F        reflectDir = norm * fac * 2.0f - lgt.direction;
                     if (reflectDir[2] > 0.0f) {
                         float       deltaSqr = sqr(reflectDir[0]) + sqr(reflectDir[1]),
-                                    val = exp(-deltaSqr * 32.0f);
+                                    val = float(expFast(-deltaSqr * 32.0f));    // libm exp is slow
                         acc += Vec3F(255.0f * val);
                     }
                 }
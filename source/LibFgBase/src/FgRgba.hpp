@@ -27,6 +27,25 @@
 
 namespace Fg {
 
+// Rec.709 RGB -> luminance. 'Rgba::rec709', 'luminanceRow_' and so every RGBA -> mono conversion use
+// these so they agree exactly. The weights (0.2130, 0.7150, 0.0720) are in 2.14 fixed point and sum to 1
+// so greys are unchanged:
+uint const      rec709R = 3490,
+                rec709G = 11715,
+                rec709B = 1179;
+
+// Integer channels are computed in fixed point and truncated, as in 'luminanceRow_', so results can be
+// 1 less than the rounded value:
+template<typename T>
+T
+rec709Lum(T r,T g,T b,std::true_type)
+{return static_cast<T>((int64(r)*rec709R + int64(g)*rec709G + int64(b)*rec709B) >> 14); }
+
+template<typename T>
+T
+rec709Lum(T r,T g,T b,std::false_type)
+{return (r*T(rec709R) + g*T(rec709G) + b*T(rec709B)) / T(1 << 14); }
+
 template<typename T>
 struct      Rgba
 {
@@ -122,7 +141,7 @@ struct      Rgba
 
     T       
     rec709() const                      // Use rec.709 RGB -> CIE L
-    {return static_cast<T>(0.213 * red() + 0.715 * green() + 0.072 * blue()); }
+    {return rec709Lum(red(),green(),blue(),std::is_integral<T>()); }
 
     static
     Rgba<T>
@@ -0,0 +1,586 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Vectorized per-pixel RGBA kernels (see FgSimd.hpp). Each vector loop handles as many whole vectors
+// as fit and returns where the scalar loop must finish. 8-bit channel products are divided by 255
+// exactly using (x + 1 + (x >> 8)) >> 8, which holds for x < 65535, so results are identical to the
+// scalar versions. Integer division by alpha is done in float with the numerator offset by 1/2 so that
+// truncation is exact even with approximate (eg. -ffast-math) division.
+//
+
+#include "stdafx.h"
+
+#include "FgImage.hpp"
+#include "FgSimd.hpp"
+
+using namespace std;
+
+namespace Fg {
+
+namespace {
+
+#ifdef FG_SSE2
+
+// Exact x/255 for x < 65535 in each ushort lane:
+inline
+__m128i
+div255Sse2(__m128i x)
+{
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x,_mm_set1_epi16(1)),_mm_srli_epi16(x,8)),8);
+}
+
+// Broadcast the alpha of each of the two RGBA pixels in ushort lanes:
+inline
+__m128i
+alphasSse2(__m128i x)
+{return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x,0xFF),0xFF); }
+
+// Select 'alpha' in the alpha lanes and 'rgb' elsewhere:
+inline
+__m128i
+mergeAlphaSse2(__m128i rgb,__m128i alpha)
+{
+    __m128i const       mask = _mm_set_epi16(-1,0,0,0,-1,0,0,0);
+    return _mm_or_si128(_mm_andnot_si128(mask,rgb),_mm_and_si128(mask,alpha));
+}
+
+size_t
+alphaWeightSse2(uchar * p,size_t beg,size_t end)
+{
+    __m128i const       zero = _mm_setzero_si128(),
+                        half = _mm_set1_epi16(127);
+    size_t              ii = beg;
+    for (; ii+4<=end; ii+=4) {
+        __m128i         x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p+ii*4)),
+                        lo = _mm_unpacklo_epi8(x,zero),
+                        hi = _mm_unpackhi_epi8(x,zero),
+                        wlo = div255Sse2(_mm_add_epi16(_mm_mullo_epi16(lo,alphasSse2(lo)),half)),
+                        whi = div255Sse2(_mm_add_epi16(_mm_mullo_epi16(hi,alphasSse2(hi)),half));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p+ii*4),
+            _mm_packus_epi16(mergeAlphaSse2(wlo,lo),mergeAlphaSse2(whi,hi)));
+    }
+    return ii;
+}
+
+size_t
+alphaUnweightSse2(uchar * p,size_t beg,size_t end)
+{
+    __m128i const       zero = _mm_setzero_si128(),
+                        mask = _mm_set_epi32(-1,0,0,0);
+    __m128 const        maxVal = _mm_set1_ps(255.0f);
+    size_t              ii = beg;
+    for (; ii+4<=end; ii+=4) {
+        __m128i         x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p+ii*4)),
+                        x16[2] = {_mm_unpacklo_epi8(x,zero),_mm_unpackhi_epi8(x,zero)},
+                        r[4];
+        for (uint jj=0; jj<4; ++jj) {
+            __m128i         c = (jj%2 == 0) ? _mm_unpacklo_epi16(x16[jj/2],zero) : _mm_unpackhi_epi16(x16[jj/2],zero),
+                            a = _mm_shuffle_epi32(c,0xFF),
+                            num = _mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(c,8),c),_mm_srli_epi32(a,1)),
+                            q = _mm_cvttps_epi32(_mm_min_ps(_mm_div_ps(_mm_add_ps(_mm_cvtepi32_ps(num),_mm_set1_ps(0.5f)),_mm_cvtepi32_ps(a)),maxVal));
+            q = _mm_andnot_si128(_mm_cmpeq_epi32(a,zero),q);
+            r[jj] = _mm_or_si128(_mm_andnot_si128(mask,q),_mm_and_si128(mask,c));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p+ii*4),
+            _mm_packus_epi16(_mm_packs_epi32(r[0],r[1]),_mm_packs_epi32(r[2],r[3])));
+    }
+    return ii;
+}
+
+size_t
+compositeSse2(uchar const * f,uchar * b,size_t beg,size_t end)
+{
+    __m128i const       zero = _mm_setzero_si128(),
+                        half = _mm_set1_epi16(127),
+                        full = _mm_set1_epi16(255);
+    size_t              ii = beg;
+    for (; ii+4<=end; ii+=4) {
+        __m128i         fx = _mm_loadu_si128(reinterpret_cast<__m128i const *>(f+ii*4)),
+                        bx = _mm_loadu_si128(reinterpret_cast<__m128i const *>(b+ii*4)),
+                        ff[2] = {_mm_unpacklo_epi8(fx,zero),_mm_unpackhi_epi8(fx,zero)},
+                        bb[2] = {_mm_unpacklo_epi8(bx,zero),_mm_unpackhi_epi8(bx,zero)},
+                        r[2];
+        for (uint jj=0; jj<2; ++jj) {
+            __m128i         tra = _mm_sub_epi16(full,alphasSse2(ff[jj])),
+                            aca = div255Sse2(_mm_add_epi16(_mm_mullo_epi16(tra,alphasSse2(bb[jj])),half)),
+                            rgb = _mm_add_epi16(ff[jj],div255Sse2(_mm_add_epi16(_mm_mullo_epi16(bb[jj],aca),half)));
+            // Wrap rather than saturate on overflow as the scalar version does:
+            r[jj] = _mm_and_si128(mergeAlphaSse2(rgb,_mm_add_epi16(ff[jj],aca)),full);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(b+ii*4),_mm_packus_epi16(r[0],r[1]));
+    }
+    return ii;
+}
+
+// Luminance of 4 pixels in uint lanes:
+inline
+__m128i
+luminance4Sse2(__m128i x)
+{
+    __m128i const       zero = _mm_setzero_si128(),
+                        wgts = _mm_set_epi16(0,rec709B,rec709G,rec709R,0,rec709B,rec709G,rec709R);
+    __m128              lo = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpacklo_epi8(x,zero),wgts)),
+                        hi = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpackhi_epi8(x,zero),wgts));
+    __m128i             sum = _mm_add_epi32(_mm_castps_si128(_mm_shuffle_ps(lo,hi,_MM_SHUFFLE(2,0,2,0))),
+                                            _mm_castps_si128(_mm_shuffle_ps(lo,hi,_MM_SHUFFLE(3,1,3,1))));
+    return _mm_srli_epi32(sum,14);
+}
+
+size_t
+luminanceSse2(uchar const * s,uchar * d,size_t beg,size_t end)
+{
+    size_t              ii = beg;
+    for (; ii+8<=end; ii+=8) {
+        __m128i         l0 = luminance4Sse2(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s+ii*4))),
+                        l1 = luminance4Sse2(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s+ii*4+16))),
+                        l = _mm_packs_epi32(l0,l1);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(d+ii),_mm_packus_epi16(l,l));
+    }
+    return ii;
+}
+
+// Channel ranges [beg,end) rather than pixels:
+size_t
+ucToFloatSse2(uchar const * s,float * d,size_t beg,size_t end)
+{
+    __m128i const       zero = _mm_setzero_si128();
+    size_t              ii = beg;
+    for (; ii+16<=end; ii+=16) {
+        __m128i         x = _mm_loadu_si128(reinterpret_cast<__m128i const *>(s+ii)),
+                        lo = _mm_unpacklo_epi8(x,zero),
+                        hi = _mm_unpackhi_epi8(x,zero);
+        _mm_storeu_ps(d+ii,_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo,zero)));
+        _mm_storeu_ps(d+ii+4,_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo,zero)));
+        _mm_storeu_ps(d+ii+8,_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi,zero)));
+        _mm_storeu_ps(d+ii+12,_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi,zero)));
+    }
+    return ii;
+}
+
+inline
+__m128i
+clampTruncSse2(float const * s)
+{
+    return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(s),_mm_setzero_ps()),_mm_set1_ps(255.0f)));
+}
+
+size_t
+floatToUcSse2(float const * s,uchar * d,size_t beg,size_t end)
+{
+    size_t              ii = beg;
+    for (; ii+16<=end; ii+=16) {
+        __m128i         lo = _mm_packs_epi32(clampTruncSse2(s+ii),clampTruncSse2(s+ii+4)),
+                        hi = _mm_packs_epi32(clampTruncSse2(s+ii+8),clampTruncSse2(s+ii+12));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(d+ii),_mm_packus_epi16(lo,hi));
+    }
+    return ii;
+}
+
+#endif
+
+#ifdef FG_AVX2
+
+FG_TARGET_AVX2
+inline
+__m256i
+div255Avx2(__m256i x)
+{
+    return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(x,_mm256_set1_epi16(1)),_mm256_srli_epi16(x,8)),8);
+}
+
+FG_TARGET_AVX2
+inline
+__m256i
+alphasAvx2(__m256i x)
+{return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(x,0xFF),0xFF); }
+
+FG_TARGET_AVX2
+inline
+__m256i
+mergeAlphaAvx2(__m256i rgb,__m256i alpha)
+{return _mm256_blend_epi16(rgb,alpha,0x88); }
+
+// Two packs of 4 registers in sequence leave 4-byte groups in the order 0,2,4,6,1,3,5,7 since they work
+// within 128-bit lanes. This restores the sequential order:
+FG_TARGET_AVX2
+inline
+__m256i
+unpermuteAvx2(__m256i x)
+{return _mm256_permutevar8x32_epi32(x,_mm256_setr_epi32(0,4,1,5,2,6,3,7)); }
+
+FG_TARGET_AVX2
+inline
+__m256i
+loadAvx2(uchar const * p)
+{return _mm256_loadu_si256(reinterpret_cast<__m256i const *>(p)); }
+
+FG_TARGET_AVX2
+inline
+void
+storeAvx2(uchar * p,__m256i x)
+{_mm256_storeu_si256(reinterpret_cast<__m256i *>(p),x); }
+
+// 8 pixels per iteration. Unpacking to ushorts and packing back both work within 128-bit lanes so
+// the pixel order is preserved:
+FG_TARGET_AVX2
+size_t
+alphaWeightAvx2(uchar * p,size_t beg,size_t end)
+{
+    __m256i const       zero = _mm256_setzero_si256(),
+                        half = _mm256_set1_epi16(127);
+    size_t              ii = beg;
+    for (; ii+8<=end; ii+=8) {
+        __m256i         x = loadAvx2(p+ii*4),
+                        lo = _mm256_unpacklo_epi8(x,zero),
+                        hi = _mm256_unpackhi_epi8(x,zero),
+                        wlo = div255Avx2(_mm256_add_epi16(_mm256_mullo_epi16(lo,alphasAvx2(lo)),half)),
+                        whi = div255Avx2(_mm256_add_epi16(_mm256_mullo_epi16(hi,alphasAvx2(hi)),half));
+        storeAvx2(p+ii*4,_mm256_packus_epi16(mergeAlphaAvx2(wlo,lo),mergeAlphaAvx2(whi,hi)));
+    }
+    return ii;
+}
+
+FG_TARGET_AVX2
+size_t
+alphaUnweightAvx2(uchar * p,size_t beg,size_t end)
+{
+    __m256i const       zero = _mm256_setzero_si256();
+    __m256 const        maxVal = _mm256_set1_ps(255.0f);
+    size_t              ii = beg;
+    for (; ii+8<=end; ii+=8) {
+        __m256i         r[4];
+        for (uint jj=0; jj<4; ++jj) {
+            __m256i         c = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(p+ii*4+jj*8))),
+                            a = _mm256_shuffle_epi32(c,0xFF),
+                            num = _mm256_add_epi32(_mm256_mullo_epi32(c,_mm256_set1_epi32(255)),_mm256_srli_epi32(a,1)),
+                            q = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_div_ps(_mm256_add_ps(_mm256_cvtepi32_ps(num),_mm256_set1_ps(0.5f)),_mm256_cvtepi32_ps(a)),maxVal));
+            q = _mm256_andnot_si256(_mm256_cmpeq_epi32(a,zero),q);
+            r[jj] = _mm256_blend_epi32(q,c,0x88);
+        }
+        storeAvx2(p+ii*4,unpermuteAvx2(_mm256_packus_epi16(_mm256_packs_epi32(r[0],r[1]),_mm256_packs_epi32(r[2],r[3]))));
+    }
+    return ii;
+}
+
+FG_TARGET_AVX2
+size_t
+compositeAvx2(uchar const * f,uchar * b,size_t beg,size_t end)
+{
+    __m256i const       zero = _mm256_setzero_si256(),
+                        half = _mm256_set1_epi16(127),
+                        full = _mm256_set1_epi16(255);
+    size_t              ii = beg;
+    for (; ii+8<=end; ii+=8) {
+        __m256i         fx = loadAvx2(f+ii*4),
+                        bx = loadAvx2(b+ii*4),
+                        ff[2] = {_mm256_unpacklo_epi8(fx,zero),_mm256_unpackhi_epi8(fx,zero)},
+                        bb[2] = {_mm256_unpacklo_epi8(bx,zero),_mm256_unpackhi_epi8(bx,zero)},
+                        r[2];
+        for (uint jj=0; jj<2; ++jj) {
+            __m256i         tra = _mm256_sub_epi16(full,alphasAvx2(ff[jj])),
+                            aca = div255Avx2(_mm256_add_epi16(_mm256_mullo_epi16(tra,alphasAvx2(bb[jj])),half)),
+                            rgb = _mm256_add_epi16(ff[jj],div255Avx2(_mm256_add_epi16(_mm256_mullo_epi16(bb[jj],aca),half)));
+            r[jj] = _mm256_and_si256(mergeAlphaAvx2(rgb,_mm256_add_epi16(ff[jj],aca)),full);
+        }
+        storeAvx2(b+ii*4,_mm256_packus_epi16(r[0],r[1]));
+    }
+    return ii;
+}
+
+FG_TARGET_AVX2
+size_t
+luminanceAvx2(uchar const * s,uchar * d,size_t beg,size_t end)
+{
+    __m256i const       wgts = _mm256_setr_epi16(rec709R,rec709G,rec709B,0,rec709R,rec709G,rec709B,0,
+                                                 rec709R,rec709G,rec709B,0,rec709R,rec709G,rec709B,0),
+                        order = _mm256_setr_epi32(0,1,4,5,2,3,6,7);
+    size_t              ii = beg;
+    for (; ii+8<=end; ii+=8) {
+        __m256i         lo = _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s+ii*4))),wgts),
+                        hi = _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<__m128i const *>(s+ii*4+16))),wgts),
+                        sum = _mm256_permutevar8x32_epi32(_mm256_srli_epi32(_mm256_hadd_epi32(lo,hi),14),order);
+        __m128i         l = _mm_packs_epi32(_mm256_castsi256_si128(sum),_mm256_extracti128_si256(sum,1));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(d+ii),_mm_packus_epi16(l,l));
+    }
+    return ii;
+}
+
+FG_TARGET_AVX2
+size_t
+ucToFloatAvx2(uchar const * s,float * d,size_t beg,size_t end)
+{
+    size_t              ii = beg;
+    for (; ii+32<=end; ii+=32)
+        for (size_t jj=0; jj<32; jj+=8)
+            _mm256_storeu_ps(d+ii+jj,_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<__m128i const *>(s+ii+jj)))));
+    return ii;
+}
+
+FG_TARGET_AVX2
+inline
+__m256i
+clampTruncAvx2(float const * s)
+{
+    return _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(s),_mm256_setzero_ps()),_mm256_set1_ps(255.0f)));
+}
+
+FG_TARGET_AVX2
+size_t
+floatToUcAvx2(float const * s,uchar * d,size_t beg,size_t end)
+{
+    size_t              ii = beg;
+    for (; ii+32<=end; ii+=32) {
+        __m256i         lo = _mm256_packs_epi32(clampTruncAvx2(s+ii),clampTruncAvx2(s+ii+8)),
+                        hi = _mm256_packs_epi32(clampTruncAvx2(s+ii+16),clampTruncAvx2(s+ii+24));
+        storeAvx2(d+ii,unpermuteAvx2(_mm256_packus_epi16(lo,hi)));
+    }
+    return ii;
+}
+
+#endif
+
+#ifdef FG_NEON
+
+inline
+uint16x8_t
+div255Neon(uint16x8_t x)
+{return vshrq_n_u16(vaddq_u16(vaddq_u16(x,vdupq_n_u16(1)),vshrq_n_u16(x,8)),8); }
+
+size_t
+alphaWeightNeon(uchar * p,size_t beg,size_t end)
+{
+    uint16x8_t const    half = vdupq_n_u16(127);
+    size_t              ii = beg;
+    for (; ii+8<=end; ii+=8) {
+        uint8x8x4_t     x = vld4_u8(p+ii*4);
+        for (uint cc=0; cc<3; ++cc)
+            x.val[cc] = vmovn_u16(div255Neon(vaddq_u16(vmull_u8(x.val[cc],x.val[3]),half)));
+        vst4_u8(p+ii*4,x);
+    }
+    return ii;
+}
+
+size_t
+compositeNeon(uchar const * f,uchar * b,size_t beg,size_t end)
+{
+    uint16x8_t const    half = vdupq_n_u16(127);
+    size_t              ii = beg;
+    for (; ii+8<=end; ii+=8) {
+        uint8x8x4_t     ff = vld4_u8(f+ii*4),
+                        bb = vld4_u8(b+ii*4);
+        uint8x8_t       aca = vmovn_u16(div255Neon(vaddq_u16(vmull_u8(vsub_u8(vdup_n_u8(255),ff.val[3]),bb.val[3]),half)));
+        for (uint cc=0; cc<3; ++cc)
+            bb.val[cc] = vmovn_u16(vaddw_u8(div255Neon(vaddq_u16(vmull_u8(bb.val[cc],aca),half)),ff.val[cc]));
+        bb.val[3] = vadd_u8(ff.val[3],aca);
+        vst4_u8(b+ii*4,bb);
+    }
+    return ii;
+}
+
+size_t
+luminanceNeon(uchar const * s,uchar * d,size_t beg,size_t end)
+{
+    size_t              ii = beg;
+    for (; ii+8<=end; ii+=8) {
+        uint8x8x4_t     x = vld4_u8(s+ii*4);
+        uint16x8_t      r = vmovl_u8(x.val[0]),
+                        g = vmovl_u8(x.val[1]),
+                        b = vmovl_u8(x.val[2]);
+        uint32x4_t      lo = vmull_n_u16(vget_low_u16(r),rec709R),
+                        hi = vmull_n_u16(vget_high_u16(r),rec709R);
+        lo = vmlal_n_u16(lo,vget_low_u16(g),rec709G);
+        hi = vmlal_n_u16(hi,vget_high_u16(g),rec709G);
+        lo = vmlal_n_u16(lo,vget_low_u16(b),rec709B);
+        hi = vmlal_n_u16(hi,vget_high_u16(b),rec709B);
+        vst1_u8(d+ii,vmovn_u16(vcombine_u16(vshrn_n_u32(lo,14),vshrn_n_u32(hi,14))));
+    }
+    return ii;
+}
+
+size_t
+ucToFloatNeon(uchar const * s,float * d,size_t beg,size_t end)
+{
+    size_t              ii = beg;
+    for (; ii+16<=end; ii+=16) {
+        uint8x16_t      x = vld1q_u8(s+ii);
+        uint16x8_t      lo = vmovl_u8(vget_low_u8(x)),
+                        hi = vmovl_u8(vget_high_u8(x));
+        vst1q_f32(d+ii,vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))));
+        vst1q_f32(d+ii+4,vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))));
+        vst1q_f32(d+ii+8,vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))));
+        vst1q_f32(d+ii+12,vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))));
+    }
+    return ii;
+}
+
+inline
+uint16x4_t
+clampTruncNeon(float const * s)
+{
+    float32x4_t     x = vminq_f32(vmaxq_f32(vld1q_f32(s),vdupq_n_f32(0.0f)),vdupq_n_f32(255.0f));
+    return vmovn_u32(vcvtq_u32_f32(x));
+}
+
+size_t
+floatToUcNeon(float const * s,uchar * d,size_t beg,size_t end)
+{
+    size_t              ii = beg;
+    for (; ii+8<=end; ii+=8)
+        vst1_u8(d+ii,vmovn_u16(vcombine_u16(clampTruncNeon(s+ii),clampTruncNeon(s+ii+4))));
+    return ii;
+}
+
+// No NEON version of 'alphaUnweight' since ARMv7 NEON has no vector divide.
+
+#endif
+
+uchar *
+flat(RgbaUC * p)
+{return reinterpret_cast<uchar *>(p); }
+
+uchar const *
+flat(RgbaUC const * p)
+{return reinterpret_cast<uchar const *>(p); }
+
+}
+
+void
+alphaWeightRow_(RgbaUC * pixels,size_t num)
+{
+    size_t              ii = 0;
+    Simd                simd = simdLevel();
+#ifdef FG_AVX2
+    if (simd == Simd::avx2)
+        ii = alphaWeightAvx2(flat(pixels),ii,num);
+#endif
+#ifdef FG_SSE2
+    if (simd >= Simd::vec128)
+        ii = alphaWeightSse2(flat(pixels),ii,num);
+#endif
+#ifdef FG_NEON
+    if (simd >= Simd::vec128)
+        ii = alphaWeightNeon(flat(pixels),ii,num);
+#endif
+    for (; ii<num; ++ii)
+        pixels[ii].alphaWeight();
+}
+
+void
+alphaUnweightRow_(RgbaUC * pixels,size_t num)
+{
+    size_t              ii = 0;
+    Simd                simd = simdLevel();
+#ifdef FG_AVX2
+    if (simd == Simd::avx2)
+        ii = alphaUnweightAvx2(flat(pixels),ii,num);
+#endif
+#ifdef FG_SSE2
+    if (simd >= Simd::vec128)
+        ii = alphaUnweightSse2(flat(pixels),ii,num);
+#endif
+    for (; ii<num; ++ii) {
+        RgbaUC &            p = pixels[ii];
+        uint                a = p.alpha();
+        for (uint cc=0; cc<3; ++cc)
+            p.m_c[cc] = (a == 0) ? 0 : uchar(std::min((uint(p.m_c[cc]) * 255 + a/2) / a,255U));
+    }
+}
+
+void
+compositeRow_(RgbaUC const * foreground,RgbaUC * background,size_t num)
+{
+    size_t              ii = 0;
+    Simd                simd = simdLevel();
+#ifdef FG_AVX2
+    if (simd == Simd::avx2)
+        ii = compositeAvx2(flat(foreground),flat(background),ii,num);
+#endif
+#ifdef FG_SSE2
+    if (simd >= Simd::vec128)
+        ii = compositeSse2(flat(foreground),flat(background),ii,num);
+#endif
+#ifdef FG_NEON
+    if (simd >= Simd::vec128)
+        ii = compositeNeon(flat(foreground),flat(background),ii,num);
+#endif
+    for (; ii<num; ++ii)
+        background[ii] = fgCompositeFragmentUnweighted(foreground[ii],background[ii]);
+}
+
+void
+luminanceRow_(RgbaUC const * src,uchar * dst,size_t num)
+{
+    size_t              ii = 0;
+    Simd                simd = simdLevel();
+#ifdef FG_AVX2
+    if (simd == Simd::avx2)
+        ii = luminanceAvx2(flat(src),dst,ii,num);
+#endif
+#ifdef FG_SSE2
+    if (simd >= Simd::vec128)
+        ii = luminanceSse2(flat(src),dst,ii,num);
+#endif
+#ifdef FG_NEON
+    if (simd >= Simd::vec128)
+        ii = luminanceNeon(flat(src),dst,ii,num);
+#endif
+    for (; ii<num; ++ii) {
+        RgbaUC const &      p = src[ii];
+        dst[ii] = uchar((rec709R*p.red() + rec709G*p.green() + rec709B*p.blue()) >> 14);
+    }
+}
+
+void
+convertRow_(RgbaUC const * src,RgbaF * dst,size_t num)
+{
+    static_assert(sizeof(RgbaF) == 4*sizeof(float),"RgbaF must be densely packed");
+    uchar const *       s = flat(src);
+    float *             d = reinterpret_cast<float *>(dst);
+    size_t              ii = 0,
+                        end = num * 4;
+    Simd                simd = simdLevel();
+#ifdef FG_AVX2
+    if (simd == Simd::avx2)
+        ii = ucToFloatAvx2(s,d,ii,end);
+#endif
+#ifdef FG_SSE2
+    if (simd >= Simd::vec128)
+        ii = ucToFloatSse2(s,d,ii,end);
+#endif
+#ifdef FG_NEON
+    if (simd >= Simd::vec128)
+        ii = ucToFloatNeon(s,d,ii,end);
+#endif
+    for (; ii<end; ++ii)
+        d[ii] = float(s[ii]);
+}
+
+void
+convertRow_(RgbaF const * src,RgbaUC * dst,size_t num)
+{
+    float const *       s = reinterpret_cast<float const *>(src);
+    uchar *             d = flat(dst);
+    size_t              ii = 0,
+                        end = num * 4;
+    Simd                simd = simdLevel();
+#ifdef FG_AVX2
+    if (simd == Simd::avx2)
+        ii = floatToUcAvx2(s,d,ii,end);
+#endif
+#ifdef FG_SSE2
+    if (simd >= Simd::vec128)
+        ii = floatToUcSse2(s,d,ii,end);
+#endif
+#ifdef FG_NEON
+    if (simd >= Simd::vec128)
+        ii = floatToUcNeon(s,d,ii,end);
+#endif
+    for (; ii<end; ++ii)
+        d[ii] = uchar(clampBounds(s[ii],0.0f,255.0f));
+}
+
+}
+
+// */
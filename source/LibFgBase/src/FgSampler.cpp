@@ -129,19 +129,9 @@ fgSampler(
     FgFuncSample        sample,
     uint                antiAliasBitDepth)
 {
-    ImgC4UC         img(dims);
+    ImgC4UC         img;
     FGASSERT((antiAliasBitDepth > 0) && (antiAliasBitDepth <= 8));
-    ImgC4F          fimg = fgSamplerF(img.dims(),sample,antiAliasBitDepth);
-    for (Iter2UI it(img.dims()); it.valid(); it.next())
-    {
-        const RgbaF & fpix = fimg[it()];
-        img[it()] = 
-            RgbaUC(
-                uchar(clampBounds(fpix.red(),0.0f,255.0f)),
-                uchar(clampBounds(fpix.green(),0.0f,255.0f)),
-                uchar(clampBounds(fpix.blue(),0.0f,255.0f)),
-                uchar(clampBounds(fpix.alpha(),0.0f,255.0f)));
-    }
+    imgConvert_(fgSamplerF(dims,sample,antiAliasBitDepth),img);
     return img;
 }
 
@@ -0,0 +1,86 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+
+#include "stdafx.h"
+
+#include "FgSimd.hpp"
+#include <atomic>
+#ifdef _MSC_VER
+    #include <intrin.h>
+#endif
+
+using namespace std;
+
+namespace Fg {
+
+namespace {
+
+bool
+cpuHasAvx2Fma()
+{
+#if defined(FG_AVX2) && defined(_MSC_VER)
+    int             info[4];
+    __cpuid(info,0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info,1);
+    bool            osxsave = (info[2] & (1 << 27)) != 0,
+                    avx = (info[2] & (1 << 28)) != 0,
+                    fma = (info[2] & (1 << 12)) != 0;
+    // The OS must save the YMM registers on context switch:
+    if (!osxsave || !avx || !fma || ((_xgetbv(0) & 6) != 6))
+        return false;
+    __cpuidex(info,7,0);
+    return ((info[1] & (1 << 5)) != 0);
+#elif defined(FG_AVX2)
+    return ((__builtin_cpu_supports("avx2") != 0) && (__builtin_cpu_supports("fma") != 0));
+#else
+    return false;
+#endif
+}
+
+Simd
+detect()
+{
+    if (cpuHasAvx2Fma())
+        return Simd::avx2;
+#if defined(FG_SSE2) || defined(FG_NEON)
+    return Simd::vec128;
+#else
+    return Simd::scalar;
+#endif
+}
+
+atomic<int>     s_level(-1);
+
+}
+
+Simd
+simdSupported()
+{
+    static Simd     ret = detect();
+    return ret;
+}
+
+Simd
+simdLevel()
+{
+    int             level = s_level.load(memory_order_relaxed);
+    if (level < 0)
+        return simdSupported();
+    return Simd(level);
+}
+
+void
+setSimdLevel(Simd level)
+{
+    level = Simd(std::min(int(level),int(simdSupported())));
+    s_level.store(int(level),memory_order_relaxed);
+}
+
+}
+
+// */
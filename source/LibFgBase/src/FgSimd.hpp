@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// SIMD instruction set selection.
+//
+// * 128-bit vectors (SSE2 on x86/x64, NEON on ARM) are selected at compile time since they are part
+//   of the base ISA on all our 64-bit targets.
+// * AVX2 is detected at run time on x86/x64. Functions using AVX2 intrinsics must be marked with
+//   FG_TARGET_AVX2 so that gcc/clang generate AVX2 code for them without requiring it elsewhere.
+//   The 'avx2' level also requires FMA3 (present on all AVX2 CPUs in practice). Functions using FMA
+//   intrinsics must be marked with FG_TARGET_AVX2_FMA instead.
+// * All kernels must give results identical to their scalar versions for integer data.
+//
+// FaceGen defines:
+//
+// FG_SSE2              SSE2 intrinsics are available (<emmintrin.h>)
+// FG_AVX2              AVX2 intrinsics can be compiled (<immintrin.h>) for run-time selection
+// FG_NEON              NEON intrinsics are available (<arm_neon.h>)
+//
+
+#ifndef FGSIMD_HPP
+#define FGSIMD_HPP
+
+#include "FgStdLibs.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #define FG_SSE2
+    #include <emmintrin.h>
+    #define FG_AVX2
+    #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define FG_NEON
+    #include <arm_neon.h>
+#endif
+
+#ifdef FG_AVX2
+    #ifdef _MSC_VER
+        #define FG_TARGET_AVX2
+        #define FG_TARGET_AVX2_FMA
+    #else
+        #define FG_TARGET_AVX2 __attribute__((target("avx2")))
+        #define FG_TARGET_AVX2_FMA __attribute__((target("avx2,fma")))
+    #endif
+#endif
+
+namespace Fg {
+
+enum struct Simd
+{
+    scalar,
+    vec128,     // SSE2 or NEON
+    avx2,
+};
+
+// Best instruction set supported by this build on this CPU:
+Simd
+simdSupported();
+
+// Instruction set currently used by the vectorized kernels. Defaults to 'simdSupported()':
+Simd
+simdLevel();
+
+// Select a lower level, eg. for testing or benchmarking. Levels above 'simdSupported()' are clamped:
+void
+setSimdLevel(Simd level);
+
+}
+
+#endif
@@ -0,0 +1,352 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+
+#include "stdafx.h"
+
+#include "FgTriAabbTree.hpp"
+#include "FgBounds.hpp"
+#include "FgParallel.hpp"
+#include "FgSimd.hpp"
+
+using namespace std;
+
+namespace Fg {
+
+namespace {
+
+// Max triangles in a leaf:
+size_t constexpr    s_leafSize = 4;
+// Bounds of unused child slots. Far enough to never be visited but small enough that the squared
+// distance is finite:
+float constexpr     s_far = 1.0e18f;
+
+inline Vec3F
+closestInSegment(Vec3F p,Vec3F a,Vec3F b,float & t)
+{
+    Vec3F           ab = b - a;
+    float           len = ab.mag();
+    t = (len > 0.0f) ? std::min(std::max(cDot(p-a,ab)/len,0.0f),1.0f) : 0.0f;
+    return a + ab * t;
+}
+
+// Closest point on the edges of a zero area triangle:
+float
+closestInDegenerate(Vec3F p,Vec3F a,Vec3F b,Vec3F c,Vec3F & bary)
+{
+    float           t0,t1,t2,
+                    m0 = (p - closestInSegment(p,a,b,t0)).mag(),
+                    m1 = (p - closestInSegment(p,b,c,t1)).mag(),
+                    m2 = (p - closestInSegment(p,a,c,t2)).mag();
+    if ((m0 <= m1) && (m0 <= m2)) {
+        bary = Vec3F(1-t0,t0,0);
+        return m0;
+    }
+    if (m1 <= m2) {
+        bary = Vec3F(0,1-t1,t1);
+        return m1;
+    }
+    bary = Vec3F(1-t2,0,t2);
+    return m2;
+}
+
+// Closest point in triangle 'abc' to 'p' by Voronoi region, from Ericson, "Real-Time Collision
+// Detection" 5.1.5. Returns the squared distance:
+float
+closestInTri(Vec3F p,Vec3F a,Vec3F b,Vec3F c,Vec3F & bary)
+{
+    Vec3F           ab = b - a,
+                    ac = c - a,
+                    ap = p - a;
+    // The region tests below divide by zero when the triangle has no area (eg. 2 equal vertices):
+    if (crossProduct(ab,ac).mag() <= 0.0f)
+        return closestInDegenerate(p,a,b,c,bary);
+    float           d1 = cDot(ab,ap),
+                    d2 = cDot(ac,ap);
+    if ((d1 <= 0.0f) && (d2 <= 0.0f)) {
+        bary = Vec3F(1,0,0);
+        return ap.mag();
+    }
+    Vec3F           bp = p - b;
+    float           d3 = cDot(ab,bp),
+                    d4 = cDot(ac,bp);
+    if ((d3 >= 0.0f) && (d4 <= d3)) {
+        bary = Vec3F(0,1,0);
+        return bp.mag();
+    }
+    Vec3F           cp = p - c;
+    float           d5 = cDot(ab,cp),
+                    d6 = cDot(ac,cp),
+                    vc = d1*d4 - d3*d2,
+                    vb = d5*d2 - d1*d6,
+                    va = d3*d6 - d5*d4;
+    if ((d6 >= 0.0f) && (d5 <= d6)) {
+        bary = Vec3F(0,0,1);
+        return cp.mag();
+    }
+    if ((vc <= 0.0f) && (d1 >= 0.0f) && (d3 <= 0.0f)) {
+        float           v = d1 / (d1 - d3);
+        bary = Vec3F(1-v,v,0);
+        return (p - (a + ab*v)).mag();
+    }
+    if ((vb <= 0.0f) && (d2 >= 0.0f) && (d6 <= 0.0f)) {
+        float           w = d2 / (d2 - d6);
+        bary = Vec3F(1-w,0,w);
+        return (p - (a + ac*w)).mag();
+    }
+    if ((va <= 0.0f) && (d4 >= d3) && (d5 >= d6)) {
+        float           w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        bary = Vec3F(0,1-w,w);
+        return (p - (b + (c-b)*w)).mag();
+    }
+    float           sum = va + vb + vc;
+    if (sum > 0.0f) {
+        float           v = vb / sum,
+                        w = vc / sum;
+        bary = Vec3F(1-v-w,v,w);
+        return (p - (a + ab*v + ac*w)).mag();
+    }
+    // Nearly degenerate so rounding has left no region; take the closest of its edges:
+    return closestInDegenerate(p,a,b,c,bary);
+}
+
+// Squared distances from 'p' to each of the 4 boxes (zero if inside):
+inline void
+boxDists(float const lo[3][4],float const hi[3][4],Vec3F p,float * dists)
+{
+#if defined(FG_SSE2)
+    __m128          zero = _mm_setzero_ps(),
+                    acc = zero;
+    for (uint dd=0; dd<3; ++dd) {
+        __m128          pd = _mm_set1_ps(p[dd]),
+                        delta = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(lo[dd]),pd),
+                                    _mm_sub_ps(pd,_mm_loadu_ps(hi[dd]))),zero);
+        acc = _mm_add_ps(acc,_mm_mul_ps(delta,delta));
+    }
+    _mm_storeu_ps(dists,acc);
+#elif defined(FG_NEON)
+    float32x4_t     zero = vdupq_n_f32(0.0f),
+                    acc = zero;
+    for (uint dd=0; dd<3; ++dd) {
+        float32x4_t     pd = vdupq_n_f32(p[dd]),
+                        delta = vmaxq_f32(vmaxq_f32(vsubq_f32(vld1q_f32(lo[dd]),pd),
+                                    vsubq_f32(pd,vld1q_f32(hi[dd]))),zero);
+        acc = vmlaq_f32(acc,delta,delta);
+    }
+    vst1q_f32(dists,acc);
+#else
+    for (uint cc=0; cc<4; ++cc) {
+        float           acc = 0.0f;
+        for (uint dd=0; dd<3; ++dd) {
+            float           delta = std::max(std::max(lo[dd][cc]-p[dd],p[dd]-hi[dd][cc]),0.0f);
+            acc += delta * delta;
+        }
+        dists[cc] = acc;
+    }
+#endif
+}
+
+}
+
+TriAabbTree::TriAabbTree(Vec3Fs const & verts,Vec3UIs const & tris) :
+    m_verts(verts),
+    m_tris(tris),
+    m_order(tris.size())
+{
+    FGASSERT(!tris.empty());
+    FGASSERT(tris.size() < size_t(numeric_limits<uint>::max()));
+    Vec3Fs          centroids(tris.size());
+    for (size_t ii=0; ii<tris.size(); ++ii) {
+        Vec3UI          t = tris[ii];
+        for (uint vv=0; vv<3; ++vv)
+            FGASSERT(t[vv] < verts.size());
+        centroids[ii] = (verts[t[0]] + verts[t[1]] + verts[t[2]]) / 3.0f;
+        m_order[ii] = uint(ii);
+    }
+    m_nodes.reserve(tris.size() / 8 + 1);
+    build(0,tris.size(),centroids);
+    refit(verts);
+}
+
+uint
+TriAabbTree::build(size_t lo,size_t hi,Vec3Fs & centroids)
+{
+    // Median split on the axis of largest centroid extent:
+    auto            split = [&](size_t l,size_t h)
+    {
+        Vec3F           bmin = centroids[m_order[l]],
+                        bmax = bmin;
+        for (size_t ii=l+1; ii<h; ++ii) {
+            Vec3F           c = centroids[m_order[ii]];
+            for (uint dd=0; dd<3; ++dd) {
+                setIfLess(bmin[dd],c[dd]);
+                setIfGreater(bmax[dd],c[dd]);
+            }
+        }
+        Vec3F           ext = bmax - bmin;
+        uint            dim = (ext[0] > ext[1]) ? ((ext[0] > ext[2]) ? 0 : 2) : ((ext[1] > ext[2]) ? 1 : 2);
+        size_t          mid = (l + h) / 2;
+        nth_element(m_order.begin()+l,m_order.begin()+mid,m_order.begin()+h,
+            [&centroids,dim](uint a,uint b){return (centroids[a][dim] < centroids[b][dim]); });
+        return mid;
+    };
+    // Two levels of binary splits give the (up to) 4 children:
+    Svec<pair<size_t,size_t> >  ranges;
+    if (hi - lo <= s_leafSize)
+        ranges.push_back(make_pair(lo,hi));
+    else {
+        size_t          mid = split(lo,hi);
+        for (pair<size_t,size_t> half : {make_pair(lo,mid),make_pair(mid,hi)}) {
+            if (half.second - half.first <= s_leafSize)
+                ranges.push_back(half);
+            else {
+                size_t          m = split(half.first,half.second);
+                ranges.push_back(make_pair(half.first,m));
+                ranges.push_back(make_pair(m,half.second));
+            }
+        }
+    }
+    uint            idx = uint(m_nodes.size());
+    m_nodes.push_back(Node());
+    for (uint cc=0; cc<4; ++cc) {
+        uint            child = 0,
+                        num = 0;
+        if (cc < ranges.size()) {
+            size_t          l = ranges[cc].first,
+                            h = ranges[cc].second;
+            if (h - l <= s_leafSize) {
+                child = uint(l);
+                num = uint(h - l);
+            }
+            else
+                child = build(l,h,centroids);   // Invalidates references to 'm_nodes'
+        }
+        m_nodes[idx].child[cc] = child;
+        m_nodes[idx].numTris[cc] = num;
+    }
+    // Slots used by child nodes are non-zero since the root is never a child:
+    for (uint cc=uint(ranges.size()); cc<4; ++cc)
+        m_nodes[idx].child[cc] = 0;
+    return idx;
+}
+
+void
+TriAabbTree::setBounds(Node & node,uint cc) const
+{
+    Mat32F          bounds;
+    if (node.numTris[cc] > 0) {
+        Vec3Fs          pnts;
+        for (uint ii=0; ii<node.numTris[cc]; ++ii) {
+            Vec3UI          t = m_tris[m_order[node.child[cc]+ii]];
+            for (uint vv=0; vv<3; ++vv)
+                pnts.push_back(m_verts[t[vv]]);
+        }
+        bounds = cBounds(pnts);
+    }
+    else if (node.child[cc] > 0) {
+        Node const &    ch = m_nodes[node.child[cc]];
+        for (uint dd=0; dd<3; ++dd) {
+            bounds.rc(dd,0) = numeric_limits<float>::max();
+            bounds.rc(dd,1) = numeric_limits<float>::lowest();
+            for (uint ii=0; ii<4; ++ii) {
+                if ((ch.numTris[ii] > 0) || (ch.child[ii] > 0)) {
+                    setIfLess(bounds.rc(dd,0),ch.lo[dd][ii]);
+                    setIfGreater(bounds.rc(dd,1),ch.hi[dd][ii]);
+                }
+            }
+        }
+    }
+    else
+        bounds = Mat32F(s_far);                 // Unused slot
+    for (uint dd=0; dd<3; ++dd) {
+        node.lo[dd][cc] = bounds.rc(dd,0);
+        node.hi[dd][cc] = bounds.rc(dd,1);
+    }
+}
+
+void
+TriAabbTree::refit(Vec3Fs const & verts)
+{
+    FGASSERT(verts.size() == m_verts.size());
+    m_verts = verts;
+    // Children always follow their parents:
+    for (size_t nn=m_nodes.size(); nn>0; --nn)
+        for (uint cc=0; cc<4; ++cc)
+            setBounds(m_nodes[nn-1],cc);
+}
+
+TriClosest
+TriAabbTree::closest(Vec3F pos) const
+{
+    TriClosest      ret;
+    ret.mag = numeric_limits<float>::max();
+    ret.triIdx = 0;
+    ret.baryCoord = Vec3F(1,0,0);
+    // Balanced tree so the depth is logarithmic and at most 3 siblings are deferred at each level:
+    uint constexpr  stackSize = 256;
+    uint            stack[stackSize];
+    float           stackDist[stackSize];
+    uint            top = 0;
+    stack[top] = 0;
+    stackDist[top++] = 0.0f;
+    while (top > 0) {
+        --top;
+        if (stackDist[top] >= ret.mag)
+            continue;
+        Node const &    node = m_nodes[stack[top]];
+        float           dists[4];
+        boxDists(node.lo,node.hi,pos,dists);
+        // Visit the closest boxes first:
+        uint            order[4] = {0,1,2,3};
+        sort(order,order+4,[&dists](uint l,uint r){return (dists[l] < dists[r]); });
+        uint            push[4],
+                        numPush = 0;
+        for (uint ii=0; ii<4; ++ii) {
+            uint            cc = order[ii];
+            if (dists[cc] >= ret.mag)
+                break;
+            if (node.numTris[cc] > 0) {
+                for (uint tt=0; tt<node.numTris[cc]; ++tt) {
+                    uint            triIdx = m_order[node.child[cc]+tt];
+                    Vec3UI          t = m_tris[triIdx];
+                    Vec3F           bary;
+                    float           mag = closestInTri(pos,m_verts[t[0]],m_verts[t[1]],m_verts[t[2]],bary);
+                    if (mag < ret.mag) {
+                        ret.mag = mag;
+                        ret.triIdx = triIdx;
+                        ret.baryCoord = bary;
+                    }
+                }
+            }
+            else if (node.child[cc] > 0)
+                push[numPush++] = cc;
+        }
+        FGASSERT(top + numPush <= stackSize);
+        for (uint ii=numPush; ii>0; --ii) {     // Closest on top
+            uint            cc = push[ii-1];
+            stack[top] = node.child[cc];
+            stackDist[top++] = dists[cc];
+        }
+    }
+    Vec3UI          t = m_tris[ret.triIdx];
+    ret.pos = m_verts[t[0]] * ret.baryCoord[0] + m_verts[t[1]] * ret.baryCoord[1] + m_verts[t[2]] * ret.baryCoord[2];
+    return ret;
+}
+
+TriClosests
+TriAabbTree::closest(Vec3Fs const & queries) const
+{
+    TriClosests     ret(queries.size());
+    parallelForBlocks(queries.size(),256,[&](size_t lo,size_t hi)
+    {
+        for (size_t ii=lo; ii<hi; ++ii)
+            ret[ii] = closest(queries[ii]);
+    });
+    return ret;
+}
+
+}
+
+// */
@@ -0,0 +1,72 @@
+//
+// Copyright (c) 2019 Singular Inversions Inc. (facegen.com)
+// Use, modification and distribution is subject to the MIT License,
+// see accompanying file LICENSE.txt or facegen.com/base_library_license.txt
+//
+// Bounding volume hierarchy of axis-aligned boxes over a triangle mesh, for closest surface point queries.
+//
+// * Each node holds the boxes of up to 4 children so that the point to box distances are computed
+//   together in one SIMD register.
+// * Built top-down by median splits of the triangle centroids on the axis of largest extent.
+// * Queries are threadsafe. The bulk version runs across threads.
+//
+
+#ifndef FGTRIAABBTREE_HPP
+#define FGTRIAABBTREE_HPP
+
+#include "FgMatrixC.hpp"
+
+namespace Fg {
+
+struct  TriClosest
+{
+    float           mag;            // Squared distance from the query point
+    Vec3F           pos;            // Closest point on the surface
+    uint            triIdx;         // Index of its triangle in the list given to the tree
+    Vec3F           baryCoord;      // Of 'pos' in that triangle
+};
+typedef Svec<TriClosest>    TriClosests;
+
+class   TriAabbTree
+{
+public:
+    // Must have at least one triangle. Unreferenced vertices are ignored:
+    TriAabbTree(Vec3Fs const & verts,Vec3UIs const & tris);
+
+    // Update the vertex positions (same number, same triangles) and the node bounds, in O(n) without
+    // changing the tree structure. Queries slow down if the deformation is large relative to the
+    // triangle sizes, in which case construct a new tree:
+    void
+    refit(Vec3Fs const & verts);
+
+    TriClosest
+    closest(Vec3F pos) const;
+
+    TriClosests
+    closest(Vec3Fs const & queries) const;
+
+private:
+    struct  Node
+    {
+        float           lo[3][4];       // [axis][child] bounds
+        float           hi[3][4];
+        uint            child[4];       // Node index or first index into 'm_order' for a leaf
+        uint            numTris[4];     // Zero for a child node or empty slot
+    };
+    Vec3Fs          m_verts;
+    Vec3UIs         m_tris;
+    Uints           m_order;            // Triangle indices in leaf order
+    Svec<Node>      m_nodes;            // Root first, children after parents
+
+    uint
+    build(size_t lo,size_t hi,Vec3Fs & centroids);
+
+    void
+    setBounds(Node & node,uint cc) const;
+};
+
+}
+
+#endif
+
+// */
@@ -12,6 +12,8 @@
 #include <unistd.h>
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include "FgFileSystem.hpp"
 #include "FgException.hpp"
 #include "FgDiagnostics.hpp"
@@ -159,10 +161,65 @@ std::time_t
 getLastWriteTime(const Ustring & path)
 {return boost::filesystem::last_write_time(path.ns()); }
 
+uint64
+getLastWriteTimeNs(Ustring const & path)
+{
+    struct stat     st;
+    if (stat(path.as_utf8_string().c_str(),&st) != 0)
+        fgThrow("Unable to get modification time",path);
+#ifdef __APPLE__
+    timespec const & ts = st.st_mtimespec;
+#else
+    timespec const & ts = st.st_mtim;
+#endif
+    return uint64(ts.tv_sec) * 1000000000ULL + uint64(ts.tv_nsec);
+}
+
 void
 fgMakeWritableByAll(const Ustring &)
 {throw FgExceptionNotImplemented(); }
 
+MappedFile::MappedFile(Ustring const & fname)
+{
+    string          sname = fname.as_utf8_string();
+    int             fd = open(sname.c_str(),O_RDONLY);
+    if (fd < 0)
+        fgThrow("Unable to open file for mapping",fname);
+    struct stat     st;
+    if (fstat(fd,&st) != 0) {
+        close(fd);
+        fgThrow("Unable to get size of file for mapping",fname);
+    }
+    m_size = size_t(st.st_size);
+    if (m_size > 0) {
+        void *          ptr = mmap(nullptr,m_size,PROT_READ,MAP_PRIVATE,fd,0);
+        close(fd);                          // The mapping holds its own reference to the file
+        if (ptr == MAP_FAILED)
+            fgThrow("Unable to memory map file",fname);
+        m_data = static_cast<char const *>(ptr);
+    }
+    else
+        close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data != nullptr)
+        munmap(const_cast<char *>(m_data),m_size);
+}
+
+void
+MappedFile::discard(size_t offset,size_t size) const
+{
+    FGASSERT(offset+size <= m_size);
+    // Only whole pages within the range can be released:
+    size_t          page = size_t(sysconf(_SC_PAGESIZE)),
+                    lo = (offset + page - 1) / page * page,
+                    hi = (offset + size) / page * page;
+    if (lo < hi)
+        madvise(const_cast<char *>(m_data)+lo,hi-lo,MADV_DONTNEED);
+}
+
 #if defined(__APPLE__)
 
 #include <CoreFoundation/CFBundle.h>
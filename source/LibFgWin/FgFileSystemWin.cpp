@@ -284,4 +284,52 @@ fgMakeWritableByAll(const Ustring & name)
     }
 }
 
+MappedFile::MappedFile(Ustring const & fname)
+{
+    HANDLE          hFile =
+        CreateFile(fname.as_wstring().c_str(),GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+    if (hFile == INVALID_HANDLE_VALUE)
+        fgThrow("Unable to open file for mapping",fname);
+    LARGE_INTEGER   sz;
+    if (!GetFileSizeEx(hFile,&sz)) {
+        CloseHandle(hFile);
+        fgThrow("Unable to get size of file for mapping",fname);
+    }
+    m_size = size_t(sz.QuadPart);
+    if (m_size > 0) {
+        // Windows can't map empty files:
+        HANDLE          hMap = CreateFileMapping(hFile,NULL,PAGE_READONLY,0,0,NULL);
+        CloseHandle(hFile);                 // The mapping holds its own reference to the file
+        if (hMap == NULL)
+            fgThrow("Unable to create file mapping",fname);
+        void *          ptr = MapViewOfFile(hMap,FILE_MAP_READ,0,0,0);
+        if (ptr == NULL) {
+            CloseHandle(hMap);
+            fgThrow("Unable to memory map file",fname);
+        }
+        m_handle = hMap;
+        m_data = static_cast<char const *>(ptr);
+    }
+    else
+        CloseHandle(hFile);
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data != nullptr)
+        UnmapViewOfFile(m_data);
+    if (m_handle != nullptr)
+        CloseHandle(m_handle);
+}
+
+void
+MappedFile::discard(size_t offset,size_t size) const
+{
+    FGASSERT(offset+size <= m_size);
+    // Unlocking pages that are not locked removes them from the working set (the call then
+    // reports failure, which is expected):
+    if (size > 0)
+        VirtualUnlock(const_cast<char *>(m_data)+offset,size);
+}
+
 }
@@ -234,8 +234,8 @@ SDIRLibFgBase = LibFgBase/src/
 ODIRLibFgBase = $(BUILDIR)LibFgBase/
 $(shell mkdir -p $(ODIRLibFgBase))
 INCSLibFgBase := $(wildcard LibFgBase/src/*.hpp) $(wildcard LibTpEigen/Eigen/*.hpp) $(wildcard LibJpegIjg6b/*.hpp) $(wildcard LibTpStb/stb/*.hpp) $(wildcard LibTpBoost/boost_1_67_0/boost/*.hpp) 
-$(BUILDIR)LibFgBase.a: $(ODIRLibFgBase)Fg3dCamera.o $(ODIRLibFgBase)Fg3dDisplay.o $(ODIRLibFgBase)Fg3dMesh.o $(ODIRLibFgBase)Fg3dMesh3ds.o $(ODIRLibFgBase)Fg3dMeshDae.o $(ODIRLibFgBase)Fg3dMeshFbx.o $(ODIRLibFgBase)Fg3dMeshFgmesh.o $(ODIRLibFgBase)Fg3dMeshIo.o $(ODIRLibFgBase)Fg3dMeshLegacy.o $(ODIRLibFgBase)Fg3dMeshLwo.o $(ODIRLibFgBase)Fg3dMeshMa.o $(ODIRLibFgBase)Fg3dMeshObj.o $(ODIRLibFgBase)Fg3dMeshOps.o $(ODIRLibFgBase)Fg3dMeshPly.o $(ODIRLibFgBase)Fg3dMeshStl.o $(ODIRLibFgBase)Fg3dMeshTri.o $(ODIRLibFgBase)Fg3dMeshVrml.o $(ODIRLibFgBase)Fg3dMeshXsi.o $(ODIRLibFgBase)Fg3dNormals.o $(ODIRLibFgBase)Fg3dPose.o $(ODIRLibFgBase)Fg3dRayCaster.o $(ODIRLibFgBase)Fg3dSurface.o $(ODIRLibFgBase)Fg3dTest.o $(ODIRLibFgBase)Fg3dTopology.o $(ODIRLibFgBase)FgApproxFunc.o $(ODIRLibFgBase)FgBuild.o $(ODIRLibFgBase)FgCl.o $(ODIRLibFgBase)FgCluster.o $(ODIRLibFgBase)FgCmdBase.o $(ODIRLibFgBase)FgCmdImgops.o $(ODIRLibFgBase)FgCmdMeshops.o $(ODIRLibFgBase)FgCmdMorph.o $(ODIRLibFgBase)FgCmdNcServer.o $(ODIRLibFgBase)FgCmdRender.o $(ODIRLibFgBase)FgCmdTestmCpp.o $(ODIRLibFgBase)FgCmdView.o $(ODIRLibFgBase)FgCommand.o $(ODIRLibFgBase)FgCons.o $(ODIRLibFgBase)FgConsMakefiles.o $(ODIRLibFgBase)FgConsVisualStudio201x.o $(ODIRLibFgBase)FgDataflow.o $(ODIRLibFgBase)FgDiagnostics.o $(ODIRLibFgBase)FgDraw.o $(ODIRLibFgBase)FgException.o $(ODIRLibFgBase)FgExceptionTest.o $(ODIRLibFgBase)FgFileSystem.o $(ODIRLibFgBase)FgFileSystemTest.o $(ODIRLibFgBase)FgFileUtils.o $(ODIRLibFgBase)FgGeometry.o $(ODIRLibFgBase)FgGeometryTest.o $(ODIRLibFgBase)FgGridTriangles.o $(ODIRLibFgBase)FgGuiApi.o $(ODIRLibFgBase)FgGuiApi3d.o $(ODIRLibFgBase)FgGuiApiBase.o $(ODIRLibFgBase)FgGuiApiButton.o $(ODIRLibFgBase)FgGuiApiCheckbox.o $(ODIRLibFgBase)FgGuiApiDialogs.o $(ODIRLibFgBase)FgGuiApiImage.o $(ODIRLibFgBase)FgGuiApiRadio.o $(ODIRLibFgBase)FgGuiApiSlider.o $(ODIRLibFgBase)FgGuiApiSplit.o $(ODIRLibFgBase)FgGuiApiText.o $(ODIRLibFgBase)FgHex.o $(ODIRLibFgBase)FgHistogram.o $(ODIRLibFgBase)FgImage.o $(ODIRLibFgBase)FgImageIo.o $(ODIRLibFgBase)FgImageIoStb.o $(ODIRLibFgBase)FgImageTest.o $(ODIRLibFgBase)FgImgDisplay.o $(ODIRLibFgBase)FgImgJpeg.o $(ODIRLibFgBase)FgKdTree.o $(ODIRLibFgBase)FgLighting.o $(ODIRLibFgBase)FgMain.o $(ODIRLibFgBase)FgMath.o $(ODIRLibFgBase)FgMatrixC.o $(ODIRLibFgBase)FgMatrixSolver.o $(ODIRLibFgBase)FgMatrixSolverEigen.o $(ODIRLibFgBase)FgMatrixV.o $(ODIRLibFgBase)FgMetaFormat.o $(ODIRLibFgBase)FgNc.o $(ODIRLibFgBase)FgOut.o $(ODIRLibFgBase)FgParse.o $(ODIRLibFgBase)FgPath.o $(ODIRLibFgBase)FgPlatform.o $(ODIRLibFgBase)FgQuaternion.o $(ODIRLibFgBase)FgRandom.o $(ODIRLibFgBase)FgRayCaster.o $(ODIRLibFgBase)FgSampler.o $(ODIRLibFgBase)FgSerial.o $(ODIRLibFgBase)FgSimilarity.o $(ODIRLibFgBase)FgSoftRender.o $(ODIRLibFgBase)FgStdio.o $(ODIRLibFgBase)FgStdStream.o $(ODIRLibFgBase)FgStdString.o $(ODIRLibFgBase)FgStdVectorTest.o $(ODIRLibFgBase)FgString.o $(ODIRLibFgBase)FgStringTest.o $(ODIRLibFgBase)FgSyntax.o $(ODIRLibFgBase)FgTcpTest.o $(ODIRLibFgBase)FgTensorC.o $(ODIRLibFgBase)FgTestUtils.o $(ODIRLibFgBase)FgTime.o $(ODIRLibFgBase)FgViz.o $(ODIRLibFgBase)jpeg_mem_dest.o $(ODIRLibFgBase)jpeg_mem_src.o $(ODIRLibFgBase)MurmurHash2.o $(ODIRLibFgBase)MurmurHash3.o $(ODIRLibFgBase)portable_binary_iarchive.o $(ODIRLibFgBase)portable_binary_oarchive.o $(ODIRLibFgBase)stdafx.o $(ODIRLibFgBase)nix_FgClNix.o $(ODIRLibFgBase)nix_FgClusterNix.o $(ODIRLibFgBase)nix_FgConioNix.o $(ODIRLibFgBase)nix_FgFileSystemNix.o $(ODIRLibFgBase)nix_FgGuiNix.o $(ODIRLibFgBase)nix_FgSystemInfoNix.o $(ODIRLibFgBase)nix_FgTcpNix.o $(ODIRLibFgBase)nix_FgTimeNix.o $(ODIRLibFgBase)nix_FgWinSpecificNix.o 
-	$(AR) rc $(BUILDIR)LibFgBase.a $(ODIRLibFgBase)Fg3dCamera.o $(ODIRLibFgBase)Fg3dDisplay.o $(ODIRLibFgBase)Fg3dMesh.o $(ODIRLibFgBase)Fg3dMesh3ds.o $(ODIRLibFgBase)Fg3dMeshDae.o $(ODIRLibFgBase)Fg3dMeshFbx.o $(ODIRLibFgBase)Fg3dMeshFgmesh.o $(ODIRLibFgBase)Fg3dMeshIo.o $(ODIRLibFgBase)Fg3dMeshLegacy.o $(ODIRLibFgBase)Fg3dMeshLwo.o $(ODIRLibFgBase)Fg3dMeshMa.o $(ODIRLibFgBase)Fg3dMeshObj.o $(ODIRLibFgBase)Fg3dMeshOps.o $(ODIRLibFgBase)Fg3dMeshPly.o $(ODIRLibFgBase)Fg3dMeshStl.o $(ODIRLibFgBase)Fg3dMeshTri.o $(ODIRLibFgBase)Fg3dMeshVrml.o $(ODIRLibFgBase)Fg3dMeshXsi.o $(ODIRLibFgBase)Fg3dNormals.o $(ODIRLibFgBase)Fg3dPose.o $(ODIRLibFgBase)Fg3dRayCaster.o $(ODIRLibFgBase)Fg3dSurface.o $(ODIRLibFgBase)Fg3dTest.o $(ODIRLibFgBase)Fg3dTopology.o $(ODIRLibFgBase)FgApproxFunc.o $(ODIRLibFgBase)FgBuild.o $(ODIRLibFgBase)FgCl.o $(ODIRLibFgBase)FgCluster.o $(ODIRLibFgBase)FgCmdBase.o $(ODIRLibFgBase)FgCmdImgops.o $(ODIRLibFgBase)FgCmdMeshops.o $(ODIRLibFgBase)FgCmdMorph.o $(ODIRLibFgBase)FgCmdNcServer.o $(ODIRLibFgBase)FgCmdRender.o $(ODIRLibFgBase)FgCmdTestmCpp.o $(ODIRLibFgBase)FgCmdView.o $(ODIRLibFgBase)FgCommand.o $(ODIRLibFgBase)FgCons.o $(ODIRLibFgBase)FgConsMakefiles.o $(ODIRLibFgBase)FgConsVisualStudio201x.o $(ODIRLibFgBase)FgDataflow.o $(ODIRLibFgBase)FgDiagnostics.o $(ODIRLibFgBase)FgDraw.o $(ODIRLibFgBase)FgException.o $(ODIRLibFgBase)FgExceptionTest.o $(ODIRLibFgBase)FgFileSystem.o $(ODIRLibFgBase)FgFileSystemTest.o $(ODIRLibFgBase)FgFileUtils.o $(ODIRLibFgBase)FgGeometry.o $(ODIRLibFgBase)FgGeometryTest.o $(ODIRLibFgBase)FgGridTriangles.o $(ODIRLibFgBase)FgGuiApi.o $(ODIRLibFgBase)FgGuiApi3d.o $(ODIRLibFgBase)FgGuiApiBase.o $(ODIRLibFgBase)FgGuiApiButton.o $(ODIRLibFgBase)FgGuiApiCheckbox.o $(ODIRLibFgBase)FgGuiApiDialogs.o $(ODIRLibFgBase)FgGuiApiImage.o $(ODIRLibFgBase)FgGuiApiRadio.o $(ODIRLibFgBase)FgGuiApiSlider.o $(ODIRLibFgBase)FgGuiApiSplit.o $(ODIRLibFgBase)FgGuiApiText.o $(ODIRLibFgBase)FgHex.o $(ODIRLibFgBase)FgHistogram.o $(ODIRLibFgBase)FgImage.o $(ODIRLibFgBase)FgImageIo.o $(ODIRLibFgBase)FgImageIoStb.o $(ODIRLibFgBase)FgImageTest.o $(ODIRLibFgBase)FgImgDisplay.o $(ODIRLibFgBase)FgImgJpeg.o $(ODIRLibFgBase)FgKdTree.o $(ODIRLibFgBase)FgLighting.o $(ODIRLibFgBase)FgMain.o $(ODIRLibFgBase)FgMath.o $(ODIRLibFgBase)FgMatrixC.o $(ODIRLibFgBase)FgMatrixSolver.o $(ODIRLibFgBase)FgMatrixSolverEigen.o $(ODIRLibFgBase)FgMatrixV.o $(ODIRLibFgBase)FgMetaFormat.o $(ODIRLibFgBase)FgNc.o $(ODIRLibFgBase)FgOut.o $(ODIRLibFgBase)FgParse.o $(ODIRLibFgBase)FgPath.o $(ODIRLibFgBase)FgPlatform.o $(ODIRLibFgBase)FgQuaternion.o $(ODIRLibFgBase)FgRandom.o $(ODIRLibFgBase)FgRayCaster.o $(ODIRLibFgBase)FgSampler.o $(ODIRLibFgBase)FgSerial.o $(ODIRLibFgBase)FgSimilarity.o $(ODIRLibFgBase)FgSoftRender.o $(ODIRLibFgBase)FgStdio.o $(ODIRLibFgBase)FgStdStream.o $(ODIRLibFgBase)FgStdString.o $(ODIRLibFgBase)FgStdVectorTest.o $(ODIRLibFgBase)FgString.o $(ODIRLibFgBase)FgStringTest.o $(ODIRLibFgBase)FgSyntax.o $(ODIRLibFgBase)FgTcpTest.o $(ODIRLibFgBase)FgTensorC.o $(ODIRLibFgBase)FgTestUtils.o $(ODIRLibFgBase)FgTime.o $(ODIRLibFgBase)FgViz.o $(ODIRLibFgBase)jpeg_mem_dest.o $(ODIRLibFgBase)jpeg_mem_src.o $(ODIRLibFgBase)MurmurHash2.o $(ODIRLibFgBase)MurmurHash3.o $(ODIRLibFgBase)portable_binary_iarchive.o $(ODIRLibFgBase)portable_binary_oarchive.o $(ODIRLibFgBase)stdafx.o $(ODIRLibFgBase)nix_FgClNix.o $(ODIRLibFgBase)nix_FgClusterNix.o $(ODIRLibFgBase)nix_FgConioNix.o $(ODIRLibFgBase)nix_FgFileSystemNix.o $(ODIRLibFgBase)nix_FgGuiNix.o $(ODIRLibFgBase)nix_FgSystemInfoNix.o $(ODIRLibFgBase)nix_FgTcpNix.o $(ODIRLibFgBase)nix_FgTimeNix.o $(ODIRLibFgBase)nix_FgWinSpecificNix.o 
+$(BUILDIR)LibFgBase.a: $(ODIRLibFgBase)Fg3dCamera.o $(ODIRLibFgBase)Fg3dDisplay.o $(ODIRLibFgBase)Fg3dMesh.o $(ODIRLibFgBase)Fg3dMesh3ds.o $(ODIRLibFgBase)Fg3dMeshDae.o $(ODIRLibFgBase)Fg3dMeshFbx.o $(ODIRLibFgBase)Fg3dMeshFgmesh.o $(ODIRLibFgBase)Fg3dMeshIo.o $(ODIRLibFgBase)Fg3dMeshLegacy.o $(ODIRLibFgBase)Fg3dMeshLwo.o $(ODIRLibFgBase)Fg3dMeshMa.o $(ODIRLibFgBase)Fg3dMeshObj.o $(ODIRLibFgBase)Fg3dMeshOps.o $(ODIRLibFgBase)Fg3dMeshPly.o $(ODIRLibFgBase)Fg3dMeshStl.o $(ODIRLibFgBase)Fg3dMeshTri.o $(ODIRLibFgBase)Fg3dMeshVrml.o $(ODIRLibFgBase)Fg3dMeshXsi.o $(ODIRLibFgBase)Fg3dNormals.o $(ODIRLibFgBase)Fg3dPose.o $(ODIRLibFgBase)Fg3dRayCaster.o $(ODIRLibFgBase)Fg3dSurface.o $(ODIRLibFgBase)Fg3dTest.o $(ODIRLibFgBase)Fg3dTopology.o $(ODIRLibFgBase)FgAffineBatch.o $(ODIRLibFgBase)FgApproxFunc.o $(ODIRLibFgBase)FgBuild.o $(ODIRLibFgBase)FgCl.o $(ODIRLibFgBase)FgCluster.o $(ODIRLibFgBase)FgCmdBase.o $(ODIRLibFgBase)FgCmdImgops.o $(ODIRLibFgBase)FgCmdMeshops.o $(ODIRLibFgBase)FgCmdMorph.o $(ODIRLibFgBase)FgCmdNcServer.o $(ODIRLibFgBase)FgCmdRender.o $(ODIRLibFgBase)FgCmdTestmCpp.o $(ODIRLibFgBase)FgCmdView.o $(ODIRLibFgBase)FgCommand.o $(ODIRLibFgBase)FgCons.o $(ODIRLibFgBase)FgConsMakefiles.o $(ODIRLibFgBase)FgConsVisualStudio201x.o $(ODIRLibFgBase)FgDataflow.o $(ODIRLibFgBase)FgDiagnostics.o $(ODIRLibFgBase)FgDraw.o $(ODIRLibFgBase)FgException.o $(ODIRLibFgBase)FgExceptionTest.o $(ODIRLibFgBase)FgFileSystem.o $(ODIRLibFgBase)FgFileSystemTest.o $(ODIRLibFgBase)FgFileUtils.o $(ODIRLibFgBase)FgGemm.o $(ODIRLibFgBase)FgGeometry.o $(ODIRLibFgBase)FgGeometryTest.o $(ODIRLibFgBase)FgGridTriangles.o $(ODIRLibFgBase)FgGuiApi.o $(ODIRLibFgBase)FgGuiApi3d.o $(ODIRLibFgBase)FgGuiApiBase.o $(ODIRLibFgBase)FgGuiApiButton.o $(ODIRLibFgBase)FgGuiApiCheckbox.o $(ODIRLibFgBase)FgGuiApiDialogs.o $(ODIRLibFgBase)FgGuiApiImage.o $(ODIRLibFgBase)FgGuiApiRadio.o $(ODIRLibFgBase)FgGuiApiSlider.o $(ODIRLibFgBase)FgGuiApiSplit.o $(ODIRLibFgBase)FgGuiApiText.o $(ODIRLibFgBase)FgHex.o $(ODIRLibFgBase)FgHistogram.o $(ODIRLibFgBase)FgImage.o $(ODIRLibFgBase)FgImageFilter.o $(ODIRLibFgBase)FgImageIo.o $(ODIRLibFgBase)FgImageIoStb.o $(ODIRLibFgBase)FgImageResample.o $(ODIRLibFgBase)FgImageSimd.o $(ODIRLibFgBase)FgImageTest.o $(ODIRLibFgBase)FgImageTiled.o $(ODIRLibFgBase)FgImgDisplay.o $(ODIRLibFgBase)FgImgJpeg.o $(ODIRLibFgBase)FgKdTree.o $(ODIRLibFgBase)FgLighting.o $(ODIRLibFgBase)FgLoadCache.o $(ODIRLibFgBase)FgMain.o $(ODIRLibFgBase)FgMath.o $(ODIRLibFgBase)FgMatrixC.o $(ODIRLibFgBase)FgMatrixSolver.o $(ODIRLibFgBase)FgMatrixSolverEigen.o $(ODIRLibFgBase)FgMatrixSparse.o $(ODIRLibFgBase)FgMatrixV.o $(ODIRLibFgBase)FgMetaFormat.o $(ODIRLibFgBase)FgNc.o $(ODIRLibFgBase)FgOut.o $(ODIRLibFgBase)FgParallel.o $(ODIRLibFgBase)FgParse.o $(ODIRLibFgBase)FgPath.o $(ODIRLibFgBase)FgPlatform.o $(ODIRLibFgBase)FgQuaternion.o $(ODIRLibFgBase)FgRandom.o $(ODIRLibFgBase)FgRayCaster.o $(ODIRLibFgBase)FgRgbaSimd.o $(ODIRLibFgBase)FgSampler.o $(ODIRLibFgBase)FgSerial.o $(ODIRLibFgBase)FgSimd.o $(ODIRLibFgBase)FgSimilarity.o $(ODIRLibFgBase)FgSoftRender.o $(ODIRLibFgBase)FgStdio.o $(ODIRLibFgBase)FgStdStream.o $(ODIRLibFgBase)FgStdString.o $(ODIRLibFgBase)FgStdVectorTest.o $(ODIRLibFgBase)FgString.o $(ODIRLibFgBase)FgStringTest.o $(ODIRLibFgBase)FgSyntax.o $(ODIRLibFgBase)FgTcpTest.o $(ODIRLibFgBase)FgTensorC.o $(ODIRLibFgBase)FgTestUtils.o $(ODIRLibFgBase)FgTime.o $(ODIRLibFgBase)FgTriAabbTree.o $(ODIRLibFgBase)FgViz.o $(ODIRLibFgBase)jpeg_mem_dest.o $(ODIRLibFgBase)jpeg_mem_src.o $(ODIRLibFgBase)MurmurHash2.o $(ODIRLibFgBase)MurmurHash3.o $(ODIRLibFgBase)portable_binary_iarchive.o $(ODIRLibFgBase)portable_binary_oarchive.o $(ODIRLibFgBase)stdafx.o $(ODIRLibFgBase)nix_FgClNix.o $(ODIRLibFgBase)nix_FgClusterNix.o $(ODIRLibFgBase)nix_FgConioNix.o $(ODIRLibFgBase)nix_FgFileSystemNix.o $(ODIRLibFgBase)nix_FgGuiNix.o $(ODIRLibFgBase)nix_FgSystemInfoNix.o $(ODIRLibFgBase)nix_FgTcpNix.o $(ODIRLibFgBase)nix_FgTimeNix.o $(ODIRLibFgBase)nix_FgWinSpecificNix.o 
+	$(AR) rc $(BUILDIR)LibFgBase.a $(ODIRLibFgBase)Fg3dCamera.o $(ODIRLibFgBase)Fg3dDisplay.o $(ODIRLibFgBase)Fg3dMesh.o $(ODIRLibFgBase)Fg3dMesh3ds.o $(ODIRLibFgBase)Fg3dMeshDae.o $(ODIRLibFgBase)Fg3dMeshFbx.o $(ODIRLibFgBase)Fg3dMeshFgmesh.o $(ODIRLibFgBase)Fg3dMeshIo.o $(ODIRLibFgBase)Fg3dMeshLegacy.o $(ODIRLibFgBase)Fg3dMeshLwo.o $(ODIRLibFgBase)Fg3dMeshMa.o $(ODIRLibFgBase)Fg3dMeshObj.o $(ODIRLibFgBase)Fg3dMeshOps.o $(ODIRLibFgBase)Fg3dMeshPly.o $(ODIRLibFgBase)Fg3dMeshStl.o $(ODIRLibFgBase)Fg3dMeshTri.o $(ODIRLibFgBase)Fg3dMeshVrml.o $(ODIRLibFgBase)Fg3dMeshXsi.o $(ODIRLibFgBase)Fg3dNormals.o $(ODIRLibFgBase)Fg3dPose.o $(ODIRLibFgBase)Fg3dRayCaster.o $(ODIRLibFgBase)Fg3dSurface.o $(ODIRLibFgBase)Fg3dTest.o $(ODIRLibFgBase)Fg3dTopology.o $(ODIRLibFgBase)FgAffineBatch.o $(ODIRLibFgBase)FgApproxFunc.o $(ODIRLibFgBase)FgBuild.o $(ODIRLibFgBase)FgCl.o $(ODIRLibFgBase)FgCluster.o $(ODIRLibFgBase)FgCmdBase.o $(ODIRLibFgBase)FgCmdImgops.o $(ODIRLibFgBase)FgCmdMeshops.o $(ODIRLibFgBase)FgCmdMorph.o $(ODIRLibFgBase)FgCmdNcServer.o $(ODIRLibFgBase)FgCmdRender.o $(ODIRLibFgBase)FgCmdTestmCpp.o $(ODIRLibFgBase)FgCmdView.o $(ODIRLibFgBase)FgCommand.o $(ODIRLibFgBase)FgCons.o $(ODIRLibFgBase)FgConsMakefiles.o $(ODIRLibFgBase)FgConsVisualStudio201x.o $(ODIRLibFgBase)FgDataflow.o $(ODIRLibFgBase)FgDiagnostics.o $(ODIRLibFgBase)FgDraw.o $(ODIRLibFgBase)FgException.o $(ODIRLibFgBase)FgExceptionTest.o $(ODIRLibFgBase)FgFileSystem.o $(ODIRLibFgBase)FgFileSystemTest.o $(ODIRLibFgBase)FgFileUtils.o $(ODIRLibFgBase)FgGemm.o $(ODIRLibFgBase)FgGeometry.o $(ODIRLibFgBase)FgGeometryTest.o $(ODIRLibFgBase)FgGridTriangles.o $(ODIRLibFgBase)FgGuiApi.o $(ODIRLibFgBase)FgGuiApi3d.o $(ODIRLibFgBase)FgGuiApiBase.o $(ODIRLibFgBase)FgGuiApiButton.o $(ODIRLibFgBase)FgGuiApiCheckbox.o $(ODIRLibFgBase)FgGuiApiDialogs.o $(ODIRLibFgBase)FgGuiApiImage.o $(ODIRLibFgBase)FgGuiApiRadio.o $(ODIRLibFgBase)FgGuiApiSlider.o $(ODIRLibFgBase)FgGuiApiSplit.o $(ODIRLibFgBase)FgGuiApiText.o $(ODIRLibFgBase)FgHex.o $(ODIRLibFgBase)FgHistogram.o $(ODIRLibFgBase)FgImage.o $(ODIRLibFgBase)FgImageFilter.o $(ODIRLibFgBase)FgImageIo.o $(ODIRLibFgBase)FgImageIoStb.o $(ODIRLibFgBase)FgImageResample.o $(ODIRLibFgBase)FgImageSimd.o $(ODIRLibFgBase)FgImageTest.o $(ODIRLibFgBase)FgImageTiled.o $(ODIRLibFgBase)FgImgDisplay.o $(ODIRLibFgBase)FgImgJpeg.o $(ODIRLibFgBase)FgKdTree.o $(ODIRLibFgBase)FgLighting.o $(ODIRLibFgBase)FgLoadCache.o $(ODIRLibFgBase)FgMain.o $(ODIRLibFgBase)FgMath.o $(ODIRLibFgBase)FgMatrixC.o $(ODIRLibFgBase)FgMatrixSolver.o $(ODIRLibFgBase)FgMatrixSolverEigen.o $(ODIRLibFgBase)FgMatrixSparse.o $(ODIRLibFgBase)FgMatrixV.o $(ODIRLibFgBase)FgMetaFormat.o $(ODIRLibFgBase)FgNc.o $(ODIRLibFgBase)FgOut.o $(ODIRLibFgBase)FgParallel.o $(ODIRLibFgBase)FgParse.o $(ODIRLibFgBase)FgPath.o $(ODIRLibFgBase)FgPlatform.o $(ODIRLibFgBase)FgQuaternion.o $(ODIRLibFgBase)FgRandom.o $(ODIRLibFgBase)FgRayCaster.o $(ODIRLibFgBase)FgRgbaSimd.o $(ODIRLibFgBase)FgSampler.o $(ODIRLibFgBase)FgSerial.o $(ODIRLibFgBase)FgSimd.o $(ODIRLibFgBase)FgSimilarity.o $(ODIRLibFgBase)FgSoftRender.o $(ODIRLibFgBase)FgStdio.o $(ODIRLibFgBase)FgStdStream.o $(ODIRLibFgBase)FgStdString.o $(ODIRLibFgBase)FgStdVectorTest.o $(ODIRLibFgBase)FgString.o $(ODIRLibFgBase)FgStringTest.o $(ODIRLibFgBase)FgSyntax.o $(ODIRLibFgBase)FgTcpTest.o $(ODIRLibFgBase)FgTensorC.o $(ODIRLibFgBase)FgTestUtils.o $(ODIRLibFgBase)FgTime.o $(ODIRLibFgBase)FgTriAabbTree.o $(ODIRLibFgBase)FgViz.o $(ODIRLibFgBase)jpeg_mem_dest.o $(ODIRLibFgBase)jpeg_mem_src.o $(ODIRLibFgBase)MurmurHash2.o $(ODIRLibFgBase)MurmurHash3.o $(ODIRLibFgBase)portable_binary_iarchive.o $(ODIRLibFgBase)portable_binary_oarchive.o $(ODIRLibFgBase)stdafx.o $(ODIRLibFgBase)nix_FgClNix.o $(ODIRLibFgBase)nix_FgClusterNix.o $(ODIRLibFgBase)nix_FgConioNix.o $(ODIRLibFgBase)nix_FgFileSystemNix.o $(ODIRLibFgBase)nix_FgGuiNix.o $(ODIRLibFgBase)nix_FgSystemInfoNix.o $(ODIRLibFgBase)nix_FgTcpNix.o $(ODIRLibFgBase)nix_FgTimeNix.o $(ODIRLibFgBase)nix_FgWinSpecificNix.o 
 	$(RANLIB) $(BUILDIR)LibFgBase.a
 $(ODIRLibFgBase)Fg3dCamera.o: $(SDIRLibFgBase)Fg3dCamera.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)Fg3dCamera.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)Fg3dCamera.cpp
@@ -285,6 +285,8 @@ $(ODIRLibFgBase)Fg3dTest.o: $(SDIRLibFgBase)Fg3dTest.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)Fg3dTest.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)Fg3dTest.cpp
 $(ODIRLibFgBase)Fg3dTopology.o: $(SDIRLibFgBase)Fg3dTopology.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)Fg3dTopology.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)Fg3dTopology.cpp
+$(ODIRLibFgBase)FgAffineBatch.o: $(SDIRLibFgBase)FgAffineBatch.cpp $(INCSLibFgBase)
+	$(CXX) -o $(ODIRLibFgBase)FgAffineBatch.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgAffineBatch.cpp
 $(ODIRLibFgBase)FgApproxFunc.o: $(SDIRLibFgBase)FgApproxFunc.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgApproxFunc.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgApproxFunc.cpp
 $(ODIRLibFgBase)FgBuild.o: $(SDIRLibFgBase)FgBuild.cpp $(INCSLibFgBase)
@@ -333,6 +335,8 @@ $(ODIRLibFgBase)FgFileSystemTest.o: $(SDIRLibFgBase)FgFileSystemTest.cpp $(INCSL
 	$(CXX) -o $(ODIRLibFgBase)FgFileSystemTest.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgFileSystemTest.cpp
 $(ODIRLibFgBase)FgFileUtils.o: $(SDIRLibFgBase)FgFileUtils.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgFileUtils.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgFileUtils.cpp
+$(ODIRLibFgBase)FgGemm.o: $(SDIRLibFgBase)FgGemm.cpp $(INCSLibFgBase)
+	$(CXX) -o $(ODIRLibFgBase)FgGemm.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgGemm.cpp
 $(ODIRLibFgBase)FgGeometry.o: $(SDIRLibFgBase)FgGeometry.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgGeometry.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgGeometry.cpp
 $(ODIRLibFgBase)FgGeometryTest.o: $(SDIRLibFgBase)FgGeometryTest.cpp $(INCSLibFgBase)
@@ -367,12 +371,20 @@ $(ODIRLibFgBase)FgHistogram.o: $(SDIRLibFgBase)FgHistogram.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgHistogram.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgHistogram.cpp
 $(ODIRLibFgBase)FgImage.o: $(SDIRLibFgBase)FgImage.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgImage.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgImage.cpp
+$(ODIRLibFgBase)FgImageFilter.o: $(SDIRLibFgBase)FgImageFilter.cpp $(INCSLibFgBase)
+	$(CXX) -o $(ODIRLibFgBase)FgImageFilter.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgImageFilter.cpp
 $(ODIRLibFgBase)FgImageIo.o: $(SDIRLibFgBase)FgImageIo.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgImageIo.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgImageIo.cpp
 $(ODIRLibFgBase)FgImageIoStb.o: $(SDIRLibFgBase)FgImageIoStb.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgImageIoStb.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgImageIoStb.cpp
+$(ODIRLibFgBase)FgImageResample.o: $(SDIRLibFgBase)FgImageResample.cpp $(INCSLibFgBase)
+	$(CXX) -o $(ODIRLibFgBase)FgImageResample.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgImageResample.cpp
+$(ODIRLibFgBase)FgImageSimd.o: $(SDIRLibFgBase)FgImageSimd.cpp $(INCSLibFgBase)
+	$(CXX) -o $(ODIRLibFgBase)FgImageSimd.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgImageSimd.cpp
 $(ODIRLibFgBase)FgImageTest.o: $(SDIRLibFgBase)FgImageTest.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgImageTest.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgImageTest.cpp
+$(ODIRLibFgBase)FgImageTiled.o: $(SDIRLibFgBase)FgImageTiled.cpp $(INCSLibFgBase)
+	$(CXX) -o $(ODIRLibFgBase)FgImageTiled.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgImageTiled.cpp
 $(ODIRLibFgBase)FgImgDisplay.o: $(SDIRLibFgBase)FgImgDisplay.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgImgDisplay.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgImgDisplay.cpp
 $(ODIRLibFgBase)FgImgJpeg.o: $(SDIRLibFgBase)FgImgJpeg.cpp $(INCSLibFgBase)
@@ -381,6 +393,8 @@ $(ODIRLibFgBase)FgKdTree.o: $(SDIRLibFgBase)FgKdTree.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgKdTree.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgKdTree.cpp
 $(ODIRLibFgBase)FgLighting.o: $(SDIRLibFgBase)FgLighting.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgLighting.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgLighting.cpp
+$(ODIRLibFgBase)FgLoadCache.o: $(SDIRLibFgBase)FgLoadCache.cpp $(INCSLibFgBase)
+	$(CXX) -o $(ODIRLibFgBase)FgLoadCache.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgLoadCache.cpp
 $(ODIRLibFgBase)FgMain.o: $(SDIRLibFgBase)FgMain.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgMain.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgMain.cpp
 $(ODIRLibFgBase)FgMath.o: $(SDIRLibFgBase)FgMath.cpp $(INCSLibFgBase)
@@ -391,6 +405,8 @@ $(ODIRLibFgBase)FgMatrixSolver.o: $(SDIRLibFgBase)FgMatrixSolver.cpp $(INCSLibFg
 	$(CXX) -o $(ODIRLibFgBase)FgMatrixSolver.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgMatrixSolver.cpp
 $(ODIRLibFgBase)FgMatrixSolverEigen.o: $(SDIRLibFgBase)FgMatrixSolverEigen.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgMatrixSolverEigen.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgMatrixSolverEigen.cpp
+$(ODIRLibFgBase)FgMatrixSparse.o: $(SDIRLibFgBase)FgMatrixSparse.cpp $(INCSLibFgBase)
+	$(CXX) -o $(ODIRLibFgBase)FgMatrixSparse.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgMatrixSparse.cpp
 $(ODIRLibFgBase)FgMatrixV.o: $(SDIRLibFgBase)FgMatrixV.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgMatrixV.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgMatrixV.cpp
 $(ODIRLibFgBase)FgMetaFormat.o: $(SDIRLibFgBase)FgMetaFormat.cpp $(INCSLibFgBase)
@@ -399,6 +415,8 @@ $(ODIRLibFgBase)FgNc.o: $(SDIRLibFgBase)FgNc.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgNc.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgNc.cpp
 $(ODIRLibFgBase)FgOut.o: $(SDIRLibFgBase)FgOut.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgOut.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgOut.cpp
+$(ODIRLibFgBase)FgParallel.o: $(SDIRLibFgBase)FgParallel.cpp $(INCSLibFgBase)
+	$(CXX) -o $(ODIRLibFgBase)FgParallel.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgParallel.cpp
 $(ODIRLibFgBase)FgParse.o: $(SDIRLibFgBase)FgParse.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgParse.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgParse.cpp
 $(ODIRLibFgBase)FgPath.o: $(SDIRLibFgBase)FgPath.cpp $(INCSLibFgBase)
@@ -411,10 +429,14 @@ $(ODIRLibFgBase)FgRandom.o: $(SDIRLibFgBase)FgRandom.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgRandom.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgRandom.cpp
 $(ODIRLibFgBase)FgRayCaster.o: $(SDIRLibFgBase)FgRayCaster.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgRayCaster.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgRayCaster.cpp
+$(ODIRLibFgBase)FgRgbaSimd.o: $(SDIRLibFgBase)FgRgbaSimd.cpp $(INCSLibFgBase)
+	$(CXX) -o $(ODIRLibFgBase)FgRgbaSimd.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgRgbaSimd.cpp
 $(ODIRLibFgBase)FgSampler.o: $(SDIRLibFgBase)FgSampler.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgSampler.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgSampler.cpp
 $(ODIRLibFgBase)FgSerial.o: $(SDIRLibFgBase)FgSerial.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgSerial.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgSerial.cpp
+$(ODIRLibFgBase)FgSimd.o: $(SDIRLibFgBase)FgSimd.cpp $(INCSLibFgBase)
+	$(CXX) -o $(ODIRLibFgBase)FgSimd.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgSimd.cpp
 $(ODIRLibFgBase)FgSimilarity.o: $(SDIRLibFgBase)FgSimilarity.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgSimilarity.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgSimilarity.cpp
 $(ODIRLibFgBase)FgSoftRender.o: $(SDIRLibFgBase)FgSoftRender.cpp $(INCSLibFgBase)
@@ -441,6 +463,8 @@ $(ODIRLibFgBase)FgTestUtils.o: $(SDIRLibFgBase)FgTestUtils.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgTestUtils.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgTestUtils.cpp
 $(ODIRLibFgBase)FgTime.o: $(SDIRLibFgBase)FgTime.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgTime.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgTime.cpp
+$(ODIRLibFgBase)FgTriAabbTree.o: $(SDIRLibFgBase)FgTriAabbTree.cpp $(INCSLibFgBase)
+	$(CXX) -o $(ODIRLibFgBase)FgTriAabbTree.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgTriAabbTree.cpp
 $(ODIRLibFgBase)FgViz.o: $(SDIRLibFgBase)FgViz.cpp $(INCSLibFgBase)
 	$(CXX) -o $(ODIRLibFgBase)FgViz.o -c $(CXXFLAGS) $(FLAGSLibFgBase) $(SDIRLibFgBase)FgViz.cpp
 $(ODIRLibFgBase)jpeg_mem_dest.o: $(SDIRLibFgBase)jpeg_mem_dest.cpp $(INCSLibFgBase)